@@ -0,0 +1,258 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cf4ocl.  If not, see <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ * Benchmark which compares per-problem and batched launches of many
+ * small independent problems.
+ *
+ * @copyright [GNU General Public License version 3 (GPLv3)](http://www.gnu.org/licenses/gpl.html)
+ */
+
+/*
+ * Description
+ * -----------
+ *
+ * This program sums many small pairs of vectors with the `sum` kernel of
+ * the canonical example. For an increasing number of problems (1, 2, 4,
+ * ...), it first runs each problem with its own transfers and kernel
+ * launch, and then runs all problems with a single batched launch. It
+ * reports the time taken by both approaches, the number of problems from
+ * which batching pays off, and checks that both approaches produce the
+ * same results.
+ *
+ * The program accepts three optional command-line arguments:
+ *
+ * 1. Device index
+ * 2. Number of elements per problem (default 256)
+ * 3. Maximum number of problems (default 4096)
+ *
+ * */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <cf4ocl2.h>
+
+/* Default number of elements per problem. */
+#define PROBLEM_LEN 256
+
+/* Default maximum number of problems. */
+#define MAX_PROBLEMS 4096
+
+/* Constant added to each sum. */
+#define SUM_CONST 3
+
+/* Kernel source, as in the canonical example. */
+#define SUM_SRC \
+	"__kernel void sum(__global const uint *a, __global const uint *b,\n" \
+	"	__global uint *c, uint d, uint buf_size)\n" \
+	"{\n" \
+	"	uint gid = get_global_id(0);\n" \
+	"	if (gid < buf_size) {\n" \
+	"		c[gid] = a[gid] + b[gid] + d;\n" \
+	"	}\n" \
+	"}\n"
+
+/* Error handling macros. */
+#define ERROR_MSG_AND_EXIT(msg) \
+	do { fprintf(stderr, "\n%s\n", msg); exit(EXIT_FAILURE); } while(0)
+
+#define HANDLE_ERROR(err) \
+	if (err != NULL) { ERROR_MSG_AND_EXIT(err->message); }
+
+/**
+ * Batch benchmark main function.
+ *
+ * @param[in] argc Number of command line arguments.
+ * @param[in] argv Command line arguments.
+ * @return `EXIT_SUCCESS` if program terminates successfully, or another
+ * value of `EXIT_FAILURE` if an error occurs.
+ * */
+int main(int argc, char** argv) {
+
+	/* Wrappers. */
+	CCLContext* ctx = NULL;
+	CCLQueue* cq = NULL;
+	CCLProgram* prg = NULL;
+	CCLKernel* krnl = NULL;
+	CCLBatch* batch = NULL;
+	CCLBuffer* a_dev = NULL;
+	CCLBuffer* b_dev = NULL;
+	CCLBuffer* c_dev = NULL;
+
+	/* Description of the kernel arguments for batching. */
+	CCLBatchArg args[] = {
+		ccl_batch_arg_in(cl_uint), ccl_batch_arg_in(cl_uint),
+		ccl_batch_arg_out(cl_uint), ccl_batch_arg_shared(),
+		ccl_batch_arg_length()
+	};
+
+	/* Host buffers, with the problems stored one after the other. */
+	cl_uint* a_host;
+	cl_uint* b_host;
+	cl_uint* c_single;
+	cl_uint* c_batched;
+
+	/* Benchmark parameters and results. */
+	int dev_idx = -1;
+	cl_uint len = PROBLEM_LEN;
+	cl_uint max_problems = MAX_PROBLEMS;
+	cl_uint d = SUM_CONST;
+	cl_uint crossover = 0;
+	cl_uint n_last = 0;
+	size_t rws, gws, lws;
+	double t_single, t_batched;
+	GTimer* timer;
+
+	/* Error reporting object. */
+	CCLErr* err = NULL;
+
+	/* Check arguments. */
+	if (argc >= 2) dev_idx = atoi(argv[1]);
+	if (argc >= 3) len = (cl_uint) atoi(argv[2]);
+	if (argc >= 4) max_problems = (cl_uint) atoi(argv[3]);
+	if ((len == 0) || (max_problems == 0))
+		ERROR_MSG_AND_EXIT(
+			"Usage: batch_bench [dev_idx] [problem len] [max problems]");
+
+	/* Set up context, queue, per-problem kernel and batcher. */
+	ctx = ccl_context_new_from_menu_full(&dev_idx, &err);
+	HANDLE_ERROR(err);
+	cq = ccl_queue_new(ctx, NULL, 0, &err);
+	HANDLE_ERROR(err);
+	prg = ccl_program_new_from_source(ctx, SUM_SRC, &err);
+	HANDLE_ERROR(err);
+	ccl_program_build(prg, NULL, &err);
+	HANDLE_ERROR(err);
+	krnl = ccl_program_get_kernel(prg, "sum", &err);
+	HANDLE_ERROR(err);
+	batch = ccl_batch_new(ctx, SUM_SRC, "sum", args, 5, &err);
+	HANDLE_ERROR(err);
+
+	/* Get work sizes for one problem. */
+	rws = len;
+	ccl_kernel_suggest_worksizes(krnl, ccl_context_get_device(ctx, 0, NULL),
+		1, &rws, &gws, &lws, &err);
+	HANDLE_ERROR(err);
+
+	/* Allocate and initialize buffers. */
+	a_host = g_new(cl_uint, (size_t) len * max_problems);
+	b_host = g_new(cl_uint, (size_t) len * max_problems);
+	c_single = g_new(cl_uint, (size_t) len * max_problems);
+	c_batched = g_new(cl_uint, (size_t) len * max_problems);
+	for (size_t i = 0; i < (size_t) len * max_problems; ++i) {
+		a_host[i] = (cl_uint) (i % 1000);
+		b_host[i] = (cl_uint) (i % 777);
+	}
+	a_dev = ccl_buffer_new(ctx, CL_MEM_READ_ONLY,
+		len * sizeof(cl_uint), NULL, &err);
+	HANDLE_ERROR(err);
+	b_dev = ccl_buffer_new(ctx, CL_MEM_READ_ONLY,
+		len * sizeof(cl_uint), NULL, &err);
+	HANDLE_ERROR(err);
+	c_dev = ccl_buffer_new(ctx, CL_MEM_WRITE_ONLY,
+		len * sizeof(cl_uint), NULL, &err);
+	HANDLE_ERROR(err);
+
+	printf("\n   Problem length    : %u\n\n", len);
+	printf("   %10s   %14s   %14s   %10s\n",
+		"Problems", "Single (ms)", "Batched (ms)", "Speedup");
+
+	/* Run an increasing number of problems, both ways. The first round
+	 * only warms up the kernels and the arenas, and is not reported. */
+	timer = g_timer_new();
+	for (cl_uint n = 1, warm = 0; n <= max_problems;
+		n = warm++ ? n * 2 : n) {
+
+		/* One set of transfers and one kernel launch per problem. */
+		g_timer_start(timer);
+		for (cl_uint p = 0; p < n; ++p) {
+			size_t off = (size_t) p * len;
+			ccl_buffer_enqueue_write(a_dev, cq, CL_FALSE, 0,
+				len * sizeof(cl_uint), a_host + off, NULL, &err);
+			HANDLE_ERROR(err);
+			ccl_buffer_enqueue_write(b_dev, cq, CL_FALSE, 0,
+				len * sizeof(cl_uint), b_host + off, NULL, &err);
+			HANDLE_ERROR(err);
+			ccl_kernel_set_args_and_enqueue_ndrange(krnl, cq, 1, NULL,
+				&gws, &lws, NULL, &err, a_dev, b_dev, c_dev,
+				ccl_arg_priv(d, cl_uint), ccl_arg_priv(len, cl_uint),
+				NULL);
+			HANDLE_ERROR(err);
+			ccl_buffer_enqueue_read(c_dev, cq, CL_TRUE, 0,
+				len * sizeof(cl_uint), c_single + off, NULL, &err);
+			HANDLE_ERROR(err);
+		}
+		ccl_queue_gc(cq);
+		t_single = g_timer_elapsed(timer, NULL);
+
+		/* All problems with a single batched launch. */
+		g_timer_start(timer);
+		for (cl_uint p = 0; p < n; ++p) {
+			size_t off = (size_t) p * len;
+			void* data[] = {
+				a_host + off, b_host + off, c_batched + off, NULL, NULL };
+			ccl_batch_add(batch, len, data);
+		}
+		void* shared[] = {
+			NULL, NULL, NULL, ccl_arg_priv(d, cl_uint), NULL };
+		ccl_batch_enqueue(batch, cq, shared, &err);
+		HANDLE_ERROR(err);
+		ccl_queue_gc(cq);
+		t_batched = g_timer_elapsed(timer, NULL);
+
+		if (!warm) continue;
+		printf("   %10u   %14.3f   %14.3f   %9.2fx\n", n,
+			t_single * 1e3, t_batched * 1e3, t_single / t_batched);
+		if ((crossover == 0) && (t_batched < t_single)) crossover = n;
+		n_last = n;
+	}
+	g_timer_destroy(timer);
+
+	/* Check results of the largest round. */
+	if (memcmp(c_single, c_batched,
+		(size_t) len * n_last * sizeof(cl_uint)) != 0)
+		ERROR_MSG_AND_EXIT("Batched and per-problem results differ.");
+
+	/* Show results. */
+	if (crossover > 0)
+		printf("\n   Batching pays off from %u problem(s).\n\n", crossover);
+	else
+		printf("\n   Batching did not pay off.\n\n");
+	printf("Batched and per-problem launches produced the same results.\n");
+
+	/* Destroy stuff. */
+	g_free(a_host);
+	g_free(b_host);
+	g_free(c_single);
+	g_free(c_batched);
+	ccl_buffer_destroy(a_dev);
+	ccl_buffer_destroy(b_dev);
+	ccl_buffer_destroy(c_dev);
+	ccl_batch_destroy(batch);
+	ccl_program_destroy(prg);
+	ccl_queue_destroy(cq);
+	ccl_context_destroy(ctx);
+
+	/* Check all wrappers have been destroyed. */
+	assert(ccl_wrapper_memcheck());
+
+	/* Terminate. */
+	return EXIT_SUCCESS;
+}
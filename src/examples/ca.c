@@ -34,10 +34,30 @@
  * Life, in OpenCL using _cf4ocl_. It demonstrates the use of double-buffering
  * with images, multiple command queues and profiling.
  *
- * The program accepts two command-line arguments:
+ * The simulation is organized as a three-stage pipeline:
+ *
+ * 1. Device compute: iterations are enqueued back to back in the execution
+ *    queue, alternating between two kernel instances whose arguments are set
+ *    only once (see ccl_kernel_enqueue_ndrange_iter()).
+ * 2. Asynchronous readback: simulation states are read in the
+ *    communications queue into a ring of host frames, overlapping with
+ *    compute. A collector thread waits for each read to complete.
+ * 3. Image encoding: completed frames are handed to a thread pool which
+ *    saves them in PNG format with stb_image_write.
+ *
+ * When no host frame is available, the compute stage blocks until the
+ * encoders release one (back-pressure). The number of iterations per
+ * second, including image output, is reported at the end.
+ *
+ * The program accepts the following command-line arguments:
  *
  * 1. Device index
  * 2. RNG seed
+ * 3. Grid width (default 128, maximum 16384)
+ * 4. Grid height (default 128, maximum 16384)
+ * 5. Number of iterations (default 64)
+ * 6. Save period, i.e. save simulation state every n iterations (default 1,
+ *    0 disables image output)
  *
  * A series of images will be saved in the folder where this program runs. The
  * images can be converted to a video with the following command:
@@ -48,6 +68,7 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include <assert.h>
 #include <cf4ocl2.h>
@@ -74,6 +95,181 @@
 #define CA_WIDTH 128
 #define CA_HEIGHT 128
 #define CA_ITERS 64
+#define CA_MAX_SIDE 16384
+
+/* Pipeline settings. */
+#define CA_NUM_FRAMES 4
+#define CA_NUM_ENCODERS 2
+
+/* Host frame states. */
+#define CA_FRAME_FREE 0
+#define CA_FRAME_READING 1
+#define CA_FRAME_ENCODING 2
+
+/* A host frame in the readback ring. */
+typedef struct ca_frame {
+	/* Frame data. */
+	cl_uchar4* data;
+	/* Simulation state (iteration) held in frame. */
+	cl_uint state;
+	/* Frame status. */
+	int status;
+	/* Event of read into this frame. */
+	CCLEvent* evt_read;
+} CAFrame;
+
+/* Pipeline data. */
+typedef struct ca_pipeline {
+	/* Simulation images, the first one holds the initial state. */
+	CCLImage* imgs[2];
+	/* Queue for kernel execution. */
+	CCLQueue* queue_exec;
+	/* Queue for readbacks. */
+	CCLQueue* queue_comm;
+	/* Grid dimensions. */
+	size_t width;
+	size_t height;
+	/* Ring of host frames. */
+	CAFrame frames[CA_NUM_FRAMES];
+	/* Next frame to use. */
+	cl_uint next_frame;
+	/* Frames pending readback completion. */
+	GAsyncQueue* pending;
+	/* Thread pool of image encoders. */
+	GThreadPool* encoders;
+	/* Synchronizes access to frame status. */
+	GMutex lock;
+	GCond frame_freed;
+	/* Number of images which failed to be written. */
+	cl_uint write_errors;
+} CAPipeline;
+
+/**
+ * Stage 3: encode a frame to a PNG file and release it. Runs in the
+ * encoder thread pool.
+ * */
+static void ca_encode(gpointer data, gpointer user_data) {
+
+	CAFrame* frame = (CAFrame*) data;
+	CAPipeline* p = (CAPipeline*) user_data;
+	char filename[64];
+	int file_write_status;
+
+	/* Determine filename. */
+	snprintf(filename, sizeof(filename),
+		"%s%0" G_STRINGIFY(IMAGE_FILE_NUM_DIGITS) "u.png",
+		IMAGE_FILE_PREFIX, frame->state);
+
+	/* Save image. */
+	file_write_status = stbi_write_png(filename, (int) p->width,
+		(int) p->height, 4, frame->data,
+		(int) (p->width * sizeof(cl_uchar4)));
+
+	/* Release frame. */
+	g_mutex_lock(&p->lock);
+	if (!file_write_status) p->write_errors++;
+	frame->status = CA_FRAME_FREE;
+	g_cond_broadcast(&p->frame_freed);
+	g_mutex_unlock(&p->lock);
+
+}
+
+/**
+ * Stage 2: wait for frame reads to complete, in order, and hand frames to
+ * the encoders. Runs in its own thread until it gets the pipeline itself
+ * as a termination marker.
+ * */
+static gpointer ca_collect(gpointer user_data) {
+
+	CAPipeline* p = (CAPipeline*) user_data;
+	CCLEventWaitList ewl = NULL;
+	CCLErr* err = NULL;
+	gpointer item;
+
+	while ((item = g_async_queue_pop(p->pending)) != p) {
+
+		CAFrame* frame = (CAFrame*) item;
+
+		/* Wait for read to complete. */
+		ccl_event_wait(ccl_ewl(&ewl, frame->evt_read, NULL), &err);
+		HANDLE_ERROR(err);
+
+		/* Hand frame to encoders. */
+		g_mutex_lock(&p->lock);
+		frame->status = CA_FRAME_ENCODING;
+		g_mutex_unlock(&p->lock);
+		g_thread_pool_push(p->encoders, frame, NULL);
+	}
+
+	return NULL;
+}
+
+/**
+ * Get next host frame from the ring, blocking until it's released by the
+ * encoders.
+ * */
+static CAFrame* ca_frame_acquire(CAPipeline* p) {
+
+	CAFrame* frame = &p->frames[p->next_frame];
+	p->next_frame = (p->next_frame + 1) % CA_NUM_FRAMES;
+
+	g_mutex_lock(&p->lock);
+	while (frame->status != CA_FRAME_FREE)
+		g_cond_wait(&p->frame_freed, &p->lock);
+	frame->status = CA_FRAME_READING;
+	g_mutex_unlock(&p->lock);
+
+	return frame;
+}
+
+/**
+ * Stage 1 to stage 2 transition: enqueue asynchronous read of simulation
+ * state after an iteration. Called by ccl_kernel_enqueue_ndrange_iter()
+ * every save period.
+ * */
+static void ca_readback(cl_uint iter, CCLEvent* evt,
+	CCLEventWaitList* evt_wait_lst, void* user_data, CCLErr** err) {
+
+	CAPipeline* p = (CAPipeline*) user_data;
+	CCLEventWaitList ewl = NULL;
+	CAFrame* frame;
+	size_t origin[3] = { 0, 0, 0 };
+	size_t region[3] = { p->width, p->height, 1 };
+
+	/* The read below waits on a kernel in the execution queue, and the
+	 * frame may only be released by encoders waiting on earlier reads,
+	 * so make sure the kernels enqueued so far are submitted to the
+	 * device before waiting for a frame or enqueuing the read. */
+	ccl_queue_flush(p->queue_exec, err);
+	if (*err != NULL) return;
+
+	/* Get a free host frame (may block). */
+	frame = ca_frame_acquire(p);
+	frame->state = iter + 1;
+
+	/* Read result of this iteration once it's over. Even iterations write
+	 * to the second image, odd iterations write to the first one. */
+	ccl_event_wait_list_add(&ewl, evt, NULL);
+	frame->evt_read = ccl_image_enqueue_read(p->imgs[(iter + 1) % 2],
+		p->queue_comm, CL_FALSE, origin, region, 0, 0, frame->data,
+		&ewl, err);
+	if (frame->evt_read == NULL) return;
+
+	/* Make sure read is submitted to the device. */
+	ccl_queue_flush(p->queue_comm, err);
+	if (*err != NULL) return;
+
+	/* The image being read is only read by the next iteration, and is
+	 * overwritten two iterations from now, by the next iteration which
+	 * runs the same kernel instance. This is the iteration gated by the
+	 * events added to evt_wait_lst, so the read overlaps with the next
+	 * iteration. */
+	ccl_event_wait_list_add(evt_wait_lst, frame->evt_read, NULL);
+
+	/* Pass frame to collector. */
+	g_async_queue_push(p->pending, frame);
+
+}
 
 /**
  * Cellular automata sample main function.
@@ -85,44 +281,51 @@ int main(int argc, char* argv[]) {
 	CCLDevice* dev;
 	CCLImage* img1;
 	CCLImage* img2;
-	CCLImage* img_aux;
 	CCLQueue* queue_exec;
 	CCLQueue* queue_comm;
 	CCLProgram* prg;
-	CCLKernel* krnl;
-	CCLEvent* evt_comm;
 	CCLEvent* evt_exec;
+	/* One kernel instance per argument configuration (ping-pong). */
+	CCLKernel* krnls[2];
 	/* Other variables. */
 	CCLEventWaitList ewl = NULL;
+	/* Pipeline data. */
+	CAPipeline p;
+	/* Collector thread. */
+	GThread* collector;
 	/* Profiler object. */
 	CCLProf* prof;
-	/* Output images filename. */
-	char* filename;
 	/* Selected device, may be given in command line. */
 	int dev_idx = -1;
 	/* Error handling object (must be NULL). */
 	CCLErr* err = NULL;
 	/* Does selected device support images? */
 	cl_bool image_ok;
+	/* Maximum image dimensions supported by device. */
+	size_t max_width, max_height;
 	/* Initial sim state. */
 	cl_uchar4* input_image;
-	/* Simulation states. */
-	cl_uchar4** output_images;
 	/* RNG seed, may be given in command line. */
 	unsigned int seed;
-	/* Image file write status. */
-	int file_write_status;
+	/* Simulation size and number of iterations. */
+	size_t width = CA_WIDTH, height = CA_HEIGHT;
+	cl_uint iters = CA_ITERS;
+	/* Save state every save_period iterations. */
+	cl_uint save_period = 1;
 	/* Image format. */
 	cl_image_format image_format = { CL_RGBA, CL_UNSIGNED_INT8 };
 	/* Origin of sim space. */
 	size_t origin[3] = { 0, 0, 0 };
 	/* Region of sim space. */
-	size_t region[3] = { CA_WIDTH, CA_HEIGHT, 1 };
+	size_t region[3];
 	/* Real worksize. */
-	size_t real_ws[] = { CA_WIDTH, CA_HEIGHT };
+	size_t real_ws[2];
 	/* Global and local worksizes. */
 	size_t gws[2];
 	size_t lws[2];
+	/* Pipeline timer. */
+	GTimer* timer;
+	double elapsed;
 
 	/* Check arguments. */
 	if (argc >= 2) {
@@ -135,24 +338,40 @@ int main(int argc, char* argv[]) {
 	} else {
 		seed = (unsigned int) time(NULL);
 	}
+	if (argc >= 4) width = atoi(argv[3]);
+	if (argc >= 5) height = atoi(argv[4]);
+	if (argc >= 6) iters = atoi(argv[5]);
+	if (argc >= 7) save_period = atoi(argv[6]);
+	if ((width == 0) || (height == 0) || (width > CA_MAX_SIDE)
+			|| (height > CA_MAX_SIDE) || (iters == 0)) {
+		ERROR_MSG_AND_EXIT("Usage: ca [device_index] [seed] [width] " \
+			"[height] [iterations] [save_period]\n" \
+			"Width and height must be between 1 and " \
+			G_STRINGIFY(CA_MAX_SIDE) ".");
+	}
+	region[0] = width; region[1] = height; region[2] = 1;
+	real_ws[0] = width; real_ws[1] = height;
 
 	/* Initialize RNG. */
 	srand(seed);
 
 	/* Create random initial state. */
-	input_image = (cl_uchar4*)
-		malloc(CA_WIDTH * CA_HEIGHT * sizeof(cl_uchar4));
-	for (cl_uint i = 0; i < CA_WIDTH * CA_HEIGHT; ++i) {
+	input_image = (cl_uchar4*) malloc(width * height * sizeof(cl_uchar4));
+	if (input_image == NULL) ERROR_MSG_AND_EXIT("Out of host memory.");
+	for (size_t i = 0; i < width * height; ++i) {
 		cl_uchar state = (rand() & 0x3) ? 0xFF : 0x00;
 		input_image[i] = (cl_uchar4) {{ state, state, state, 0xFF }};
 	}
 
-	/* Allocate space for simulation results. */
-	output_images = (cl_uchar4**)
-		malloc((CA_ITERS + 1) * sizeof(cl_uchar4*));
-	for (cl_uint i = 0; i < CA_ITERS + 1; ++i)
-		output_images[i] = (cl_uchar4*)
-			malloc(CA_WIDTH * CA_HEIGHT * sizeof(cl_uchar4));
+	/* Allocate ring of host frames. */
+	for (cl_uint i = 0; i < CA_NUM_FRAMES; ++i) {
+		p.frames[i].data = (cl_uchar4*)
+			malloc(width * height * sizeof(cl_uchar4));
+		if (p.frames[i].data == NULL)
+			ERROR_MSG_AND_EXIT("Out of host memory.");
+		p.frames[i].status = CA_FRAME_FREE;
+		p.frames[i].evt_read = NULL;
+	}
 
 	/* Create context using device selected from menu. */
 	ctx = ccl_context_new_from_menu_full(&dev_idx, &err);
@@ -169,6 +388,16 @@ int main(int argc, char* argv[]) {
 	if (!image_ok)
 		ERROR_MSG_AND_EXIT("Selected device doesn't support images.");
 
+	/* Check if device supports images of the requested size. */
+	max_width = ccl_device_get_info_scalar(
+		dev, CL_DEVICE_IMAGE2D_MAX_WIDTH, size_t, &err);
+	HANDLE_ERROR(err);
+	max_height = ccl_device_get_info_scalar(
+		dev, CL_DEVICE_IMAGE2D_MAX_HEIGHT, size_t, &err);
+	HANDLE_ERROR(err);
+	if ((width > max_width) || (height > max_height))
+		ERROR_MSG_AND_EXIT("Grid size not supported by selected device.");
+
 	/* Create command queues. */
 	queue_exec = ccl_queue_new(ctx, dev, CL_QUEUE_PROFILING_ENABLE, &err);
 	HANDLE_ERROR(err);
@@ -179,8 +408,8 @@ int main(int argc, char* argv[]) {
 	img1 = ccl_image_new(ctx, CL_MEM_READ_WRITE,
 		&image_format, NULL, &err,
 		"image_type", (cl_mem_object_type) CL_MEM_OBJECT_IMAGE2D,
-		"image_width", (size_t) CA_WIDTH,
-		"image_height", (size_t) CA_HEIGHT,
+		"image_width", width,
+		"image_height", height,
 		NULL);
 	HANDLE_ERROR(err);
 
@@ -188,8 +417,8 @@ int main(int argc, char* argv[]) {
 	img2 = ccl_image_new(ctx, CL_MEM_READ_WRITE,
 		&image_format, NULL, &err,
 		"image_type", (cl_mem_object_type) CL_MEM_OBJECT_IMAGE2D,
-		"image_width", (size_t) CA_WIDTH,
-		"image_height", (size_t) CA_HEIGHT,
+		"image_width", width,
+		"image_height", height,
 		NULL);
 	HANDLE_ERROR(err);
 
@@ -200,87 +429,93 @@ int main(int argc, char* argv[]) {
 	ccl_program_build(prg, NULL, &err);
 	HANDLE_ERROR(err);
 
-	/* Get kernel wrapper. */
-	krnl = ccl_program_get_kernel(prg, "ca", &err);
+	/* Create two kernel instances, the first reads from img1 and writes
+	 * to img2, the second does the opposite. Arguments are set only
+	 * once. */
+	krnls[0] = ccl_kernel_new(prg, "ca", &err);
 	HANDLE_ERROR(err);
+	krnls[1] = ccl_kernel_new(prg, "ca", &err);
+	HANDLE_ERROR(err);
+	ccl_kernel_set_args(krnls[0], img1, img2, NULL);
+	ccl_kernel_set_args(krnls[1], img2, img1, NULL);
 
 	/* Determine nice local and global worksizes. */
-	ccl_kernel_suggest_worksizes(krnl, dev, 2, real_ws, gws, lws, &err);
+	ccl_kernel_suggest_worksizes(krnls[0], dev, 2, real_ws, gws, lws, &err);
 	HANDLE_ERROR(err);
 
-	printf("\n * Global work-size: (%d, %d)\n", (int) gws[0], (int) gws[1]);
+	printf("\n * Grid size: %d x %d, %d iterations\n",
+		(int) width, (int) height, (int) iters);
+	printf(" * Global work-size: (%d, %d)\n", (int) gws[0], (int) gws[1]);
 	printf(" * Local work-size: (%d, %d)\n", (int) lws[0], (int) lws[1]);
 
+	/* Setup pipeline. */
+	p.imgs[0] = img1;
+	p.imgs[1] = img2;
+	p.queue_exec = queue_exec;
+	p.queue_comm = queue_comm;
+	p.width = width;
+	p.height = height;
+	p.next_frame = 0;
+	p.write_errors = 0;
+	g_mutex_init(&p.lock);
+	g_cond_init(&p.frame_freed);
+	p.pending = g_async_queue_new();
+	p.encoders = g_thread_pool_new(
+		ca_encode, &p, CA_NUM_ENCODERS, FALSE, NULL);
+	collector = g_thread_new("collector", ca_collect, &p);
+
 	/* Start profiling. */
 	prof = ccl_prof_new();
 	ccl_prof_start(prof);
+	timer = g_timer_new();
 
 	/* Write initial state. */
 	ccl_image_enqueue_write(img1, queue_comm, CL_TRUE,
 		origin, region, 0, 0, input_image, NULL, &err);
 	HANDLE_ERROR(err);
 
-	/* Run CA_ITERS iterations of the CA. */
-	for (cl_uint i = 0; i < CA_ITERS; ++i) {
-
-		/* Read result of last iteration. On first run it is the initial
-		 * state. */
-		evt_comm = ccl_image_enqueue_read(img1, queue_comm, CL_FALSE,
-			origin, region, 0, 0, output_images[i], NULL, &err);
-		HANDLE_ERROR(err);
-
-		/* Execute iteration. */
-		evt_exec = ccl_kernel_set_args_and_enqueue_ndrange(
-			krnl, queue_exec, 2, NULL, gws, lws, NULL, &err,
-			img1, img2, NULL);
-		HANDLE_ERROR(err);
-
-		/* Can't start new read until this iteration is over. */
-		ccl_event_wait_list_add(&ewl, evt_comm, evt_exec, NULL);
-
-		/* Wait for events. */
-		ccl_event_wait(&ewl, &err);
-		HANDLE_ERROR(err);
-
-		/* Swap buffers. */
-		img_aux = img1;
-		img1 = img2;
-		img2 = img_aux;
-
+	/* The initial state is the first output. */
+	if (save_period > 0) {
+		CAFrame* frame = ca_frame_acquire(&p);
+		frame->state = 0;
+		frame->status = CA_FRAME_ENCODING;
+		memcpy(frame->data, input_image,
+			width * height * sizeof(cl_uchar4));
+		g_thread_pool_push(p.encoders, frame, NULL);
 	}
 
-	/* Read result of last iteration. */
-	ccl_image_enqueue_read(img1, queue_comm, CL_TRUE,
-		origin, region, 0, 0, output_images[CA_ITERS], &ewl, &err);
+	/* Run the CA, alternating between kernel instances and reading back
+	 * the state every save period. */
+	evt_exec = ccl_kernel_enqueue_ndrange_iter(krnls, 2, queue_exec, 2,
+		NULL, gws, lws, iters, save_period,
+		save_period > 0 ? ca_readback : NULL, &p, NULL, &err);
+	HANDLE_ERROR(err);
+
+	/* Wait for simulation to finish. */
+	ccl_event_wait(ccl_ewl(&ewl, evt_exec, NULL), &err);
 	HANDLE_ERROR(err);
 
-	/* Stop profiling timer and add queues for analysis. */
+	/* Drain pipeline: stop collector, then wait for encoders. */
+	g_async_queue_push(p.pending, &p);
+	g_thread_join(collector);
+	g_thread_pool_free(p.encoders, FALSE, TRUE);
+
+	/* Stop timers and add queues for analysis. */
+	g_timer_stop(timer);
+	elapsed = g_timer_elapsed(timer, NULL);
 	ccl_prof_stop(prof);
 	ccl_prof_add_queue(prof, "Comms", queue_comm);
 	ccl_prof_add_queue(prof, "Exec", queue_exec);
 
-	/* Allocate space for base filename. */
-	filename = (char*) malloc(
-		(strlen(IMAGE_FILE_PREFIX ".png") + IMAGE_FILE_NUM_DIGITS + 1)
-		* sizeof(char));
-
-	/* Write results to image files. */
-	for (cl_uint i = 0; i < CA_ITERS; ++i) {
-
-		/* Determine next filename. */
-		sprintf(filename, "%s%0" G_STRINGIFY(IMAGE_FILE_NUM_DIGITS) "d.png",
-			IMAGE_FILE_PREFIX, i);
-
-		/* Save next image. */
-		file_write_status = stbi_write_png(filename, CA_WIDTH, CA_HEIGHT, 4,
-			output_images[i], CA_WIDTH * sizeof(cl_uchar4));
-
-		/* Give feedback if unable to save image. */
-		if (!file_write_status) {
-			ERROR_MSG_AND_EXIT("Unable to save image in file.");
-		}
+	/* Give feedback if unable to save images. */
+	if (p.write_errors > 0) {
+		ERROR_MSG_AND_EXIT("Unable to save image in file.");
 	}
 
+	/* Report throughput. */
+	printf(" * Iterations per second: %.2f (%.3f seconds total)\n\n",
+		iters / elapsed, elapsed);
+
 	/* Process profiling info. */
 	ccl_prof_calc(prof, &err);
 	HANDLE_ERROR(err);
@@ -292,16 +527,22 @@ int main(int argc, char* argv[]) {
 	ccl_prof_export_info_file(prof, "prof.tsv", &err);
 	HANDLE_ERROR(err);
 
+	/* Release pipeline resources. */
+	g_timer_destroy(timer);
+	g_async_queue_unref(p.pending);
+	g_mutex_clear(&p.lock);
+	g_cond_clear(&p.frame_freed);
+
 	/* Release host buffers. */
-	free(filename);
 	free(input_image);
-	for (cl_uint i = 0; i < CA_ITERS + 1; ++i)
-		free(output_images[i]);
-	free(output_images);
+	for (cl_uint i = 0; i < CA_NUM_FRAMES; ++i)
+		free(p.frames[i].data);
 
 	/* Release wrappers. */
 	ccl_image_destroy(img1);
 	ccl_image_destroy(img2);
+	ccl_kernel_destroy(krnls[0]);
+	ccl_kernel_destroy(krnls[1]);
 	ccl_program_destroy(prg);
 	ccl_queue_destroy(queue_comm);
 	ccl_queue_destroy(queue_exec);
@@ -317,5 +558,3 @@ int main(int argc, char* argv[]) {
 	return EXIT_SUCCESS;
 
 }
-
-
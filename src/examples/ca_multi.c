@@ -0,0 +1,588 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cf4ocl.  If not, see <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ *
+ * Example of a cellular automata simulation (Conway's Game of Life) split
+ * across several OpenCL devices, with halo exchange between devices.
+ *
+ * @note Requires OpenCL >= 1.1 (>= 1.2 for sub-devices).
+ *
+ * @copyright [GNU General Public License version 3 (GPLv3)](http://www.gnu.org/licenses/gpl.html)
+ */
+
+/*
+ * Description
+ * -----------
+ *
+ * This example performs a Game of Life simulation with domain
+ * decomposition. The grid is partitioned in horizontal strips, one per
+ * device, where each strip has an extra halo row above and below. At each
+ * step, every device:
+ *
+ * 1. updates the top and bottom rows of its strip;
+ * 2. updates the interior rows of its strip, while
+ * 3. the updated top and bottom rows are sent to the halo rows of the
+ *    neighboring strips, in a separate command queue.
+ *
+ * As such, halo transfers overlap with interior compute. Halos are
+ * exchanged with ccl_buffer_enqueue_copy_rect() (device to device) or, in
+ * "host" mode, with ccl_buffer_enqueue_read_rect() and
+ * ccl_buffer_enqueue_write_rect() through host memory.
+ *
+ * The devices are either all the devices in the first platform, all the GPUs
+ * in the first platform with GPUs, or sub-devices of the first CPU device.
+ * The simulation runs with 1 to N devices, showing the speedup relative to
+ * one device, and results are validated against a host implementation.
+ *
+ * The program accepts the following command-line arguments:
+ *
+ * 1. Devices: `all` (default), `gpu` or `cpu`
+ * 2. Number of CPU sub-devices, only for `cpu` (default 0, i.e. as many
+ *    as compute units, up to 8)
+ * 3. Grid width (default 1024)
+ * 4. Grid height (default 1024)
+ * 5. Number of iterations (default 100)
+ * 6. Halo exchange: `copy` (default) or `host`
+ *
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <cf4ocl2.h>
+
+/* Kernel source string, will be hardwired in this location during the build
+ * process, before compilation. The kernel source is available in
+ * ca_multi.cl. */
+#define CA_KERNEL \
+@ca_multi_KERNEL_SRC@
+
+/* Error handling macros. */
+#define ERROR_MSG_AND_EXIT(msg) \
+	do { fprintf(stderr, "\n%s\n", msg); exit(EXIT_FAILURE); } while(0)
+
+#define HANDLE_ERROR(err) \
+	if (err != NULL) { ERROR_MSG_AND_EXIT(err->message); }
+
+/* Default simulation settings. */
+#define CA_WIDTH 1024
+#define CA_HEIGHT 1024
+#define CA_ITERS 100
+#define CA_MAX_SUBDEVS 8
+
+/* Halo exchange modes. */
+#define CA_XCHG_COPY 0
+#define CA_XCHG_HOST 1
+
+/* A horizontal strip of the grid, handled by one device. */
+typedef struct ca_strip {
+	/* Command queues for compute and for halo exchange. */
+	CCLQueue* q_exec;
+	CCLQueue* q_comm;
+	/* Double buffered strip, with halo rows. */
+	CCLBuffer* bufs[2];
+	/* Kernel instances, the first reads from bufs[0] and writes to
+	 * bufs[1], the second does the opposite. */
+	CCLKernel* krnls[2];
+	/* First grid row in strip and number of rows (without halos). */
+	size_t row0;
+	size_t rows;
+	/* Host staging rows for host halo exchange. */
+	cl_uchar* halo_host[2];
+	/* Events of boundary rows update in current step. */
+	CCLEvent* evt_top;
+	CCLEvent* evt_bot;
+	/* Last kernel event of current and of previous step. */
+	CCLEvent* evt_cur;
+	CCLEvent* evt_last;
+	/* Events which the next step must wait on. */
+	CCLEventWaitList ewl;
+} CAStrip;
+
+/* Grid partitioned across devices. */
+typedef struct ca_domain {
+	/* Grid dimensions. */
+	size_t width;
+	size_t height;
+	/* Strips, one per device. */
+	CAStrip* strips;
+	cl_uint num_strips;
+	/* Halo exchange mode. */
+	int xchg;
+	/* Current step. */
+	cl_uint step;
+} CADomain;
+
+/**
+ * Partition a grid in horizontal strips across the given devices, and
+ * upload the initial state.
+ * */
+static CADomain* ca_domain_new(CCLContext* ctx, CCLProgram* prg,
+	CCLDevice* const* devs, cl_uint num_devs, size_t width, size_t height,
+	const cl_uchar* grid, int xchg) {
+
+	CCLErr* err = NULL;
+	CADomain* dom = (CADomain*) malloc(sizeof(CADomain));
+	cl_uchar* strip_host;
+	cl_uint width_arg = (cl_uint) width;
+	size_t row = 0;
+
+	dom->width = width;
+	dom->height = height;
+	dom->num_strips = num_devs;
+	dom->xchg = xchg;
+	dom->step = 0;
+	dom->strips = (CAStrip*) calloc(num_devs, sizeof(CAStrip));
+
+	for (cl_uint d = 0; d < num_devs; ++d) {
+
+		CAStrip* s = &dom->strips[d];
+
+		/* Distribute rows as evenly as possible. */
+		s->row0 = row;
+		s->rows = height / num_devs + (d < height % num_devs ? 1 : 0);
+		row += s->rows;
+
+		/* Create queues. */
+		s->q_exec = ccl_queue_new(ctx, devs[d], 0, &err);
+		HANDLE_ERROR(err);
+		s->q_comm = ccl_queue_new(ctx, devs[d], 0, &err);
+		HANDLE_ERROR(err);
+
+		/* Prepare strip with halos in host, wrapping around vertically. */
+		strip_host = (cl_uchar*) malloc((s->rows + 2) * width);
+		for (size_t r = 0; r < s->rows + 2; ++r) {
+			size_t grid_row = (s->row0 + height + r - 1) % height;
+			memcpy(strip_host + r * width, grid + grid_row * width, width);
+		}
+
+		/* Create device buffers, the first with the initial state. */
+		s->bufs[0] = ccl_buffer_new(ctx,
+			CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+			(s->rows + 2) * width, strip_host, &err);
+		HANDLE_ERROR(err);
+		s->bufs[1] = ccl_buffer_new(ctx, CL_MEM_READ_WRITE,
+			(s->rows + 2) * width, NULL, &err);
+		HANDLE_ERROR(err);
+		free(strip_host);
+
+		/* Create kernel instances and set their arguments once. */
+		for (cl_uint k = 0; k < 2; ++k) {
+			s->krnls[k] = ccl_kernel_new(prg, "gol", &err);
+			HANDLE_ERROR(err);
+			ccl_kernel_set_args(s->krnls[k], s->bufs[k], s->bufs[1 - k],
+				ccl_arg_priv(width_arg, cl_uint), NULL);
+		}
+
+		/* Host staging rows. */
+		s->halo_host[0] = (cl_uchar*) malloc(width);
+		s->halo_host[1] = (cl_uchar*) malloc(width);
+
+	}
+
+	return dom;
+}
+
+/**
+ * Enqueue update of `nrows` strip rows starting at strip row `y0`.
+ * */
+static CCLEvent* ca_strip_update(CADomain* dom, CAStrip* s,
+	size_t y0, size_t nrows, CCLEventWaitList* ewl) {
+
+	CCLErr* err = NULL;
+	CCLEvent* evt;
+	size_t gwo[2] = { 0, y0 };
+	size_t gws[2] = { dom->width, nrows };
+
+	evt = ccl_kernel_enqueue_ndrange(s->krnls[dom->step % 2], s->q_exec,
+		2, gwo, gws, NULL, ewl, &err);
+	HANDLE_ERROR(err);
+
+	return evt;
+}
+
+/**
+ * Enqueue transfer of row `src_row` of the output buffer of strip `src`
+ * into row `dst_row` of the output buffer of strip `dst`. The transfer
+ * waits for the source row to be updated and for the previous step of the
+ * destination strip, which reads the buffer being written, to finish.
+ * */
+static CCLEvent* ca_halo_send(CADomain* dom, CAStrip* src, size_t src_row,
+	CAStrip* dst, size_t dst_row, CCLEvent* evt_src, cl_uint slot) {
+
+	CCLErr* err = NULL;
+	CCLEventWaitList ewl = NULL;
+	CCLEvent* evt;
+	CCLBuffer* buf_src = src->bufs[1 - dom->step % 2];
+	CCLBuffer* buf_dst = dst->bufs[1 - dom->step % 2];
+	size_t src_origin[3] = { 0, src_row, 0 };
+	size_t dst_origin[3] = { 0, dst_row, 0 };
+	size_t host_origin[3] = { 0, 0, 0 };
+	size_t region[3] = { dom->width, 1, 1 };
+
+	ccl_event_wait_list_add(&ewl, evt_src, NULL);
+	if (dst->evt_last != NULL)
+		ccl_event_wait_list_add(&ewl, dst->evt_last, NULL);
+
+	if (dom->xchg == CA_XCHG_COPY) {
+
+		/* Copy directly between buffers. */
+		evt = ccl_buffer_enqueue_copy_rect(buf_src, buf_dst, src->q_comm,
+			src_origin, dst_origin, region, dom->width, 0, dom->width, 0,
+			&ewl, &err);
+		HANDLE_ERROR(err);
+
+	} else {
+
+		/* Copy through host memory. */
+		ccl_buffer_enqueue_read_rect(buf_src, src->q_comm, CL_FALSE,
+			src_origin, host_origin, region, dom->width, 0, dom->width, 0,
+			src->halo_host[slot], &ewl, &err);
+		HANDLE_ERROR(err);
+		evt = ccl_buffer_enqueue_write_rect(buf_dst, src->q_comm, CL_FALSE,
+			dst_origin, host_origin, region, dom->width, 0, dom->width, 0,
+			src->halo_host[slot], NULL, &err);
+		HANDLE_ERROR(err);
+
+	}
+
+	return evt;
+}
+
+/**
+ * Enqueue one simulation step in all devices.
+ * */
+static void ca_domain_step(CADomain* dom) {
+
+	CCLErr* err = NULL;
+	cl_uint n = dom->num_strips;
+
+	/* Update boundary rows first, then interior rows. */
+	for (cl_uint d = 0; d < n; ++d) {
+
+		CAStrip* s = &dom->strips[d];
+
+		s->evt_top = ca_strip_update(dom, s, 1, 1, &s->ewl);
+		s->evt_bot = (s->rows > 1)
+			? ca_strip_update(dom, s, s->rows, 1, NULL) : s->evt_top;
+		s->evt_cur = (s->rows > 2)
+			? ca_strip_update(dom, s, 2, s->rows - 2, NULL) : s->evt_bot;
+
+		ccl_queue_flush(s->q_exec, &err);
+		HANDLE_ERROR(err);
+	}
+
+	/* Send boundary rows to neighbors while interior is updated. */
+	for (cl_uint d = 0; d < n; ++d) {
+
+		CAStrip* s = &dom->strips[d];
+		CAStrip* up = &dom->strips[(d + n - 1) % n];
+		CAStrip* down = &dom->strips[(d + 1) % n];
+		CCLEvent* evt_up;
+		CCLEvent* evt_down;
+
+		/* Top row goes to the bottom halo of the strip above, bottom
+		 * row goes to the top halo of the strip below. */
+		evt_up = ca_halo_send(dom, s, 1, up, up->rows + 1, s->evt_top, 0);
+		evt_down = ca_halo_send(dom, s, s->rows, down, 0, s->evt_bot, 1);
+
+		/* Next step in destination strips must wait for their halos, and
+		 * next step in this strip must wait for the rows to be read. */
+		ccl_event_wait_list_add(&s->ewl, evt_up, evt_down, NULL);
+		ccl_event_wait_list_add(&up->ewl, evt_up, NULL);
+		ccl_event_wait_list_add(&down->ewl, evt_down, NULL);
+
+		ccl_queue_flush(s->q_comm, &err);
+		HANDLE_ERROR(err);
+	}
+
+	/* Current step becomes previous step. */
+	for (cl_uint d = 0; d < n; ++d)
+		dom->strips[d].evt_last = dom->strips[d].evt_cur;
+
+	dom->step++;
+}
+
+/**
+ * Wait for all enqueued steps to finish.
+ * */
+static void ca_domain_finish(CADomain* dom) {
+
+	CCLErr* err = NULL;
+
+	for (cl_uint d = 0; d < dom->num_strips; ++d) {
+		ccl_queue_finish(dom->strips[d].q_exec, &err);
+		HANDLE_ERROR(err);
+		ccl_queue_finish(dom->strips[d].q_comm, &err);
+		HANDLE_ERROR(err);
+	}
+}
+
+/**
+ * Read current state of all strips into a host grid.
+ * */
+static void ca_domain_gather(CADomain* dom, cl_uchar* grid) {
+
+	CCLErr* err = NULL;
+
+	ca_domain_finish(dom);
+
+	for (cl_uint d = 0; d < dom->num_strips; ++d) {
+
+		CAStrip* s = &dom->strips[d];
+		size_t buf_origin[3] = { 0, 1, 0 };
+		size_t host_origin[3] = { 0, s->row0, 0 };
+		size_t region[3] = { dom->width, s->rows, 1 };
+
+		ccl_buffer_enqueue_read_rect(s->bufs[dom->step % 2], s->q_comm,
+			CL_TRUE, buf_origin, host_origin, region, dom->width, 0,
+			dom->width, 0, grid, NULL, &err);
+		HANDLE_ERROR(err);
+	}
+}
+
+/**
+ * Release a partitioned grid.
+ * */
+static void ca_domain_destroy(CADomain* dom) {
+
+	for (cl_uint d = 0; d < dom->num_strips; ++d) {
+		CAStrip* s = &dom->strips[d];
+		ccl_event_wait_list_clear(&s->ewl);
+		ccl_kernel_destroy(s->krnls[0]);
+		ccl_kernel_destroy(s->krnls[1]);
+		ccl_buffer_destroy(s->bufs[0]);
+		ccl_buffer_destroy(s->bufs[1]);
+		ccl_queue_destroy(s->q_exec);
+		ccl_queue_destroy(s->q_comm);
+		free(s->halo_host[0]);
+		free(s->halo_host[1]);
+	}
+	free(dom->strips);
+	free(dom);
+}
+
+/**
+ * Reference host implementation, grid wraps around in both dimensions.
+ * */
+static void ca_host(cl_uchar* grid, size_t width, size_t height,
+	cl_uint iters) {
+
+	cl_uchar* next = (cl_uchar*) malloc(width * height);
+
+	for (cl_uint i = 0; i < iters; ++i) {
+		for (size_t y = 0; y < height; ++y) {
+			for (size_t x = 0; x < width; ++x) {
+				cl_uint alive = 0;
+				for (int dy = -1; dy <= 1; ++dy) {
+					for (int dx = -1; dx <= 1; ++dx) {
+						size_t ny = (y + height + dy) % height;
+						size_t nx = (x + width + dx) % width;
+						if ((dx != 0) || (dy != 0))
+							alive += grid[ny * width + nx];
+					}
+				}
+				next[y * width + x] = (alive == 3)
+					|| (grid[y * width + x] && (alive == 2));
+			}
+		}
+		memcpy(grid, next, width * height);
+	}
+
+	free(next);
+}
+
+/**
+ * Multi-device cellular automata main function.
+ * */
+int main(int argc, char* argv[]) {
+
+	/* Wrappers for OpenCL objects. */
+	CCLContext* ctx;
+	CCLContext* ctx_parent = NULL;
+	CCLProgram* prg;
+	CCLDevice* const* devs;
+	/* Partitioned grid. */
+	CADomain* dom;
+	/* Error handling object (must be NULL). */
+	CCLErr* err = NULL;
+	/* Command line options. */
+	const char* mode = "all";
+	cl_uint num_subdevs = 0;
+	size_t width = CA_WIDTH, height = CA_HEIGHT;
+	cl_uint iters = CA_ITERS;
+	int xchg = CA_XCHG_COPY;
+	/* Number of devices in context. */
+	cl_uint num_devs;
+	/* Initial, reference and simulated grids. */
+	cl_uchar* grid;
+	cl_uchar* grid_ref;
+	cl_uchar* grid_out;
+	/* Timing. */
+	GTimer* timer;
+	double elapsed, elapsed_one = 0;
+	/* Number of wrong results. */
+	cl_uint num_wrong = 0;
+
+	/* Check arguments. */
+	if (argc >= 2) mode = argv[1];
+	if (argc >= 3) num_subdevs = atoi(argv[2]);
+	if (argc >= 4) width = atoi(argv[3]);
+	if (argc >= 5) height = atoi(argv[4]);
+	if (argc >= 6) iters = atoi(argv[5]);
+	if (argc >= 7) xchg = strcmp(argv[6], "host") == 0
+		? CA_XCHG_HOST : CA_XCHG_COPY;
+	if ((width < 3) || (height < 3))
+		ERROR_MSG_AND_EXIT("Usage: ca_multi [all|gpu|cpu] [num_subdevices] " \
+			"[width] [height] [iterations] [copy|host]");
+
+	/* Create context with the requested devices. */
+	if (strcmp(mode, "cpu") == 0) {
+
+#ifdef CL_VERSION_1_2
+
+		CCLDevice* dev;
+		CCLDevice* const* subdevs;
+		cl_uint num_cu;
+		cl_device_partition_property props[3];
+
+		/* Get first CPU device. */
+		ctx_parent = ccl_context_new_cpu(&err);
+		HANDLE_ERROR(err);
+		dev = ccl_context_get_device(ctx_parent, 0, &err);
+		HANDLE_ERROR(err);
+
+		/* Split it in equally sized sub-devices. */
+		num_cu = ccl_device_get_info_scalar(
+			dev, CL_DEVICE_MAX_COMPUTE_UNITS, cl_uint, &err);
+		HANDLE_ERROR(err);
+		if (num_subdevs == 0)
+			num_subdevs = num_cu < CA_MAX_SUBDEVS ? num_cu : CA_MAX_SUBDEVS;
+		if (num_subdevs > num_cu) num_subdevs = num_cu;
+		props[0] = CL_DEVICE_PARTITION_EQUALLY;
+		props[1] = num_cu / num_subdevs;
+		props[2] = 0;
+		subdevs = ccl_device_create_subdevices(dev, props, &num_devs, &err);
+		HANDLE_ERROR(err);
+
+		/* Create context with sub-devices. */
+		ctx = ccl_context_new_from_devices(num_devs, subdevs, &err);
+		HANDLE_ERROR(err);
+
+#else
+
+		ERROR_MSG_AND_EXIT("Sub-devices require OpenCL >= 1.2.");
+
+#endif
+
+	} else if (strcmp(mode, "gpu") == 0) {
+		ctx = ccl_context_new_gpu(&err);
+		HANDLE_ERROR(err);
+	} else {
+		ctx = ccl_context_new_any(&err);
+		HANDLE_ERROR(err);
+	}
+
+	/* Get devices in context. */
+	num_devs = ccl_context_get_num_devices(ctx, &err);
+	HANDLE_ERROR(err);
+	devs = ccl_context_get_all_devices(ctx, &err);
+	HANDLE_ERROR(err);
+
+	/* Create program from kernel source and build it for all devices. */
+	prg = ccl_program_new_from_source(ctx, CA_KERNEL, &err);
+	HANDLE_ERROR(err);
+	ccl_program_build(prg, NULL, &err);
+	HANDLE_ERROR(err);
+
+	/* Create random initial state and host reference. */
+	srand(0);
+	grid = (cl_uchar*) malloc(width * height);
+	grid_ref = (cl_uchar*) malloc(width * height);
+	grid_out = (cl_uchar*) malloc(width * height);
+	for (size_t i = 0; i < width * height; ++i)
+		grid[i] = (rand() & 0x3) ? 0 : 1;
+	memcpy(grid_ref, grid, width * height);
+	ca_host(grid_ref, width, height, iters);
+
+	printf("\n * Grid size: %d x %d, %d iterations, %s halo exchange\n",
+		(int) width, (int) height, (int) iters,
+		xchg == CA_XCHG_COPY ? "device copy" : "host");
+	printf(" * Devices in context: %d\n\n", num_devs);
+	printf(" Devices |  Time (s) | Speedup | Efficiency | Result\n");
+	printf(" --------|-----------|---------|------------|-------\n");
+
+	/* Scaling benchmark, from one device to all devices. */
+	timer = g_timer_new();
+	for (cl_uint n = 1; (n <= num_devs) && (n <= height); ++n) {
+
+		int ok;
+
+		/* Partition grid across first n devices. */
+		dom = ca_domain_new(ctx, prg, devs, n, width, height, grid, xchg);
+		ca_domain_finish(dom);
+
+		/* Run simulation. */
+		g_timer_start(timer);
+		for (cl_uint i = 0; i < iters; ++i)
+			ca_domain_step(dom);
+		ca_domain_finish(dom);
+		g_timer_stop(timer);
+		elapsed = g_timer_elapsed(timer, NULL);
+		if (n == 1) elapsed_one = elapsed;
+
+		/* Check results. */
+		ca_domain_gather(dom, grid_out);
+		ok = memcmp(grid_out, grid_ref, width * height) == 0;
+		if (!ok) num_wrong++;
+
+		printf(" %7d | %9.4f | %7.2f | %9.1f%% | %s\n", n, elapsed,
+			elapsed_one / elapsed, 100 * elapsed_one / (elapsed * n),
+			ok ? "OK" : "WRONG");
+
+		ca_domain_destroy(dom);
+	}
+
+	/* Give feedback. */
+	if (num_wrong == 0) {
+		printf("\n * All decompositions produced the expected results.\n\n");
+	} else {
+		printf("\n * %d decomposition(s) produced wrong results.\n\n",
+			num_wrong);
+	}
+
+	/* Release host resources. */
+	g_timer_destroy(timer);
+	free(grid);
+	free(grid_ref);
+	free(grid_out);
+
+	/* Release wrappers. */
+	ccl_program_destroy(prg);
+	ccl_context_destroy(ctx);
+	if (ctx_parent != NULL) ccl_context_destroy(ctx_parent);
+
+	/* Check all wrappers have been destroyed. */
+	assert(ccl_wrapper_memcheck());
+
+	/* Terminate. */
+	return num_wrong == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+}
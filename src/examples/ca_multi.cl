@@ -0,0 +1,64 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cf4ocl.  If not, see <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ * File containing a buffer-based cellular automata kernel for grids split
+ * in horizontal strips.
+ *
+ * @copyright [GNU General Public License version 3 (GPLv3)](http://www.gnu.org/licenses/gpl.html)
+ */
+
+/*
+ * This is the OpenCL kernel for the multi-device cellular automata example
+ * ca_multi.c.
+ *
+ * Each device holds a horizontal strip of the grid, with one halo row above
+ * and one below, i.e. strip row 0 and strip row (rows + 1) are copies of the
+ * neighboring strips' boundary rows. The kernel is launched with a global
+ * work offset in the second dimension, so that the boundary rows and the
+ * interior rows of a strip can be updated by separate launches. Cells are
+ * 0 (dead) or 1 (alive), and the grid wraps around horizontally.
+ */
+
+/**
+ * Kernel which performs one GOL step in a strip.
+ *
+ * @param[in] in Input strip, including halo rows.
+ * @param[out] out Output strip, including halo rows (not written).
+ * @param[in] width Grid width.
+ * */
+__kernel void gol(__global const uchar* in, __global uchar* out, uint width) {
+
+	uint x = get_global_id(0);
+	uint y = get_global_id(1);
+
+	if (x < width) {
+
+		uint xl = (x == 0) ? width - 1 : x - 1;
+		uint xr = (x == width - 1) ? 0 : x + 1;
+		__global const uchar* up = in + (y - 1) * width;
+		__global const uchar* mid = in + y * width;
+		__global const uchar* down = in + (y + 1) * width;
+
+		uint neighs_alive = up[xl] + up[x] + up[xr] + mid[xl] + mid[xr]
+			+ down[xl] + down[x] + down[xr];
+
+		out[y * width + x] =
+			(neighs_alive == 3) || (mid[x] && (neighs_alive == 2));
+	}
+}
@@ -0,0 +1,505 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cf4ocl. If not, see <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ * Out-of-core streaming version of the canonical example.
+ *
+ * @copyright [GNU General Public License version 3 (GPLv3)](http://www.gnu.org/licenses/gpl.html)
+ * */
+
+/*
+ * Description
+ * -----------
+ *
+ * Streaming version of the canonical example, for datasets which do not fit
+ * in device memory. The dataset is processed in tiles, using a fixed set of
+ * three device buffer pairs (triple buffering). Tiles are read from a
+ * source (a generator callback, a host array or a file), uploaded,
+ * processed by the `sum_tile` kernel, downloaded and given to a sink (a
+ * verification callback or a file).
+ *
+ * Uploads, kernel executions and downloads are performed in three separate
+ * command queues, such that the upload of tile _i_, the execution of tile
+ * _i - 1_ and the download of tile _i - 2_ can overlap, while the host
+ * fills the next tile. Each tile slot is only reused after its previous
+ * download is complete (back-pressure), so the number of tiles in flight
+ * never exceeds the number of slots. Host staging memory is pinned, i.e.
+ * allocated by the OpenCL implementation with `CL_MEM_ALLOC_HOST_PTR`.
+ *
+ * The sustained throughput is reported at the end.
+ *
+ * Optional command-line arguments:
+ *
+ * 1. Device index
+ * 2. Total number of elements (default 32M)
+ * 3. Number of elements per tile (default 1M)
+ * 4. Source: `gen` (default), `array` or path to a file of 32-bit
+ *    unsigned integers
+ * 5. Path to output file (if not given, results are verified)
+ *
+ * */
+
+#include <cf4ocl2.h>
+#include <assert.h>
+#include <string.h>
+
+/* Kernel source string, will be hardwired in this location during the build
+ * process, before compilation. The kernel source is available in
+ * canon_stream.cl. */
+#define KERNEL_SRC \
+@canon_stream_KERNEL_SRC@
+
+/* Kernel name. */
+#define KERNEL_NAME "sum_tile"
+
+/* Default total number of elements and tile size. */
+#define DEF_TOTAL_N (32 * 1024 * 1024)
+#define DEF_TILE_N (1024 * 1024)
+
+/* Number of tile slots (triple buffering). */
+#define NUM_SLOTS 3
+
+/* Constant to sum. */
+#define CONST_D 5
+
+/* Error handling macros. */
+#define ERROR_MSG_AND_EXIT(msg) \
+	do { fprintf(stderr, "\n%s\n", msg); exit(EXIT_FAILURE); } while(0)
+
+#define HANDLE_ERROR(err) \
+	if (err != NULL) { ERROR_MSG_AND_EXIT(err->message); }
+
+/* Source of tiles: fills `tile` with `n` elements starting at `offset`,
+ * returns number of elements actually read. */
+typedef size_t (*stream_source)(
+	void* data, size_t offset, size_t n, cl_uint* tile);
+
+/* Sink of tiles: consumes `n` result elements starting at `offset`. */
+typedef void (*stream_sink)(
+	void* data, size_t offset, size_t n, const cl_uint* tile);
+
+/* A tile slot: device buffers, pinned host staging and in-flight state.
+ * The pinned buffers are mapped during the whole run and only their host
+ * pointers are used in transfers. */
+typedef struct stream_slot {
+	/* Device buffers. */
+	CCLBuffer* a_dev;
+	CCLBuffer* c_dev;
+	/* Pinned buffers and their mapped host pointers. */
+	CCLBuffer* a_pin;
+	CCLBuffer* c_pin;
+	cl_uint* a_host;
+	cl_uint* c_host;
+	/* Tile in slot, if any. */
+	size_t offset;
+	size_t n;
+	/* Download event of tile in slot, NULL if slot is free. */
+	CCLEvent* evt_read;
+} StreamSlot;
+
+/* Generate input element for a given position. */
+static cl_uint gen_value(size_t i) {
+	return (cl_uint) ((i * 2654435761u) >> 8);
+}
+
+/* Generator callback source, `data` points to the total number of
+ * elements. */
+static size_t source_gen(void* data, size_t offset, size_t n,
+	cl_uint* tile) {
+
+	size_t total = *((size_t*) data);
+	if (offset + n > total) n = total - offset;
+	for (size_t i = 0; i < n; ++i)
+		tile[i] = gen_value(offset + i);
+	return n;
+}
+
+/* Host array source, `data` is a structure with the array and its size. */
+typedef struct {
+	cl_uint* array;
+	size_t n;
+} SourceArray;
+
+static size_t source_array(void* data, size_t offset, size_t n,
+	cl_uint* tile) {
+
+	SourceArray* src = (SourceArray*) data;
+	if (offset + n > src->n) n = src->n - offset;
+	memcpy(tile, src->array + offset, n * sizeof(cl_uint));
+	return n;
+}
+
+/* File source, `data` is the file handle. */
+static size_t source_file(void* data, size_t offset, size_t n,
+	cl_uint* tile) {
+
+	(void) offset;
+	return fread(tile, sizeof(cl_uint), n, (FILE*) data);
+}
+
+/* Verification sink, `data` points to the number of wrong elements. */
+static void sink_verify(void* data, size_t offset, size_t n,
+	const cl_uint* tile) {
+
+	size_t* wrong = (size_t*) data;
+	for (size_t i = 0; i < n; ++i) {
+		cl_uint expected = gen_value(offset + i)
+			+ (cl_uint) (offset + i) + CONST_D;
+		if (tile[i] != expected) (*wrong)++;
+	}
+}
+
+/* File sink, `data` is the file handle. */
+static void sink_file(void* data, size_t offset, size_t n,
+	const cl_uint* tile) {
+
+	(void) offset;
+	if (fwrite(tile, sizeof(cl_uint), n, (FILE*) data) != n)
+		ERROR_MSG_AND_EXIT("Unable to write to output file.");
+}
+
+/* Wait for the tile in a slot to be downloaded and hand it to the sink. */
+static void slot_drain(StreamSlot* slot, stream_sink sink, void* sink_data) {
+
+	CCLErr* err = NULL;
+	CCLEventWaitList ewl = NULL;
+
+	if (slot->evt_read != NULL) {
+		ccl_event_wait(ccl_ewl(&ewl, slot->evt_read, NULL), &err);
+		HANDLE_ERROR(err);
+		sink(sink_data, slot->offset, slot->n, slot->c_host);
+		slot->evt_read = NULL;
+	}
+}
+
+/**
+ * Streaming example main function.
+ * */
+int main(int argc, char** argv) {
+
+	/* Dataset and tile sizes. */
+	size_t total_n = DEF_TOTAL_N;
+	size_t tile_n = DEF_TILE_N;
+
+	/* Device selected specified in the command line. */
+	int dev_idx = -1;
+
+	/* Source and sink. */
+	const char* src_name = "gen";
+	const char* out_path = NULL;
+	stream_source source;
+	void* source_data;
+	stream_sink sink;
+	void* sink_data;
+	SourceArray src_array = { NULL, 0 };
+	FILE* fin = NULL;
+	FILE* fout = NULL;
+	size_t num_wrong = 0;
+
+	/* Wrappers. */
+	CCLContext* ctx = NULL;
+	CCLProgram* prg = NULL;
+	CCLDevice* dev = NULL;
+	CCLQueue* q_up = NULL;
+	CCLQueue* q_exec = NULL;
+	CCLQueue* q_down = NULL;
+	CCLKernel* krnl = NULL;
+	CCLEvent* evt_write;
+	CCLEvent* evt_exec;
+	CCLEventWaitList ewl = NULL;
+
+	/* Tile slots. */
+	StreamSlot slots[NUM_SLOTS];
+
+	/* Global and local worksizes. */
+	size_t gws = 0;
+	size_t lws = 0;
+
+	/* Device memory information. */
+	cl_ulong glob_mem, max_alloc;
+
+	/* Streaming state. */
+	size_t offset = 0, tile_count = 0, processed = 0;
+	cl_uint d = CONST_D;
+
+	/* Timing. */
+	GTimer* timer;
+	double elapsed;
+
+	/* Error reporting object. */
+	CCLErr* err = NULL;
+
+	/* Program return value. */
+	int ret_val;
+
+	/* Parse command-line arguments. */
+	if (argc >= 2) dev_idx = atoi(argv[1]);
+	if (argc >= 3) total_n = (size_t) atol(argv[2]);
+	if (argc >= 4) tile_n = (size_t) atol(argv[3]);
+	if (argc >= 5) src_name = argv[4];
+	if (argc >= 6) out_path = argv[5];
+	if ((total_n == 0) || (tile_n == 0))
+		ERROR_MSG_AND_EXIT("Usage: canon_stream [device_index] " \
+			"[total_elements] [tile_elements] [gen|array|file] [out_file]");
+
+	/* Setup source. */
+	if (strcmp(src_name, "gen") == 0) {
+		source = source_gen;
+		source_data = &total_n;
+	} else if (strcmp(src_name, "array") == 0) {
+		src_array.n = total_n;
+		src_array.array = (cl_uint*) malloc(total_n * sizeof(cl_uint));
+		if (src_array.array == NULL)
+			ERROR_MSG_AND_EXIT("Unable to allocate source array.");
+		for (size_t i = 0; i < total_n; ++i)
+			src_array.array[i] = gen_value(i);
+		source = source_array;
+		source_data = &src_array;
+	} else {
+		fin = fopen(src_name, "rb");
+		if (fin == NULL) ERROR_MSG_AND_EXIT("Unable to open input file.");
+		source = source_file;
+		source_data = fin;
+	}
+
+	/* Setup sink. */
+	if (out_path != NULL) {
+		fout = fopen(out_path, "wb");
+		if (fout == NULL) ERROR_MSG_AND_EXIT("Unable to open output file.");
+		sink = sink_file;
+		sink_data = fout;
+	} else {
+		sink = sink_verify;
+		sink_data = &num_wrong;
+	}
+
+	/* Create a context with device selected from menu. */
+	ctx = ccl_context_new_from_menu_full(&dev_idx, &err);
+	HANDLE_ERROR(err);
+
+	/* Get the selected device. */
+	dev = ccl_context_get_device(ctx, 0, &err);
+	HANDLE_ERROR(err);
+
+	/* Make sure tiles fit in a single allocation. */
+	glob_mem = ccl_device_get_info_scalar(
+		dev, CL_DEVICE_GLOBAL_MEM_SIZE, cl_ulong, &err);
+	HANDLE_ERROR(err);
+	max_alloc = ccl_device_get_info_scalar(
+		dev, CL_DEVICE_MAX_MEM_ALLOC_SIZE, cl_ulong, &err);
+	HANDLE_ERROR(err);
+	if (tile_n * sizeof(cl_uint) > max_alloc)
+		tile_n = (size_t) (max_alloc / sizeof(cl_uint));
+
+	/* Create and build program. */
+	prg = ccl_program_new_from_source(ctx, KERNEL_SRC, &err);
+	HANDLE_ERROR(err);
+	ccl_program_build(prg, NULL, &err);
+	HANDLE_ERROR(err);
+
+	/* Create upload, execution and download queues. */
+	q_up = ccl_queue_new(ctx, dev, 0, &err);
+	HANDLE_ERROR(err);
+	q_exec = ccl_queue_new(ctx, dev, 0, &err);
+	HANDLE_ERROR(err);
+	q_down = ccl_queue_new(ctx, dev, 0, &err);
+	HANDLE_ERROR(err);
+
+	/* Get kernel object. */
+	krnl = ccl_program_get_kernel(prg, KERNEL_NAME, &err);
+	HANDLE_ERROR(err);
+
+	/* Get worksizes for a full tile. */
+	ccl_kernel_suggest_worksizes(krnl, dev, 1, &tile_n, &gws, &lws, &err);
+	HANDLE_ERROR(err);
+
+	/* Create slots. */
+	for (cl_uint s = 0; s < NUM_SLOTS; ++s) {
+
+		slots[s].a_dev = ccl_buffer_new(ctx, CL_MEM_READ_ONLY,
+			tile_n * sizeof(cl_uint), NULL, &err);
+		HANDLE_ERROR(err);
+		slots[s].c_dev = ccl_buffer_new(ctx, CL_MEM_WRITE_ONLY,
+			tile_n * sizeof(cl_uint), NULL, &err);
+		HANDLE_ERROR(err);
+
+		/* Pinned staging buffers, mapped once for the whole run. */
+		slots[s].a_pin = ccl_buffer_new(ctx, CL_MEM_ALLOC_HOST_PTR,
+			tile_n * sizeof(cl_uint), NULL, &err);
+		HANDLE_ERROR(err);
+		slots[s].c_pin = ccl_buffer_new(ctx, CL_MEM_ALLOC_HOST_PTR,
+			tile_n * sizeof(cl_uint), NULL, &err);
+		HANDLE_ERROR(err);
+		slots[s].a_host = (cl_uint*) ccl_buffer_enqueue_map(slots[s].a_pin,
+			q_up, CL_TRUE, CL_MAP_WRITE, 0, tile_n * sizeof(cl_uint),
+			NULL, NULL, &err);
+		HANDLE_ERROR(err);
+		slots[s].c_host = (cl_uint*) ccl_buffer_enqueue_map(slots[s].c_pin,
+			q_down, CL_TRUE, CL_MAP_READ, 0, tile_n * sizeof(cl_uint),
+			NULL, NULL, &err);
+		HANDLE_ERROR(err);
+
+		slots[s].offset = 0;
+		slots[s].n = 0;
+		slots[s].evt_read = NULL;
+	}
+
+	/* Show setup. */
+	printf("\n");
+	printf(" * Dataset size    : %.1f MiB\n",
+		(double) (total_n * sizeof(cl_uint)) / (1024 * 1024));
+	printf(" * Device memory   : %.1f MiB\n",
+		(double) glob_mem / (1024 * 1024));
+	printf(" * Tile size       : %.1f MiB (%d slots)\n",
+		(double) (tile_n * sizeof(cl_uint)) / (1024 * 1024), NUM_SLOTS);
+	printf(" * Global worksize : %d\n", (int) gws);
+	printf(" * Local worksize  : %d\n", (int) lws);
+
+	/* Stream tiles through slots. */
+	timer = g_timer_new();
+	while (offset < total_n) {
+
+		StreamSlot* slot = &slots[tile_count % NUM_SLOTS];
+		size_t n;
+		cl_uint off_arg, n_arg;
+
+		/* Back-pressure: wait until slot is free, consuming its
+		 * previous tile. */
+		slot_drain(slot, sink, sink_data);
+
+		/* Fill slot from source, while device works on other slots. */
+		n = source(source_data, offset, MIN(tile_n, total_n - offset),
+			slot->a_host);
+		if (n == 0) break;
+		slot->offset = offset;
+		slot->n = n;
+
+		/* Upload tile. */
+		evt_write = ccl_buffer_enqueue_write(slot->a_dev, q_up, CL_FALSE,
+			0, n * sizeof(cl_uint), slot->a_host, NULL, &err);
+		HANDLE_ERROR(err);
+		ccl_queue_flush(q_up, &err);
+		HANDLE_ERROR(err);
+
+		/* Process tile. */
+		off_arg = (cl_uint) offset;
+		n_arg = (cl_uint) n;
+		evt_exec = ccl_kernel_set_args_and_enqueue_ndrange(krnl, q_exec, 1,
+			NULL, &gws, &lws, ccl_ewl(&ewl, evt_write, NULL), &err,
+			slot->a_dev, slot->c_dev, ccl_arg_priv(d, cl_uint),
+			ccl_arg_priv(off_arg, cl_uint), ccl_arg_priv(n_arg, cl_uint),
+			NULL);
+		HANDLE_ERROR(err);
+		ccl_queue_flush(q_exec, &err);
+		HANDLE_ERROR(err);
+
+		/* Download results. */
+		slot->evt_read = ccl_buffer_enqueue_read(slot->c_dev, q_down,
+			CL_FALSE, 0, n * sizeof(cl_uint), slot->c_host,
+			ccl_ewl(&ewl, evt_exec, NULL), &err);
+		HANDLE_ERROR(err);
+		ccl_queue_flush(q_down, &err);
+		HANDLE_ERROR(err);
+
+		offset += n;
+		processed += n;
+		tile_count++;
+
+		/* Periodically drain all slots, oldest first, and release the
+		 * events kept by the queues. */
+		if (tile_count % (16 * NUM_SLOTS) == 0) {
+			for (cl_uint s = 0; s < NUM_SLOTS; ++s)
+				slot_drain(&slots[(tile_count + s) % NUM_SLOTS],
+					sink, sink_data);
+			ccl_queue_gc(q_up);
+			ccl_queue_gc(q_exec);
+			ccl_queue_gc(q_down);
+		}
+	}
+
+	/* Drain remaining tiles, oldest first. */
+	for (cl_uint s = 0; s < NUM_SLOTS; ++s)
+		slot_drain(&slots[(tile_count + s) % NUM_SLOTS], sink, sink_data);
+	g_timer_stop(timer);
+	elapsed = g_timer_elapsed(timer, NULL);
+
+	/* Report sustained throughput. */
+	printf(" * Tiles processed : %d\n", (int) tile_count);
+	printf(" * Elapsed time    : %.4f s\n", elapsed);
+	printf(" * Throughput      : %.1f MiB/s (%.1f Melements/s)\n",
+		(double) (2 * processed * sizeof(cl_uint))
+			/ (1024 * 1024 * elapsed),
+		(double) processed / (1e6 * elapsed));
+
+	/* Check results (not available with OpenCL stub). */
+	if (processed != total_n) {
+		fprintf(stderr, " * Source provided only %d of %d elements.\n",
+			(int) processed, (int) total_n);
+		ret_val = EXIT_FAILURE;
+	} else if (out_path != NULL) {
+		fprintf(stdout, " * Results written to %s.\n", out_path);
+		ret_val = EXIT_SUCCESS;
+	} else if (num_wrong == 0) {
+		fprintf(stdout,
+			" * Kernel execution produced the expected results.\n");
+		ret_val = EXIT_SUCCESS;
+	} else {
+		fprintf(stderr,
+			" * Kernel execution failed to produce the expected results.\n");
+		ret_val = EXIT_FAILURE;
+	}
+
+	/* Destroy slots. */
+	for (cl_uint s = 0; s < NUM_SLOTS; ++s) {
+		ccl_buffer_enqueue_unmap(slots[s].a_pin, q_up, slots[s].a_host,
+			NULL, &err);
+		HANDLE_ERROR(err);
+		ccl_buffer_enqueue_unmap(slots[s].c_pin, q_down, slots[s].c_host,
+			NULL, &err);
+		HANDLE_ERROR(err);
+	}
+	ccl_queue_finish(q_up, &err);
+	HANDLE_ERROR(err);
+	ccl_queue_finish(q_down, &err);
+	HANDLE_ERROR(err);
+	for (cl_uint s = 0; s < NUM_SLOTS; ++s) {
+		ccl_buffer_destroy(slots[s].a_dev);
+		ccl_buffer_destroy(slots[s].c_dev);
+		ccl_buffer_destroy(slots[s].a_pin);
+		ccl_buffer_destroy(slots[s].c_pin);
+	}
+
+	/* Destroy host resources. */
+	g_timer_destroy(timer);
+	if (src_array.array != NULL) free(src_array.array);
+	if (fin != NULL) fclose(fin);
+	if (fout != NULL) fclose(fout);
+
+	/* Destroy wrappers. */
+	ccl_queue_destroy(q_up);
+	ccl_queue_destroy(q_exec);
+	ccl_queue_destroy(q_down);
+	ccl_program_destroy(prg);
+	ccl_context_destroy(ctx);
+
+	/* Confirm that memory allocated by wrappers has been properly freed. */
+	assert(ccl_wrapper_memcheck());
+
+	/* Bye. */
+	return ret_val;
+}
@@ -0,0 +1,51 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cf4ocl. If not, see <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ * File containing kernel for the out-of-core streaming example.
+ *
+ * @copyright [GNU General Public License version 3 (GPLv3)](http://www.gnu.org/licenses/gpl.html)
+ * */
+
+/*
+ * This is the OpenCL kernel for the streaming example canon_stream.c.
+ */
+
+/**
+ * Performs sum of a vector tile, of the global index of each element and
+ * of a constant. This is the same operation as in the canonical example,
+ * with the second vector replaced by the element position in the full
+ * dataset.
+ *
+ * @param[in] a Input tile.
+ * @param[out] c Output tile.
+ * @param[in] d Constant to sum.
+ * @param[in] offset Position of first tile element in the full dataset.
+ * @param[in] tile_size Number of elements in tile.
+ * */
+__kernel void sum_tile(__global const uint *a, __global uint *c, uint d,
+	uint offset, uint tile_size) {
+
+	/* Get global ID. */
+	uint gid = get_global_id(0);
+
+	/* Only perform sum if this workitem is within the size of the
+	 * tile. */
+	if (gid < tile_size)
+		c[gid] = a[gid] + offset + gid + d;
+}
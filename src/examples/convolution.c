@@ -0,0 +1,590 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cf4ocl.  If not, see <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ * Generic 2D convolution example, comparing naive, local-memory tiled
+ * and separable convolution kernels for increasing filter radii.
+ *
+ * @note Requires OpenCL >= 1.1.
+ *
+ * @copyright [GNU General Public License version 3 (GPLv3)](http://www.gnu.org/licenses/gpl.html)
+ */
+
+/*
+ * Description
+ * -----------
+ *
+ * Generalization of the image_filter example. Filter weights are given at
+ * run time, and the kernels in convolution.cl are specialized for each
+ * filter radius and data type by passing them as build options, so that
+ * loops over the filter are fully known to the OpenCL compiler.
+ *
+ * For each radius between 1 and the maximum radius, and for a separable
+ * (Gaussian) and a non-separable (disk) filter, the following variants
+ * are executed and timed:
+ *
+ * * naive     - every pixel in the neighborhood read from global memory;
+ * * tiled     - work-group tile plus halo loaded into local memory;
+ * * separable - two tiled 1D passes, used if the filter is separable;
+ * * img naive - naive kernel using image storage;
+ * * img tiled - tiled kernel using image storage.
+ *
+ * Image variants are only executed for float data and if the device
+ * supports single channel float images. All results are validated
+ * against the naive kernel.
+ *
+ * Usage:
+ *
+ *     convolution [device_index] [type] [size] [max_radius]
+ *
+ * where type is `float` (default) or `uchar`, size is the side of the
+ * square test image (default 1024) and max_radius is the largest filter
+ * radius to test (default 15).
+ *
+ * This example requires OpenCL >= 1.1.
+ *
+ * */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <cf4ocl2.h>
+
+/* Kernel source string, will be hardwired in this location during the build
+ * process, before compilation. The kernel source is available in
+ * convolution.cl. */
+#define CONV_KERNEL \
+@convolution_KERNEL_SRC@
+
+/* Error handling macros. */
+#define ERROR_MSG_AND_EXIT(msg) \
+	do { fprintf(stderr, "\n%s\n", msg); exit(EXIT_FAILURE); } while(0)
+
+#define HANDLE_ERROR(err) \
+	if (err != NULL) { ERROR_MSG_AND_EXIT(err->message); }
+
+/* Default settings. */
+#define CONV_SIZE 1024
+#define CONV_MAX_RADIUS 15
+#define CONV_REPS 5
+
+/* Number of kernel variants. */
+#define CONV_NVARS 5
+
+/* Number of test filters. */
+#define CONV_NFILTERS 2
+
+/* Test filter indexes. */
+#define CONV_GAUSS 0
+#define CONV_DISK 1
+
+/* Kernel variant indexes. */
+#define CONV_NAIVE 0
+#define CONV_TILED 1
+#define CONV_SEP 2
+#define CONV_NAIVE_IMG 3
+#define CONV_TILED_IMG 4
+
+/* Variant names. */
+static const char* var_names[CONV_NVARS] =
+	{ "naive", "tiled", "separable", "img naive", "img tiled" };
+
+/* Filter names. */
+static const char* filter_names[CONV_NFILTERS] = { "gauss", "disk" };
+
+/* Supported data types. */
+typedef struct conv_type {
+	const char* name;
+	const char* convert;
+	size_t size;
+	double tolerance;
+	int relative;
+} ConvType;
+
+/* Results are checked against the reference with a relative tolerance for
+ * floats, and within one unit (due to rounding) for integers. */
+static const ConvType conv_types[] = {
+	{ "float", "convert_float", sizeof(cl_float), 1e-3, 1 },
+	{ "uchar", "convert_uchar_sat_rte", sizeof(cl_uchar), 1.0, 0 }
+};
+
+/**
+ * Get the value of pixel `i` in a host image as a double.
+ * */
+static double pixel(const ConvType* t, const void* data, size_t i) {
+	return (t->size == sizeof(cl_float))
+		? (double) ((const cl_float*) data)[i]
+		: (double) ((const cl_uchar*) data)[i];
+}
+
+/**
+ * Build a Gaussian filter with the given radius, both in full 2D form and
+ * as the original 1D vector.
+ * */
+static void gaussian(cl_uint radius, cl_float* w2d, cl_float* w1d) {
+
+	cl_uint side = 2 * radius + 1;
+	double sigma = radius / 2.0 + 0.5;
+	double sum = 0;
+
+	for (cl_uint i = 0; i < side; ++i) {
+		double d = (double) i - radius;
+		w1d[i] = (cl_float) exp(-d * d / (2 * sigma * sigma));
+		sum += w1d[i];
+	}
+	for (cl_uint i = 0; i < side; ++i)
+		w1d[i] /= sum;
+	for (cl_uint j = 0; j < side; ++j)
+		for (cl_uint i = 0; i < side; ++i)
+			w2d[j * side + i] = w1d[j] * w1d[i];
+}
+
+/**
+ * Build a disk filter with the given radius, which averages the pixels
+ * within that distance of the center. Unlike the Gaussian filter, it is
+ * not separable, so only the 2D variants can apply it.
+ * */
+static void disk(cl_uint radius, cl_float* w2d) {
+
+	cl_uint side = 2 * radius + 1;
+	cl_uint count = 0;
+
+	for (cl_uint j = 0; j < side; ++j) {
+		for (cl_uint i = 0; i < side; ++i) {
+			double dx = (double) i - radius, dy = (double) j - radius;
+			int in = dx * dx + dy * dy <= (double) radius * radius;
+			w2d[j * side + i] = in ? 1.0f : 0.0f;
+			count += in;
+		}
+	}
+	for (cl_uint k = 0; k < side * side; ++k)
+		w2d[k] /= count;
+}
+
+/**
+ * Determine if a 2D filter is separable, i.e. if it can be written as the
+ * outer product of a column vector `wy` and a row vector `wx`. If so,
+ * `wx` and `wy` are filled in and 1 is returned.
+ * */
+static int separate(cl_uint radius, const cl_float* w2d,
+	cl_float* wx, cl_float* wy) {
+
+	cl_uint side = 2 * radius + 1;
+	cl_uint p = 0, q = 0;
+	double pivot = 0;
+
+	/* Use largest weight as pivot. */
+	for (cl_uint j = 0; j < side; ++j) {
+		for (cl_uint i = 0; i < side; ++i) {
+			if (fabs(w2d[j * side + i]) > fabs(pivot)) {
+				pivot = w2d[j * side + i];
+				p = j; q = i;
+			}
+		}
+	}
+	if (pivot == 0) return 0;
+
+	/* Column through pivot is wy, row through pivot scaled is wx. */
+	for (cl_uint k = 0; k < side; ++k) {
+		wy[k] = w2d[k * side + q];
+		wx[k] = (cl_float) (w2d[p * side + k] / pivot);
+	}
+
+	/* Check rank one. */
+	for (cl_uint j = 0; j < side; ++j)
+		for (cl_uint i = 0; i < side; ++i)
+			if (fabs(w2d[j * side + i] - wy[j] * wx[i]) > 1e-6)
+				return 0;
+
+	return 1;
+}
+
+/**
+ * Elapsed device time of an event, in milliseconds.
+ * */
+static double evt_ms(CCLEvent* evt) {
+
+	CCLErr* err = NULL;
+	cl_ulong t_start, t_end;
+
+	t_start = ccl_event_get_profiling_info_scalar(
+		evt, CL_PROFILING_COMMAND_START, cl_ulong, &err);
+	HANDLE_ERROR(err);
+	t_end = ccl_event_get_profiling_info_scalar(
+		evt, CL_PROFILING_COMMAND_END, cl_ulong, &err);
+	HANDLE_ERROR(err);
+
+	return (t_end - t_start) * 1e-6;
+}
+
+/**
+ * Convolution example main function.
+ * */
+int main(int argc, char* argv[]) {
+
+	/* Wrappers for OpenCL objects. */
+	CCLContext* ctx;
+	CCLDevice* dev;
+	CCLQueue* queue;
+	CCLProgram* prg = NULL;
+	CCLKernel* krnl;
+	CCLKernel* krnl2;
+	CCLBuffer* buf_in;
+	CCLBuffer* buf_out;
+	CCLBuffer* buf_tmp;
+	CCLBuffer* buf_w2d;
+	CCLBuffer* buf_wx;
+	CCLBuffer* buf_wy;
+	CCLImage* img_in = NULL;
+	CCLImage* img_out = NULL;
+	CCLEvent* evt;
+	CCLEvent* evt2;
+	/* Error handling object (must be NULL). */
+	CCLErr* err = NULL;
+	/* Selected device, may be given in command line. */
+	int dev_idx = -1;
+	/* Data type. */
+	const ConvType* t = &conv_types[0];
+	/* Image side and maximum filter radius. */
+	cl_uint size = CONV_SIZE, max_radius = CONV_MAX_RADIUS;
+	/* Host data. */
+	void* data_in;
+	void* data_ref;
+	void* data_out;
+	cl_float* w2d;
+	cl_float* w1d;
+	cl_float* wx;
+	cl_float* wy;
+	/* Image data related. */
+	cl_bool image_ok;
+	cl_image_format image_format = { CL_R, CL_FLOAT };
+	const cl_image_format* formats;
+	cl_uint num_formats;
+	size_t origin[3] = { 0, 0, 0 };
+	size_t region[3];
+	/* Work sizes. */
+	size_t tile[2] = { 16, 16 };
+	size_t gws[2];
+	size_t max_wg;
+	/* Build options. */
+	char opts[256];
+	/* Timings, in milliseconds. */
+	double times[CONV_NVARS];
+	/* Number of mismatches between variants and naive kernel. */
+	unsigned int mismatches = 0;
+
+	/* Check arguments. */
+	if (argc >= 2) dev_idx = atoi(argv[1]);
+	if (argc >= 3) {
+		t = NULL;
+		for (cl_uint i = 0; i < sizeof(conv_types) / sizeof(ConvType); ++i)
+			if (strcmp(argv[2], conv_types[i].name) == 0)
+				t = &conv_types[i];
+		if (t == NULL) ERROR_MSG_AND_EXIT("Type must be float or uchar.");
+	}
+	if (argc >= 4) size = atoi(argv[3]);
+	if (argc >= 5) max_radius = atoi(argv[4]);
+	if ((size == 0) || (max_radius == 0))
+		ERROR_MSG_AND_EXIT("Usage: convolution [device_index] [type] " \
+			"[size] [max_radius]");
+	region[0] = size; region[1] = size; region[2] = 1;
+
+	/* Create random input image. */
+	srand(0);
+	data_in = malloc(size * size * t->size);
+	data_ref = malloc(size * size * t->size);
+	data_out = malloc(size * size * t->size);
+	for (cl_uint i = 0; i < size * size; ++i) {
+		if (t->size == sizeof(cl_float))
+			((cl_float*) data_in)[i] = (cl_float) (rand() % 256);
+		else
+			((cl_uchar*) data_in)[i] = (cl_uchar) (rand() % 256);
+	}
+
+	/* Host filter storage for the largest radius. */
+	w2d = (cl_float*) malloc(
+		(2 * max_radius + 1) * (2 * max_radius + 1) * sizeof(cl_float));
+	w1d = (cl_float*) malloc((2 * max_radius + 1) * sizeof(cl_float));
+	wx = (cl_float*) malloc((2 * max_radius + 1) * sizeof(cl_float));
+	wy = (cl_float*) malloc((2 * max_radius + 1) * sizeof(cl_float));
+
+	/* Create context using device selected from menu. */
+	ctx = ccl_context_new_from_menu_full(&dev_idx, &err);
+	HANDLE_ERROR(err);
+
+	/* Get first device in context. */
+	dev = ccl_context_get_device(ctx, 0, &err);
+	HANDLE_ERROR(err);
+
+	/* Reduce tile size if device can't handle 16x16 work-groups. */
+	max_wg = ccl_device_get_info_scalar(
+		dev, CL_DEVICE_MAX_WORK_GROUP_SIZE, size_t, &err);
+	HANDLE_ERROR(err);
+	while (tile[0] * tile[1] > max_wg) {
+		tile[0] /= 2; tile[1] /= 2;
+	}
+	gws[0] = ((size + tile[0] - 1) / tile[0]) * tile[0];
+	gws[1] = ((size + tile[1] - 1) / tile[1]) * tile[1];
+
+	/* Check if image variants can be used. */
+	image_ok = ccl_device_get_info_scalar(
+		dev, CL_DEVICE_IMAGE_SUPPORT, cl_bool, &err);
+	HANDLE_ERROR(err);
+	if (image_ok && (t->size == sizeof(cl_float))) {
+		image_ok = CL_FALSE;
+		formats = ccl_context_get_supported_image_formats(ctx,
+			CL_MEM_READ_WRITE, CL_MEM_OBJECT_IMAGE2D, &num_formats, &err);
+		HANDLE_ERROR(err);
+		for (cl_uint i = 0; i < num_formats; ++i)
+			if ((formats[i].image_channel_order == CL_R)
+					&& (formats[i].image_channel_data_type == CL_FLOAT))
+				image_ok = CL_TRUE;
+	} else {
+		image_ok = CL_FALSE;
+	}
+
+	/* Create a profiling-enabled command queue. */
+	queue = ccl_queue_new(ctx, dev, CL_QUEUE_PROFILING_ENABLE, &err);
+	HANDLE_ERROR(err);
+
+	/* Create device buffers. */
+	buf_in = ccl_buffer_new(ctx, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+		size * size * t->size, data_in, &err);
+	HANDLE_ERROR(err);
+	buf_out = ccl_buffer_new(ctx, CL_MEM_WRITE_ONLY,
+		size * size * t->size, NULL, &err);
+	HANDLE_ERROR(err);
+	buf_tmp = ccl_buffer_new(ctx, CL_MEM_READ_WRITE,
+		size * size * sizeof(cl_float), NULL, &err);
+	HANDLE_ERROR(err);
+
+	/* Create device images, if supported. */
+	if (image_ok) {
+		img_in = ccl_image_new(ctx, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+			&image_format, data_in, &err,
+			"image_type", (cl_mem_object_type) CL_MEM_OBJECT_IMAGE2D,
+			"image_width", (size_t) size,
+			"image_height", (size_t) size,
+			NULL);
+		HANDLE_ERROR(err);
+		img_out = ccl_image_new(ctx, CL_MEM_WRITE_ONLY,
+			&image_format, NULL, &err,
+			"image_type", (cl_mem_object_type) CL_MEM_OBJECT_IMAGE2D,
+			"image_width", (size_t) size,
+			"image_height", (size_t) size,
+			NULL);
+		HANDLE_ERROR(err);
+	}
+
+	/* Show information to user. */
+	printf("\n * Image size: %u x %u, type %s\n", size, size, t->name);
+	printf(" * Global work-size: (%d, %d)\n", (int) gws[0], (int) gws[1]);
+	printf(" * Local work-size (tile): (%d, %d)\n",
+		(int) tile[0], (int) tile[1]);
+	printf(" * Image variants: %s\n\n", image_ok ? "yes" : "no");
+	printf(" Radius Filter");
+	for (cl_uint v = 0; v < CONV_NVARS; ++v)
+		printf(" | %9s", var_names[v]);
+	printf("  (ms, average of %d runs)\n", CONV_REPS);
+
+	/* Test each radius, with each filter. */
+	for (cl_uint c = 0; c < max_radius * CONV_NFILTERS; ++c) {
+
+		cl_uint r = c / CONV_NFILTERS + 1;
+		cl_uint f = c % CONV_NFILTERS;
+		cl_uint side = 2 * r + 1;
+		int separable;
+
+		/* Get filter weights at run time. */
+		if (f == CONV_GAUSS)
+			gaussian(r, w2d, w1d);
+		else
+			disk(r, w2d);
+		separable = separate(r, w2d, wx, wy);
+
+		/* Move weights to device. */
+		buf_w2d = ccl_buffer_new(ctx,
+			CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+			side * side * sizeof(cl_float), w2d, &err);
+		HANDLE_ERROR(err);
+		buf_wx = ccl_buffer_new(ctx, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+			side * sizeof(cl_float), wx, &err);
+		HANDLE_ERROR(err);
+		buf_wy = ccl_buffer_new(ctx, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+			side * sizeof(cl_float), wy, &err);
+		HANDLE_ERROR(err);
+
+		/* Build program specialized for this radius and type, once for
+		 * all filters. */
+		if (f == 0) {
+			snprintf(opts, sizeof(opts),
+				"-DRADIUS=%u -DT=%s -DCONVERT_T=%s -DTILE_W=%u -DTILE_H=%u",
+				r, t->name, t->convert, (cl_uint) tile[0], (cl_uint) tile[1]);
+			prg = ccl_program_new_from_source(ctx, CONV_KERNEL, &err);
+			HANDLE_ERROR(err);
+			ccl_program_build(prg, opts, &err);
+			HANDLE_ERROR(err);
+		}
+
+		printf(" %6u %6s", r, filter_names[f]);
+
+		for (cl_uint v = 0; v < CONV_NVARS; ++v) {
+
+			times[v] = 0;
+
+			/* Skip variants which are not applicable. */
+			if (((v == CONV_SEP) && !separable)
+					|| ((v >= CONV_NAIVE_IMG) && !image_ok)) {
+				printf(" | %9s", "n/a");
+				continue;
+			}
+
+			/* Run variant several times. */
+			for (cl_uint k = 0; k < CONV_REPS; ++k) {
+
+				evt2 = NULL;
+
+				if ((v == CONV_NAIVE) || (v == CONV_TILED)) {
+
+					krnl = ccl_program_get_kernel(prg,
+						v == CONV_NAIVE ? "conv_naive" : "conv_tiled", &err);
+					HANDLE_ERROR(err);
+					evt = ccl_kernel_set_args_and_enqueue_ndrange(
+						krnl, queue, 2, NULL, gws, tile, NULL, &err,
+						buf_in, buf_out, buf_w2d, ccl_arg_priv(size, cl_uint),
+						ccl_arg_priv(size, cl_uint), NULL);
+					HANDLE_ERROR(err);
+
+				} else if (v == CONV_SEP) {
+
+					krnl = ccl_program_get_kernel(prg, "conv_sep_rows", &err);
+					HANDLE_ERROR(err);
+					krnl2 = ccl_program_get_kernel(prg, "conv_sep_cols", &err);
+					HANDLE_ERROR(err);
+					evt = ccl_kernel_set_args_and_enqueue_ndrange(
+						krnl, queue, 2, NULL, gws, tile, NULL, &err,
+						buf_in, buf_tmp, buf_wx, ccl_arg_priv(size, cl_uint),
+						ccl_arg_priv(size, cl_uint), NULL);
+					HANDLE_ERROR(err);
+					evt2 = ccl_kernel_set_args_and_enqueue_ndrange(
+						krnl2, queue, 2, NULL, gws, tile, NULL, &err,
+						buf_tmp, buf_out, buf_wy, ccl_arg_priv(size, cl_uint),
+						ccl_arg_priv(size, cl_uint), NULL);
+					HANDLE_ERROR(err);
+
+				} else {
+
+					krnl = ccl_program_get_kernel(prg,
+						v == CONV_NAIVE_IMG ? "conv_naive_img" : "conv_tiled_img",
+						&err);
+					HANDLE_ERROR(err);
+					evt = ccl_kernel_set_args_and_enqueue_ndrange(
+						krnl, queue, 2, NULL, gws, tile, NULL, &err,
+						img_in, img_out, buf_w2d, NULL);
+					HANDLE_ERROR(err);
+
+				}
+
+				ccl_queue_finish(queue, &err);
+				HANDLE_ERROR(err);
+
+				times[v] += evt_ms(evt) + (evt2 != NULL ? evt_ms(evt2) : 0);
+			}
+			times[v] /= CONV_REPS;
+			printf(" | %9.3f", times[v]);
+			fflush(stdout);
+
+			/* Get results. */
+			if (v >= CONV_NAIVE_IMG) {
+				ccl_image_enqueue_read(img_out, queue, CL_TRUE, origin,
+					region, 0, 0, data_out, NULL, &err);
+			} else {
+				ccl_buffer_enqueue_read(buf_out, queue, CL_TRUE, 0,
+					size * size * t->size, data_out, NULL, &err);
+			}
+			HANDLE_ERROR(err);
+
+			/* Naive kernel is the reference, others are checked
+			 * against it. */
+			if (v == CONV_NAIVE) {
+				memcpy(data_ref, data_out, size * size * t->size);
+			} else {
+				for (cl_uint i = 0; i < size * size; ++i) {
+					double ref = pixel(t, data_ref, i);
+					double diff = fabs(ref - pixel(t, data_out, i));
+					double tol = t->relative
+						? t->tolerance * (fabs(ref) > 1 ? fabs(ref) : 1)
+						: t->tolerance;
+					if (diff > tol) {
+						mismatches++;
+						break;
+					}
+				}
+			}
+		}
+
+		if ((times[CONV_NAIVE] > 0) && (times[CONV_TILED] > 0))
+			printf("  (tiled speedup: %.2fx)",
+				times[CONV_NAIVE] / times[CONV_TILED]);
+		printf("\n");
+
+		/* Release filter and radius-specific wrappers and events. */
+		ccl_buffer_destroy(buf_w2d);
+		ccl_buffer_destroy(buf_wx);
+		ccl_buffer_destroy(buf_wy);
+		if (f == CONV_NFILTERS - 1) ccl_program_destroy(prg);
+		ccl_queue_gc(queue);
+	}
+
+	/* Give feedback. */
+	if (mismatches == 0) {
+		printf("\n * All kernel variants produced the same results.\n\n");
+	} else {
+		printf("\n * %u kernel variant(s) produced wrong results.\n\n",
+			mismatches);
+	}
+
+	/* Release host buffers. */
+	free(data_in);
+	free(data_ref);
+	free(data_out);
+	free(w2d);
+	free(w1d);
+	free(wx);
+	free(wy);
+
+	/* Release wrappers. */
+	if (image_ok) {
+		ccl_image_destroy(img_in);
+		ccl_image_destroy(img_out);
+	}
+	ccl_buffer_destroy(buf_in);
+	ccl_buffer_destroy(buf_out);
+	ccl_buffer_destroy(buf_tmp);
+	ccl_queue_destroy(queue);
+	ccl_context_destroy(ctx);
+
+	/* Check all wrappers have been destroyed. */
+	assert(ccl_wrapper_memcheck());
+
+	/* Terminate. */
+	return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+
+}
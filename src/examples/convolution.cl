@@ -0,0 +1,291 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cf4ocl.  If not, see <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ * File containing generic 2D convolution kernels.
+ *
+ * @copyright [GNU General Public License version 3 (GPLv3)](http://www.gnu.org/licenses/gpl.html)
+ */
+
+/*
+ * These are the OpenCL kernels for the convolution example convolution.c.
+ *
+ * The kernels are specialized at build time with the following macros,
+ * which are passed as compiler options by the host:
+ *
+ * RADIUS    - Filter radius, filter side is 2 * RADIUS + 1.
+ * T         - Storage type of buffer data (e.g. float, uchar).
+ * CONVERT_T - Function converting a float to T (e.g. convert_uchar_sat_rte).
+ * TILE_W    - Work-group width, must match the local work size.
+ * TILE_H    - Work-group height, must match the local work size.
+ *
+ * Filter weights are given at run time in constant memory. Pixels outside
+ * the image are clamped to the nearest edge pixel.
+ */
+
+#ifndef RADIUS
+#define RADIUS 1
+#endif
+
+#ifndef T
+#define T float
+#endif
+
+#ifndef CONVERT_T
+#define CONVERT_T convert_float
+#endif
+
+#ifndef TILE_W
+#define TILE_W 16
+#endif
+
+#ifndef TILE_H
+#define TILE_H 16
+#endif
+
+/* Filter side. */
+#define FSIDE (2 * RADIUS + 1)
+
+/* Tile side including halos. */
+#define HALO_W (TILE_W + 2 * RADIUS)
+#define HALO_H (TILE_H + 2 * RADIUS)
+
+/* Fetch a pixel from a buffer, clamping coordinates to the image edges. */
+#define FETCH(buf, x, y, w, h) \
+	convert_float(buf[clamp((int) (y), 0, (int) (h) - 1) * (w) \
+		+ clamp((int) (x), 0, (int) (w) - 1)])
+
+/**
+ * Naive convolution kernel, buffer storage. Each work-item reads all
+ * the pixels in its neighborhood directly from global memory.
+ *
+ * @param[in] in Input image.
+ * @param[out] out Output image.
+ * @param[in] weights Filter weights, FSIDE x FSIDE, row-major.
+ * @param[in] w Image width.
+ * @param[in] h Image height.
+ * */
+__kernel void conv_naive(__global const T* in, __global T* out,
+	__constant float* weights, uint w, uint h) {
+
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+
+	if ((x < w) && (y < h)) {
+
+		float acc = 0.0f;
+
+		for (int j = -RADIUS; j <= RADIUS; ++j)
+			for (int i = -RADIUS; i <= RADIUS; ++i)
+				acc += weights[(j + RADIUS) * FSIDE + (i + RADIUS)]
+					* FETCH(in, x + i, y + j, w, h);
+
+		out[y * w + x] = CONVERT_T(acc);
+	}
+}
+
+/**
+ * Tiled convolution kernel, buffer storage. The work-group cooperatively
+ * loads its tile plus a RADIUS-wide halo into local memory, and each
+ * work-item then convolves from local memory only.
+ *
+ * @param[in] in Input image.
+ * @param[out] out Output image.
+ * @param[in] weights Filter weights, FSIDE x FSIDE, row-major.
+ * @param[in] w Image width.
+ * @param[in] h Image height.
+ * */
+__kernel __attribute__((reqd_work_group_size(TILE_W, TILE_H, 1)))
+void conv_tiled(__global const T* in, __global T* out,
+	__constant float* weights, uint w, uint h) {
+
+	__local float tile[HALO_H][HALO_W];
+
+	int lx = get_local_id(0);
+	int ly = get_local_id(1);
+	int x0 = get_group_id(0) * TILE_W - RADIUS;
+	int y0 = get_group_id(1) * TILE_H - RADIUS;
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+
+	/* Load tile and halo. */
+	for (int j = ly; j < HALO_H; j += TILE_H)
+		for (int i = lx; i < HALO_W; i += TILE_W)
+			tile[j][i] = FETCH(in, x0 + i, y0 + j, w, h);
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if ((x < w) && (y < h)) {
+
+		float acc = 0.0f;
+
+		for (int j = 0; j < FSIDE; ++j)
+			for (int i = 0; i < FSIDE; ++i)
+				acc += weights[j * FSIDE + i] * tile[ly + j][lx + i];
+
+		out[y * w + x] = CONVERT_T(acc);
+	}
+}
+
+/**
+ * Horizontal pass of a separable convolution, buffer storage. Loads a
+ * tile with left and right halos into local memory. Output is kept in
+ * float to avoid losing precision between passes.
+ *
+ * @param[in] in Input image.
+ * @param[out] out Intermediate image.
+ * @param[in] wx Horizontal filter weights, FSIDE elements.
+ * @param[in] w Image width.
+ * @param[in] h Image height.
+ * */
+__kernel __attribute__((reqd_work_group_size(TILE_W, TILE_H, 1)))
+void conv_sep_rows(__global const T* in, __global float* out,
+	__constant float* wx, uint w, uint h) {
+
+	__local float tile[TILE_H][HALO_W];
+
+	int lx = get_local_id(0);
+	int ly = get_local_id(1);
+	int x0 = get_group_id(0) * TILE_W - RADIUS;
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+
+	for (int i = lx; i < HALO_W; i += TILE_W)
+		tile[ly][i] = FETCH(in, x0 + i, y, w, h);
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if ((x < w) && (y < h)) {
+
+		float acc = 0.0f;
+
+		for (int i = 0; i < FSIDE; ++i)
+			acc += wx[i] * tile[ly][lx + i];
+
+		out[y * w + x] = acc;
+	}
+}
+
+/**
+ * Vertical pass of a separable convolution, buffer storage. Loads a
+ * tile with top and bottom halos into local memory.
+ *
+ * @param[in] in Intermediate image produced by conv_sep_rows.
+ * @param[out] out Output image.
+ * @param[in] wy Vertical filter weights, FSIDE elements.
+ * @param[in] w Image width.
+ * @param[in] h Image height.
+ * */
+__kernel __attribute__((reqd_work_group_size(TILE_W, TILE_H, 1)))
+void conv_sep_cols(__global const float* in, __global T* out,
+	__constant float* wy, uint w, uint h) {
+
+	__local float tile[HALO_H][TILE_W];
+
+	int lx = get_local_id(0);
+	int ly = get_local_id(1);
+	int y0 = get_group_id(1) * TILE_H - RADIUS;
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+
+	for (int j = ly; j < HALO_H; j += TILE_H)
+		tile[j][lx] = FETCH(in, x, y0 + j, w, h);
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if ((x < w) && (y < h)) {
+
+		float acc = 0.0f;
+
+		for (int j = 0; j < FSIDE; ++j)
+			acc += wy[j] * tile[ly + j][lx];
+
+		out[y * w + x] = CONVERT_T(acc);
+	}
+}
+
+/* Sampler for image kernels: unnormalized coordinates, clamp to edge. */
+__constant sampler_t smplr =
+	CLK_NORMALIZED_COORDS_FALSE | CLK_ADDRESS_CLAMP_TO_EDGE | CLK_FILTER_NEAREST;
+
+/**
+ * Naive convolution kernel, image storage (single channel images).
+ *
+ * @param[in] in Input image.
+ * @param[out] out Output image.
+ * @param[in] weights Filter weights, FSIDE x FSIDE, row-major.
+ * */
+__kernel void conv_naive_img(__read_only image2d_t in,
+	__write_only image2d_t out, __constant float* weights) {
+
+	int2 dim = get_image_dim(in);
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+
+	if ((x < dim.x) && (y < dim.y)) {
+
+		float acc = 0.0f;
+
+		for (int j = -RADIUS; j <= RADIUS; ++j)
+			for (int i = -RADIUS; i <= RADIUS; ++i)
+				acc += weights[(j + RADIUS) * FSIDE + (i + RADIUS)]
+					* read_imagef(in, smplr, (int2) (x + i, y + j)).x;
+
+		write_imagef(out, (int2) (x, y), (float4) (acc, 0.0f, 0.0f, 1.0f));
+	}
+}
+
+/**
+ * Tiled convolution kernel, image storage (single channel images).
+ *
+ * @param[in] in Input image.
+ * @param[out] out Output image.
+ * @param[in] weights Filter weights, FSIDE x FSIDE, row-major.
+ * */
+__kernel __attribute__((reqd_work_group_size(TILE_W, TILE_H, 1)))
+void conv_tiled_img(__read_only image2d_t in,
+	__write_only image2d_t out, __constant float* weights) {
+
+	__local float tile[HALO_H][HALO_W];
+
+	int2 dim = get_image_dim(in);
+	int lx = get_local_id(0);
+	int ly = get_local_id(1);
+	int x0 = get_group_id(0) * TILE_W - RADIUS;
+	int y0 = get_group_id(1) * TILE_H - RADIUS;
+	int x = get_global_id(0);
+	int y = get_global_id(1);
+
+	for (int j = ly; j < HALO_H; j += TILE_H)
+		for (int i = lx; i < HALO_W; i += TILE_W)
+			tile[j][i] =
+				read_imagef(in, smplr, (int2) (x0 + i, y0 + j)).x;
+
+	barrier(CLK_LOCAL_MEM_FENCE);
+
+	if ((x < dim.x) && (y < dim.y)) {
+
+		float acc = 0.0f;
+
+		for (int j = 0; j < FSIDE; ++j)
+			for (int i = 0; i < FSIDE; ++i)
+				acc += weights[j * FSIDE + i] * tile[ly + j][lx + i];
+
+		write_imagef(out, (int2) (x, y), (float4) (acc, 0.0f, 0.0f, 1.0f));
+	}
+}
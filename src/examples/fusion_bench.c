@@ -0,0 +1,216 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cf4ocl.  If not, see <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ * Benchmark which compares fused and unfused chains of elementwise
+ * kernels.
+ *
+ * @copyright [GNU General Public License version 3 (GPLv3)](http://www.gnu.org/licenses/gpl.html)
+ */
+
+/*
+ * Description
+ * -----------
+ *
+ * This program applies a chain of six elementwise operations (scale, add,
+ * multiply, clamp, offset and convert to `uchar`) to a vector of floats,
+ * first launching one kernel per operation (unfused, with the intermediate
+ * results going through global memory), and then launching a single kernel
+ * generated by the fusion composer. It reports the time taken by both
+ * approaches and checks that they produce the same results.
+ *
+ * The program accepts three optional command-line arguments:
+ *
+ * 1. Device index
+ * 2. Number of elements in millions (default 16)
+ * 3. Number of repetitions (default 10)
+ *
+ * */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <assert.h>
+#include <cf4ocl2.h>
+
+/* Default number of elements, in millions. */
+#define NUM_MEGA 16
+
+/* Default number of repetitions. */
+#define REPS 10
+
+/* Number of operations in the chain. */
+#define NUM_OPS 6
+
+/* Error handling macros. */
+#define ERROR_MSG_AND_EXIT(msg) \
+	do { fprintf(stderr, "\n%s\n", msg); exit(EXIT_FAILURE); } while(0)
+
+#define HANDLE_ERROR(err) \
+	if (err != NULL) { ERROR_MSG_AND_EXIT(err->message); }
+
+/**
+ * Fusion benchmark main function.
+ *
+ * @param[in] argc Number of command line arguments.
+ * @param[in] argv Command line arguments.
+ * @return `EXIT_SUCCESS` if program terminates successfully, or another
+ * value of `EXIT_FAILURE` if an error occurs.
+ * */
+int main(int argc, char** argv) {
+
+	/* Wrappers. */
+	CCLContext* ctx = NULL;
+	CCLQueue* cq = NULL;
+	CCLFusion* fus = NULL;
+	CCLBuffer* in = NULL;
+	CCLBuffer* b = NULL;
+	CCLBuffer* tmp = NULL;
+	CCLBuffer* out = NULL;
+
+	/* Host buffers. */
+	cl_float* h_in;
+	cl_uchar* h_unfused;
+	cl_uchar* h_fused;
+
+	/* Benchmark parameters and results. */
+	int dev_idx = -1;
+	size_t n = (size_t) NUM_MEGA * 1000 * 1000;
+	int reps = REPS;
+	double t_unfused, t_fused;
+	GTimer* timer;
+
+	/* Error reporting object. */
+	CCLErr* err = NULL;
+
+	/* Check arguments. */
+	if (argc >= 2) dev_idx = atoi(argv[1]);
+	if (argc >= 3) n = (size_t) atoi(argv[2]) * 1000 * 1000;
+	if (argc >= 4) reps = atoi(argv[3]);
+	if ((n == 0) || (reps <= 0))
+		ERROR_MSG_AND_EXIT("Usage: fusion_bench [dev_idx] [M elems] [reps]");
+
+	/* Set up context, queue and composer. */
+	ctx = ccl_context_new_from_menu_full(&dev_idx, &err);
+	HANDLE_ERROR(err);
+	cq = ccl_queue_new(ctx, NULL, 0, &err);
+	HANDLE_ERROR(err);
+	fus = ccl_fusion_new(ctx);
+
+	/* Allocate and initialize buffers. */
+	h_in = g_new(cl_float, n);
+	h_unfused = g_new(cl_uchar, n);
+	h_fused = g_new(cl_uchar, n);
+	for (size_t i = 0; i < n; ++i)
+		h_in[i] = (cl_float) (i % 1000) / 10.0f;
+	in = ccl_buffer_new(ctx, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+		n * sizeof(cl_float), h_in, &err);
+	HANDLE_ERROR(err);
+	b = ccl_buffer_new(ctx, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+		n * sizeof(cl_float), h_in, &err);
+	HANDLE_ERROR(err);
+	tmp = ccl_buffer_new(ctx, CL_MEM_READ_WRITE,
+		n * sizeof(cl_float), NULL, &err);
+	HANDLE_ERROR(err);
+	out = ccl_buffer_new(ctx, CL_MEM_WRITE_ONLY,
+		n * sizeof(cl_uchar), NULL, &err);
+	HANDLE_ERROR(err);
+
+	/* The chain of operations. */
+	CCLFusionOp ops[NUM_OPS] = {
+		ccl_fusion_op_scale(1.5f),
+		ccl_fusion_op_add(b),
+		ccl_fusion_op_mul(b),
+		ccl_fusion_op_clamp(0.0f, 254.0f),
+		ccl_fusion_op_offset(1.0f),
+		ccl_fusion_op_convert("uchar")
+	};
+
+	/* Unfused: one kernel per operation, the first reading the input
+	 * buffer, the float operations updating a temporary buffer in place,
+	 * and the conversion writing the output buffer. The first repetition
+	 * builds the kernels and is not timed. */
+	timer = g_timer_new();
+	for (int r = -1; r < reps; ++r) {
+		if (r == 0) g_timer_start(timer);
+		for (cl_uint k = 0; k < NUM_OPS; ++k) {
+			ccl_fusion_enqueue(fus, cq,
+				k == 0 ? in : tmp, "float",
+				k == NUM_OPS - 1 ? out : tmp, n,
+				&ops[k], 1, NULL, &err);
+			HANDLE_ERROR(err);
+		}
+		ccl_queue_finish(cq, &err);
+		HANDLE_ERROR(err);
+		ccl_queue_gc(cq);
+	}
+	t_unfused = g_timer_elapsed(timer, NULL) / reps;
+	ccl_buffer_enqueue_read(out, cq, CL_TRUE, 0, n * sizeof(cl_uchar),
+		h_unfused, NULL, &err);
+	HANDLE_ERROR(err);
+
+	/* Fused: a single kernel for the whole chain. */
+	for (int r = -1; r < reps; ++r) {
+		if (r == 0) g_timer_start(timer);
+		ccl_fusion_enqueue(fus, cq, in, "float", out, n,
+			ops, NUM_OPS, NULL, &err);
+		HANDLE_ERROR(err);
+		ccl_queue_finish(cq, &err);
+		HANDLE_ERROR(err);
+		ccl_queue_gc(cq);
+	}
+	t_fused = g_timer_elapsed(timer, NULL) / reps;
+	ccl_buffer_enqueue_read(out, cq, CL_TRUE, 0, n * sizeof(cl_uchar),
+		h_fused, NULL, &err);
+	HANDLE_ERROR(err);
+	g_timer_destroy(timer);
+
+	/* Check results. The compiler may contract operations of the fused
+	 * chain (e.g. into fused multiply-adds), so results which differ by
+	 * one unit after the final truncation are accepted. */
+	for (size_t i = 0; i < n; ++i) {
+		if (abs((int) h_unfused[i] - (int) h_fused[i]) > 1)
+			ERROR_MSG_AND_EXIT("Fused and unfused results differ.");
+	}
+
+	/* Show results. */
+	printf("\n   Elements          : %zu x %d\n", n, reps);
+	printf("   Operations        : %d\n", NUM_OPS);
+	printf("   Cached kernels    : %u\n", ccl_fusion_get_num_kernels(fus));
+	printf("   Unfused / fused   : %10.3f / %10.3f ms\n",
+		t_unfused * 1e3, t_fused * 1e3);
+	printf("   Speedup           : %10.2fx\n\n", t_unfused / t_fused);
+	printf("Fused and unfused chains produced the same results.\n");
+
+	/* Destroy stuff. */
+	g_free(h_in);
+	g_free(h_unfused);
+	g_free(h_fused);
+	ccl_buffer_destroy(in);
+	ccl_buffer_destroy(b);
+	ccl_buffer_destroy(tmp);
+	ccl_buffer_destroy(out);
+	ccl_fusion_destroy(fus);
+	ccl_queue_destroy(cq);
+	ccl_context_destroy(ctx);
+
+	/* Check all wrappers have been destroyed. */
+	assert(ccl_wrapper_memcheck());
+
+	/* Terminate. */
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,205 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with cf4ocl.  If not, see <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ * Benchmark which compares the driver and the mapped, multi-threaded
+ * host-device transfer paths.
+ *
+ * @copyright [GNU General Public License version 3 (GPLv3)](http://www.gnu.org/licenses/gpl.html)
+ */
+
+/*
+ * Description
+ * -----------
+ *
+ * This program measures the host-device transfer throughput of
+ * ccl_buffer_enqueue_write_mt() and ccl_buffer_enqueue_read_mt() with
+ * the driver (single command) and mapped (multi-threaded host copy)
+ * transfer modes, and checks that both produce the same data. The
+ * mapped mode is expected to be faster on CPU devices and devices
+ * with unified host memory, which is when the automatic mode selects
+ * it.
+ *
+ * The program accepts three optional command-line arguments:
+ *
+ * 1. Device index
+ * 2. Buffer size in MiB (default 256)
+ * 3. Number of repetitions (default 10)
+ *
+ * */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <cf4ocl2.h>
+
+/* Default buffer size in MiB. */
+#define BUF_MIB 256
+
+/* Default number of repetitions. */
+#define REPS 10
+
+/* Error handling macros. */
+#define ERROR_MSG_AND_EXIT(msg) \
+	do { fprintf(stderr, "\n%s\n", msg); exit(EXIT_FAILURE); } while(0)
+
+#define HANDLE_ERROR(err) \
+	if (err != NULL) { ERROR_MSG_AND_EXIT(err->message); }
+
+/**
+ * Time write and read transfers with the given mode.
+ *
+ * @param[in] buf Device buffer.
+ * @param[in] cq Command queue.
+ * @param[in] mode Transfer mode.
+ * @param[in] h_in Host data to write.
+ * @param[out] h_out Host location where to read data into.
+ * @param[in] size Transfer size in bytes.
+ * @param[in] reps Number of repetitions.
+ * @param[out] gbs_write Write throughput in GB/s.
+ * @param[out] gbs_read Read throughput in GB/s.
+ * */
+static void bench(CCLBuffer* buf, CCLQueue* cq,
+	CCLBufferTransferMode mode, unsigned char* h_in,
+	unsigned char* h_out, size_t size, int reps, double* gbs_write,
+	double* gbs_read) {
+
+	CCLErr* err = NULL;
+	GTimer* timer = g_timer_new();
+
+	/* Time writes, including completion of the last command. */
+	g_timer_start(timer);
+	for (int i = 0; i < reps; ++i) {
+		ccl_buffer_enqueue_write_mt(
+			buf, cq, mode, 0, size, h_in, NULL, &err);
+		HANDLE_ERROR(err);
+	}
+	ccl_queue_finish(cq, &err);
+	HANDLE_ERROR(err);
+	*gbs_write = 1e-9 * size * reps / g_timer_elapsed(timer, NULL);
+
+	/* Time reads. */
+	g_timer_start(timer);
+	for (int i = 0; i < reps; ++i) {
+		ccl_buffer_enqueue_read_mt(
+			buf, cq, mode, 0, size, h_out, NULL, &err);
+		HANDLE_ERROR(err);
+	}
+	ccl_queue_finish(cq, &err);
+	HANDLE_ERROR(err);
+	*gbs_read = 1e-9 * size * reps / g_timer_elapsed(timer, NULL);
+
+	/* Release events produced so far. */
+	ccl_queue_gc(cq);
+	g_timer_destroy(timer);
+
+	/* Check data. */
+	if (memcmp(h_in, h_out, size) != 0)
+		ERROR_MSG_AND_EXIT("Data read back does not match data written.");
+}
+
+/**
+ * Transfer benchmark main function.
+ *
+ * @param[in] argc Number of command line arguments.
+ * @param[in] argv Command line arguments.
+ * @return `EXIT_SUCCESS` if program terminates successfully, or another
+ * value of `EXIT_FAILURE` if an error occurs.
+ * */
+int main(int argc, char** argv) {
+
+	/* Wrappers. */
+	CCLContext* ctx = NULL;
+	CCLDevice* dev = NULL;
+	CCLQueue* cq = NULL;
+	CCLBuffer* buf = NULL;
+
+	/* Host buffers. */
+	unsigned char* h_in;
+	unsigned char* h_out;
+
+	/* Benchmark parameters and results. */
+	int dev_idx = -1;
+	size_t size = (size_t) BUF_MIB * 1024 * 1024;
+	int reps = REPS;
+	double w_drv, r_drv, w_map, r_map;
+	cl_device_type type;
+
+	/* Error reporting object. */
+	CCLErr* err = NULL;
+
+	/* Check arguments. */
+	if (argc >= 2) dev_idx = atoi(argv[1]);
+	if (argc >= 3) size = (size_t) atoi(argv[2]) * 1024 * 1024;
+	if (argc >= 4) reps = atoi(argv[3]);
+	if ((size == 0) || (reps <= 0))
+		ERROR_MSG_AND_EXIT("Usage: transfer_bench [dev_idx] [MiB] [reps]");
+
+	/* Set up context, device and queue. */
+	ctx = ccl_context_new_from_menu_full(&dev_idx, &err);
+	HANDLE_ERROR(err);
+	dev = ccl_context_get_device(ctx, 0, &err);
+	HANDLE_ERROR(err);
+	cq = ccl_queue_new(ctx, dev, 0, &err);
+	HANDLE_ERROR(err);
+	type = ccl_device_get_info_scalar(
+		dev, CL_DEVICE_TYPE, cl_device_type, &err);
+	HANDLE_ERROR(err);
+
+	/* Allocate and initialize buffers. */
+	buf = ccl_buffer_new(ctx, CL_MEM_READ_WRITE, size, NULL, &err);
+	HANDLE_ERROR(err);
+	h_in = g_malloc(size);
+	h_out = g_malloc(size);
+	for (size_t i = 0; i < size; ++i)
+		h_in[i] = (unsigned char) (i * 7 + (i >> 12));
+
+	/* Warm up, then benchmark both paths. */
+	bench(buf, cq, CCL_BUFFER_TRANSFER_DRIVER, h_in, h_out, size, 1,
+		&w_drv, &r_drv);
+	bench(buf, cq, CCL_BUFFER_TRANSFER_DRIVER, h_in, h_out, size, reps,
+		&w_drv, &r_drv);
+	memset(h_out, 0, size);
+	bench(buf, cq, CCL_BUFFER_TRANSFER_MAPPED, h_in, h_out, size, reps,
+		&w_map, &r_map);
+
+	/* Show results. */
+	printf("\n   Device type        : %s\n",
+		(type & CL_DEVICE_TYPE_CPU) ? "CPU" : "non-CPU");
+	printf("   Transfer size      : %.1f MiB x %d\n",
+		size / (1024.0 * 1024.0), reps);
+	printf("   Driver  write/read : %8.2f / %8.2f GB/s\n", w_drv, r_drv);
+	printf("   Mapped  write/read : %8.2f / %8.2f GB/s\n", w_map, r_map);
+	printf("   Speedup write/read : %8.2fx / %7.2fx\n\n",
+		w_map / w_drv, r_map / r_drv);
+	printf("All transfer modes produced the expected results.\n");
+
+	/* Destroy stuff. */
+	g_free(h_in);
+	g_free(h_out);
+	ccl_buffer_destroy(buf);
+	ccl_queue_destroy(cq);
+	ccl_context_destroy(ctx);
+
+	/* Check all wrappers have been destroyed. */
+	assert(ccl_wrapper_memcheck());
+
+	/* Terminate. */
+	return EXIT_SUCCESS;
+}
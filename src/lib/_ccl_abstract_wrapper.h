@@ -42,7 +42,8 @@
 typedef struct ccl_wrapper_info_table CCLWrapperInfoTable;
 
 /**
- * Base class for all OpenCL wrappers.
+ * Base class for all OpenCL wrappers. The first two fields must have
+ * the same layout as ::CCLWrapperPrefix.
  * */
 struct ccl_wrapper {
 
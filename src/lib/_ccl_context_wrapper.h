@@ -0,0 +1,40 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ *
+ * This header provides the prototype of the
+ * ccl_context_get_internal_program() function. This header is not part of
+ * the _cf4ocl_ public API.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#ifndef __CCL_CONTEXT_WRAPPER_H_
+#define __CCL_CONTEXT_WRAPPER_H_
+
+#include "ccl_context_wrapper.h"
+#include "ccl_program_wrapper.h"
+
+/* Get a program used internally by the library, building and caching it
+ * in the context on first use. */
+CCLProgram* ccl_context_get_internal_program(CCLContext* ctx,
+	const char* name, const char* src, CCLErr** err);
+
+#endif /* __CCL_CONTEXT_WRAPPER_H_ */
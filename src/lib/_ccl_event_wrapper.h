@@ -0,0 +1,112 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ *
+ * This header provides the prototypes of the ccl_event_set_ndrange()
+ * function and of the memory object access tracking functions used for
+ * redundant transfer analysis. This header is not part of the _cf4ocl_
+ * public API.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#ifndef __CCL_EVENT_WRAPPER_H_
+#define __CCL_EVENT_WRAPPER_H_
+
+#include "ccl_event_wrapper.h"
+
+/* Record the NDRange with which the kernel command associated with the
+ * event was launched. */
+void ccl_event_set_ndrange(CCLEvent* evt, cl_uint work_dim,
+	const size_t* global_work_size, const size_t* local_work_size);
+
+/**
+ * @internal
+ * Kinds of memory object accesses recorded in events for redundant
+ * transfer analysis.
+ * */
+typedef enum ccl_event_mem_access_kind {
+
+	/** Host to device transfer. */
+	CCL_EVENT_MEM_UPLOAD   = 0,
+
+	/** Device to host transfer. */
+	CCL_EVENT_MEM_DOWNLOAD = 1,
+
+	/** Device-side read, e.g. the source of a copy. */
+	CCL_EVENT_MEM_READ     = 2,
+
+	/** Device-side write which overwrites the region without reading
+	 * it, e.g. the destination of a copy or a fill. */
+	CCL_EVENT_MEM_WRITE    = 3,
+
+	/** Device-side access which may read and modify the region, e.g.
+	 * a kernel argument or a map. */
+	CCL_EVENT_MEM_USE      = 4
+
+} CCLEventMemAccessKind;
+
+/**
+ * @internal
+ * A memory object access recorded in an event.
+ * */
+typedef struct ccl_event_mem_access {
+
+	/** Kind of access. */
+	CCLEventMemAccessKind kind;
+
+	/** Memory object, or parent buffer in case of sub-buffers. */
+	cl_mem mem;
+
+	/** Offset of accessed region. */
+	size_t offset;
+
+	/** Size of accessed region, `G_MAXSIZE` for the whole object. */
+	size_t size;
+
+	/** Whether the hash of the transferred data is known. */
+	cl_bool has_hash;
+
+	/** Hash of the transferred data. */
+	guint64 hash;
+
+	/** Order in which the access was issued. */
+	guint seq;
+
+} CCLEventMemAccess;
+
+/* Set the memory object access tracking mode. */
+void ccl_event_set_mem_tracking(int mode);
+
+/* Get the memory object access tracking mode. */
+int ccl_event_get_mem_tracking(void);
+
+/* Record a memory object access in an event, if tracking is enabled. */
+void ccl_event_add_mem_access(CCLEvent* evt, CCLEventMemAccessKind kind,
+	cl_mem mem, size_t offset, size_t size, const void* ptr);
+
+/* Get the kind of memory object access of a map command. */
+CCLEventMemAccessKind ccl_event_map_access(cl_map_flags map_flags);
+
+/* Get the memory object accesses recorded in an event. */
+const CCLEventMemAccess* ccl_event_get_mem_accesses(CCLEvent* evt,
+	guint* num_accesses);
+
+#endif /* __CCL_EVENT_WRAPPER_H_ */
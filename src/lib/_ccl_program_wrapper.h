@@ -0,0 +1,39 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ *
+ * This header provides the prototype of the ccl_program_prewarm_arg_size()
+ * function. This header is not part of the _cf4ocl_ public API.
+ *
+ * @copyright [GNU Lesser General Public License version 3
+ * (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#ifndef __CCL_PROGRAM_WRAPPER_H_
+#define __CCL_PROGRAM_WRAPPER_H_
+
+#include "ccl_program_wrapper.h"
+
+/* Determine the size of a private kernel argument from its OpenCL C type
+ * name. Exported so that the unit tests can check it directly. */
+CCL_EXPORT
+size_t ccl_program_prewarm_arg_size(const char* type_name);
+
+#endif /* __CCL_PROGRAM_WRAPPER_H_ */
@@ -0,0 +1,48 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ *
+ * This header provides the prototypes of the ccl_queue_qos_gate(),
+ * ccl_queue_inflight_acquire() and ccl_queue_inflight_cancel()
+ * functions. This header is not part of the _cf4ocl_ public API.
+ *
+ * @copyright [GNU Lesser General Public License version 3
+ * (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#ifndef __CCL_QUEUE_WRAPPER_H_
+#define __CCL_QUEUE_WRAPPER_H_
+
+#include "ccl_queue_wrapper.h"
+
+/* Hold back a kernel launch on a low priority queue while commands of high
+ * priority queues on the same device are outstanding. */
+void ccl_queue_qos_gate(CCLQueue* cq);
+
+/* Wait for room in the in-flight window of the queue before enqueuing a
+ * command which transfers the given number of bytes. */
+cl_bool ccl_queue_inflight_acquire(CCLQueue* cq, size_t bytes,
+	CCLErr** err);
+
+/* Forget the number of bytes kept for a command which failed to be
+ * enqueued. */
+void ccl_queue_inflight_cancel(CCLQueue* cq);
+
+#endif /* __CCL_QUEUE_WRAPPER_H_ */
@@ -32,6 +32,12 @@
 #include "_ccl_kernel_wrapper.h"
 #include "_ccl_defs.h"
 
+/* The first fields of wrappers must match the stable wrapper prefix. */
+G_STATIC_ASSERT(G_STRUCT_OFFSET(CCLWrapper, class)
+	== G_STRUCT_OFFSET(CCLWrapperPrefix, type));
+G_STATIC_ASSERT(G_STRUCT_OFFSET(CCLWrapper, cl_object)
+	== G_STRUCT_OFFSET(CCLWrapperPrefix, cl_object));
+
 /* Generic function pointer for OpenCL clget**Info() functions. */
 typedef cl_int (*ccl_wrapper_info_fp)(void);
 
@@ -420,6 +426,10 @@ int ccl_wrapper_ref_count(CCLWrapper* wrapper) {
 /**
  * Get the wrapped OpenCL object.
  *
+ * The `ccl_*_unwrap()` macros use ::ccl_wrapper_unwrap_inline()
+ * instead, which avoids the function call. This function is kept for
+ * bindings and other code which cannot use inline functions.
+ *
  * @public @memberof ccl_wrapper
  *
  * @param[in] wrapper The wrapper object.
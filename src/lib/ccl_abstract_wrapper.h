@@ -33,6 +33,7 @@
 #include "ccl_oclversions.h"
 #include "ccl_common.h"
 #include "ccl_errors.h"
+#include "ccl_wrapper_layout.h"
 
 /**
  * Class which represents information about a wrapped OpenCL
@@ -0,0 +1,780 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+ /**
+ * @file
+ *
+ * Implementation of a batcher which packs many small independent
+ * problems into a single kernel launch.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#include <string.h>
+#include "ccl_batch.h"
+#include "ccl_buffer_wrapper.h"
+#include "ccl_kernel_arg.h"
+#include "ccl_kernel_wrapper.h"
+#include "ccl_program_wrapper.h"
+#include "_ccl_defs.h"
+
+/**
+ * @internal
+ * Name of the generated kernel.
+ * */
+#define CCL_BATCH_KERNEL "ccl_batched"
+
+/**
+ * @internal
+ * Device buffer and host staging area for packed data.
+ * */
+typedef struct ccl_batch_arena {
+
+	/** Device buffer. */
+	CCLBuffer* buf;
+
+	/** Size in bytes of the device buffer and of the staging area. */
+	size_t size;
+
+	/** Host staging area. */
+	void* host;
+
+} CCLBatchArena;
+
+/**
+ * Batcher of small independent problems.
+ * */
+struct ccl_batch {
+
+	/**
+	 * Context in which the batched kernel runs.
+	 * @private
+	 * */
+	CCLContext* ctx;
+
+	/**
+	 * Program containing the batched kernel.
+	 * @private
+	 * */
+	CCLProgram* prg;
+
+	/**
+	 * Description of the original kernel arguments.
+	 * @private
+	 * */
+	CCLBatchArg* args;
+
+	/**
+	 * Number of original kernel arguments.
+	 * @private
+	 * */
+	cl_uint num_args;
+
+	/**
+	 * Lengths of the added instances.
+	 * @private
+	 * */
+	GArray* lengths;
+
+	/**
+	 * Host arrays of the added instances, `num_args` per instance.
+	 * @private
+	 * */
+	GPtrArray* data;
+
+	/**
+	 * Arenas, one per original kernel argument (only used for
+	 * per-instance arrays), plus one for the table of offsets.
+	 * @private
+	 * */
+	CCLBatchArena* arenas;
+
+};
+
+/**
+ * @internal
+ * Is the given character part of an identifier?
+ *
+ * @param[in] c Character to check.
+ * @return `TRUE` if the character is part of an identifier, `FALSE`
+ * otherwise.
+ * */
+#define ccl_batch_is_ident(c) (g_ascii_isalnum(c) || ((c) == '_'))
+
+/**
+ * @internal
+ * Is the given argument kind a per-instance array?
+ *
+ * @param[in] kind Argument kind.
+ * @return `TRUE` if the argument is a per-instance array, `FALSE`
+ * otherwise.
+ * */
+#define ccl_batch_is_array(kind) \
+	(((kind) == CCL_BATCH_ARG_IN) || ((kind) == CCL_BATCH_ARG_OUT) \
+	|| ((kind) == CCL_BATCH_ARG_INOUT))
+
+/**
+ * @internal
+ * Locate a kernel in OpenCL C source code.
+ *
+ * @param[in] src OpenCL C source code.
+ * @param[in] name Kernel name.
+ * @param[out] kstart Position of the `__kernel` qualifier.
+ * @param[out] pstart Position of the parenthesis which opens the
+ * parameter list.
+ * @param[out] pend Position of the parenthesis which closes the
+ * parameter list.
+ * @param[out] bend Position of the brace which closes the kernel body.
+ * @return `TRUE` if the kernel was found, `FALSE` otherwise.
+ * */
+static gboolean ccl_batch_find_kernel(const char* src, const char* name,
+	size_t* kstart, size_t* pstart, size_t* pend, size_t* bend) {
+
+	size_t len = strlen(name);
+
+	for (const char* p = strstr(src, name); p != NULL;
+		p = strstr(p + 1, name)) {
+
+		const char* q = p + len;
+		const char* v = p;
+		const char* k;
+		const char* qual = NULL;
+		int depth = 0;
+
+		/* The name must be a whole identifier followed by a parameter
+		 * list... */
+		if (((p > src) && ccl_batch_is_ident(p[-1]))
+			|| ccl_batch_is_ident(*q))
+			continue;
+		while (g_ascii_isspace(*q)) q++;
+		if (*q != '(') continue;
+
+		/* ...preceded by the return type... */
+		while ((v > src) && g_ascii_isspace(v[-1])) v--;
+		if ((v - src < 4) || (strncmp(v - 4, "void", 4) != 0)
+			|| ((v - src > 4) && ccl_batch_is_ident(v[-5])))
+			continue;
+		v -= 4;
+
+		/* ...and by the kernel qualifier, after the previous
+		 * declaration. */
+		for (k = v; (k > src) && (k[-1] != ';') && (k[-1] != '}'); k--);
+		for (; (k = strstr(k, "kernel")) != NULL && k < v; k += 6) {
+			const char* s = k;
+			if ((s - src >= 2) && (s[-1] == '_') && (s[-2] == '_'))
+				s -= 2;
+			if (((s == src) || !ccl_batch_is_ident(s[-1]))
+				&& !ccl_batch_is_ident(k[6]))
+				qual = s;
+		}
+		if (qual == NULL) continue;
+		*kstart = qual - src;
+
+		/* Find the end of the parameter list. */
+		*pstart = q - src;
+		for (; *q != '\0'; q++) {
+			if (*q == '(') depth++;
+			else if ((*q == ')') && (--depth == 0)) break;
+		}
+		if (*q == '\0') return FALSE;
+		*pend = q - src;
+
+		/* Find the end of the body. */
+		q = strchr(q, '{');
+		if (q == NULL) return FALSE;
+		for (; *q != '\0'; q++) {
+			if (*q == '{') depth++;
+			else if ((*q == '}') && (--depth == 0)) break;
+		}
+		if (*q == '\0') return FALSE;
+		*bend = q - src;
+
+		return TRUE;
+	}
+
+	return FALSE;
+
+}
+
+/**
+ * @internal
+ * Get the name of a parameter from its declaration.
+ *
+ * @param[in] decl Parameter declaration, without surrounding spaces.
+ * @return Start of the parameter name within the declaration.
+ * */
+static const char* ccl_batch_param_name(const char* decl) {
+
+	const char* e = decl + strlen(decl);
+	while ((e > decl) && ccl_batch_is_ident(e[-1])) e--;
+	return e;
+
+}
+
+/**
+ * @internal
+ * Make sure an arena can hold the given number of bytes, growing it if
+ * necessary.
+ *
+ * @param[in] batch Batcher.
+ * @param[in] arena Arena.
+ * @param[in] size Required size in bytes.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return `CL_TRUE` if the arena can hold the given number of bytes,
+ * `CL_FALSE` if an error occurs.
+ * */
+static cl_bool ccl_batch_arena_reserve(CCLBatch* batch,
+	CCLBatchArena* arena, size_t size, CCLErr** err) {
+
+	if (arena->size >= size) return CL_TRUE;
+
+	if (arena->buf != NULL) ccl_buffer_destroy(arena->buf);
+	arena->size = 0;
+	arena->buf = ccl_buffer_new(
+		batch->ctx, CL_MEM_READ_WRITE, size, NULL, err);
+	if (arena->buf == NULL) return CL_FALSE;
+	arena->host = g_realloc(arena->host, size);
+	arena->size = size;
+	return CL_TRUE;
+
+}
+
+/**
+ * @addtogroup CCL_BATCH
+ * @{
+ */
+
+/**
+ * Create a new batcher for the given kernel, building the batched
+ * kernel.
+ *
+ * @public @memberof ccl_batch
+ *
+ * @param[in] ctx Context in which the batched kernel is built and run.
+ * @param[in] src OpenCL C source code containing the kernel.
+ * @param[in] kernel_name Name of the kernel, which processes one
+ * instance with one work-item per element.
+ * @param[in] args Description of each kernel argument, in order.
+ * @param[in] num_args Number of kernel arguments.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return A new batcher, which should be destroyed with
+ * ::ccl_batch_destroy(), or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLBatch* ccl_batch_new(CCLContext* ctx, const char* src,
+	const char* kernel_name, const CCLBatchArg* args, cl_uint num_args,
+	CCLErr** err) {
+
+	/* Make sure ctx is not NULL. */
+	g_return_val_if_fail(ctx != NULL, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Batcher to return. */
+	CCLBatch* batch = NULL;
+	/* Batched kernel source. */
+	char* batched_src = NULL;
+	/* Program containing batched kernel. */
+	CCLProgram* prg = NULL;
+	/* Internal error object. */
+	CCLErr* err_internal = NULL;
+
+	/* Generate batched kernel source, which also checks arguments. */
+	batched_src = ccl_batch_get_source(
+		src, kernel_name, args, num_args, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Build batched kernel. */
+	prg = ccl_program_new_from_source(ctx, batched_src, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	ccl_program_build(prg, NULL, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Create batcher. */
+	batch = g_slice_new0(CCLBatch);
+	batch->ctx = ctx;
+	ccl_context_ref(ctx);
+	batch->prg = prg;
+	batch->args = g_memdup(args, num_args * sizeof(CCLBatchArg));
+	batch->num_args = num_args;
+	batch->lengths = g_array_new(FALSE, FALSE, sizeof(size_t));
+	batch->data = g_ptr_array_new();
+	batch->arenas = g_new0(CCLBatchArena, num_args + 1);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	if (prg != NULL) ccl_program_destroy(prg);
+
+finish:
+
+	/* Release temporary objects. */
+	g_free(batched_src);
+
+	/* Return batcher. */
+	return batch;
+
+}
+
+/**
+ * Destroy a batcher, releasing its batched kernel and arenas.
+ *
+ * @public @memberof ccl_batch
+ *
+ * @param[in] batch Batcher to destroy.
+ * */
+CCL_EXPORT
+void ccl_batch_destroy(CCLBatch* batch) {
+
+	/* Make sure batch is not NULL. */
+	g_return_if_fail(batch != NULL);
+
+	for (cl_uint k = 0; k <= batch->num_args; ++k) {
+		if (batch->arenas[k].buf != NULL)
+			ccl_buffer_destroy(batch->arenas[k].buf);
+		g_free(batch->arenas[k].host);
+	}
+	g_free(batch->arenas);
+	g_ptr_array_free(batch->data, TRUE);
+	g_array_free(batch->lengths, TRUE);
+	g_free(batch->args);
+	ccl_program_destroy(batch->prg);
+	ccl_context_unref(batch->ctx);
+	g_slice_free(CCLBatch, batch);
+
+}
+
+/**
+ * Generate the source of the batched kernel for the given kernel. This
+ * function is used internally by ::ccl_batch_new(), and is exposed for
+ * inspection and debugging purposes.
+ *
+ * The original kernel is renamed to `ccl_batch_<kernel_name>`, a regular
+ * function which takes the index within the instance and the instance
+ * length as two additional leading parameters. The generated kernel is
+ * named `ccl_batched` and has the following parameters: the table of
+ * instance offsets (as `ulong`, with one more entry than instances), the
+ * number of instances (as `uint`), and then the original kernel
+ * parameters, except the ones of kind ::CCL_BATCH_ARG_LENGTH.
+ *
+ * @public @memberof ccl_batch
+ *
+ * @param[in] src OpenCL C source code containing the kernel.
+ * @param[in] kernel_name Name of the kernel.
+ * @param[in] args Description of each kernel argument, in order.
+ * @param[in] num_args Number of kernel arguments.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return The batched kernel source, which should be freed with
+ * g_free(), or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+char* ccl_batch_get_source(const char* src, const char* kernel_name,
+	const CCLBatchArg* args, cl_uint num_args, CCLErr** err) {
+
+	/* Make sure src and kernel_name are not NULL. */
+	g_return_val_if_fail((src != NULL) && (kernel_name != NULL), NULL);
+	/* Make sure args is not NULL. */
+	g_return_val_if_fail(args != NULL, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Source being generated. */
+	GString* out = NULL;
+	/* Source to return. */
+	char* out_str = NULL;
+	/* Positions of the kernel within the original source. */
+	size_t kstart, pstart, pend, bend;
+	/* Original parameter list and declarations. */
+	gchar* params = NULL;
+	gchar** decls = NULL;
+
+	/* Find kernel. */
+	g_if_err_create_goto(*err, CCL_ERROR,
+		!ccl_batch_find_kernel(src, kernel_name,
+			&kstart, &pstart, &pend, &bend),
+		CCL_ERROR_ARGS, error_handler,
+		"%s: kernel '%s' not found in source.", CCL_STRD, kernel_name);
+
+	/* Check that parameters match the argument descriptions. */
+	params = g_strndup(src + pstart + 1, pend - pstart - 1);
+	decls = g_strsplit(params, ",", -1);
+	g_if_err_create_goto(*err, CCL_ERROR,
+		g_strv_length(decls) != num_args,
+		CCL_ERROR_ARGS, error_handler,
+		"%s: kernel '%s' has %u parameters, but %u arguments were "
+		"described.", CCL_STRD, kernel_name, g_strv_length(decls),
+		num_args);
+	for (cl_uint k = 0; k < num_args; ++k) {
+		g_strstrip(decls[k]);
+		g_if_err_create_goto(*err, CCL_ERROR,
+			*ccl_batch_param_name(decls[k]) == '\0',
+			CCL_ERROR_ARGS, error_handler,
+			"%s: unable to parse parameter %u of kernel '%s'.",
+			CCL_STRD, k, kernel_name);
+		g_if_err_create_goto(*err, CCL_ERROR,
+			(int) args[k].kind < 0 || args[k].kind > CCL_BATCH_ARG_LENGTH,
+			CCL_ERROR_ARGS, error_handler,
+			"%s: unknown kind %d of argument %u.",
+			CCL_STRD, (int) args[k].kind, k);
+		g_if_err_create_goto(*err, CCL_ERROR,
+			ccl_batch_is_array(args[k].kind)
+			&& ((args[k].elem_size == 0) || !strchr(decls[k], '*')),
+			CCL_ERROR_ARGS, error_handler,
+			"%s: parameter %u of kernel '%s' is not a pointer, or "
+			"element size is zero.", CCL_STRD, k, kernel_name);
+	}
+
+	/* Source before the kernel. */
+	out = g_string_new(NULL);
+	g_string_append_printf(out,
+		"/* Batched launch of kernel '%s' */\n", kernel_name);
+	g_string_append_len(out, src, kstart);
+
+	/* The kernel, as a function of the index within the instance and
+	 * of the instance length. */
+	g_string_append(out, "\n"
+		"#define get_global_id(d) "
+		"((d) == 0 ? ccl_batch_i : get_global_id(d))\n"
+		"#define get_global_size(d) "
+		"((d) == 0 ? ccl_batch_n : get_global_size(d))\n");
+	g_string_append_printf(out,
+		"void ccl_batch_%s(size_t ccl_batch_i, size_t ccl_batch_n, ",
+		kernel_name);
+	g_string_append_len(out, src + pstart + 1, bend - pstart);
+	g_string_append(out, "\n"
+		"#undef get_global_id\n"
+		"#undef get_global_size\n");
+
+	/* Source after the kernel. */
+	g_string_append(out, src + bend + 1);
+
+	/* Batched kernel parameters. */
+	g_string_append(out, "\n__kernel void " CCL_BATCH_KERNEL
+		"(__global const ulong* ccl_offs, uint ccl_num");
+	for (cl_uint k = 0; k < num_args; ++k) {
+		if (args[k].kind != CCL_BATCH_ARG_LENGTH)
+			g_string_append_printf(out, ",\n\t%s", decls[k]);
+	}
+	g_string_append(out, ")\n{\n");
+
+	/* Batched kernel body: find the instance of the current work-item,
+	 * i.e. the last one whose offset is not above the global ID, then
+	 * call the original kernel for it. */
+	g_string_append(out,
+		"\tulong ccl_g = get_global_id(0);\n"
+		"\tuint ccl_lo = 0, ccl_hi = ccl_num;\n"
+		"\tif (ccl_g >= ccl_offs[ccl_num]) return;\n"
+		"\twhile (ccl_hi - ccl_lo > 1) {\n"
+		"\t\tuint ccl_mid = (ccl_lo + ccl_hi) / 2;\n"
+		"\t\tif (ccl_offs[ccl_mid] <= ccl_g) ccl_lo = ccl_mid;\n"
+		"\t\telse ccl_hi = ccl_mid;\n"
+		"\t}\n");
+	g_string_append_printf(out, "\tccl_batch_%s(ccl_g - ccl_offs[ccl_lo],\n"
+		"\t\tccl_offs[ccl_lo + 1] - ccl_offs[ccl_lo]", kernel_name);
+	for (cl_uint k = 0; k < num_args; ++k) {
+		const char* name = ccl_batch_param_name(decls[k]);
+		if (ccl_batch_is_array(args[k].kind))
+			g_string_append_printf(out,
+				",\n\t\t%s + ccl_offs[ccl_lo]", name);
+		else if (args[k].kind == CCL_BATCH_ARG_LENGTH)
+			g_string_append(out,
+				",\n\t\tccl_offs[ccl_lo + 1] - ccl_offs[ccl_lo]");
+		else
+			g_string_append_printf(out, ",\n\t\t%s", name);
+	}
+	g_string_append(out, ");\n}\n");
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	out_str = g_string_free(out, FALSE);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	if (out != NULL) g_string_free(out, TRUE);
+
+finish:
+
+	/* Release temporary objects. */
+	g_free(params);
+	g_strfreev(decls);
+
+	/* Return source. */
+	return out_str;
+
+}
+
+/**
+ * Add an instance to the next batched launch.
+ *
+ * The host arrays of the instance are only accessed by the next call to
+ * ::ccl_batch_enqueue(), which packs the input arrays and unpacks the
+ * output arrays, so they must remain valid until then.
+ *
+ * @public @memberof ccl_batch
+ *
+ * @param[in] batch Batcher.
+ * @param[in] length Number of elements of the instance, i.e. of each of
+ * its arrays.
+ * @param[in] data Array with one entry per kernel argument, containing
+ * the host array of the instance for per-instance array arguments, and
+ * ignored for other arguments. May be `NULL` if there are no
+ * per-instance array arguments.
+ * */
+CCL_EXPORT
+void ccl_batch_add(CCLBatch* batch, size_t length, void** data) {
+
+	/* Make sure batch is not NULL. */
+	g_return_if_fail(batch != NULL);
+
+	g_array_append_val(batch->lengths, length);
+	for (cl_uint k = 0; k < batch->num_args; ++k)
+		g_ptr_array_add(batch->data, data != NULL ? data[k] : NULL);
+
+}
+
+/**
+ * Launch all added instances with a single kernel launch.
+ *
+ * The input arrays of all instances are packed into the respective
+ * arenas and written to the device, the batched kernel is launched with
+ * one work-item per element of all instances, and the output arrays are
+ * read back and unpacked to the instances' host arrays. This function
+ * returns once the output arrays are unpacked (or once the kernel
+ * completes, if there are no output arrays). Instances are removed from
+ * the batcher if the launch succeeds.
+ *
+ * @public @memberof ccl_batch
+ *
+ * @param[in] batch Batcher.
+ * @param[in] cq Command queue wrapper object.
+ * @param[in] shared Array with one entry per kernel argument, containing
+ * the value of shared arguments (as given to ::ccl_kernel_set_arg()),
+ * and ignored for other arguments. May be `NULL` if there are no
+ * shared arguments.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return Event wrapper object that identifies the batched kernel
+ * execution, or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLEvent* ccl_batch_enqueue(CCLBatch* batch, CCLQueue* cq,
+	void** shared, CCLErr** err) {
+
+	/* Make sure batch is not NULL. */
+	g_return_val_if_fail(batch != NULL, NULL);
+	/* Make sure cq is not NULL. */
+	g_return_val_if_fail(cq != NULL, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Event wrapper to return. */
+	CCLEvent* evt = NULL;
+	/* Events which the batched kernel waits on. */
+	CCLEventWaitList ewl = NULL;
+	/* Batched kernel. */
+	CCLKernel* krnl;
+	/* Number of instances. */
+	cl_uint num = batch->lengths->len;
+	/* Instance lengths and host arrays. */
+	size_t* lengths = (size_t*) batch->lengths->data;
+	void** data = batch->data->pdata;
+	/* Table of instance offsets. */
+	CCLBatchArena* offs_arena = &batch->arenas[batch->num_args];
+	cl_ulong* offs;
+	/* Do any arguments need to be unpacked? */
+	gboolean has_out = FALSE;
+	/* Kernel argument index. */
+	cl_uint arg_idx = 0;
+	/* Global work size. */
+	size_t gws;
+	/* Internal error object. */
+	CCLErr* err_internal = NULL;
+
+	g_if_err_create_goto(*err, CCL_ERROR, num == 0,
+		CCL_ERROR_ARGS, error_handler,
+		"%s: no instances were added.", CCL_STRD);
+
+	/* Determine offsets of instances, in elements. */
+	ccl_batch_arena_reserve(batch, offs_arena,
+		(num + 1) * sizeof(cl_ulong), &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	offs = (cl_ulong*) offs_arena->host;
+	offs[0] = 0;
+	for (cl_uint p = 0; p < num; ++p)
+		offs[p + 1] = offs[p] + lengths[p];
+	g_if_err_create_goto(*err, CCL_ERROR, offs[num] == 0,
+		CCL_ERROR_ARGS, error_handler,
+		"%s: instances have no elements.", CCL_STRD);
+	gws = (size_t) offs[num];
+
+	evt = ccl_buffer_enqueue_write(offs_arena->buf, cq, CL_FALSE, 0,
+		(num + 1) * sizeof(cl_ulong), offs, NULL, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	ccl_event_wait_list_add(&ewl, evt, NULL);
+
+	/* Get kernel and set the offsets table and number of instances. */
+	krnl = ccl_program_get_kernel(batch->prg, CCL_BATCH_KERNEL,
+		&err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	ccl_kernel_set_arg(krnl, arg_idx++, offs_arena->buf);
+	ccl_kernel_set_arg(krnl, arg_idx++, ccl_arg_priv(num, cl_uint));
+
+	/* Pack input arrays and set the original kernel arguments. */
+	for (cl_uint k = 0; k < batch->num_args; ++k) {
+
+		CCLBatchArg* arg = &batch->args[k];
+		CCLBatchArena* arena = &batch->arenas[k];
+
+		switch (arg->kind) {
+
+			case CCL_BATCH_ARG_IN:
+			case CCL_BATCH_ARG_INOUT:
+			case CCL_BATCH_ARG_OUT:
+
+				ccl_batch_arena_reserve(
+					batch, arena, gws * arg->elem_size, &err_internal);
+				g_if_err_propagate_goto(err, err_internal, error_handler);
+
+				if (arg->kind == CCL_BATCH_ARG_OUT) {
+					has_out = TRUE;
+				} else {
+					if (arg->kind == CCL_BATCH_ARG_INOUT) has_out = TRUE;
+					for (cl_uint p = 0; p < num; ++p) {
+						void* ptr = data[p * batch->num_args + k];
+						g_if_err_create_goto(*err, CCL_ERROR,
+							(ptr == NULL) && (lengths[p] > 0),
+							CCL_ERROR_ARGS, error_handler,
+							"%s: instance %u has no array for argument %u.",
+							CCL_STRD, p, k);
+						if (lengths[p] > 0)
+							memcpy((char*) arena->host
+								+ offs[p] * arg->elem_size,
+								ptr, lengths[p] * arg->elem_size);
+					}
+					evt = ccl_buffer_enqueue_write(arena->buf, cq,
+						CL_FALSE, 0, gws * arg->elem_size, arena->host,
+						NULL, &err_internal);
+					g_if_err_propagate_goto(err, err_internal, error_handler);
+					ccl_event_wait_list_add(&ewl, evt, NULL);
+				}
+				ccl_kernel_set_arg(krnl, arg_idx++, arena->buf);
+				break;
+
+			case CCL_BATCH_ARG_SHARED:
+
+				g_if_err_create_goto(*err, CCL_ERROR,
+					(shared == NULL) || (shared[k] == NULL),
+					CCL_ERROR_ARGS, error_handler,
+					"%s: no value for shared argument %u.", CCL_STRD, k);
+				ccl_kernel_set_arg(krnl, arg_idx++, shared[k]);
+				break;
+
+			case CCL_BATCH_ARG_LENGTH:
+				break;
+		}
+	}
+
+	/* Launch batched kernel, one work-item per element of all
+	 * instances. */
+	evt = ccl_kernel_enqueue_ndrange(krnl, cq, 1, NULL, &gws, NULL,
+		&ewl, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Unpack output arrays, or wait for the kernel so that the staging
+	 * areas can be reused. */
+	for (cl_uint k = 0; k < batch->num_args; ++k) {
+
+		CCLBatchArg* arg = &batch->args[k];
+		CCLBatchArena* arena = &batch->arenas[k];
+
+		if ((arg->kind != CCL_BATCH_ARG_OUT)
+			&& (arg->kind != CCL_BATCH_ARG_INOUT))
+			continue;
+
+		ccl_buffer_enqueue_read(arena->buf, cq, CL_TRUE, 0,
+			gws * arg->elem_size, arena->host,
+			ccl_ewl(&ewl, evt, NULL), &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+		for (cl_uint p = 0; p < num; ++p) {
+			void* ptr = data[p * batch->num_args + k];
+			g_if_err_create_goto(*err, CCL_ERROR,
+				(ptr == NULL) && (lengths[p] > 0),
+				CCL_ERROR_ARGS, error_handler,
+				"%s: instance %u has no array for argument %u.",
+				CCL_STRD, p, k);
+			if (lengths[p] > 0)
+				memcpy(ptr, (char*) arena->host + offs[p] * arg->elem_size,
+					lengths[p] * arg->elem_size);
+		}
+	}
+	if (!has_out) {
+		ccl_event_wait(ccl_ewl(&ewl, evt, NULL), &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+	}
+
+	/* Remove launched instances. */
+	g_array_set_size(batch->lengths, 0);
+	g_ptr_array_set_size(batch->data, 0);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	evt = NULL;
+
+finish:
+
+	/* Release the event wait list, if it was not consumed. */
+	ccl_event_wait_list_clear(&ewl);
+
+	/* Return event. */
+	return evt;
+
+}
+
+/**
+ * Get the number of instances added for the next batched launch.
+ *
+ * @public @memberof ccl_batch
+ *
+ * @param[in] batch Batcher.
+ * @return Number of instances added since the last successful launch.
+ * */
+CCL_EXPORT
+cl_uint ccl_batch_get_num_problems(CCLBatch* batch) {
+
+	/* Make sure batch is not NULL. */
+	g_return_val_if_fail(batch != NULL, 0);
+
+	return batch->lengths->len;
+
+}
+
+/** @} */
@@ -0,0 +1,200 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+ /**
+ * @file
+ *
+ * Definition of a batcher which packs many small independent problems
+ * into a single kernel launch.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#ifndef _CCL_BATCH_H_
+#define _CCL_BATCH_H_
+
+#include "ccl_common.h"
+#include "ccl_context_wrapper.h"
+#include "ccl_event_wrapper.h"
+#include "ccl_queue_wrapper.h"
+
+/**
+ * @defgroup CCL_BATCH Batched launches
+ *
+ * This module runs many small independent instances of a problem, e.g.
+ * thousands of short vectors to sum, with a single kernel launch
+ * instead of one launch (plus transfers) per instance, which for small
+ * instances is dominated by launch overhead.
+ *
+ * A batcher is created for an existing kernel, written to process one
+ * instance with one work-item per element, such as the `sum` kernel of
+ * the canonical example. Each kernel argument is described by a
+ * ::CCLBatchArg, initialized with the `ccl_batch_arg_*()` macros:
+ * per-instance input and output arrays are packed into contiguous
+ * buffers (arenas), a scalar argument may receive the instance length,
+ * and the remaining arguments are shared by all instances.
+ *
+ * The kernel is renamed into a regular function, and a thin generated
+ * kernel maps each global ID to an instance and an index within it,
+ * using a table of instance offsets, and calls the function with the
+ * arena pointers offset to the instance's data. Within the original
+ * kernel, `get_global_id(0)` and `get_global_size(0)` return the index
+ * within the instance and the instance length. As such, the original
+ * kernel must not use those functions in helper functions, nor depend
+ * on work-groups (local IDs, barriers or local memory shared between
+ * work-items), since work-groups may span several instances. All arena
+ * arguments of an instance have the same number of elements, namely
+ * the instance length.
+ *
+ * Instances are added with ::ccl_batch_add() and run with
+ * ::ccl_batch_enqueue(), which packs their input data, launches the
+ * generated kernel over all their elements, and unpacks the outputs to
+ * the instances' host arrays. Arenas are kept and reused between
+ * enqueues. A batcher should not be used concurrently by several
+ * threads.
+ *
+ * _Example:_
+ *
+ * @code{.c}
+ * CCLBatchArg args[] = {
+ *     ccl_batch_arg_in(cl_uint), ccl_batch_arg_in(cl_uint),
+ *     ccl_batch_arg_out(cl_uint), ccl_batch_arg_shared(),
+ *     ccl_batch_arg_length()
+ * };
+ * CCLBatch* batch = ccl_batch_new(ctx, src, "sum", args, 5, &err);
+ * @endcode
+ * @code{.c}
+ * for (cl_uint p = 0; p < num_problems; ++p) {
+ *     void* data[] = { a[p], b[p], c[p], NULL, NULL };
+ *     ccl_batch_add(batch, lengths[p], data);
+ * }
+ * void* shared[] = { NULL, NULL, NULL, ccl_arg_priv(d, cl_uint), NULL };
+ * ccl_batch_enqueue(batch, cq, shared, &err);
+ * @endcode
+ * @code{.c}
+ * ccl_batch_destroy(batch);
+ * @endcode
+ *
+ * @{
+ */
+
+/**
+ * Kinds of kernel arguments in batched launches.
+ * */
+typedef enum ccl_batch_arg_kind {
+
+	/** Argument shared by all instances, given to ::ccl_batch_enqueue(). */
+	CCL_BATCH_ARG_SHARED = 0,
+
+	/** Per-instance input array, packed into an arena. */
+	CCL_BATCH_ARG_IN     = 1,
+
+	/** Per-instance output array, unpacked from an arena. */
+	CCL_BATCH_ARG_OUT    = 2,
+
+	/** Per-instance array which is both packed and unpacked. */
+	CCL_BATCH_ARG_INOUT  = 3,
+
+	/** Scalar argument which receives the instance length. */
+	CCL_BATCH_ARG_LENGTH = 4
+
+} CCLBatchArgKind;
+
+/**
+ * Description of a kernel argument in batched launches. Should be
+ * initialized with one of the `ccl_batch_arg_*()` macros.
+ * */
+typedef struct ccl_batch_arg {
+
+	/** Kind of argument. */
+	CCLBatchArgKind kind;
+
+	/** Size of array elements, for per-instance arrays. */
+	size_t elem_size;
+
+} CCLBatchArg;
+
+/**
+ * Argument shared by all instances.
+ * */
+#define ccl_batch_arg_shared() { CCL_BATCH_ARG_SHARED, 0 }
+
+/**
+ * Per-instance input array.
+ *
+ * @param[in] type Host type of array elements, e.g. `cl_uint`.
+ * */
+#define ccl_batch_arg_in(type) { CCL_BATCH_ARG_IN, sizeof(type) }
+
+/**
+ * Per-instance output array.
+ *
+ * @param[in] type Host type of array elements, e.g. `cl_uint`.
+ * */
+#define ccl_batch_arg_out(type) { CCL_BATCH_ARG_OUT, sizeof(type) }
+
+/**
+ * Per-instance input and output array.
+ *
+ * @param[in] type Host type of array elements, e.g. `cl_uint`.
+ * */
+#define ccl_batch_arg_inout(type) { CCL_BATCH_ARG_INOUT, sizeof(type) }
+
+/**
+ * Scalar argument which receives the instance length.
+ * */
+#define ccl_batch_arg_length() { CCL_BATCH_ARG_LENGTH, 0 }
+
+/**
+ * Batcher of small independent problems.
+ *
+ * @see ccl_batch_new()
+ * */
+typedef struct ccl_batch CCLBatch;
+
+/* Create a new batcher for the given kernel. */
+CCL_EXPORT
+CCLBatch* ccl_batch_new(CCLContext* ctx, const char* src,
+	const char* kernel_name, const CCLBatchArg* args, cl_uint num_args,
+	CCLErr** err);
+
+/* Destroy a batcher. */
+CCL_EXPORT
+void ccl_batch_destroy(CCLBatch* batch);
+
+/* Generate the source of the batched kernel for the given kernel. */
+CCL_EXPORT
+char* ccl_batch_get_source(const char* src, const char* kernel_name,
+	const CCLBatchArg* args, cl_uint num_args, CCLErr** err);
+
+/* Add an instance to the next batched launch. */
+CCL_EXPORT
+void ccl_batch_add(CCLBatch* batch, size_t length, void** data);
+
+/* Launch all added instances with a single kernel launch. */
+CCL_EXPORT
+CCLEvent* ccl_batch_enqueue(CCLBatch* batch, CCLQueue* cq,
+	void** shared, CCLErr** err);
+
+/* Get the number of instances added for the next batched launch. */
+CCL_EXPORT
+cl_uint ccl_batch_get_num_problems(CCLBatch* batch);
+
+/** @} */
+
+#endif
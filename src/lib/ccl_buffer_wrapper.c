@@ -29,8 +29,71 @@
 
 #include "ccl_buffer_wrapper.h"
 #include "ccl_image_wrapper.h"
+#include "ccl_kernel_arg.h"
+#include "ccl_kernel_wrapper.h"
+#include "_ccl_context_wrapper.h"
+#include "_ccl_event_wrapper.h"
 #include "_ccl_memobj_wrapper.h"
+#include "_ccl_queue_wrapper.h"
 #include "_ccl_defs.h"
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/**
+ * @internal
+ * Minimum transfer size for which ::CCL_BUFFER_TRANSFER_AUTO selects
+ * the mapped, multi-threaded path.
+ * */
+#define CCL_BUFFER_MT_MIN_SIZE (4 * 1024 * 1024)
+
+/**
+ * @internal
+ * Minimum number of bytes copied by each thread in the mapped path.
+ * */
+#define CCL_BUFFER_MT_CHUNK_MIN (1024 * 1024)
+
+/**
+ * @internal
+ * Maximum number of threads used to copy in the mapped path.
+ * */
+#define CCL_BUFFER_MT_MAX_THREADS 32
+
+/**
+ * @internal
+ * Largest pattern supported by buffer fills.
+ * */
+#define CCL_BUFFER_FILL_MAX_PATTERN 128
+
+/**
+ * @internal
+ * Source of the fill kernel used when the platform does not support
+ * clEnqueueFillBuffer(). The pattern is replicated to 128 bytes, such that
+ * byte `p` of the buffer gets byte `p % 128` of the replicated pattern.
+ * Each work-item writes 16 aligned bytes, and the first one also writes
+ * the unaligned head and tail of the region.
+ * */
+static const char* ccl_buffer_fill_src =
+	"__kernel void ccl_fill_buffer(__global uchar* buf, ulong start,\n"
+	"	ulong end, ulong16 pat)\n"
+	"{\n"
+	"	union { ulong16 v; uint4 c[8]; uchar b[128]; } u;\n"
+	"	ulong a0 = (start + 15) & ~((ulong) 15);\n"
+	"	ulong a1 = end & ~((ulong) 15);\n"
+	"	ulong p = a0 + get_global_id(0) * 16;\n"
+	"	u.v = pat;\n"
+	"	if (a0 >= a1) {\n"
+	"		a0 = end;\n"
+	"		a1 = end;\n"
+	"	} else if (p < a1) {\n"
+	"		*((__global uint4*) (buf + p)) = u.c[(p / 16) % 8];\n"
+	"	}\n"
+	"	if (get_global_id(0) == 0) {\n"
+	"		for (p = start; p < a0; ++p) buf[p] = u.b[p % 128];\n"
+	"		for (p = a1; p < end; ++p) buf[p] = u.b[p % 128];\n"
+	"	}\n"
+	"}\n";
 
 /**
  * Buffer wrapper class
@@ -186,6 +249,11 @@ CCLEvent* ccl_buffer_enqueue_read(CCLBuffer* buf, CCLQueue* cq,
 	cl_int ocl_status;
 	cl_event event = NULL;
 	CCLEvent* evt = NULL;
+	CCLErr* err_internal = NULL;
+
+	/* Wait for room in the queue, if it has an in-flight limit. */
+	ccl_queue_inflight_acquire(cq, size, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
 
 	ocl_status = clEnqueueReadBuffer(ccl_queue_unwrap(cq),
 		ccl_memobj_unwrap(buf), blocking_read, offset, size, ptr,
@@ -201,6 +269,11 @@ CCLEvent* ccl_buffer_enqueue_read(CCLBuffer* buf, CCLQueue* cq,
 	 * queue is released. */
 	evt = ccl_queue_produce_event(cq, event);
 
+	/* Record access, for redundant transfer analysis. The read data is
+	 * only available at this point for blocking reads. */
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_DOWNLOAD,
+		ccl_memobj_unwrap(buf), offset, size, blocking_read ? ptr : NULL);
+
 	/* Clear event wait list. */
 	ccl_event_wait_list_clear(evt_wait_lst);
 
@@ -215,6 +288,9 @@ error_handler:
 	/* An error occurred, return NULL to signal it. */
 	evt = NULL;
 
+	/* The command was not enqueued, so it is not in flight. */
+	ccl_queue_inflight_cancel(cq);
+
 finish:
 
 	/* Return event. */
@@ -261,6 +337,11 @@ CCLEvent* ccl_buffer_enqueue_write(CCLBuffer* buf, CCLQueue* cq,
 	cl_int ocl_status;
 	cl_event event = NULL;
 	CCLEvent* evt = NULL;
+	CCLErr* err_internal = NULL;
+
+	/* Wait for room in the queue, if it has an in-flight limit. */
+	ccl_queue_inflight_acquire(cq, size, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
 
 	ocl_status = clEnqueueWriteBuffer(ccl_queue_unwrap(cq),
 		ccl_memobj_unwrap(buf), blocking_write, offset, size, ptr,
@@ -276,6 +357,10 @@ CCLEvent* ccl_buffer_enqueue_write(CCLBuffer* buf, CCLQueue* cq,
 	 * queue is released. */
 	evt = ccl_queue_produce_event(cq, event);
 
+	/* Record access, for redundant transfer analysis. */
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_UPLOAD,
+		ccl_memobj_unwrap(buf), offset, size, ptr);
+
 	/* Clear event wait list. */
 	ccl_event_wait_list_clear(evt_wait_lst);
 
@@ -290,6 +375,9 @@ error_handler:
 	/* An error occurred, return NULL to signal it. */
 	evt = NULL;
 
+	/* The command was not enqueued, so it is not in flight. */
+	ccl_queue_inflight_cancel(cq);
+
 finish:
 
 	/* Return event. */
@@ -357,6 +445,11 @@ void* ccl_buffer_enqueue_map(CCLBuffer* buf, CCLQueue* cq,
 	 * The event object will be released automatically when the command
 	 * queue is released. */
 	evt_inner = ccl_queue_produce_event(cq, event);
+
+	/* Record access, for redundant transfer analysis. Mapped regions may
+	 * be modified by the host unless mapped for reading only. */
+	ccl_event_add_mem_access(evt_inner, ccl_event_map_access(map_flags),
+		ccl_memobj_unwrap(buf), offset, size, NULL);
 	if (evt != NULL)
 		*evt = evt_inner;
 
@@ -381,6 +474,402 @@ finish:
 
 }
 
+/**
+ * @internal
+ * Copy memory using non-temporal stores where available, so that large
+ * copies don't evict useful data from the cache.
+ *
+ * @param[out] dst Destination.
+ * @param[in] src Source.
+ * @param[in] size Number of bytes to copy.
+ * */
+static void ccl_buffer_memcpy_nt(void* dst, const void* src, size_t size) {
+
+#ifdef __SSE2__
+
+	guchar* d = (guchar*) dst;
+	const guchar* s = (const guchar*) src;
+
+	/* Align destination to 16 bytes. */
+	size_t head = (16 - (GPOINTER_TO_SIZE(d) & 15)) & 15;
+	if (head > size) head = size;
+	memcpy(d, s, head);
+	d += head; s += head; size -= head;
+
+	/* Stream 64 bytes at a time. */
+	for (; size >= 64; size -= 64, d += 64, s += 64) {
+		__m128i v0 = _mm_loadu_si128((const __m128i*) s);
+		__m128i v1 = _mm_loadu_si128((const __m128i*) (s + 16));
+		__m128i v2 = _mm_loadu_si128((const __m128i*) (s + 32));
+		__m128i v3 = _mm_loadu_si128((const __m128i*) (s + 48));
+		_mm_stream_si128((__m128i*) d, v0);
+		_mm_stream_si128((__m128i*) (d + 16), v1);
+		_mm_stream_si128((__m128i*) (d + 32), v2);
+		_mm_stream_si128((__m128i*) (d + 48), v3);
+	}
+
+	/* Copy the remaining bytes and make streamed stores visible. */
+	memcpy(d, s, size);
+	_mm_sfence();
+
+#else
+
+	memcpy(dst, src, size);
+
+#endif
+
+}
+
+/**
+ * @internal
+ * Part of a parallel host copy.
+ * */
+typedef struct ccl_buffer_copy_chunk {
+
+	/** Destination. */
+	guchar* dst;
+	/** Source. */
+	const guchar* src;
+	/** Number of bytes to copy. */
+	size_t size;
+
+} CCLBufferCopyChunk;
+
+/**
+ * @internal
+ * Thread function which copies one chunk of a parallel host copy.
+ *
+ * @param[in] data A ::CCLBufferCopyChunk object.
+ * @return Always `NULL`.
+ * */
+static gpointer ccl_buffer_copy_thread(gpointer data) {
+
+	CCLBufferCopyChunk* chunk = (CCLBufferCopyChunk*) data;
+	ccl_buffer_memcpy_nt(chunk->dst, chunk->src, chunk->size);
+	return NULL;
+
+}
+
+/**
+ * @internal
+ * Copy host memory using several threads, one chunk of at least
+ * ::CCL_BUFFER_MT_CHUNK_MIN bytes per thread. The calling thread copies
+ * the first chunk.
+ *
+ * @param[out] dst Destination.
+ * @param[in] src Source.
+ * @param[in] size Number of bytes to copy.
+ * */
+static void ccl_buffer_copy_parallel(void* dst, const void* src,
+	size_t size) {
+
+	CCLBufferCopyChunk chunks[CCL_BUFFER_MT_MAX_THREADS];
+	GThread* threads[CCL_BUFFER_MT_MAX_THREADS];
+	guint num_threads;
+	size_t chunk_size, offset;
+
+#if GLIB_CHECK_VERSION(2, 36, 0)
+	num_threads = g_get_num_processors();
+#else
+	num_threads = 4;
+#endif
+	num_threads = MIN(num_threads, CCL_BUFFER_MT_MAX_THREADS);
+	num_threads = MIN(num_threads, MAX(size / CCL_BUFFER_MT_CHUNK_MIN, 1));
+
+	/* Chunks are multiples of the cache line size. */
+	chunk_size = ((size / num_threads) + 63) & ~((size_t) 63);
+
+	/* Split copy among threads; if a thread can't be created, its
+	 * chunk is copied by the calling thread. */
+	num_threads = 0;
+	for (offset = 0; offset < size; offset += chunk_size) {
+		chunks[num_threads].dst = (guchar*) dst + offset;
+		chunks[num_threads].src = (const guchar*) src + offset;
+		chunks[num_threads].size = MIN(chunk_size, size - offset);
+		threads[num_threads] = (num_threads == 0) ? NULL
+			: g_thread_try_new("ccl_copy", ccl_buffer_copy_thread,
+				&chunks[num_threads], NULL);
+		num_threads++;
+	}
+	for (guint i = 0; i < num_threads; ++i)
+		if (threads[i] == NULL) ccl_buffer_copy_thread(&chunks[i]);
+	for (guint i = 0; i < num_threads; ++i)
+		if (threads[i] != NULL) g_thread_join(threads[i]);
+
+}
+
+/**
+ * @internal
+ * Determine if a transfer should use the mapped, multi-threaded path,
+ * i.e. if it is large and the queue device is a CPU or shares memory
+ * with the host.
+ *
+ * @param[in] cq Command-queue wrapper object.
+ * @param[in] size Transfer size in bytes.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return `CL_TRUE` if the mapped path should be used, `CL_FALSE`
+ * otherwise or if an error occurs.
+ * */
+static cl_bool ccl_buffer_use_mapped_transfer(CCLQueue* cq, size_t size,
+	CCLErr** err) {
+
+	/* Use mapped path? */
+	cl_bool mapped = CL_FALSE;
+	/* Queue device and its type. */
+	CCLDevice* dev;
+	cl_device_type type;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Small transfers don't benefit from multiple threads. */
+	if (size < CCL_BUFFER_MT_MIN_SIZE) goto finish;
+
+	dev = ccl_queue_get_device(cq, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	type = ccl_device_get_info_scalar(
+		dev, CL_DEVICE_TYPE, cl_device_type, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	if (type & CL_DEVICE_TYPE_CPU) {
+		mapped = CL_TRUE;
+	} else {
+#ifdef CL_DEVICE_HOST_UNIFIED_MEMORY
+		/* Deprecated in OpenCL 2.0, so a failed query just means we
+		 * don't know. */
+		mapped = ccl_device_get_info_scalar(dev,
+			CL_DEVICE_HOST_UNIFIED_MEMORY, cl_bool, &err_internal);
+		if (err_internal != NULL) {
+			g_clear_error(&err_internal);
+			mapped = CL_FALSE;
+		}
+#endif
+	}
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	mapped = CL_FALSE;
+
+finish:
+
+	/* Return decision. */
+	return mapped;
+
+}
+
+/**
+ * @internal
+ * Implementation of ::ccl_buffer_enqueue_read_mt() and
+ * ::ccl_buffer_enqueue_write_mt().
+ *
+ * @param[in] buf Buffer wrapper object.
+ * @param[in] cq Command-queue wrapper object.
+ * @param[in] read Read from (`CL_TRUE`) or write to (`CL_FALSE`) the
+ * buffer?
+ * @param[in] mode Transfer mode.
+ * @param[in] offset The offset in bytes in the buffer object.
+ * @param[in] size The size in bytes of data being transferred.
+ * @param[in,out] ptr Host memory.
+ * @param[in,out] evt_wait_lst List of events that need to complete
+ * before the transfer can be executed.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return Event wrapper object which identifies the last command of
+ * the transfer, or `NULL` if an error occurs.
+ * */
+static CCLEvent* ccl_buffer_transfer_mt(CCLBuffer* buf, CCLQueue* cq,
+	cl_bool read, CCLBufferTransferMode mode, size_t offset, size_t size,
+	void* ptr, CCLEventWaitList* evt_wait_lst, CCLErr** err) {
+
+	/* Event of the last command. */
+	CCLEvent* evt = NULL;
+	/* Mapped region. */
+	void* map;
+	/* Map flags. */
+	cl_map_flags map_flags;
+	/* Use mapped path? */
+	cl_bool mapped;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Choose path. */
+	if (mode == CCL_BUFFER_TRANSFER_AUTO) {
+		mapped = ccl_buffer_use_mapped_transfer(cq, size, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+	} else {
+		mapped = (mode == CCL_BUFFER_TRANSFER_MAPPED);
+	}
+
+	if (!mapped) {
+
+		/* Let the driver do the copy. */
+		evt = read
+			? ccl_buffer_enqueue_read(buf, cq, CL_TRUE, offset, size,
+				ptr, evt_wait_lst, &err_internal)
+			: ccl_buffer_enqueue_write(buf, cq, CL_TRUE, offset, size,
+				ptr, evt_wait_lst, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	} else {
+
+		/* When writing, the previous contents of the region are not
+		 * needed. */
+		map_flags = read ? CL_MAP_READ : CL_MAP_WRITE;
+#ifdef CL_VERSION_1_2
+		if (!read) {
+			cl_uint ocl_ver = ccl_memobj_get_opencl_version(
+				(CCLMemObj*) buf, &err_internal);
+			g_if_err_propagate_goto(err, err_internal, error_handler);
+			if (ocl_ver >= 120)
+				map_flags = CL_MAP_WRITE_INVALIDATE_REGION;
+		}
+#endif
+
+		/* Map region, copy with host threads and unmap. */
+		map = ccl_buffer_enqueue_map(buf, cq, CL_TRUE, map_flags, offset,
+			size, evt_wait_lst, NULL, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		if (read) ccl_buffer_copy_parallel(ptr, map, size);
+		else ccl_buffer_copy_parallel(map, ptr, size);
+
+		evt = ccl_memobj_enqueue_unmap(
+			(CCLMemObj*) buf, cq, map, NULL, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		/* Record transfer, for redundant transfer analysis. */
+		ccl_event_add_mem_access(evt, read ? CCL_EVENT_MEM_DOWNLOAD
+			: CCL_EVENT_MEM_UPLOAD, ccl_memobj_unwrap(buf), offset, size,
+			ptr);
+
+	}
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+	/* An error occurred, return NULL to signal it. */
+	evt = NULL;
+
+finish:
+
+	/* Return event. */
+	return evt;
+
+}
+
+/**
+ * Read from a buffer object to host memory, optionally replacing the
+ * driver's copy with a multi-threaded host copy over a mapped region
+ * of the buffer. On CPU runtimes the driver copy is frequently
+ * single-threaded and limited to a fraction of the host memory
+ * bandwidth.
+ *
+ * Unlike ::ccl_buffer_enqueue_read(), this function always blocks
+ * until the data is available in `ptr`.
+ *
+ * @public @memberof ccl_buffer
+ *
+ * @param[in] buf Buffer wrapper object where to read from.
+ * @param[in] cq Command-queue wrapper object in which the read
+ * commands will be queued.
+ * @param[in] mode Transfer mode. With ::CCL_BUFFER_TRANSFER_AUTO, the
+ * mapped path is used for transfers of at least 4 MiB on CPU devices
+ * and devices with unified host memory.
+ * @param[in] offset The offset in bytes in the buffer object to read
+ * from.
+ * @param[in] size The size in bytes of data being read.
+ * @param[out] ptr The pointer to buffer in host memory where data is to
+ * be read into.
+ * @param[in,out] evt_wait_lst List of events that need to complete
+ * before this command can be executed. The list will be cleared and
+ * can be reused by client code.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return Event wrapper object that identifies the read command (or
+ * the unmap command, for the mapped path), or `NULL` if an error
+ * occurs.
+ * */
+CCL_EXPORT
+CCLEvent* ccl_buffer_enqueue_read_mt(CCLBuffer* buf, CCLQueue* cq,
+	CCLBufferTransferMode mode, size_t offset, size_t size, void *ptr,
+	CCLEventWaitList* evt_wait_lst, CCLErr** err) {
+
+	/* Make sure cq is not NULL. */
+	g_return_val_if_fail(cq != NULL, NULL);
+	/* Make sure buf is not NULL. */
+	g_return_val_if_fail(buf != NULL, NULL);
+	/* Make sure ptr is not NULL. */
+	g_return_val_if_fail(ptr != NULL, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	return ccl_buffer_transfer_mt(buf, cq, CL_TRUE, mode, offset, size,
+		ptr, evt_wait_lst, err);
+
+}
+
+/**
+ * Write to a buffer object from host memory, optionally replacing the
+ * driver's copy with a multi-threaded host copy over a mapped region
+ * of the buffer.
+ *
+ * Unlike ::ccl_buffer_enqueue_write(), this function always blocks
+ * until `ptr` can be reused. With the mapped path, the data is only
+ * guaranteed to be visible to the device once the returned (unmap)
+ * event completes.
+ *
+ * @public @memberof ccl_buffer
+ *
+ * @param[out] buf Buffer wrapper object where to write to.
+ * @param[in] cq Command-queue wrapper object in which the write
+ * commands will be queued.
+ * @param[in] mode Transfer mode. With ::CCL_BUFFER_TRANSFER_AUTO, the
+ * mapped path is used for transfers of at least 4 MiB on CPU devices
+ * and devices with unified host memory.
+ * @param[in] offset The offset in bytes in the buffer object to write
+ * to.
+ * @param[in] size The size in bytes of data being written.
+ * @param[in] ptr The pointer to buffer in host memory where data is to
+ * be written from.
+ * @param[in,out] evt_wait_lst List of events that need to complete
+ * before this command can be executed. The list will be cleared and
+ * can be reused by client code.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return Event wrapper object that identifies the write command (or
+ * the unmap command, for the mapped path), or `NULL` if an error
+ * occurs.
+ * */
+CCL_EXPORT
+CCLEvent* ccl_buffer_enqueue_write_mt(CCLBuffer* buf, CCLQueue* cq,
+	CCLBufferTransferMode mode, size_t offset, size_t size, void *ptr,
+	CCLEventWaitList* evt_wait_lst, CCLErr** err) {
+
+	/* Make sure cq is not NULL. */
+	g_return_val_if_fail(cq != NULL, NULL);
+	/* Make sure buf is not NULL. */
+	g_return_val_if_fail(buf != NULL, NULL);
+	/* Make sure ptr is not NULL. */
+	g_return_val_if_fail(ptr != NULL, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	return ccl_buffer_transfer_mt(buf, cq, CL_FALSE, mode, offset, size,
+		ptr, evt_wait_lst, err);
+
+}
+
 /**
  * Copy from one buffer object to another. This function wraps the
  * clEnqueueCopyBuffer() OpenCL function.
@@ -422,6 +911,11 @@ CCLEvent* ccl_buffer_enqueue_copy(CCLBuffer* src_buf,
 	cl_int ocl_status;
 	cl_event event = NULL;
 	CCLEvent* evt = NULL;
+	CCLErr* err_internal = NULL;
+
+	/* Wait for room in the queue, if it has an in-flight limit. */
+	ccl_queue_inflight_acquire(cq, size, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
 
 	ocl_status = clEnqueueCopyBuffer(ccl_queue_unwrap(cq),
 		ccl_memobj_unwrap(src_buf), ccl_memobj_unwrap(dst_buf),
@@ -438,6 +932,12 @@ CCLEvent* ccl_buffer_enqueue_copy(CCLBuffer* src_buf,
 	 * queue is released. */
 	evt = ccl_queue_produce_event(cq, event);
 
+	/* Record accesses, for redundant transfer analysis. */
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_READ,
+		ccl_memobj_unwrap(src_buf), src_offset, size, NULL);
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_WRITE,
+		ccl_memobj_unwrap(dst_buf), dst_offset, size, NULL);
+
 	/* Clear event wait list. */
 	ccl_event_wait_list_clear(evt_wait_lst);
 
@@ -452,6 +952,9 @@ error_handler:
 	/* An error occurred, return NULL to signal it. */
 	evt = NULL;
 
+	/* The command was not enqueued, so it is not in flight. */
+	ccl_queue_inflight_cancel(cq);
+
 finish:
 
 	/* Return event. */
@@ -526,6 +1029,12 @@ CCLEvent* ccl_buffer_enqueue_copy_to_image(CCLBuffer* src_buf,
 	 * queue is released. */
 	evt = ccl_queue_produce_event(cq, event);
 
+	/* Record accesses, for redundant transfer analysis. */
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_READ,
+		ccl_memobj_unwrap(src_buf), 0, G_MAXSIZE, NULL);
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_USE,
+		ccl_memobj_unwrap(dst_img), 0, G_MAXSIZE, NULL);
+
 	/* Clear event wait list. */
 	ccl_event_wait_list_clear(evt_wait_lst);
 
@@ -768,6 +1277,10 @@ CCLEvent* ccl_buffer_enqueue_read_rect(CCLBuffer* buf, CCLQueue* cq,
 	 * queue is released. */
 	evt = ccl_queue_produce_event(cq, event);
 
+	/* Record access, for redundant transfer analysis. */
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_READ,
+		ccl_memobj_unwrap(buf), 0, G_MAXSIZE, NULL);
+
 	/* Clear event wait list. */
 	ccl_event_wait_list_clear(evt_wait_lst);
 
@@ -911,6 +1424,11 @@ CCLEvent* ccl_buffer_enqueue_write_rect(CCLBuffer* buf, CCLQueue* cq,
 	 * queue is released. */
 	evt = ccl_queue_produce_event(cq, event);
 
+	/* Record access, for redundant transfer analysis. The rectangular
+	 * region is not tracked, so the buffer is marked as modified. */
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_USE,
+		ccl_memobj_unwrap(buf), 0, G_MAXSIZE, NULL);
+
 	/* Clear event wait list. */
 	ccl_event_wait_list_clear(evt_wait_lst);
 
@@ -1050,6 +1568,12 @@ CCLEvent* ccl_buffer_enqueue_copy_rect(CCLBuffer* src_buf,
 	 * queue is released. */
 	evt = ccl_queue_produce_event(cq, event);
 
+	/* Record accesses, for redundant transfer analysis. */
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_READ,
+		ccl_memobj_unwrap(src_buf), 0, G_MAXSIZE, NULL);
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_USE,
+		ccl_memobj_unwrap(dst_buf), 0, G_MAXSIZE, NULL);
+
 	/* Clear event wait list. */
 	ccl_event_wait_list_clear(evt_wait_lst);
 
@@ -1073,12 +1597,109 @@ finish:
 
 }
 
+/**
+ * @internal
+ * Fill a buffer object with a pattern using a kernel, for platforms which
+ * don't support clEnqueueFillBuffer().
+ *
+ * @private @memberof ccl_buffer
+ *
+ * @param[out] buf Buffer wrapper object to fill.
+ * @param[in] cq Command-queue wrapper object in which the fill kernel
+ * will be queued.
+ * @param[in] pattern A pointer to the data pattern.
+ * @param[in] pattern_size Size of data pattern in bytes.
+ * @param[in] offset The location in bytes of the region being filled.
+ * @param[in] size The size in bytes of region being filled.
+ * @param[in,out] evt_wait_lst List of events that need to complete
+ * before this command can be executed.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return Event wrapper object that identifies the fill kernel, or `NULL`
+ * if an error occurs.
+ * */
+static CCLEvent* ccl_buffer_enqueue_fill_kernel(CCLBuffer* buf,
+	CCLQueue* cq, const void *pattern, size_t pattern_size, size_t offset,
+	size_t size, CCLEventWaitList* evt_wait_lst, CCLErr** err) {
+
+	/* Event wrapper object. */
+	CCLEvent* evt = NULL;
+	/* Context of command queue. */
+	CCLContext* ctx;
+	/* Fill program and kernel. */
+	CCLProgram* prg;
+	CCLKernel* krnl;
+	/* Replicated pattern. */
+	cl_ulong16 pat;
+	guchar* pat_bytes = (guchar*) &pat;
+	/* Region limits and their 16-byte aligned counterparts. */
+	cl_ulong start = offset, end = offset + size;
+	cl_ulong a0 = (start + 15) & ~((cl_ulong) 15);
+	cl_ulong a1 = end & ~((cl_ulong) 15);
+	/* Global work size. */
+	size_t gws;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Check arguments, as clEnqueueFillBuffer() would. */
+	g_if_err_create_goto(*err, CCL_ERROR, (pattern == NULL)
+		|| (pattern_size == 0)
+		|| (pattern_size > CCL_BUFFER_FILL_MAX_PATTERN)
+		|| ((pattern_size & (pattern_size - 1)) != 0)
+		|| (offset % pattern_size != 0) || (size % pattern_size != 0),
+		CCL_ERROR_ARGS, error_handler,
+		"%s: invalid pattern, offset or size for buffer fill.", CCL_STRD);
+
+	/* Replicate the pattern. The offset is a multiple of the pattern
+	 * size, so byte p of the buffer gets byte p % pattern_size of the
+	 * pattern. */
+	for (size_t i = 0; i < CCL_BUFFER_FILL_MAX_PATTERN; ++i)
+		pat_bytes[i] = ((const guchar*) pattern)[i % pattern_size];
+
+	/* Get fill kernel, built once per context. */
+	ctx = ccl_queue_get_context(cq, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	prg = ccl_context_get_internal_program(
+		ctx, "ccl_fill_buffer", ccl_buffer_fill_src, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	krnl = ccl_program_get_kernel(prg, "ccl_fill_buffer", &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* One work-item per aligned 16-byte chunk, at least one. */
+	gws = (a1 > a0) ? (size_t) ((a1 - a0) / 16) : 1;
+	evt = ccl_kernel_set_args_and_enqueue_ndrange(krnl, cq, 1, NULL,
+		&gws, NULL, evt_wait_lst, &err_internal,
+		buf, ccl_arg_priv(start, cl_ulong), ccl_arg_priv(end, cl_ulong),
+		ccl_arg_priv(pat, cl_ulong16), NULL);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	evt = NULL;
+
+finish:
+
+	/* Return event. */
+	return evt;
+
+}
+
 /**
  * Fill a buffer object with a pattern of a given pattern size. This
  * function wraps the clEnqueueFillBuffer() OpenCL function.
  *
+ * On platforms which do not support clEnqueueFillBuffer() (OpenCL < 1.2),
+ * or if _cf4ocl_ was built without OpenCL 1.2 support, the buffer is
+ * filled by a kernel bundled with the library, built once per context. The
+ * kernel supports the same pattern sizes, i.e. powers of two up to 128
+ * bytes.
+ *
  * @public @memberof ccl_buffer
- * @note Requires OpenCL >= 1.2
  *
  * @param[out] buf Buffer wrapper object to fill.
  * @param[in] cq Command-queue wrapper object in which the fill command
@@ -1119,60 +1740,55 @@ CCLEvent* ccl_buffer_enqueue_fill(CCLBuffer* buf, CCLQueue* cq,
 	/* Internal error handling object. */
 	CCLErr* err_internal = NULL;
 
-#ifndef CL_VERSION_1_2
+#ifdef CL_VERSION_1_2
 
-	CCL_UNUSED(pattern);
-	CCL_UNUSED(pattern_size);
-	CCL_UNUSED(offset);
-	CCL_UNUSED(size);
-	CCL_UNUSED(evt_wait_lst);
-	CCL_UNUSED(ocl_status);
-	CCL_UNUSED(event);
-	CCL_UNUSED(evt);
-	CCL_UNUSED(ocl_ver);
-	CCL_UNUSED(err_internal);
-
-	/* If cf4ocl was not compiled with support for OpenCL >= 1.2, always throw
-	 * error. */
-	g_if_err_create_goto(*err, CCL_ERROR, TRUE,
-		CCL_ERROR_UNSUPPORTED_OCL, error_handler,
-		"%s: Buffer fill requires cf4ocl to be deployed with "
-		"support for OpenCL version 1.1 or newer.",
-		CCL_STRD);
-
-#else
-
-	/* Check that context platform is >= OpenCL 1.2 */
+	/* Get OpenCL version of the context platform. */
 	ocl_ver = ccl_memobj_get_opencl_version(
 		(CCLMemObj*) buf, &err_internal);
 	g_if_err_propagate_goto(err, err_internal, error_handler);
 
-	/* If OpenCL version is not >= 1.2, throw error. */
-	g_if_err_create_goto(*err, CCL_ERROR, ocl_ver < 120,
-		CCL_ERROR_UNSUPPORTED_OCL, error_handler,
-		"%s: Buffer fill requires OpenCL version 1.2 or newer.",
-		CCL_STRD);
+	/* Use the fill command if the platform supports it. */
+	if (ocl_ver >= 120) {
+
+		/* Fill buffer. */
+		ocl_status = clEnqueueFillBuffer(ccl_queue_unwrap(cq),
+			ccl_memobj_unwrap(buf), pattern, pattern_size, offset, size,
+			ccl_event_wait_list_get_num_events(evt_wait_lst),
+			ccl_event_wait_list_get_clevents(evt_wait_lst), &event);
+		g_if_err_create_goto(*err, CCL_OCL_ERROR,
+			CL_SUCCESS != ocl_status, ocl_status, error_handler,
+			"%s: unable to enqueue a fill buffer command " \
+			"(OpenCL error %d: %s).",
+			CCL_STRD, ocl_status, ccl_err(ocl_status));
+
+		/* Wrap event and associate it with the respective command
+		 * queue. The event object will be released automatically when
+		 * the command queue is released. */
+		evt = ccl_queue_produce_event(cq, event);
+
+		/* Clear event wait list. */
+		ccl_event_wait_list_clear(evt_wait_lst);
+	}
 
-	/* Fill buffer. */
-	ocl_status = clEnqueueFillBuffer(ccl_queue_unwrap(cq),
-		ccl_memobj_unwrap(buf), pattern, pattern_size, offset, size,
-		ccl_event_wait_list_get_num_events(evt_wait_lst),
-		ccl_event_wait_list_get_clevents(evt_wait_lst), &event);
-	g_if_err_create_goto(*err, CCL_OCL_ERROR,
-		CL_SUCCESS != ocl_status, ocl_status, error_handler,
-		"%s: unable to enqueue a fill buffer command (OpenCL error %d: %s).",
-		CCL_STRD, ocl_status, ccl_err(ocl_status));
-
-	/* Wrap event and associate it with the respective command queue.
-	 * The event object will be released automatically when the command
-	 * queue is released. */
-	evt = ccl_queue_produce_event(cq, event);
+#else
 
-	/* Clear event wait list. */
-	ccl_event_wait_list_clear(evt_wait_lst);
+	CCL_UNUSED(ocl_status);
+	CCL_UNUSED(event);
+	CCL_UNUSED(ocl_ver);
 
 #endif
 
+	/* Otherwise, fall back to a fill kernel. */
+	if (evt == NULL) {
+		evt = ccl_buffer_enqueue_fill_kernel(buf, cq, pattern,
+			pattern_size, offset, size, evt_wait_lst, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+	}
+
+	/* Record access, for redundant transfer analysis. */
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_WRITE,
+		ccl_memobj_unwrap(buf), offset, size, NULL);
+
 	/* If we got here, everything is OK. */
 	g_assert(err == NULL || *err == NULL);
 	goto finish;
@@ -44,6 +44,15 @@
  * represent a specific region in the original buffer (which is the only
  * sub-buffer type, up to OpenCL 2.1).
  *
+ * On CPU devices and devices with unified host memory, the copy
+ * performed inside the driver by ::ccl_buffer_enqueue_read() and
+ * ::ccl_buffer_enqueue_write() is usually single-threaded. The
+ * ::ccl_buffer_enqueue_read_mt() and ::ccl_buffer_enqueue_write_mt()
+ * functions can instead map the buffer and split the copy among
+ * several host threads, using non-temporal stores where available.
+ * With ::CCL_BUFFER_TRANSFER_AUTO, this path is selected automatically
+ * for large transfers on such devices.
+ *
  * Buffer wrapper objects can be directly passed as kernel arguments to
  * functions such as ::ccl_kernel_set_args_and_enqueue_ndrange() or
  * ::ccl_kernel_set_args_v().
@@ -115,6 +124,36 @@ CCLEvent* ccl_buffer_enqueue_write(CCLBuffer* buf, CCLQueue* cq,
 	cl_bool blocking_write, size_t offset, size_t size, void *ptr,
  	CCLEventWaitList* evt_wait_lst, CCLErr** err);
 
+/**
+ * How ::ccl_buffer_enqueue_read_mt() and ::ccl_buffer_enqueue_write_mt()
+ * move data between host memory and a buffer.
+ * */
+typedef enum ccl_buffer_transfer_mode {
+
+	/** Use the mapped path for large transfers on CPU devices and
+	 * devices with unified host memory, the driver path otherwise. */
+	CCL_BUFFER_TRANSFER_AUTO   = 0,
+	/** Single read/write command, copy performed by the driver. */
+	CCL_BUFFER_TRANSFER_DRIVER = 1,
+	/** Map the buffer and copy with multiple host threads. */
+	CCL_BUFFER_TRANSFER_MAPPED = 2
+
+} CCLBufferTransferMode;
+
+/* Read from a buffer object to host memory, possibly using a
+ * multi-threaded host copy over a mapped region. */
+CCL_EXPORT
+CCLEvent* ccl_buffer_enqueue_read_mt(CCLBuffer* buf, CCLQueue* cq,
+	CCLBufferTransferMode mode, size_t offset, size_t size, void *ptr,
+	CCLEventWaitList* evt_wait_lst, CCLErr** err);
+
+/* Write to a buffer object from host memory, possibly using a
+ * multi-threaded host copy over a mapped region. */
+CCL_EXPORT
+CCLEvent* ccl_buffer_enqueue_write_mt(CCLBuffer* buf, CCLQueue* cq,
+	CCLBufferTransferMode mode, size_t offset, size_t size, void *ptr,
+	CCLEventWaitList* evt_wait_lst, CCLErr** err);
+
 /* Map a region of the buffer object given by buffer into the host
  * address space and returns a pointer to this mapped region. */
 CCL_EXPORT
@@ -221,7 +260,7 @@ CCLEvent* ccl_buffer_enqueue_fill(CCLBuffer* buf, CCLQueue* cq,
  * @return The OpenCL buffer object.
  * */
 #define ccl_buffer_unwrap(buf) \
-	((cl_mem) ccl_wrapper_unwrap((CCLWrapper*) buf))
+	((cl_mem) ccl_wrapper_unwrap_inline((CCLWrapper*) buf))
 
 /** @} */
 
@@ -311,6 +311,8 @@ typedef enum ccl_error_code {
 	CCL_ERROR_UNSUPPORTED_OCL      = 6,
 	/** Object information is unavailable. */
 	CCL_ERROR_INFO_UNAVAILABLE_OCL = 7,
+	/** The command queue is full and the operation would block. */
+	CCL_ERROR_WOULD_BLOCK          = 8,
 	/** Any other errors. */
 	CCL_ERROR_OTHER                = 15
 } CCLErrorCode;
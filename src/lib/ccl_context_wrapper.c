@@ -27,6 +27,8 @@
  * */
 
 #include "ccl_context_wrapper.h"
+#include "ccl_program_wrapper.h"
+#include "_ccl_context_wrapper.h"
 #include "_ccl_abstract_dev_container_wrapper.h"
 #include "_ccl_defs.h"
 
@@ -49,8 +51,18 @@ struct ccl_context {
 	 * */
 	CCLPlatform* platf;
 
+	/**
+	 * Programs used internally by the library, keyed by name (lazy
+	 * initialized).
+	 * @private
+	 * */
+	GHashTable* int_prgs;
+
 };
 
+/* Lock for the internal programs of all contexts. */
+G_LOCK_DEFINE_STATIC(int_prgs);
+
 /**
  * @internal
  * Implementation of ccl_wrapper_release_fields() function for ::CCLContext
@@ -72,6 +84,11 @@ static void ccl_context_release_fields(CCLContext* ctx) {
 	if (ctx->platf) {
 		ccl_platform_unref(ctx->platf);
 	}
+
+	/* Release internal programs. */
+	if (ctx->int_prgs) {
+		g_hash_table_destroy(ctx->int_prgs);
+	}
 }
 
 /**
@@ -725,3 +742,72 @@ CCLDevice* const* ccl_context_get_all_devices(CCLContext* ctx,
 }
 
 /** @}*/
+
+/**
+ * @internal
+ * Get a program used internally by the library (e.g. fallback kernels),
+ * building it for all devices in the context the first time it is
+ * requested and caching it for the lifetime of the context.
+ *
+ * @private @memberof ccl_context
+ *
+ * @param[in] ctx The context wrapper object.
+ * @param[in] name Unique name of the program.
+ * @param[in] src Source code of the program.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return The program wrapper object, which belongs to the context and
+ * should not be destroyed by the caller, or `NULL` if an error occurs.
+ * */
+CCLProgram* ccl_context_get_internal_program(CCLContext* ctx,
+	const char* name, const char* src, CCLErr** err) {
+
+	/* Make sure ctx is not NULL. */
+	g_return_val_if_fail(ctx != NULL, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Program to return. */
+	CCLProgram* prg = NULL;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	G_LOCK(int_prgs);
+
+	/* Is the program already built? */
+	if (ctx->int_prgs == NULL) {
+		ctx->int_prgs = g_hash_table_new_full(g_str_hash, g_str_equal,
+			g_free, (GDestroyNotify) ccl_program_destroy);
+	}
+	prg = g_hash_table_lookup(ctx->int_prgs, name);
+
+	/* If not, build and cache it. */
+	if (prg == NULL) {
+
+		prg = ccl_program_new_from_source(ctx, src, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		ccl_program_build(prg, NULL, &err_internal);
+		if (err_internal != NULL) ccl_program_destroy(prg);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		g_hash_table_insert(ctx->int_prgs, g_strdup(name), prg);
+	}
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	prg = NULL;
+
+finish:
+
+	G_UNLOCK(int_prgs);
+
+	/* Return program. */
+	return prg;
+
+}
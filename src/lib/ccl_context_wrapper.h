@@ -421,7 +421,7 @@ CCLDevice* const* ccl_context_get_all_devices(CCLContext* ctx,
  * @return The OpenCL context object.
  * */
 #define ccl_context_unwrap(ctx) \
-	((cl_context) ccl_wrapper_unwrap((CCLWrapper*) ctx))
+	((cl_context) ccl_wrapper_unwrap_inline((CCLWrapper*) ctx))
 
 /** @} */
 
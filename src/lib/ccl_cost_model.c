@@ -0,0 +1,810 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ *
+ * Implementation of a history-based kernel cost model for device
+ * placement.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#include <string.h>
+#include "ccl_cost_model.h"
+#include "_ccl_defs.h"
+
+/**
+ * @internal
+ * Weight of new samples in the moving average, once enough samples
+ * have been gathered.
+ * */
+#define CCL_COST_MODEL_ALPHA 0.2
+
+/**
+ * @internal
+ * Default probability of exploring a device other than the best.
+ * */
+#define CCL_COST_MODEL_EXPLORE 0.05
+
+/**
+ * @internal
+ * Host-device bandwidth in bytes per second assumed for devices
+ * without transfer history.
+ * */
+#define CCL_COST_MODEL_BANDWIDTH 8e9
+
+/**
+ * @internal
+ * Header of cost model files.
+ * */
+#define CCL_COST_MODEL_HEADER "# cf4ocl cost model v1"
+
+/**
+ * @internal
+ * Moving average of a measured quantity.
+ * */
+struct ccl_cost_entry {
+
+	/** Moving average of samples. */
+	gdouble mean;
+
+	/** Number of samples. */
+	guint count;
+
+};
+
+/**
+ * History-based kernel cost model.
+ * */
+struct ccl_cost_model {
+
+	/**
+	 * Execution time averages, keyed by
+	 * "kernel\\tdevice\\tbucket" strings.
+	 * @private
+	 * */
+	GHashTable* entries;
+
+	/**
+	 * Bandwidth averages in bytes per second, keyed by device name.
+	 * @private
+	 * */
+	GHashTable* bandwidths;
+
+	/**
+	 * Probability of exploring a device other than the best.
+	 * @private
+	 * */
+	gdouble explore;
+
+	/**
+	 * Random number generator used for exploration.
+	 * @private
+	 * */
+	GRand* rand;
+
+};
+
+/**
+ * @internal
+ * Get the problem size bucket of a number of work-items, i.e. its
+ * number of significant bits.
+ *
+ * @param[in] work_items Number of work-items.
+ * @return Problem size bucket.
+ * */
+static inline guint ccl_cost_model_bucket(size_t work_items) {
+	return g_bit_storage(work_items);
+}
+
+/**
+ * @internal
+ * Add a sample to the entry with the given key, creating it if
+ * necessary. The first samples are averaged uniformly, further
+ * samples exponentially.
+ *
+ * @param[in] table Hash table of ::ccl_cost_entry objects.
+ * @param[in] key Entry key, copied if a new entry is created.
+ * @param[in] value Sample value.
+ * */
+static void ccl_cost_model_update(GHashTable* table, const char* key,
+	gdouble value) {
+
+	struct ccl_cost_entry* entry = g_hash_table_lookup(table, key);
+	gdouble alpha;
+
+	if (entry == NULL) {
+		entry = g_new0(struct ccl_cost_entry, 1);
+		g_hash_table_insert(table, g_strdup(key), entry);
+	}
+
+	entry->count++;
+	alpha = MAX(1.0 / entry->count, CCL_COST_MODEL_ALPHA);
+	entry->mean += alpha * (value - entry->mean);
+
+}
+
+/**
+ * @internal
+ * Set the entry with the given key, replacing any existing one.
+ *
+ * @param[in] table Hash table of ::ccl_cost_entry objects.
+ * @param[in] key Entry key, copied.
+ * @param[in] count Number of samples.
+ * @param[in] mean Moving average of samples.
+ * */
+static void ccl_cost_model_set(GHashTable* table, const char* key,
+	guint count, gdouble mean) {
+
+	struct ccl_cost_entry* entry = g_new(struct ccl_cost_entry, 1);
+
+	entry->count = count;
+	entry->mean = mean;
+	g_hash_table_replace(table, g_strdup(key), entry);
+
+}
+
+/**
+ * @internal
+ * Predict the execution time of a kernel in a given bucket from the
+ * nearest bucket with history, assuming time scales linearly with
+ * the number of work-items.
+ *
+ * @param[in] cm The cost model.
+ * @param[in] kernel_name Kernel function name.
+ * @param[in] device_name Device name.
+ * @param[in] bucket Problem size bucket.
+ * @return Predicted time in seconds, or a negative value if the
+ * kernel has no history on the device.
+ * */
+static gdouble ccl_cost_model_predict_bucket(CCLCostModel* cm,
+	const char* kernel_name, const char* device_name, guint bucket) {
+
+	struct ccl_cost_entry* entry;
+	gchar* key;
+	gdouble predicted = -1.0;
+	/* Ratio between problem sizes of the buckets being compared. */
+	gdouble scale = 1.0;
+
+	for (guint d = 0; d <= 8 * sizeof(size_t); ++d, scale *= 2.0) {
+
+		/* Try the larger bucket first, it is usually less affected by
+		 * launch overhead. */
+		key = g_strdup_printf("%s\t%s\t%u",
+			kernel_name, device_name, bucket + d);
+		entry = g_hash_table_lookup(cm->entries, key);
+		g_free(key);
+		if (entry != NULL) {
+			predicted = entry->mean / scale;
+			break;
+		}
+
+		if (d > bucket) continue;
+		key = g_strdup_printf("%s\t%s\t%u",
+			kernel_name, device_name, bucket - d);
+		entry = g_hash_table_lookup(cm->entries, key);
+		g_free(key);
+		if (entry != NULL) {
+			predicted = entry->mean * scale;
+			break;
+		}
+	}
+
+	return predicted;
+
+}
+
+/**
+ * @addtogroup CCL_COST_MODEL
+ * @{
+ */
+
+/**
+ * Create a new, empty, cost model. The exploration probability is
+ * initially 0.05, with a randomly seeded generator.
+ *
+ * @public @memberof ccl_cost_model
+ *
+ * @return A new cost model, which should be freed with
+ * ::ccl_cost_model_destroy().
+ * */
+CCL_EXPORT
+CCLCostModel* ccl_cost_model_new(void) {
+
+	CCLCostModel* cm = g_slice_new(CCLCostModel);
+
+	cm->entries = g_hash_table_new_full(
+		g_str_hash, g_str_equal, g_free, g_free);
+	cm->bandwidths = g_hash_table_new_full(
+		g_str_hash, g_str_equal, g_free, g_free);
+	cm->explore = CCL_COST_MODEL_EXPLORE;
+	cm->rand = g_rand_new();
+
+	return cm;
+
+}
+
+/**
+ * Destroy a cost model.
+ *
+ * @public @memberof ccl_cost_model
+ *
+ * @param[in] cm The cost model, may be `NULL`.
+ * */
+CCL_EXPORT
+void ccl_cost_model_destroy(CCLCostModel* cm) {
+
+	if (cm == NULL) return;
+
+	g_hash_table_destroy(cm->entries);
+	g_hash_table_destroy(cm->bandwidths);
+	g_rand_free(cm->rand);
+	g_slice_free(CCLCostModel, cm);
+
+}
+
+/**
+ * Set the probability with which ::ccl_cost_model_place() returns a
+ * device other than the predicted best, and reseed the random number
+ * generator used for this purpose.
+ *
+ * @public @memberof ccl_cost_model
+ *
+ * @param[in] cm The cost model.
+ * @param[in] probability Exploration probability between 0 (never
+ * explore) and 1.
+ * @param[in] seed Seed for the random number generator.
+ * */
+CCL_EXPORT
+void ccl_cost_model_set_exploration(CCLCostModel* cm,
+	double probability, guint32 seed) {
+
+	/* Make sure cm is not NULL. */
+	g_return_if_fail(cm != NULL);
+
+	cm->explore = CLAMP(probability, 0.0, 1.0);
+	g_rand_set_seed(cm->rand, seed);
+
+}
+
+/**
+ * Add an execution time sample to the cost model.
+ *
+ * @public @memberof ccl_cost_model
+ *
+ * @param[in] cm The cost model.
+ * @param[in] kernel_name Kernel function name.
+ * @param[in] device_name Device name.
+ * @param[in] work_items Total number of work-items of the launch.
+ * @param[in] seconds Execution time in seconds.
+ * */
+CCL_EXPORT
+void ccl_cost_model_record(CCLCostModel* cm, const char* kernel_name,
+	const char* device_name, size_t work_items, double seconds) {
+
+	/* Make sure cm is not NULL. */
+	g_return_if_fail(cm != NULL);
+	/* Make sure names are not NULL. */
+	g_return_if_fail((kernel_name != NULL) && (device_name != NULL));
+
+	gchar* key = g_strdup_printf("%s\t%s\t%u", kernel_name, device_name,
+		ccl_cost_model_bucket(work_items));
+	ccl_cost_model_update(cm->entries, key, seconds);
+	g_free(key);
+
+}
+
+/**
+ * Add a host-device transfer sample to the cost model.
+ *
+ * @public @memberof ccl_cost_model
+ *
+ * @param[in] cm The cost model.
+ * @param[in] device_name Device name.
+ * @param[in] bytes Number of bytes transferred.
+ * @param[in] seconds Transfer time in seconds.
+ * */
+CCL_EXPORT
+void ccl_cost_model_record_transfer(CCLCostModel* cm,
+	const char* device_name, size_t bytes, double seconds) {
+
+	/* Make sure cm is not NULL. */
+	g_return_if_fail(cm != NULL);
+	/* Make sure device_name is not NULL. */
+	g_return_if_fail(device_name != NULL);
+
+	/* Ignore samples which carry no throughput information. */
+	if ((bytes == 0) || (seconds <= 0)) return;
+
+	ccl_cost_model_update(cm->bandwidths, device_name, bytes / seconds);
+
+}
+
+/**
+ * Add the execution time of a completed kernel profiling event to the
+ * cost model. The event's queue must have been created with the
+ * `CL_QUEUE_PROFILING_ENABLE` property.
+ *
+ * @public @memberof ccl_cost_model
+ *
+ * @param[in] cm The cost model.
+ * @param[in] krnl Kernel wrapper.
+ * @param[in] dev Device wrapper on which the kernel executed.
+ * @param[in] evt Completed event of the kernel launch.
+ * @param[in] work_items Total number of work-items of the launch.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return ::CL_TRUE if the sample was added, ::CL_FALSE otherwise.
+ * */
+CCL_EXPORT
+cl_bool ccl_cost_model_record_event(CCLCostModel* cm, CCLKernel* krnl,
+	CCLDevice* dev, CCLEvent* evt, size_t work_items, CCLErr** err) {
+
+	/* Make sure cm is not NULL. */
+	g_return_val_if_fail(cm != NULL, CL_FALSE);
+	/* Make sure krnl, dev and evt are not NULL. */
+	g_return_val_if_fail(
+		(krnl != NULL) && (dev != NULL) && (evt != NULL), CL_FALSE);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, CL_FALSE);
+
+	/* Names. */
+	char* kernel_name;
+	char* device_name;
+	/* Profiling instants. */
+	cl_ulong start, end;
+	/* Function status. */
+	cl_bool status;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Get names. */
+	kernel_name = ccl_kernel_get_info_array(
+		krnl, CL_KERNEL_FUNCTION_NAME, char*, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	device_name = ccl_device_get_info_array(
+		dev, CL_DEVICE_NAME, char*, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Get execution time. */
+	start = ccl_event_get_profiling_info_scalar(
+		evt, CL_PROFILING_COMMAND_START, cl_ulong, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	end = ccl_event_get_profiling_info_scalar(
+		evt, CL_PROFILING_COMMAND_END, cl_ulong, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	ccl_cost_model_record(cm, kernel_name, device_name, work_items,
+		(end > start) ? (end - start) * 1e-9 : 0.0);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	status = CL_TRUE;
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	status = CL_FALSE;
+
+finish:
+
+	/* Return status. */
+	return status;
+
+}
+
+/**
+ * Add the throughput of a completed transfer profiling event (e.g.
+ * from ::ccl_buffer_enqueue_write()) to the cost model. The event's
+ * queue must have been created with the `CL_QUEUE_PROFILING_ENABLE`
+ * property.
+ *
+ * @public @memberof ccl_cost_model
+ *
+ * @param[in] cm The cost model.
+ * @param[in] dev Device wrapper to or from which data was transferred.
+ * @param[in] evt Completed event of the transfer.
+ * @param[in] bytes Number of bytes transferred.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return ::CL_TRUE if the sample was processed, ::CL_FALSE otherwise.
+ * */
+CCL_EXPORT
+cl_bool ccl_cost_model_record_transfer_event(CCLCostModel* cm,
+	CCLDevice* dev, CCLEvent* evt, size_t bytes, CCLErr** err) {
+
+	/* Make sure cm is not NULL. */
+	g_return_val_if_fail(cm != NULL, CL_FALSE);
+	/* Make sure dev and evt are not NULL. */
+	g_return_val_if_fail((dev != NULL) && (evt != NULL), CL_FALSE);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, CL_FALSE);
+
+	/* Device name. */
+	char* device_name;
+	/* Profiling instants. */
+	cl_ulong start, end;
+	/* Function status. */
+	cl_bool status;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	device_name = ccl_device_get_info_array(
+		dev, CL_DEVICE_NAME, char*, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	start = ccl_event_get_profiling_info_scalar(
+		evt, CL_PROFILING_COMMAND_START, cl_ulong, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	end = ccl_event_get_profiling_info_scalar(
+		evt, CL_PROFILING_COMMAND_END, cl_ulong, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	if (end > start)
+		ccl_cost_model_record_transfer(
+			cm, device_name, bytes, (end - start) * 1e-9);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	status = CL_TRUE;
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	status = CL_FALSE;
+
+finish:
+
+	/* Return status. */
+	return status;
+
+}
+
+/**
+ * Predict the execution time of a kernel on a device. If there is no
+ * history for the exact problem size bucket, the prediction is scaled
+ * linearly from the nearest bucket with history.
+ *
+ * @public @memberof ccl_cost_model
+ *
+ * @param[in] cm The cost model.
+ * @param[in] kernel_name Kernel function name.
+ * @param[in] device_name Device name.
+ * @param[in] work_items Total number of work-items of the launch.
+ * @return Predicted execution time in seconds, or a negative value if
+ * the kernel has no history on the device.
+ * */
+CCL_EXPORT
+double ccl_cost_model_predict(CCLCostModel* cm, const char* kernel_name,
+	const char* device_name, size_t work_items) {
+
+	/* Make sure cm is not NULL. */
+	g_return_val_if_fail(cm != NULL, -1.0);
+	/* Make sure names are not NULL. */
+	g_return_val_if_fail(
+		(kernel_name != NULL) && (device_name != NULL), -1.0);
+
+	return ccl_cost_model_predict_bucket(cm, kernel_name, device_name,
+		ccl_cost_model_bucket(work_items));
+
+}
+
+/**
+ * Choose the device on which a kernel launch is predicted to finish
+ * first, taking into account the time required to move input data to
+ * each device.
+ *
+ * Devices on which the kernel has no history are chosen first, in
+ * the given order, so that every device is measured at least once.
+ * Otherwise, the device with the lowest predicted execution plus
+ * transfer time is chosen, except with the exploration probability
+ * (see ::ccl_cost_model_set_exploration()), in which case another
+ * device is chosen at random.
+ *
+ * @public @memberof ccl_cost_model
+ *
+ * @param[in] cm The cost model.
+ * @param[in] krnl Kernel wrapper.
+ * @param[in] devs Candidate devices.
+ * @param[in] num_devs Number of candidate devices.
+ * @param[in] work_items Total number of work-items of the launch.
+ * @param[in] bytes_to_move Number of bytes which would have to be
+ * transferred to each candidate device before the launch (i.e. data
+ * not yet resident there), or `NULL` to ignore transfer costs.
+ * @param[out] predicted Return location for the predicted time in
+ * seconds on the chosen device, negative if unknown, or `NULL`.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return Index of the chosen device in `devs`, or -1 if an error
+ * occurs.
+ * */
+CCL_EXPORT
+cl_int ccl_cost_model_place(CCLCostModel* cm, CCLKernel* krnl,
+	CCLDevice* const* devs, cl_uint num_devs, size_t work_items,
+	const size_t* bytes_to_move, double* predicted, CCLErr** err) {
+
+	/* Make sure cm is not NULL. */
+	g_return_val_if_fail(cm != NULL, -1);
+	/* Make sure krnl is not NULL. */
+	g_return_val_if_fail(krnl != NULL, -1);
+	/* Make sure there are candidate devices. */
+	g_return_val_if_fail((devs != NULL) && (num_devs > 0), -1);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, -1);
+
+	/* Chosen device and its predicted time. */
+	cl_int best = -1;
+	gdouble best_time = -1.0;
+	/* Predicted times for each device. */
+	gdouble* times = NULL;
+	/* Names. */
+	char* kernel_name;
+	char* device_name;
+	/* Problem size bucket. */
+	guint bucket = ccl_cost_model_bucket(work_items);
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	kernel_name = ccl_kernel_get_info_array(
+		krnl, CL_KERNEL_FUNCTION_NAME, char*, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	times = g_new(gdouble, num_devs);
+
+	for (cl_uint i = 0; i < num_devs; ++i) {
+
+		struct ccl_cost_entry* bw;
+
+		device_name = ccl_device_get_info_array(
+			devs[i], CL_DEVICE_NAME, char*, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		times[i] = ccl_cost_model_predict_bucket(
+			cm, kernel_name, device_name, bucket);
+
+		/* Explore devices without history right away. */
+		if (times[i] < 0) {
+			best = (cl_int) i;
+			best_time = -1.0;
+			goto explored;
+		}
+
+		/* Add cost of moving non-resident data. */
+		if ((bytes_to_move != NULL) && (bytes_to_move[i] > 0)) {
+			bw = g_hash_table_lookup(cm->bandwidths, device_name);
+			times[i] += bytes_to_move[i]
+				/ ((bw != NULL) ? bw->mean : CCL_COST_MODEL_BANDWIDTH);
+		}
+
+		if ((best < 0) || (times[i] < best_time)) {
+			best = (cl_int) i;
+			best_time = times[i];
+		}
+	}
+
+	/* Occasionally try another device so that its estimate does not
+	 * go stale. */
+	if ((num_devs > 1) && (g_rand_double(cm->rand) < cm->explore)) {
+		cl_int other = g_rand_int_range(cm->rand, 0, (gint32) num_devs - 1);
+		if (other >= best) other++;
+		best = other;
+		best_time = times[best];
+	}
+
+explored:
+
+	if (predicted != NULL) *predicted = best_time;
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	best = -1;
+
+finish:
+
+	/* Free predicted times. */
+	g_free(times);
+
+	/* Return chosen device. */
+	return best;
+
+}
+
+/**
+ * Save cost model history to a text file, which can be loaded in a
+ * later run with ::ccl_cost_model_load().
+ *
+ * @public @memberof ccl_cost_model
+ *
+ * @param[in] cm The cost model.
+ * @param[in] filename Name of file where to save history.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return ::CL_TRUE if history was saved, ::CL_FALSE otherwise.
+ * */
+CCL_EXPORT
+cl_bool ccl_cost_model_save(CCLCostModel* cm, const char* filename,
+	CCLErr** err) {
+
+	/* Make sure cm is not NULL. */
+	g_return_val_if_fail(cm != NULL, CL_FALSE);
+	/* Make sure filename is not NULL. */
+	g_return_val_if_fail(filename != NULL, CL_FALSE);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, CL_FALSE);
+
+	/* File contents. */
+	GString* contents = g_string_new(CCL_COST_MODEL_HEADER "\n");
+	/* Hash table iteration. */
+	GHashTableIter iter;
+	gpointer key, value;
+	struct ccl_cost_entry* entry;
+	/* Locale-independent number representation. */
+	gchar num[G_ASCII_DTOSTR_BUF_SIZE];
+	/* Function status. */
+	cl_bool status;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Execution times: K, kernel, device, bucket, count, mean. */
+	g_hash_table_iter_init(&iter, cm->entries);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		entry = (struct ccl_cost_entry*) value;
+		g_string_append_printf(contents, "K\t%s\t%u\t%s\n",
+			(gchar*) key, entry->count,
+			g_ascii_dtostr(num, sizeof(num), entry->mean));
+	}
+
+	/* Bandwidths: B, device, count, mean. */
+	g_hash_table_iter_init(&iter, cm->bandwidths);
+	while (g_hash_table_iter_next(&iter, &key, &value)) {
+		entry = (struct ccl_cost_entry*) value;
+		g_string_append_printf(contents, "B\t%s\t%u\t%s\n",
+			(gchar*) key, entry->count,
+			g_ascii_dtostr(num, sizeof(num), entry->mean));
+	}
+
+	g_file_set_contents(filename, contents->str, contents->len,
+		&err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	status = CL_TRUE;
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	status = CL_FALSE;
+
+finish:
+
+	/* Free file contents. */
+	g_string_free(contents, TRUE);
+
+	/* Return status. */
+	return status;
+
+}
+
+/**
+ * Load cost model history from a file created with
+ * ::ccl_cost_model_save(). Loaded entries replace existing entries for
+ * the same kernel, device and problem size bucket.
+ *
+ * @public @memberof ccl_cost_model
+ *
+ * @param[in] cm The cost model.
+ * @param[in] filename Name of file from where to load history.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return ::CL_TRUE if history was loaded, ::CL_FALSE otherwise.
+ * */
+CCL_EXPORT
+cl_bool ccl_cost_model_load(CCLCostModel* cm, const char* filename,
+	CCLErr** err) {
+
+	/* Make sure cm is not NULL. */
+	g_return_val_if_fail(cm != NULL, CL_FALSE);
+	/* Make sure filename is not NULL. */
+	g_return_val_if_fail(filename != NULL, CL_FALSE);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, CL_FALSE);
+
+	/* File contents, its lines and the fields of the current line. */
+	gchar* contents = NULL;
+	gchar** lines = NULL;
+	gchar** fields = NULL;
+	/* Function status. */
+	cl_bool status;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	g_file_get_contents(filename, &contents, NULL, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Check header. */
+	g_if_err_create_goto(*err, CCL_ERROR,
+		!g_str_has_prefix(contents, CCL_COST_MODEL_HEADER),
+		CCL_ERROR_INVALID_DATA, error_handler,
+		"%s: '%s' is not a cost model file.", CCL_STRD, filename);
+
+	lines = g_strsplit(contents, "\n", -1);
+	for (guint i = 1; lines[i] != NULL; ++i) {
+
+		guint n;
+		gchar* key;
+
+		/* Skip empty lines and comments. */
+		if ((*lines[i] == '\0') || (*lines[i] == '#')) continue;
+
+		fields = g_strsplit(lines[i], "\t", -1);
+		n = g_strv_length(fields);
+
+		if ((n == 6) && (strcmp(fields[0], "K") == 0)) {
+			key = g_strjoin("\t", fields[1], fields[2], fields[3], NULL);
+			ccl_cost_model_set(cm->entries, key,
+				(guint) g_ascii_strtoull(fields[4], NULL, 10),
+				g_ascii_strtod(fields[5], NULL));
+			g_free(key);
+		} else if ((n == 4) && (strcmp(fields[0], "B") == 0)) {
+			ccl_cost_model_set(cm->bandwidths, fields[1],
+				(guint) g_ascii_strtoull(fields[2], NULL, 10),
+				g_ascii_strtod(fields[3], NULL));
+		} else {
+			g_if_err_create_goto(*err, CCL_ERROR, TRUE,
+				CCL_ERROR_INVALID_DATA, error_handler,
+				"%s: invalid entry in line %u of cost model file '%s'.",
+				CCL_STRD, i + 1, filename);
+		}
+
+		g_strfreev(fields);
+		fields = NULL;
+	}
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	status = CL_TRUE;
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	status = CL_FALSE;
+
+finish:
+
+	/* Free parsing data. */
+	g_strfreev(fields);
+	g_strfreev(lines);
+	g_free(contents);
+
+	/* Return status. */
+	return status;
+
+}
+
+/** @} */
@@ -0,0 +1,153 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+ /**
+ * @file
+ *
+ * Definition of a history-based kernel cost model for device
+ * placement.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#ifndef _CCL_COST_MODEL_H_
+#define _CCL_COST_MODEL_H_
+
+#include "ccl_common.h"
+#include "ccl_device_wrapper.h"
+#include "ccl_event_wrapper.h"
+#include "ccl_kernel_wrapper.h"
+
+/**
+ * @defgroup CCL_COST_MODEL Cost model
+ *
+ * This module provides a history-based cost model which helps choosing
+ * the device on which to launch a kernel when a context spans
+ * heterogeneous devices.
+ *
+ * A ::CCLCostModel* object keeps, for each (kernel, device, problem
+ * size bucket) triplet, an exponentially weighted average of measured
+ * execution times. Problem sizes are bucketed by powers of two of the
+ * number of work-items. Times are usually gathered from profiling
+ * events with ::ccl_cost_model_record_event() (which requires queues
+ * created with `CL_QUEUE_PROFILING_ENABLE`), but can also be added
+ * directly with ::ccl_cost_model_record(). Likewise, per-device
+ * host-device bandwidth is learned from transfer events with
+ * ::ccl_cost_model_record_transfer_event().
+ *
+ * ::ccl_cost_model_place() predicts the fastest device for a new
+ * launch, adding to each device's predicted execution time the cost of
+ * moving the data which is not yet resident on it. Devices without
+ * history for the kernel are tried first, and with a small probability
+ * (see ::ccl_cost_model_set_exploration()) a device other than the
+ * predicted best is returned, so that estimates stay fresh.
+ *
+ * History is identified by kernel function name and device name, and
+ * can be persisted across runs with ::ccl_cost_model_save() and
+ * ::ccl_cost_model_load().
+ *
+ * Cost models are not thread-safe, and should be freed with
+ * ::ccl_cost_model_destroy().
+ *
+ * _Example:_
+ *
+ * @code{.c}
+ * CCLCostModel* cm = ccl_cost_model_new();
+ * ccl_cost_model_load(cm, "costs.txt", NULL);
+ * size_t bytes[2] = { 0, buf_size }; // Data already on device 0
+ * cl_int d = ccl_cost_model_place(cm, krnl, devs, 2, gws, bytes,
+ *     NULL, &err);
+ * evt = ccl_kernel_enqueue_ndrange(krnl, queues[d], 1, NULL, &gws,
+ *     NULL, NULL, &err);
+ * ccl_event_wait(ccl_ewl(&ewl, evt, NULL), &err);
+ * ccl_cost_model_record_event(cm, krnl, devs[d], evt, gws, &err);
+ * ccl_cost_model_save(cm, "costs.txt", &err);
+ * ccl_cost_model_destroy(cm);
+ * @endcode
+ *
+ * @{
+ */
+
+/**
+ * History-based kernel cost model.
+ *
+ * @see ccl_cost_model_new()
+ * */
+typedef struct ccl_cost_model CCLCostModel;
+
+/* Create a new, empty, cost model. */
+CCL_EXPORT
+CCLCostModel* ccl_cost_model_new(void);
+
+/* Destroy a cost model. */
+CCL_EXPORT
+void ccl_cost_model_destroy(CCLCostModel* cm);
+
+/* Set the probability of exploring a device other than the predicted
+ * best. */
+CCL_EXPORT
+void ccl_cost_model_set_exploration(CCLCostModel* cm,
+	double probability, guint32 seed);
+
+/* Add an execution time sample to the cost model. */
+CCL_EXPORT
+void ccl_cost_model_record(CCLCostModel* cm, const char* kernel_name,
+	const char* device_name, size_t work_items, double seconds);
+
+/* Add a host-device transfer sample to the cost model. */
+CCL_EXPORT
+void ccl_cost_model_record_transfer(CCLCostModel* cm,
+	const char* device_name, size_t bytes, double seconds);
+
+/* Add the execution time of a kernel profiling event to the cost
+ * model. */
+CCL_EXPORT
+cl_bool ccl_cost_model_record_event(CCLCostModel* cm, CCLKernel* krnl,
+	CCLDevice* dev, CCLEvent* evt, size_t work_items, CCLErr** err);
+
+/* Add the throughput of a transfer profiling event to the cost
+ * model. */
+CCL_EXPORT
+cl_bool ccl_cost_model_record_transfer_event(CCLCostModel* cm,
+	CCLDevice* dev, CCLEvent* evt, size_t bytes, CCLErr** err);
+
+/* Predict the execution time of a kernel on a device. */
+CCL_EXPORT
+double ccl_cost_model_predict(CCLCostModel* cm, const char* kernel_name,
+	const char* device_name, size_t work_items);
+
+/* Choose the device on which a kernel launch is predicted to finish
+ * first. */
+CCL_EXPORT
+cl_int ccl_cost_model_place(CCLCostModel* cm, CCLKernel* krnl,
+	CCLDevice* const* devs, cl_uint num_devs, size_t work_items,
+	const size_t* bytes_to_move, double* predicted, CCLErr** err);
+
+/* Save cost model history to a file. */
+CCL_EXPORT
+cl_bool ccl_cost_model_save(CCLCostModel* cm, const char* filename,
+	CCLErr** err);
+
+/* Load cost model history from a file. */
+CCL_EXPORT
+cl_bool ccl_cost_model_load(CCLCostModel* cm, const char* filename,
+	CCLErr** err);
+
+/** @} */
+
+#endif
@@ -28,6 +28,7 @@
  * */
 
 #include "ccl_device_selector.h"
+#include "ccl_load_registry.h"
 #include "_ccl_defs.h"
 
 /**
@@ -1232,6 +1233,96 @@ finish:
 	return devices;
 }
 
+/**
+ * Dependent filter function which selects the device with the least
+ * outstanding work (and, among those, the least memory in use)
+ * according to a @ref CCL_LOAD_REGISTRY "load registry". Ties are
+ * resolved in favor of the device which appears first in the list.
+ *
+ * @param[in] devices List of devices.
+ * @param[in] data A ::CCLLoadRegistry* object, or `NULL` to use the
+ * default registry.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return The OpenCL device which was selected by the filter.
+ * */
+CCL_EXPORT
+CCLDevSelDevices ccl_devsel_dep_least_loaded(
+	CCLDevSelDevices devices, void *data, CCLErr **err) {
+
+	/* Make sure devices is not NULL. */
+	g_return_val_if_fail(devices != NULL, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Load registry, and whether it was opened by this filter. */
+	CCLLoadRegistry* reg = (CCLLoadRegistry*) data;
+	cl_bool own_reg = CL_FALSE;
+
+	/* Load of current and selected devices. */
+	cl_ulong work, mem, best_work = 0, best_mem = 0;
+
+	/* Device to be selected. */
+	gpointer sel_dev = NULL;
+
+	/* Internal error object. */
+	CCLErr *err_internal = NULL;
+
+	/* Nothing to choose from. */
+	if (devices->len <= 1) goto finish;
+
+	/* Open default registry if none was given. */
+	if (reg == NULL) {
+		reg = ccl_load_registry_new(NULL, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+		own_reg = CL_TRUE;
+	}
+
+	/* Find least loaded device. */
+	for (guint i = 0; i < devices->len; i++) {
+
+		ccl_load_registry_query(reg,
+			(CCLDevice*) g_ptr_array_index(devices, i), &work, &mem,
+			&err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		if ((sel_dev == NULL) || (work < best_work)
+				|| ((work == best_work) && (mem < best_mem))) {
+			sel_dev = g_ptr_array_index(devices, i);
+			best_work = work;
+			best_mem = mem;
+		}
+	}
+
+	/* Select device: remove all devices from list except the selected
+	 * device. */
+	ccl_device_ref((CCLDevice*) sel_dev);
+	g_ptr_array_remove_range(devices, 0, devices->len);
+	g_ptr_array_add(devices, sel_dev);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+	/* Free array object containing device wrappers and set it to NULL. */
+	if (devices != NULL) {
+		g_ptr_array_free(devices, TRUE);
+		devices = NULL;
+	}
+
+finish:
+
+	/* Close registry if we opened it. */
+	if (own_reg) ccl_load_registry_destroy(reg);
+
+	/* Return filtered devices. */
+	return devices;
+}
+
 /** @} */
 
 /** @} */
@@ -326,6 +326,12 @@ CCL_EXPORT
 CCLDevSelDevices ccl_devsel_dep_index(
 	CCLDevSelDevices devices, void *data, CCLErr **err);
 
+/* Dependent filter function which selects the device with the least
+ * outstanding work according to a cross-process load registry. */
+CCL_EXPORT
+CCLDevSelDevices ccl_devsel_dep_least_loaded(
+	CCLDevSelDevices devices, void *data, CCLErr **err);
+
 /** @} */
 
 /** @} */
@@ -176,7 +176,7 @@ CCLDevice* const* ccl_device_create_subdevices(CCLDevice* dev,
  * @return The OpenCL device_id object.
  * */
 #define ccl_device_unwrap(dev) \
-	((cl_device_id) ccl_wrapper_unwrap((CCLWrapper*) dev))
+	((cl_device_id) ccl_wrapper_unwrap_inline((CCLWrapper*) dev))
 
 /** @} */
 
@@ -27,9 +27,11 @@
  * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
  * */
 
+#include <string.h>
 #include "ccl_event_wrapper.h"
 #include "ccl_queue_wrapper.h"
 #include "_ccl_abstract_wrapper.h"
+#include "_ccl_event_wrapper.h"
 #include "_ccl_defs.h"
 
 /**
@@ -51,8 +53,92 @@ struct ccl_event {
 	 * */
 	const char* name;
 
+	/**
+	 * Whether the work performed by the event's command was annotated.
+	 * @private
+	 * */
+	cl_bool has_work;
+
+	/**
+	 * Bytes read from memory by the event's command.
+	 * @private
+	 * */
+	cl_ulong bytes_read;
+
+	/**
+	 * Bytes written to memory by the event's command.
+	 * @private
+	 * */
+	cl_ulong bytes_written;
+
+	/**
+	 * Floating-point operations performed by the event's command.
+	 * @private
+	 * */
+	cl_ulong flops;
+
+	/**
+	 * Number of dimensions of the NDRange of the event's kernel command,
+	 * or 0 if not a kernel command launched through cf4ocl.
+	 * @private
+	 * */
+	cl_uint work_dim;
+
+	/**
+	 * Global work size of the event's kernel command.
+	 * @private
+	 * */
+	size_t gws[3];
+
+	/**
+	 * Local work size of the event's kernel command, zeros if left to the
+	 * OpenCL implementation.
+	 * @private
+	 * */
+	size_t lws[3];
+
+	/**
+	 * Memory object accesses of the event's command, recorded for
+	 * redundant transfer analysis.
+	 * @private
+	 * */
+	GArray* mem_accesses;
+
 };
 
+/* Number of blocks hashed when sampling transferred data. */
+#define CCL_EVENT_HASH_SAMPLES 64
+
+/* Size in bytes of the blocks hashed when sampling transferred data. */
+#define CCL_EVENT_HASH_BLOCK 256
+
+/* Memory object access tracking mode (0 is off, 1 is sampled and 2 is
+ * full, as in ::CCLProfTransferMode). */
+static gint mem_tracking = 0;
+
+/* Issue order of the next memory object access. */
+static gint mem_access_seq = 0;
+
+/**
+ * @internal
+ * Implementation of ::ccl_wrapper_release_fields() function for
+ * ::CCLEvent wrapper objects.
+ *
+ * @private @memberof ccl_event
+ *
+ * @param[in] evt A ::CCLEvent wrapper object.
+ * */
+static void ccl_event_release_fields(CCLEvent* evt) {
+
+	/* Make sure evt wrapper object is not NULL. */
+	g_return_if_fail(evt != NULL);
+
+	/* Free memory object accesses. */
+	if (evt->mem_accesses != NULL)
+		g_array_unref(evt->mem_accesses);
+
+}
+
 /**
  * @addtogroup CCL_EVENT_WRAPPER
  * @{
@@ -95,7 +181,8 @@ CCL_EXPORT
 void ccl_event_destroy(CCLEvent* evt) {
 
 	ccl_wrapper_unref((CCLWrapper*) evt, sizeof(CCLEvent),
-		NULL, (ccl_wrapper_release_cl_object) clReleaseEvent, NULL);
+		(ccl_wrapper_release_fields) ccl_event_release_fields,
+		(ccl_wrapper_release_cl_object) clReleaseEvent, NULL);
 
 }
 
@@ -144,6 +231,109 @@ const char* ccl_event_get_name(CCLEvent* evt) {
 
 }
 
+/**
+ * Annotate event with the work performed by its command, for profiling
+ * purposes.
+ *
+ * This is used by the @ref CCL_PROFILER "profiler module" to determine
+ * the arithmetic intensity of kernels and how close they get to the
+ * device's roofline. Annotating an event again replaces the previous
+ * annotation.
+ *
+ * @public @memberof ccl_event
+ *
+ * @param[in] evt The event wrapper object.
+ * @param[in] bytes_read Bytes read from global memory by the command.
+ * @param[in] bytes_written Bytes written to global memory by the
+ * command.
+ * @param[in] flops Floating-point operations performed by the command.
+ * */
+CCL_EXPORT
+void ccl_event_set_work(CCLEvent* evt, cl_ulong bytes_read,
+	cl_ulong bytes_written, cl_ulong flops) {
+
+	/* Make sure evt wrapper object is not NULL. */
+	g_return_if_fail(evt != NULL);
+
+	/* Set event work. */
+	evt->has_work = CL_TRUE;
+	evt->bytes_read = bytes_read;
+	evt->bytes_written = bytes_written;
+	evt->flops = flops;
+
+}
+
+/**
+ * Get the work annotated to an event with ::ccl_event_set_work().
+ *
+ * @public @memberof ccl_event
+ *
+ * @param[in] evt The event wrapper object.
+ * @param[out] bytes_read Return location for bytes read by the command,
+ * or `NULL` if not required.
+ * @param[out] bytes_written Return location for bytes written by the
+ * command, or `NULL` if not required.
+ * @param[out] flops Return location for floating-point operations
+ * performed by the command, or `NULL` if not required.
+ * @return `CL_TRUE` if the event was annotated, `CL_FALSE` otherwise (in
+ * which case the return locations are not modified).
+ * */
+CCL_EXPORT
+cl_bool ccl_event_get_work(CCLEvent* evt, cl_ulong* bytes_read,
+	cl_ulong* bytes_written, cl_ulong* flops) {
+
+	/* Make sure evt wrapper object is not NULL. */
+	g_return_val_if_fail(evt != NULL, CL_FALSE);
+
+	/* Was the event annotated? */
+	if (!evt->has_work) return CL_FALSE;
+
+	/* Return event work. */
+	if (bytes_read != NULL) *bytes_read = evt->bytes_read;
+	if (bytes_written != NULL) *bytes_written = evt->bytes_written;
+	if (flops != NULL) *flops = evt->flops;
+	return CL_TRUE;
+
+}
+
+/**
+ * Get the NDRange with which the kernel command associated with the event
+ * was launched, for profiling purposes. This information is recorded for
+ * events returned by ::ccl_kernel_enqueue_ndrange() and the functions
+ * built on it.
+ *
+ * @public @memberof ccl_event
+ *
+ * @param[in] evt The event wrapper object.
+ * @param[out] global_work_size Return location for the global work size,
+ * an array of 3 elements, or `NULL` if not required. Unused dimensions
+ * are set to 1.
+ * @param[out] local_work_size Return location for the local work size,
+ * an array of 3 elements, or `NULL` if not required. Set to zeros if the
+ * local work size was left to the OpenCL implementation.
+ * @return Number of dimensions of the NDRange, or 0 if the event is not
+ * associated with a kernel command launched with
+ * ::ccl_kernel_enqueue_ndrange() (in which case the return locations are
+ * not modified).
+ * */
+CCL_EXPORT
+cl_uint ccl_event_get_ndrange(CCLEvent* evt, size_t* global_work_size,
+	size_t* local_work_size) {
+
+	/* Make sure evt wrapper object is not NULL. */
+	g_return_val_if_fail(evt != NULL, 0);
+
+	/* Return NDRange, if recorded. */
+	if (evt->work_dim > 0) {
+		if (global_work_size != NULL)
+			memcpy(global_work_size, evt->gws, 3 * sizeof(size_t));
+		if (local_work_size != NULL)
+			memcpy(local_work_size, evt->lws, 3 * sizeof(size_t));
+	}
+	return evt->work_dim;
+
+}
+
 /**
  * Get the final event name for profiling purposes. If a name was not
  * explicitly set with ccl_event_set_name(), it will return a name
@@ -866,3 +1056,231 @@ finish:
 }
 
 /** @} */
+
+/**
+ * @internal
+ * Record the NDRange with which the kernel command associated with the
+ * event was launched.
+ *
+ * @private @memberof ccl_event
+ *
+ * @param[in] evt The event wrapper object.
+ * @param[in] work_dim Number of dimensions, between 1 and 3.
+ * @param[in] global_work_size Global work size.
+ * @param[in] local_work_size Local work size, or `NULL`.
+ * */
+void ccl_event_set_ndrange(CCLEvent* evt, cl_uint work_dim,
+	const size_t* global_work_size, const size_t* local_work_size) {
+
+	/* Make sure evt wrapper object is not NULL. */
+	g_return_if_fail(evt != NULL);
+	/* Make sure the number of dimensions is valid. */
+	g_return_if_fail((work_dim >= 1) && (work_dim <= 3));
+	/* Make sure the global work size is not NULL. */
+	g_return_if_fail(global_work_size != NULL);
+
+	evt->work_dim = work_dim;
+	for (cl_uint i = 0; i < 3; ++i) {
+		evt->gws[i] = i < work_dim ? global_work_size[i] : 1;
+		evt->lws[i] = (local_work_size == NULL) ? 0
+			: (i < work_dim ? local_work_size[i] : 1);
+	}
+
+}
+
+/**
+ * @internal
+ * Hash a block of memory, eight bytes at a time.
+ *
+ * @private @memberof ccl_event
+ *
+ * @param[in] hash Hash of previous blocks.
+ * @param[in] ptr Block of memory.
+ * @param[in] size Size of block in bytes.
+ * @return Hash of previous blocks and the given block.
+ * */
+static guint64 ccl_event_hash_block(
+	guint64 hash, const unsigned char* ptr, size_t size) {
+
+	guint64 word;
+	size_t i;
+
+	for (i = 0; i + sizeof(guint64) <= size; i += sizeof(guint64)) {
+		memcpy(&word, ptr + i, sizeof(guint64));
+		hash = (hash ^ word) * G_GUINT64_CONSTANT(0x100000001b3);
+		hash ^= hash >> 29;
+	}
+	for (; i < size; ++i)
+		hash = (hash ^ ptr[i]) * G_GUINT64_CONSTANT(0x100000001b3);
+
+	return hash;
+
+}
+
+/**
+ * @internal
+ * Set the memory object access tracking mode. When enabled, the commands
+ * enqueued through cf4ocl record the memory objects they access in their
+ * events, and hash the data of host-side reads and writes.
+ *
+ * @private @memberof ccl_event
+ *
+ * @param[in] mode 0 to disable tracking, 1 to hash a sample of the
+ * transferred data, or 2 to hash all the transferred data.
+ * */
+void ccl_event_set_mem_tracking(int mode) {
+
+	g_atomic_int_set(&mem_tracking, mode);
+
+}
+
+/**
+ * @internal
+ * Get the memory object access tracking mode.
+ *
+ * @private @memberof ccl_event
+ *
+ * @return 0 if tracking is disabled, 1 if a sample of the transferred
+ * data is hashed, or 2 if all the transferred data is hashed.
+ * */
+int ccl_event_get_mem_tracking(void) {
+
+	return g_atomic_int_get(&mem_tracking);
+
+}
+
+/**
+ * @internal
+ * Record a memory object access in an event, if tracking is enabled.
+ * Accesses to sub-buffers are recorded as accesses to the respective
+ * region of the parent buffer.
+ *
+ * @private @memberof ccl_event
+ *
+ * @param[in] evt The event wrapper object.
+ * @param[in] kind Kind of access.
+ * @param[in] mem Accessed memory object.
+ * @param[in] offset Offset of accessed region.
+ * @param[in] size Size of accessed region, `G_MAXSIZE` for the whole
+ * object.
+ * @param[in] ptr Host data transferred to or from the region, which will
+ * be hashed, or `NULL` if not available.
+ * */
+void ccl_event_add_mem_access(CCLEvent* evt, CCLEventMemAccessKind kind,
+	cl_mem mem, size_t offset, size_t size, const void* ptr) {
+
+	/* Tracking mode. */
+	int mode = g_atomic_int_get(&mem_tracking);
+	/* Access to record. */
+	CCLEventMemAccess access;
+	/* Parent buffer and offset within it, if any. */
+	cl_mem parent = NULL;
+	size_t parent_offset = 0;
+
+	/* Do nothing if tracking is disabled. */
+	if ((mode == 0) || (evt == NULL) || (mem == NULL)) return;
+
+#ifdef CL_VERSION_1_1
+	/* Record sub-buffer accesses as parent buffer accesses. */
+	if ((clGetMemObjectInfo(mem, CL_MEM_ASSOCIATED_MEMOBJECT,
+			sizeof(cl_mem), &parent, NULL) == CL_SUCCESS)
+		&& (parent != NULL)
+		&& (clGetMemObjectInfo(mem, CL_MEM_OFFSET, sizeof(size_t),
+			&parent_offset, NULL) == CL_SUCCESS)) {
+		if ((size == G_MAXSIZE) && (clGetMemObjectInfo(mem, CL_MEM_SIZE,
+				sizeof(size_t), &size, NULL) != CL_SUCCESS))
+			size = G_MAXSIZE;
+		mem = parent;
+		offset += parent_offset;
+	}
+#else
+	CCL_UNUSED(parent);
+	CCL_UNUSED(parent_offset);
+#endif
+
+	access.kind = kind;
+	access.mem = mem;
+	access.offset = offset;
+	access.size = size;
+	access.has_hash = (ptr != NULL);
+	access.hash = 0;
+	access.seq = (guint) g_atomic_int_add(&mem_access_seq, 1);
+
+	/* Hash transferred data, either fully or by sampling evenly spaced
+	 * blocks. The size is part of the hash. */
+	if (access.has_hash) {
+		const unsigned char* data = (const unsigned char*) ptr;
+		access.hash = ccl_event_hash_block(
+			G_GUINT64_CONSTANT(0xcbf29ce484222325),
+			(const unsigned char*) &size, sizeof(size_t));
+		if ((mode == 1)
+			&& (size > CCL_EVENT_HASH_SAMPLES * CCL_EVENT_HASH_BLOCK)) {
+			size_t stride = size / CCL_EVENT_HASH_SAMPLES;
+			for (guint i = 0; i < CCL_EVENT_HASH_SAMPLES; ++i)
+				access.hash = ccl_event_hash_block(access.hash,
+					data + i * stride, CCL_EVENT_HASH_BLOCK);
+		} else {
+			access.hash = ccl_event_hash_block(access.hash, data, size);
+		}
+	}
+
+	/* Keep access. */
+	if (evt->mem_accesses == NULL)
+		evt->mem_accesses = g_array_new(
+			FALSE, FALSE, sizeof(CCLEventMemAccess));
+	g_array_append_val(evt->mem_accesses, access);
+
+}
+
+/**
+ * @internal
+ * Get the kind of memory object access of a map command. Regions mapped
+ * for reading only are not modified, regions mapped with
+ * `CL_MAP_WRITE_INVALIDATE_REGION` are overwritten without being read,
+ * and other regions may be read and modified by the host.
+ *
+ * @private @memberof ccl_event
+ *
+ * @param[in] map_flags Flags of the map command.
+ * @return Kind of memory object access.
+ * */
+CCLEventMemAccessKind ccl_event_map_access(cl_map_flags map_flags) {
+
+	if (map_flags == CL_MAP_READ) return CCL_EVENT_MEM_READ;
+#ifdef CL_VERSION_1_2
+	if (map_flags == CL_MAP_WRITE_INVALIDATE_REGION)
+		return CCL_EVENT_MEM_WRITE;
+#endif
+	return CCL_EVENT_MEM_USE;
+
+}
+
+/**
+ * @internal
+ * Get the memory object accesses recorded in an event.
+ *
+ * @private @memberof ccl_event
+ *
+ * @param[in] evt The event wrapper object.
+ * @param[out] num_accesses Location where to put the number of
+ * accesses.
+ * @return The memory object accesses recorded in the event, or `NULL` if
+ * none were recorded.
+ * */
+const CCLEventMemAccess* ccl_event_get_mem_accesses(CCLEvent* evt,
+	guint* num_accesses) {
+
+	/* Make sure evt wrapper object is not NULL. */
+	g_return_val_if_fail(evt != NULL, NULL);
+	/* Make sure num_accesses is not NULL. */
+	g_return_val_if_fail(num_accesses != NULL, NULL);
+
+	if (evt->mem_accesses == NULL) {
+		*num_accesses = 0;
+		return NULL;
+	}
+
+	*num_accesses = evt->mem_accesses->len;
+	return (const CCLEventMemAccess*) evt->mem_accesses->data;
+
+}
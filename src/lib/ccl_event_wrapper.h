@@ -108,6 +108,23 @@ void ccl_event_set_name(CCLEvent* evt, const char* name);
 CCL_EXPORT
 const char* ccl_event_get_name(CCLEvent* evt);
 
+/* Annotate event with the work performed by its command, for profiling
+ * purposes. */
+CCL_EXPORT
+void ccl_event_set_work(CCLEvent* evt, cl_ulong bytes_read,
+	cl_ulong bytes_written, cl_ulong flops);
+
+/* Get the work annotated to an event. */
+CCL_EXPORT
+cl_bool ccl_event_get_work(CCLEvent* evt, cl_ulong* bytes_read,
+	cl_ulong* bytes_written, cl_ulong* flops);
+
+/* Get the NDRange with which the kernel command associated with the
+ * event was launched. */
+CCL_EXPORT
+cl_uint ccl_event_get_ndrange(CCLEvent* evt, size_t* global_work_size,
+	size_t* local_work_size);
+
 /* Get the final event name for profiling purposes. */
 CCL_EXPORT
 const char* ccl_event_get_final_name(CCLEvent* evt);
@@ -272,7 +289,7 @@ cl_bool ccl_user_event_set_status(
  * @return The OpenCL event object.
  * */
 #define ccl_event_unwrap(evt) \
-	((cl_event) ccl_wrapper_unwrap((CCLWrapper*) evt))
+	((cl_event) ccl_wrapper_unwrap_inline((CCLWrapper*) evt))
 
 /**
  * @defgroup CCL_EVENT_WAIT_LIST Event wait lists
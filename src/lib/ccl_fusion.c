@@ -0,0 +1,615 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+ /**
+ * @file
+ *
+ * Implementation of a composer which fuses chains of elementwise
+ * operations into a single kernel.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#include "ccl_fusion.h"
+#include "ccl_kernel_arg.h"
+#include "ccl_kernel_wrapper.h"
+#include "ccl_program_wrapper.h"
+#include "_ccl_defs.h"
+
+/**
+ * @internal
+ * Name of the generated kernel.
+ * */
+#define CCL_FUSION_KERNEL "ccl_fused"
+
+/**
+ * @internal
+ * Element type supported in fused chains.
+ * */
+typedef struct ccl_fusion_type {
+
+	/** OpenCL C type name. */
+	const char* name;
+
+	/** Device parameter with the preferred vector width for the type. */
+	cl_device_info width_param;
+
+} CCLFusionType;
+
+/**
+ * @internal
+ * Element types supported in fused chains.
+ * */
+static const CCLFusionType ccl_fusion_types[] = {
+	{ "char",   CL_DEVICE_PREFERRED_VECTOR_WIDTH_CHAR },
+	{ "uchar",  CL_DEVICE_PREFERRED_VECTOR_WIDTH_CHAR },
+	{ "short",  CL_DEVICE_PREFERRED_VECTOR_WIDTH_SHORT },
+	{ "ushort", CL_DEVICE_PREFERRED_VECTOR_WIDTH_SHORT },
+	{ "int",    CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT },
+	{ "uint",   CL_DEVICE_PREFERRED_VECTOR_WIDTH_INT },
+	{ "long",   CL_DEVICE_PREFERRED_VECTOR_WIDTH_LONG },
+	{ "ulong",  CL_DEVICE_PREFERRED_VECTOR_WIDTH_LONG },
+	{ "float",  CL_DEVICE_PREFERRED_VECTOR_WIDTH_FLOAT },
+	{ "double", CL_DEVICE_PREFERRED_VECTOR_WIDTH_DOUBLE },
+	{ NULL, 0 }
+};
+
+/**
+ * Fusion composer.
+ * */
+struct ccl_fusion {
+
+	/**
+	 * Context in which kernels are built.
+	 * @private
+	 * */
+	CCLContext* ctx;
+
+	/**
+	 * Built programs, keyed by chain signature.
+	 * @private
+	 * */
+	GHashTable* programs;
+
+};
+
+/**
+ * @internal
+ * Find an element type by name.
+ *
+ * @param[in] name OpenCL C type name.
+ * @return The element type, or `NULL` if the type is not supported.
+ * */
+static const CCLFusionType* ccl_fusion_type_find(const char* name) {
+
+	if (name == NULL) return NULL;
+	for (cl_uint i = 0; ccl_fusion_types[i].name != NULL; ++i) {
+		if (g_strcmp0(ccl_fusion_types[i].name, name) == 0)
+			return &ccl_fusion_types[i];
+	}
+	return NULL;
+
+}
+
+/**
+ * @internal
+ * Check a chain of operations and determine its signature, i.e. a
+ * string which identifies the generated kernel.
+ *
+ * @param[in] in_type Input element type.
+ * @param[in] ops Operations.
+ * @param[in] num_ops Number of operations.
+ * @param[in] width Vector width.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return The chain signature, which should be freed with g_free(), or
+ * `NULL` if the chain is invalid.
+ * */
+static gchar* ccl_fusion_signature(const char* in_type,
+	const CCLFusionOp* ops, cl_uint num_ops, cl_uint width,
+	CCLErr** err) {
+
+	/* Signature being built. */
+	GString* sig = NULL;
+	/* Signature to return. */
+	gchar* sig_str = NULL;
+
+	/* Check input type and vector width. */
+	g_if_err_create_goto(*err, CCL_ERROR,
+		ccl_fusion_type_find(in_type) == NULL,
+		CCL_ERROR_ARGS, error_handler,
+		"%s: unsupported element type '%s'.", CCL_STRD, in_type);
+	g_if_err_create_goto(*err, CCL_ERROR,
+		(width == 0) || (width > 16) || ((width & (width - 1)) != 0),
+		CCL_ERROR_ARGS, error_handler,
+		"%s: invalid vector width %u.", CCL_STRD, width);
+
+	sig = g_string_new(in_type);
+	g_string_append_printf(sig, ";%u", width);
+
+	/* Check operations and add them to the signature. */
+	for (cl_uint i = 0; i < num_ops; ++i) {
+		switch (ops[i].type) {
+			case CCL_FUSION_OP_SCALE:
+				g_string_append(sig, ";s");
+				break;
+			case CCL_FUSION_OP_OFFSET:
+				g_string_append(sig, ";o");
+				break;
+			case CCL_FUSION_OP_ADD:
+			case CCL_FUSION_OP_MUL:
+				g_if_err_create_goto(*err, CCL_ERROR, ops[i].buf == NULL,
+					CCL_ERROR_ARGS, error_handler,
+					"%s: operation %u requires a buffer.", CCL_STRD, i);
+				g_string_append(sig,
+					ops[i].type == CCL_FUSION_OP_ADD ? ";a" : ";m");
+				break;
+			case CCL_FUSION_OP_CLAMP:
+				g_string_append(sig, ";c");
+				break;
+			case CCL_FUSION_OP_CONVERT:
+				g_if_err_create_goto(*err, CCL_ERROR,
+					ccl_fusion_type_find(ops[i].type_name) == NULL,
+					CCL_ERROR_ARGS, error_handler,
+					"%s: unsupported element type '%s' in operation %u.",
+					CCL_STRD, ops[i].type_name, i);
+				g_string_append_printf(sig, ";v:%s", ops[i].type_name);
+				break;
+			default:
+				g_if_err_create_goto(*err, CCL_ERROR, TRUE,
+					CCL_ERROR_ARGS, error_handler,
+					"%s: unknown operation type %d in operation %u.",
+					CCL_STRD, (int) ops[i].type, i);
+		}
+	}
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	sig_str = g_string_free(sig, FALSE);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	if (sig != NULL) g_string_free(sig, TRUE);
+
+finish:
+
+	/* Return signature. */
+	return sig_str;
+
+}
+
+/**
+ * @internal
+ * Generate the code which applies a chain of operations to one element (or
+ * one vector of elements), starting at index `i`.
+ *
+ * @param[in,out] src Source code being generated.
+ * @param[in] in_type Input element type.
+ * @param[in] ops Operations.
+ * @param[in] num_ops Number of operations.
+ * @param[in] width Vector width, 1 for scalar code.
+ * @param[in] indent Indentation prefix.
+ * */
+static void ccl_fusion_gen_body(GString* src, const char* in_type,
+	const CCLFusionOp* ops, cl_uint num_ops, cl_uint width,
+	const char* indent) {
+
+	/* Vector type suffix, empty for scalar code. */
+	gchar vs[3] = "";
+	/* Current element type. */
+	const char* type = in_type;
+
+	if (width > 1) g_snprintf(vs, sizeof(vs), "%u", width);
+
+	/* Load input. */
+	if (width > 1)
+		g_string_append_printf(src, "%s%s%s x0 = vload%s(0, in + i);\n",
+			indent, type, vs, vs);
+	else
+		g_string_append_printf(src, "%s%s x0 = in[i];\n", indent, type);
+
+	/* Apply operations, one new variable per operation. */
+	for (cl_uint k = 0; k < num_ops; ++k) {
+
+		if (ops[k].type == CCL_FUSION_OP_CONVERT)
+			type = ops[k].type_name;
+
+		g_string_append_printf(src, "%s%s%s x%u = ", indent, type, vs, k + 1);
+
+		switch (ops[k].type) {
+			case CCL_FUSION_OP_SCALE:
+				g_string_append_printf(src, "x%u * (%s) c%u;\n", k, type, k);
+				break;
+			case CCL_FUSION_OP_OFFSET:
+				g_string_append_printf(src, "x%u + (%s) c%u;\n", k, type, k);
+				break;
+			case CCL_FUSION_OP_ADD:
+			case CCL_FUSION_OP_MUL:
+				g_string_append_printf(src, "x%u %c ", k,
+					ops[k].type == CCL_FUSION_OP_ADD ? '+' : '*');
+				if (width > 1)
+					g_string_append_printf(
+						src, "vload%s(0, b%u + i);\n", vs, k);
+				else
+					g_string_append_printf(src, "b%u[i];\n", k);
+				break;
+			case CCL_FUSION_OP_CLAMP:
+				g_string_append_printf(src,
+					"clamp(x%u, (%s) c%u, (%s) d%u);\n", k, type, k, type, k);
+				break;
+			case CCL_FUSION_OP_CONVERT:
+				g_string_append_printf(src,
+					"convert_%s%s(x%u);\n", type, vs, k);
+				break;
+		}
+	}
+
+	/* Store output. */
+	if (width > 1)
+		g_string_append_printf(src, "%svstore%s(x%u, 0, out + i);\n",
+			indent, vs, num_ops);
+	else
+		g_string_append_printf(src, "%sout[i] = x%u;\n", indent, num_ops);
+
+}
+
+/**
+ * @addtogroup CCL_FUSION
+ * @{
+ */
+
+/**
+ * Create a new fusion composer.
+ *
+ * @public @memberof ccl_fusion
+ *
+ * @param[in] ctx Context in which fused kernels are built and run.
+ * @return A new fusion composer, which should be destroyed with
+ * ::ccl_fusion_destroy().
+ * */
+CCL_EXPORT
+CCLFusion* ccl_fusion_new(CCLContext* ctx) {
+
+	/* Make sure ctx is not NULL. */
+	g_return_val_if_fail(ctx != NULL, NULL);
+
+	CCLFusion* fus = g_slice_new(CCLFusion);
+
+	fus->ctx = ctx;
+	ccl_context_ref(ctx);
+	fus->programs = g_hash_table_new_full(g_str_hash, g_str_equal,
+		g_free, (GDestroyNotify) ccl_program_destroy);
+
+	return fus;
+
+}
+
+/**
+ * Destroy a fusion composer, releasing its cached kernels.
+ *
+ * @public @memberof ccl_fusion
+ *
+ * @param[in] fus Fusion composer to destroy.
+ * */
+CCL_EXPORT
+void ccl_fusion_destroy(CCLFusion* fus) {
+
+	/* Make sure fus is not NULL. */
+	g_return_if_fail(fus != NULL);
+
+	g_hash_table_destroy(fus->programs);
+	ccl_context_unref(fus->ctx);
+	g_slice_free(CCLFusion, fus);
+
+}
+
+/**
+ * Generate the source of the fused kernel for the given chain of
+ * operations. This function is used internally by ::ccl_fusion_enqueue(),
+ * and is exposed for inspection and debugging purposes.
+ *
+ * The generated kernel is named `ccl_fused` and has the following
+ * parameters: the input buffer, the output buffer, the number of elements
+ * (as `ulong`), and then the operands of each operation, in order (a buffer
+ * for ::CCL_FUSION_OP_ADD and ::CCL_FUSION_OP_MUL, two `float` bounds for
+ * ::CCL_FUSION_OP_CLAMP, one `float` constant for ::CCL_FUSION_OP_SCALE and
+ * ::CCL_FUSION_OP_OFFSET). Each work-item processes `width` consecutive
+ * elements.
+ *
+ * @public @memberof ccl_fusion
+ *
+ * @param[in] in_type Input element type, e.g. `"float"`.
+ * @param[in] ops Operations.
+ * @param[in] num_ops Number of operations.
+ * @param[in] width Vector width, a power of two between 1 and 16.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return The kernel source, which should be freed with g_free(), or `NULL`
+ * if an error occurs.
+ * */
+CCL_EXPORT
+char* ccl_fusion_get_source(const char* in_type, const CCLFusionOp* ops,
+	cl_uint num_ops, cl_uint width, CCLErr** err) {
+
+	/* Make sure ops is not NULL if operations are given. */
+	g_return_val_if_fail((num_ops == 0) || (ops != NULL), NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Source being generated. */
+	GString* src;
+	/* Chain signature. */
+	gchar* sig;
+	/* Current element type. */
+	const char* type = in_type;
+	/* Does the chain use double precision? */
+	gboolean fp64 = g_strcmp0(in_type, "double") == 0;
+
+	/* Check chain. */
+	sig = ccl_fusion_signature(in_type, ops, num_ops, width, err);
+	if (sig == NULL) return NULL;
+
+	src = g_string_new(NULL);
+	g_string_append_printf(src, "/* Fused chain: %s */\n", sig);
+	g_free(sig);
+
+	/* Determine output type and double precision usage. */
+	for (cl_uint k = 0; k < num_ops; ++k) {
+		if (ops[k].type == CCL_FUSION_OP_CONVERT) {
+			type = ops[k].type_name;
+			if (g_strcmp0(type, "double") == 0) fp64 = TRUE;
+		}
+	}
+	if (fp64)
+		g_string_append(src,
+			"#pragma OPENCL EXTENSION cl_khr_fp64 : enable\n");
+
+	/* Kernel parameters. */
+	g_string_append_printf(src, "__kernel void " CCL_FUSION_KERNEL
+		"(__global const %s* in, __global %s* out, ulong n", in_type, type);
+	type = in_type;
+	for (cl_uint k = 0; k < num_ops; ++k) {
+		switch (ops[k].type) {
+			case CCL_FUSION_OP_SCALE:
+			case CCL_FUSION_OP_OFFSET:
+				g_string_append_printf(src, ",\n\tfloat c%u", k);
+				break;
+			case CCL_FUSION_OP_ADD:
+			case CCL_FUSION_OP_MUL:
+				g_string_append_printf(src,
+					",\n\t__global const %s* b%u", type, k);
+				break;
+			case CCL_FUSION_OP_CLAMP:
+				g_string_append_printf(src,
+					",\n\tfloat c%u, float d%u", k, k);
+				break;
+			case CCL_FUSION_OP_CONVERT:
+				type = ops[k].type_name;
+				break;
+		}
+	}
+	g_string_append(src, ")\n{\n");
+
+	/* Kernel body: full vectors, then the remaining scalar elements. */
+	g_string_append_printf(src, "\tulong i = get_global_id(0) * %u;\n", width);
+	if (width > 1) {
+		g_string_append_printf(src, "\tif (i + %u <= n) {\n", width);
+		ccl_fusion_gen_body(src, in_type, ops, num_ops, width, "\t\t");
+		g_string_append(src, "\t} else {\n\t\tfor (; i < n; ++i) {\n");
+		ccl_fusion_gen_body(src, in_type, ops, num_ops, 1, "\t\t\t");
+		g_string_append(src, "\t\t}\n\t}\n");
+	} else {
+		g_string_append(src, "\tif (i < n) {\n");
+		ccl_fusion_gen_body(src, in_type, ops, num_ops, 1, "\t\t");
+		g_string_append(src, "\t}\n");
+	}
+	g_string_append(src, "}\n");
+
+	/* Return source. */
+	return g_string_free(src, FALSE);
+
+}
+
+/**
+ * Enqueue a fused chain of elementwise operations, i.e. apply the given
+ * operations, in order, to the first `n` elements of the input buffer and
+ * write the results to the output buffer, in a single kernel launch.
+ *
+ * The fused kernel is generated and built the first time a chain with a
+ * given signature is enqueued, and reused afterwards.
+ *
+ * @public @memberof ccl_fusion
+ *
+ * @param[in] fus Fusion composer.
+ * @param[in] cq Command queue wrapper object.
+ * @param[in] in Input buffer.
+ * @param[in] in_type Type of input buffer elements, e.g. `"float"`.
+ * @param[out] out Output buffer, with elements of the final type of the
+ * chain. May be the same as `in` if the element type is not changed.
+ * @param[in] n Number of elements to process.
+ * @param[in] ops Operations to apply.
+ * @param[in] num_ops Number of operations (zero copies the input buffer).
+ * @param[in,out] evt_wait_lst List of events that need to complete
+ * before this command can be executed. The list will be cleared and
+ * can be reused by client code.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return Event wrapper object that identifies the fused kernel execution,
+ * or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLEvent* ccl_fusion_enqueue(CCLFusion* fus, CCLQueue* cq,
+	CCLBuffer* in, const char* in_type, CCLBuffer* out, size_t n,
+	const CCLFusionOp* ops, cl_uint num_ops,
+	CCLEventWaitList* evt_wait_lst, CCLErr** err) {
+
+	/* Make sure fus is not NULL. */
+	g_return_val_if_fail(fus != NULL, NULL);
+	/* Make sure cq is not NULL. */
+	g_return_val_if_fail(cq != NULL, NULL);
+	/* Make sure buffers are not NULL. */
+	g_return_val_if_fail((in != NULL) && (out != NULL), NULL);
+	/* Make sure ops is not NULL if operations are given. */
+	g_return_val_if_fail((num_ops == 0) || (ops != NULL), NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Event wrapper to return. */
+	CCLEvent* evt = NULL;
+	/* Device of command queue. */
+	CCLDevice* dev;
+	/* Input element type. */
+	const CCLFusionType* type;
+	/* Vector width. */
+	cl_uint width;
+	/* Chain signature. */
+	gchar* sig = NULL;
+	/* Fused kernel source. */
+	char* src = NULL;
+	/* Program containing fused kernel. */
+	CCLProgram* prg = NULL;
+	/* Fused kernel. */
+	CCLKernel* krnl;
+	/* Number of elements as kernel argument. */
+	cl_ulong n_arg = n;
+	/* Kernel argument index. */
+	cl_uint arg_idx = 0;
+	/* Global work size. */
+	size_t gws;
+	/* Internal error object. */
+	CCLErr* err_internal = NULL;
+
+	/* Check input type. */
+	type = ccl_fusion_type_find(in_type);
+	g_if_err_create_goto(*err, CCL_ERROR, type == NULL,
+		CCL_ERROR_ARGS, error_handler,
+		"%s: unsupported element type '%s'.", CCL_STRD, in_type);
+
+	/* Determine vector width from the device's preference for the input
+	 * type, which is a power of two or zero if the type is not
+	 * supported. */
+	dev = ccl_queue_get_device(cq, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	width = ccl_device_get_info_scalar(
+		dev, type->width_param, cl_uint, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	width = CLAMP(width, 1, 16);
+
+	/* Get signature, and with it the cached program, if any. */
+	sig = ccl_fusion_signature(in_type, ops, num_ops, width, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	prg = g_hash_table_lookup(fus->programs, sig);
+
+	/* Generate and build the fused kernel, if not yet cached. */
+	if (prg == NULL) {
+
+		src = ccl_fusion_get_source(
+			in_type, ops, num_ops, width, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		prg = ccl_program_new_from_source(fus->ctx, src, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		ccl_program_build(prg, NULL, &err_internal);
+		if (err_internal != NULL) ccl_program_destroy(prg);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		/* Cache program, the table takes ownership of the signature. */
+		g_hash_table_insert(fus->programs, sig, prg);
+		sig = NULL;
+	}
+
+	/* Get kernel and set its arguments. */
+	krnl = ccl_program_get_kernel(prg, CCL_FUSION_KERNEL, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	ccl_kernel_set_arg(krnl, arg_idx++, in);
+	ccl_kernel_set_arg(krnl, arg_idx++, out);
+	ccl_kernel_set_arg(krnl, arg_idx++, ccl_arg_priv(n_arg, cl_ulong));
+	for (cl_uint k = 0; k < num_ops; ++k) {
+		/* Constant operands. */
+		cl_float c_a = ops[k].a, c_b = ops[k].b;
+		switch (ops[k].type) {
+			case CCL_FUSION_OP_SCALE:
+			case CCL_FUSION_OP_OFFSET:
+				ccl_kernel_set_arg(
+					krnl, arg_idx++, ccl_arg_priv(c_a, cl_float));
+				break;
+			case CCL_FUSION_OP_ADD:
+			case CCL_FUSION_OP_MUL:
+				ccl_kernel_set_arg(krnl, arg_idx++, ops[k].buf);
+				break;
+			case CCL_FUSION_OP_CLAMP:
+				ccl_kernel_set_arg(
+					krnl, arg_idx++, ccl_arg_priv(c_a, cl_float));
+				ccl_kernel_set_arg(
+					krnl, arg_idx++, ccl_arg_priv(c_b, cl_float));
+				break;
+			case CCL_FUSION_OP_CONVERT:
+				break;
+		}
+	}
+
+	/* Launch fused kernel, one work-item per vector of elements. */
+	gws = (n + width - 1) / width;
+	evt = ccl_kernel_enqueue_ndrange(krnl, cq, 1, NULL, &gws, NULL,
+		evt_wait_lst, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	evt = NULL;
+
+finish:
+
+	/* Release temporary objects. */
+	g_free(sig);
+	g_free(src);
+
+	/* Return event. */
+	return evt;
+
+}
+
+/**
+ * Get the number of fused kernels cached by the composer, i.e. the number
+ * of distinct chain signatures enqueued so far.
+ *
+ * @public @memberof ccl_fusion
+ *
+ * @param[in] fus Fusion composer.
+ * @return Number of cached kernels.
+ * */
+CCL_EXPORT
+cl_uint ccl_fusion_get_num_kernels(CCLFusion* fus) {
+
+	/* Make sure fus is not NULL. */
+	g_return_val_if_fail(fus != NULL, 0);
+
+	return g_hash_table_size(fus->programs);
+
+}
+
+/** @} */
@@ -0,0 +1,218 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+ /**
+ * @file
+ *
+ * Definition of a composer which fuses chains of elementwise operations
+ * into a single kernel.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#ifndef _CCL_FUSION_H_
+#define _CCL_FUSION_H_
+
+#include "ccl_common.h"
+#include "ccl_buffer_wrapper.h"
+#include "ccl_context_wrapper.h"
+#include "ccl_event_wrapper.h"
+#include "ccl_queue_wrapper.h"
+
+/**
+ * @defgroup CCL_FUSION Fusion composer
+ *
+ * This module fuses a chain of elementwise operations (scale, add, clamp,
+ * convert, etc.) over buffers into a single OpenCL kernel, avoiding the
+ * global memory round trip and launch overhead of running one small kernel
+ * per operation.
+ *
+ * Chains are declared as arrays of ::CCLFusionOp objects, initialized with
+ * the `ccl_fusion_op_*()` macros, and launched with ::ccl_fusion_enqueue().
+ * Each element of the input buffer is read once, all operations are applied
+ * in order, and the result is written once to the output buffer. The
+ * element type starts as the given input type and is changed by
+ * ::ccl_fusion_op_convert(); buffer operands of ::ccl_fusion_op_add() and
+ * ::ccl_fusion_op_mul() must contain elements of the type current at that
+ * point in the chain, and the output buffer elements of the final type.
+ *
+ * The generated kernel processes as many elements per work-item as the
+ * device's preferred vector width for the input type. Kernels are cached by
+ * the ::CCLFusion* composer according to the signature of the chain, i.e.
+ * the input type, the operation sequence and the vector width; constants
+ * and buffers are passed as kernel arguments, so chains which differ only
+ * on those reuse the same kernel. Constants are given as `cl_float` and
+ * converted to the current element type in the kernel.
+ *
+ * A composer is associated with one context and should not be used
+ * concurrently by several threads.
+ *
+ * _Example:_
+ *
+ * @code{.c}
+ * CCLFusion* fus = ccl_fusion_new(ctx);
+ * CCLFusionOp ops[] = {
+ *     ccl_fusion_op_scale(0.5f),
+ *     ccl_fusion_op_add(bias_buf),
+ *     ccl_fusion_op_clamp(0.0f, 255.0f),
+ *     ccl_fusion_op_convert("uchar")
+ * };
+ * @endcode
+ * @code{.c}
+ * evt = ccl_fusion_enqueue(fus, cq, in_buf, "float", out_buf, n,
+ *     ops, G_N_ELEMENTS(ops), NULL, &err);
+ * @endcode
+ * @code{.c}
+ * ccl_fusion_destroy(fus);
+ * @endcode
+ *
+ * @{
+ */
+
+/**
+ * Elementwise operation types.
+ * */
+typedef enum ccl_fusion_op_type {
+
+	/** Multiply by a constant. */
+	CCL_FUSION_OP_SCALE = 0,
+
+	/** Add a constant. */
+	CCL_FUSION_OP_OFFSET = 1,
+
+	/** Add the elements of a buffer. */
+	CCL_FUSION_OP_ADD = 2,
+
+	/** Multiply by the elements of a buffer. */
+	CCL_FUSION_OP_MUL = 3,
+
+	/** Clamp to a range. */
+	CCL_FUSION_OP_CLAMP = 4,
+
+	/** Convert to another element type. */
+	CCL_FUSION_OP_CONVERT = 5
+
+} CCLFusionOpType;
+
+/**
+ * An elementwise operation in a fused chain. Should be initialized with
+ * one of the `ccl_fusion_op_*()` macros.
+ * */
+typedef struct ccl_fusion_op {
+
+	/** Operation type. */
+	CCLFusionOpType type;
+
+	/** Buffer operand (::CCL_FUSION_OP_ADD and ::CCL_FUSION_OP_MUL). */
+	CCLBuffer* buf;
+
+	/** First constant operand (scale, offset or lower clamp bound). */
+	cl_float a;
+
+	/** Second constant operand (upper clamp bound). */
+	cl_float b;
+
+	/** Target OpenCL C type (::CCL_FUSION_OP_CONVERT). */
+	const char* type_name;
+
+} CCLFusionOp;
+
+/**
+ * Multiply elements by a constant.
+ *
+ * @param[in] c Constant, as `cl_float`.
+ * */
+#define ccl_fusion_op_scale(c) \
+	{ CCL_FUSION_OP_SCALE, NULL, (c), 0.0f, NULL }
+
+/**
+ * Add a constant to elements.
+ *
+ * @param[in] c Constant, as `cl_float`.
+ * */
+#define ccl_fusion_op_offset(c) \
+	{ CCL_FUSION_OP_OFFSET, NULL, (c), 0.0f, NULL }
+
+/**
+ * Add the corresponding elements of a buffer.
+ *
+ * @param[in] buffer A ::CCLBuffer* wrapper object.
+ * */
+#define ccl_fusion_op_add(buffer) \
+	{ CCL_FUSION_OP_ADD, (buffer), 0.0f, 0.0f, NULL }
+
+/**
+ * Multiply by the corresponding elements of a buffer.
+ *
+ * @param[in] buffer A ::CCLBuffer* wrapper object.
+ * */
+#define ccl_fusion_op_mul(buffer) \
+	{ CCL_FUSION_OP_MUL, (buffer), 0.0f, 0.0f, NULL }
+
+/**
+ * Clamp elements to the given range.
+ *
+ * @param[in] lo Lower bound, as `cl_float`.
+ * @param[in] hi Upper bound, as `cl_float`.
+ * */
+#define ccl_fusion_op_clamp(lo, hi) \
+	{ CCL_FUSION_OP_CLAMP, NULL, (lo), (hi), NULL }
+
+/**
+ * Convert elements to another type, using the default OpenCL C rounding
+ * mode for the conversion.
+ *
+ * @param[in] type OpenCL C scalar type name, e.g. `"uchar"` or `"float"`.
+ * */
+#define ccl_fusion_op_convert(type) \
+	{ CCL_FUSION_OP_CONVERT, NULL, 0.0f, 0.0f, (type) }
+
+/**
+ * Fusion composer.
+ *
+ * @see ccl_fusion_new()
+ * */
+typedef struct ccl_fusion CCLFusion;
+
+/* Create a new fusion composer. */
+CCL_EXPORT
+CCLFusion* ccl_fusion_new(CCLContext* ctx);
+
+/* Destroy a fusion composer. */
+CCL_EXPORT
+void ccl_fusion_destroy(CCLFusion* fus);
+
+/* Generate the source of the fused kernel for the given chain. */
+CCL_EXPORT
+char* ccl_fusion_get_source(const char* in_type, const CCLFusionOp* ops,
+	cl_uint num_ops, cl_uint width, CCLErr** err);
+
+/* Enqueue a fused chain of elementwise operations. */
+CCL_EXPORT
+CCLEvent* ccl_fusion_enqueue(CCLFusion* fus, CCLQueue* cq,
+	CCLBuffer* in, const char* in_type, CCLBuffer* out, size_t n,
+	const CCLFusionOp* ops, cl_uint num_ops,
+	CCLEventWaitList* evt_wait_lst, CCLErr** err);
+
+/* Get the number of fused kernels cached by the composer. */
+CCL_EXPORT
+cl_uint ccl_fusion_get_num_kernels(CCLFusion* fus);
+
+/** @} */
+
+#endif
@@ -29,6 +29,10 @@
 
 #include "ccl_image_wrapper.h"
 #include "ccl_buffer_wrapper.h"
+#include "ccl_kernel_arg.h"
+#include "ccl_kernel_wrapper.h"
+#include "_ccl_context_wrapper.h"
+#include "_ccl_event_wrapper.h"
 #include "_ccl_memobj_wrapper.h"
 #include "_ccl_defs.h"
 
@@ -448,6 +452,474 @@ CCLImage* ccl_image_new(CCLContext* ctx, cl_mem_flags flags,
 
 }
 
+/**
+ * @internal
+ * Determine the size in bytes of an image element with the given
+ * format. Only the main image formats are supported.
+ *
+ * @private @memberof ccl_image
+ *
+ * @param[in] image_format Image format.
+ * @return Size in bytes of an image element, or 0 if the format is not
+ * supported.
+ * */
+static size_t ccl_image_format_elem_size(
+	const cl_image_format* image_format) {
+
+	/* Number of channels and size of each channel. */
+	size_t num_channels;
+	size_t channel_size;
+
+	/* Packed formats have the element size defined by the type. */
+	switch (image_format->image_channel_data_type) {
+		case CL_SNORM_INT8:
+		case CL_UNORM_INT8:
+		case CL_SIGNED_INT8:
+		case CL_UNSIGNED_INT8:
+			channel_size = 1; break;
+		case CL_SNORM_INT16:
+		case CL_UNORM_INT16:
+		case CL_SIGNED_INT16:
+		case CL_UNSIGNED_INT16:
+		case CL_HALF_FLOAT:
+			channel_size = 2; break;
+		case CL_SIGNED_INT32:
+		case CL_UNSIGNED_INT32:
+		case CL_FLOAT:
+			channel_size = 4; break;
+		case CL_UNORM_SHORT_565:
+		case CL_UNORM_SHORT_555:
+			return 2;
+		case CL_UNORM_INT_101010:
+			return 4;
+		default:
+			return 0;
+	}
+
+	/* Other formats depend on the number of channels. */
+	switch (image_format->image_channel_order) {
+		case CL_R:
+#ifdef CL_VERSION_1_1
+		case CL_Rx:
+#endif
+		case CL_A:
+		case CL_INTENSITY:
+		case CL_LUMINANCE:
+			num_channels = 1; break;
+		case CL_RG:
+#ifdef CL_VERSION_1_1
+		case CL_RGx:
+#endif
+		case CL_RA:
+			num_channels = 2; break;
+		case CL_RGBA:
+		case CL_ARGB:
+		case CL_BGRA:
+			num_channels = 4; break;
+		default:
+			return 0;
+	}
+
+	return channel_size * num_channels;
+}
+
+/**
+ * @internal
+ * Get the row pitch alignment, in pixels, required by a device for 2D
+ * images created from buffers.
+ *
+ * @private @memberof ccl_image
+ *
+ * @param[in] dev Device wrapper object.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return The row pitch alignment in pixels, or 0 if the device does not
+ * support creating 2D images from buffers (i.e. it is not OpenCL >= 2.0 and
+ * does not expose the `cl_khr_image2d_from_buffer` extension).
+ * */
+static cl_uint ccl_image_get_pitch_alignment(CCLDevice* dev, CCLErr** err) {
+
+	/* Device OpenCL version and extensions. */
+	cl_uint ocl_ver;
+	char* exts;
+	/* Row pitch alignment. */
+	cl_uint align = 0;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Check if device supports 2D images from buffers. */
+	ocl_ver = ccl_device_get_opencl_version(dev, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	if (ocl_ver < 200) {
+		exts = ccl_device_get_info_array(
+			dev, CL_DEVICE_EXTENSIONS, char*, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+		if (strstr(exts, "cl_khr_image2d_from_buffer") == NULL)
+			goto finish;
+	}
+
+	/* Get alignment, a value of zero means no specific alignment. */
+	align = ccl_device_get_info_scalar(
+		dev, CL_DEVICE_IMAGE_PITCH_ALIGNMENT, cl_uint, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	if (align == 0) align = 1;
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	align = 0;
+
+finish:
+
+	/* Return alignment. */
+	return align;
+
+}
+
+/**
+ * Get the row pitch, in bytes, which buffers must have in order to be
+ * used as the storage of 2D images of the given format and width in all
+ * the devices of a context. The row pitch is the smallest multiple of the
+ * devices' `CL_DEVICE_IMAGE_PITCH_ALIGNMENT` which holds a row of
+ * `image_width` pixels.
+ *
+ * @public @memberof ccl_image
+ *
+ * @param[in] ctx A context wrapper object.
+ * @param[in] image_format Format of the images to be created.
+ * @param[in] image_width Width of the images in pixels.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return The row pitch in bytes, or 0 if an error occurs (e.g. if a device
+ * in the context does not support 2D images from buffers).
+ * */
+CCL_EXPORT
+size_t ccl_image_get_buffer_row_pitch(CCLContext* ctx,
+	const cl_image_format* image_format, size_t image_width, CCLErr** err) {
+
+	/* Make sure ctx is not NULL. */
+	g_return_val_if_fail(ctx != NULL, 0);
+	/* Make sure image_format is not NULL. */
+	g_return_val_if_fail(image_format != NULL, 0);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, 0);
+
+	/* Devices in context. */
+	CCLDevice* const* devs;
+	cl_uint num_devs;
+	/* Element size and row alignment in pixels. */
+	size_t elem_size;
+	size_t align = 1;
+	/* Row pitch. */
+	size_t row_pitch = 0;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Get element size. */
+	elem_size = ccl_image_format_elem_size(image_format);
+	g_if_err_create_goto(*err, CCL_ERROR, elem_size == 0,
+		CCL_ERROR_ARGS, error_handler,
+		"%s: unsupported image format.", CCL_STRD);
+
+	/* Get devices in context. */
+	num_devs = ccl_context_get_num_devices(ctx, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	devs = ccl_context_get_all_devices(ctx, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Determine alignment which satisfies all devices. */
+	for (cl_uint i = 0; i < num_devs; ++i) {
+
+		size_t a, b, dev_align;
+
+		dev_align = ccl_image_get_pitch_alignment(devs[i], &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+		g_if_err_create_goto(*err, CCL_ERROR, dev_align == 0,
+			CCL_ERROR_UNSUPPORTED_OCL, error_handler,
+			"%s: device %d does not support 2D images from buffers.",
+			CCL_STRD, i);
+
+		/* Least common multiple of current and device alignment. */
+		for (a = align, b = dev_align; b != 0; ) {
+			size_t t = a % b; a = b; b = t;
+		}
+		align = align / a * dev_align;
+	}
+
+	/* Round row size up to alignment. */
+	align *= elem_size;
+	row_pitch = ((image_width * elem_size + align - 1) / align) * align;
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+finish:
+
+	/* Return row pitch. */
+	return row_pitch;
+
+}
+
+/**
+ * Create a buffer suitable to be used as the storage of 2D images created
+ * with ::ccl_image_new_from_buffer(), i.e. with rows padded to the row
+ * pitch required by the devices in the context (see
+ * ::ccl_image_get_buffer_row_pitch()).
+ *
+ * **Usage example**
+ *
+ * @code{.c}
+ * size_t row_pitch;
+ * buf = ccl_image_buffer_new(ctx, CL_MEM_READ_WRITE, &fmt, w, h,
+ *     &row_pitch, &err);
+ * ...
+ * img = ccl_image_new_from_buffer(ctx, 0, &fmt, buf,
+ *     CL_MEM_OBJECT_IMAGE2D, w, h, row_pitch, &err);
+ * @endcode
+ *
+ * @public @memberof ccl_image
+ *
+ * @param[in] ctx A context wrapper object.
+ * @param[in] flags Buffer allocation and usage flags.
+ * @param[in] image_format Format of the images to be created.
+ * @param[in] image_width Width of the images in pixels.
+ * @param[in] image_height Height of the images in pixels.
+ * @param[out] row_pitch Location where to put the buffer row pitch, in
+ * bytes.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return A new buffer wrapper object or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLBuffer* ccl_image_buffer_new(CCLContext* ctx, cl_mem_flags flags,
+	const cl_image_format* image_format, size_t image_width,
+	size_t image_height, size_t* row_pitch, CCLErr** err) {
+
+	/* Make sure row_pitch is not NULL. */
+	g_return_val_if_fail(row_pitch != NULL, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Buffer wrapper object. */
+	CCLBuffer* buf = NULL;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Determine row pitch. */
+	*row_pitch = ccl_image_get_buffer_row_pitch(
+		ctx, image_format, image_width, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Create buffer. */
+	buf = ccl_buffer_new(ctx, flags, *row_pitch * image_height, NULL,
+		&err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+finish:
+
+	/* Return buffer wrapper. */
+	return buf;
+
+}
+
+/**
+ * Create an image which uses an existing buffer as its storage, i.e. a
+ * zero-copy image view of the buffer. Data written to the buffer becomes
+ * visible through the image (and vice-versa) after proper
+ * synchronization, without any copy.
+ *
+ * Two image types are supported:
+ *
+ * * `CL_MEM_OBJECT_IMAGE1D_BUFFER` - 1D image buffer, requires OpenCL
+ * >= 1.2; `image_height` and `row_pitch` are ignored.
+ * * `CL_MEM_OBJECT_IMAGE2D` - 2D image, requires OpenCL >= 2.0 or the
+ * `cl_khr_image2d_from_buffer` extension in all devices of the context. The
+ * row pitch must be a multiple of the devices' pitch alignment, which is
+ * guaranteed if the buffer is created with ::ccl_image_buffer_new().
+ *
+ * @note The buffer's base address must also satisfy the devices'
+ * `CL_DEVICE_IMAGE_BASE_ADDRESS_ALIGNMENT`, which is always the case for
+ * buffers which are not sub-buffers.
+ *
+ * @public @memberof ccl_image
+ *
+ * @param[in] ctx A context wrapper object on which the image wrapper
+ * object is to be created.
+ * @param[in] flags Image usage flags. If zero, flags are inherited from
+ * the buffer.
+ * @param[in] image_format Image format.
+ * @param[in] buf Buffer to use as image storage.
+ * @param[in] image_type `CL_MEM_OBJECT_IMAGE1D_BUFFER` or
+ * `CL_MEM_OBJECT_IMAGE2D`.
+ * @param[in] image_width Width of the image in pixels.
+ * @param[in] image_height Height of the image in pixels.
+ * @param[in] row_pitch Row pitch in bytes. If zero, it is assumed to be
+ * the image width times the element size.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return A new image wrapper object or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLImage* ccl_image_new_from_buffer(CCLContext* ctx, cl_mem_flags flags,
+	const cl_image_format* image_format, CCLBuffer* buf,
+	cl_mem_object_type image_type, size_t image_width,
+	size_t image_height, size_t row_pitch, CCLErr** err) {
+
+	/* Make sure ctx is not NULL. */
+	g_return_val_if_fail(ctx != NULL, NULL);
+	/* Make sure image_format is not NULL. */
+	g_return_val_if_fail(image_format != NULL, NULL);
+	/* Make sure buf is not NULL. */
+	g_return_val_if_fail(buf != NULL, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Image wrapper object. */
+	CCLImage* img = NULL;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+#ifndef CL_VERSION_1_2
+
+	CCL_UNUSED(flags);
+	CCL_UNUSED(image_type);
+	CCL_UNUSED(image_width);
+	CCL_UNUSED(image_height);
+	CCL_UNUSED(row_pitch);
+	CCL_UNUSED(err_internal);
+
+	/* If cf4ocl was not compiled with support for OpenCL >= 1.2, always throw
+	 * error. */
+	g_if_err_create_goto(*err, CCL_ERROR, TRUE,
+		CCL_ERROR_UNSUPPORTED_OCL, error_handler,
+		"%s: Images from buffers require cf4ocl to be deployed with "
+		"support for OpenCL version 1.2 or newer.",
+		CCL_STRD);
+
+#else
+
+	/* Image description. */
+	CCLImageDesc img_dsc = CCL_IMAGE_DESC_BLANK;
+	/* OpenCL version of context platform. */
+	cl_uint ocl_ver;
+	/* Element and buffer sizes. */
+	size_t elem_size;
+	size_t buf_size;
+
+	/* Check that context platform is >= OpenCL 1.2 */
+	ocl_ver = ccl_context_get_opencl_version(ctx, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	g_if_err_create_goto(*err, CCL_ERROR, ocl_ver < 120,
+		CCL_ERROR_UNSUPPORTED_OCL, error_handler,
+		"%s: Images from buffers require OpenCL version 1.2 or newer.",
+		CCL_STRD);
+
+	/* Get element and buffer sizes. */
+	elem_size = ccl_image_format_elem_size(image_format);
+	g_if_err_create_goto(*err, CCL_ERROR, elem_size == 0,
+		CCL_ERROR_ARGS, error_handler,
+		"%s: unsupported image format.", CCL_STRD);
+	buf_size = ccl_memobj_get_info_scalar(
+		buf, CL_MEM_SIZE, size_t, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	if (image_type == CL_MEM_OBJECT_IMAGE1D_BUFFER) {
+
+		/* 1D image buffer, check that buffer is large enough. */
+		g_if_err_create_goto(*err, CCL_ERROR,
+			image_width * elem_size > buf_size,
+			CCL_ERROR_ARGS, error_handler,
+			"%s: buffer is too small for 1D image buffer.", CCL_STRD);
+		row_pitch = 0;
+		image_height = 0;
+
+	} else if (image_type == CL_MEM_OBJECT_IMAGE2D) {
+
+		/* 2D image, check row pitch against device requirements. */
+		size_t pitch_align;
+
+		pitch_align = ccl_image_get_buffer_row_pitch(
+			ctx, image_format, 1, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		if (row_pitch == 0) row_pitch = image_width * elem_size;
+
+		g_if_err_create_goto(*err, CCL_ERROR,
+			row_pitch < image_width * elem_size,
+			CCL_ERROR_ARGS, error_handler,
+			"%s: row pitch is smaller than image row.", CCL_STRD);
+		g_if_err_create_goto(*err, CCL_ERROR,
+			row_pitch % pitch_align != 0,
+			CCL_ERROR_ARGS, error_handler,
+			"%s: row pitch (%d bytes) is not a multiple of the device " \
+			"pitch alignment (%d bytes).",
+			CCL_STRD, (int) row_pitch, (int) pitch_align);
+		g_if_err_create_goto(*err, CCL_ERROR,
+			row_pitch * image_height > buf_size,
+			CCL_ERROR_ARGS, error_handler,
+			"%s: buffer is too small for 2D image.", CCL_STRD);
+
+	} else {
+
+		/* Unsupported image type. */
+		g_if_err_create_goto(*err, CCL_ERROR, CL_TRUE,
+			CCL_ERROR_ARGS, error_handler,
+			"%s: images from buffers must be of type " \
+			"CL_MEM_OBJECT_IMAGE1D_BUFFER or CL_MEM_OBJECT_IMAGE2D.",
+			CCL_STRD);
+
+	}
+
+	/* Describe image, with buffer as storage. */
+	img_dsc.image_type = image_type;
+	img_dsc.image_width = image_width;
+	img_dsc.image_height = image_height;
+	img_dsc.image_row_pitch = row_pitch;
+	img_dsc.memobj = (CCLMemObj*) buf;
+
+	/* Create image. */
+	img = ccl_image_new_v(ctx, flags, image_format, &img_dsc, NULL,
+		&err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+#endif
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+finish:
+
+	/* Return image wrapper. */
+	return img;
+
+}
+
 /**
  * Read from an image or image array object to host memory. This
  * function wraps the clEnqueueReadImage() OpenCL function.
@@ -517,6 +989,11 @@ CCLEvent* ccl_image_enqueue_read(CCLImage* img, CCLQueue* cq,
 	 * queue is released. */
 	evt = ccl_queue_produce_event(cq, event);
 
+	/* Record access, for redundant transfer analysis. Image regions are
+	 * not tracked. */
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_READ,
+		ccl_memobj_unwrap(img), 0, G_MAXSIZE, NULL);
+
 	/* Clear event wait list. */
 	ccl_event_wait_list_clear(evt_wait_lst);
 
@@ -607,6 +1084,11 @@ CCLEvent* ccl_image_enqueue_write(CCLImage* img, CCLQueue* cq,
 	 * queue is released. */
 	evt = ccl_queue_produce_event(cq, event);
 
+	/* Record access, for redundant transfer analysis. Image regions are
+	 * not tracked, so the image is marked as modified. */
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_USE,
+		ccl_memobj_unwrap(img), 0, G_MAXSIZE, NULL);
+
 	/* Clear event wait list. */
 	ccl_event_wait_list_clear(evt_wait_lst);
 
@@ -696,6 +1178,12 @@ CCLEvent* ccl_image_enqueue_copy(CCLImage* src_img, CCLImage* dst_img,
 	 * queue is released. */
 	evt = ccl_queue_produce_event(cq, event);
 
+	/* Record accesses, for redundant transfer analysis. */
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_READ,
+		ccl_memobj_unwrap(src_img), 0, G_MAXSIZE, NULL);
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_USE,
+		ccl_memobj_unwrap(dst_img), 0, G_MAXSIZE, NULL);
+
 	/* Clear event wait list. */
 	ccl_event_wait_list_clear(evt_wait_lst);
 
@@ -784,6 +1272,12 @@ CCLEvent* ccl_image_enqueue_copy_to_buffer(CCLImage* src_img,
 	 * queue is released. */
 	evt = ccl_queue_produce_event(cq, event);
 
+	/* Record accesses, for redundant transfer analysis. */
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_READ,
+		ccl_memobj_unwrap(src_img), 0, G_MAXSIZE, NULL);
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_USE,
+		ccl_memobj_unwrap(dst_buf), 0, G_MAXSIZE, NULL);
+
 	/* Clear event wait list. */
 	ccl_event_wait_list_clear(evt_wait_lst);
 
@@ -879,6 +1373,12 @@ void* ccl_image_enqueue_map(CCLImage* img, CCLQueue* cq,
 	 * The event object will be released automatically when the command
 	 * queue is released. */
 	evt_inner = ccl_queue_produce_event(cq, event);
+
+	/* Record access, for redundant transfer analysis. Mapped regions may
+	 * be modified by the host unless mapped for reading only. */
+	ccl_event_add_mem_access(evt_inner, map_flags == CL_MAP_READ
+		? CCL_EVENT_MEM_READ : CCL_EVENT_MEM_USE,
+		ccl_memobj_unwrap(img), 0, G_MAXSIZE, NULL);
 	if (evt != NULL)
 		*evt = evt_inner;
 
@@ -903,12 +1403,186 @@ finish:
 
 }
 
+/**
+ * @internal
+ * Source of the fill kernels used when the platform does not support
+ * clEnqueueFillImage(). There is one kernel per image type (2D or 3D, the
+ * only ones available before OpenCL 1.2) and color type (`float4`, `int4`
+ * or `uint4`); 3D kernels are only available on devices which can write to
+ * 3D images.
+ * */
+static const char* ccl_image_fill_src =
+	"#define CCL_FILL2D(s, T) \\\n"
+	"__kernel void ccl_fill_image2d_ ## s(__write_only image2d_t img, \\\n"
+	"	int4 org, T color) { \\\n"
+	"	write_image ## s(img, org.xy \\\n"
+	"		+ (int2) ((int) get_global_id(0), (int) get_global_id(1)), \\\n"
+	"		color); }\n"
+	"CCL_FILL2D(f, float4)\n"
+	"CCL_FILL2D(i, int4)\n"
+	"CCL_FILL2D(ui, uint4)\n"
+	"#ifdef cl_khr_3d_image_writes\n"
+	"#pragma OPENCL EXTENSION cl_khr_3d_image_writes : enable\n"
+	"#define CCL_FILL3D(s, T) \\\n"
+	"__kernel void ccl_fill_image3d_ ## s(__write_only image3d_t img, \\\n"
+	"	int4 org, T color) { \\\n"
+	"	write_image ## s(img, org + (int4) ((int) get_global_id(0), \\\n"
+	"		(int) get_global_id(1), (int) get_global_id(2), 0), color); }\n"
+	"CCL_FILL3D(f, float4)\n"
+	"CCL_FILL3D(i, int4)\n"
+	"CCL_FILL3D(ui, uint4)\n"
+	"#endif\n";
+
+/**
+ * @internal
+ * Names of the fill kernels, indexed by number of dimensions minus two and
+ * by color type (`float4`, `int4` or `uint4`). Kernels are cached by name
+ * in the program wrapper, so names must outlive it.
+ * */
+static const char* const ccl_image_fill_krnls[2][3] = {
+	{ "ccl_fill_image2d_f", "ccl_fill_image2d_i", "ccl_fill_image2d_ui" },
+	{ "ccl_fill_image3d_f", "ccl_fill_image3d_i", "ccl_fill_image3d_ui" }
+};
+
+/**
+ * @internal
+ * Fill an image object with a color using a kernel, for platforms which
+ * don't support clEnqueueFillImage().
+ *
+ * @private @memberof ccl_image
+ *
+ * @param[out] img Image wrapper object to fill.
+ * @param[in] cq Command-queue wrapper object in which the fill kernel
+ * will be queued.
+ * @param[in] fill_color The fill color, four `cl_float`, `cl_int` or
+ * `cl_uint` values, depending on the image channel data type.
+ * @param[in] origin The @f$(x, y, z)@f$ offset in pixels.
+ * @param[in] region The @f$(width, height, depth)@f$ in pixels.
+ * @param[in,out] evt_wait_lst List of events that need to complete
+ * before this command can be executed.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return Event wrapper object that identifies the fill kernel, or `NULL`
+ * if an error occurs.
+ * */
+static CCLEvent* ccl_image_enqueue_fill_kernel(CCLImage* img,
+	CCLQueue* cq, const void *fill_color, const size_t *origin,
+	const size_t *region, CCLEventWaitList* evt_wait_lst, CCLErr** err) {
+
+	/* Event wrapper object. */
+	CCLEvent* evt = NULL;
+	/* Image flags, type and format. */
+	cl_mem_flags flags;
+	cl_mem_object_type type;
+	cl_image_format format;
+	/* Number of dimensions and color type. */
+	cl_uint dims;
+	cl_uint color_type;
+	/* Context of command queue. */
+	CCLContext* ctx;
+	/* Fill program and kernel. */
+	CCLProgram* prg;
+	CCLKernel* krnl;
+	/* Kernel origin argument. */
+	cl_int4 org;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Check arguments. */
+	g_if_err_create_goto(*err, CCL_ERROR,
+		(fill_color == NULL) || (origin == NULL) || (region == NULL),
+		CCL_ERROR_ARGS, error_handler,
+		"%s: invalid color, origin or region for image fill.", CCL_STRD);
+
+	/* Fill kernels write to the image, so it can't be read-only. */
+	flags = ccl_memobj_get_info_scalar(
+		img, CL_MEM_FLAGS, cl_mem_flags, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	g_if_err_create_goto(*err, CCL_ERROR, flags & CL_MEM_READ_ONLY,
+		CCL_ERROR_ARGS, error_handler,
+		"%s: images created with CL_MEM_READ_ONLY can only be filled " \
+		"with OpenCL 1.2 or newer.", CCL_STRD);
+
+	/* Determine number of dimensions. */
+	type = ccl_memobj_get_info_scalar(
+		img, CL_MEM_TYPE, cl_mem_object_type, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	g_if_err_create_goto(*err, CCL_ERROR,
+		(type != CL_MEM_OBJECT_IMAGE2D) && (type != CL_MEM_OBJECT_IMAGE3D),
+		CCL_ERROR_UNSUPPORTED_OCL, error_handler,
+		"%s: image fill requires OpenCL 1.2 or newer for this image type.",
+		CCL_STRD);
+	dims = (type == CL_MEM_OBJECT_IMAGE2D) ? 2 : 3;
+
+	/* Determine how the color is written from the channel data type. */
+	format = ccl_image_get_info_scalar(
+		img, CL_IMAGE_FORMAT, cl_image_format, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	switch (format.image_channel_data_type) {
+		case CL_SIGNED_INT8:
+		case CL_SIGNED_INT16:
+		case CL_SIGNED_INT32:
+			color_type = 1;
+			break;
+		case CL_UNSIGNED_INT8:
+		case CL_UNSIGNED_INT16:
+		case CL_UNSIGNED_INT32:
+			color_type = 2;
+			break;
+		default:
+			color_type = 0;
+	}
+
+	/* Get fill kernel, built once per context. */
+	ctx = ccl_queue_get_context(cq, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	prg = ccl_context_get_internal_program(
+		ctx, "ccl_fill_image", ccl_image_fill_src, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	krnl = ccl_program_get_kernel(
+		prg, ccl_image_fill_krnls[dims - 2][color_type], &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* One work-item per pixel. */
+	org.s[0] = (cl_int) origin[0];
+	org.s[1] = (cl_int) origin[1];
+	org.s[2] = (dims == 3) ? (cl_int) origin[2] : 0;
+	org.s[3] = 0;
+	evt = ccl_kernel_set_args_and_enqueue_ndrange(krnl, cq, dims, NULL,
+		region, NULL, evt_wait_lst, &err_internal,
+		img, ccl_arg_priv(org, cl_int4),
+		ccl_arg_full((void*) fill_color, sizeof(cl_float4)), NULL);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	evt = NULL;
+
+finish:
+
+	/* Return event. */
+	return evt;
+
+}
+
 /**
  * Fill an image object with a specified color. This function wraps the
  * clEnqueueFillImage() OpenCL function.
  *
+ * On platforms which do not support clEnqueueFillImage() (OpenCL < 1.2),
+ * or if _cf4ocl_ was built without OpenCL 1.2 support, 2D and 3D images
+ * are filled by kernels bundled with the library, built once per context,
+ * which write the color with `write_imagef()`, `write_imagei()` or
+ * `write_imageui()` according to the image channel data type. Filling 3D
+ * images this way requires the `cl_khr_3d_image_writes` extension, and
+ * images created with `CL_MEM_READ_ONLY` can't be filled this way.
+ *
  * @public @memberof ccl_image
- * @note Requires OpenCL >= 1.2
  *
  * @param[out] img Image wrapper object to fill.
  * @param[in] cq Command-queue wrapper object in which the fill command
@@ -953,58 +1627,55 @@ CCLEvent* ccl_image_enqueue_fill(CCLImage* img, CCLQueue* cq,
 	/* Internal error handling object. */
 	CCLErr* err_internal = NULL;
 
-#ifndef CL_VERSION_1_2
-
-	CCL_UNUSED(fill_color);
-	CCL_UNUSED(origin);
-	CCL_UNUSED(region);
-	CCL_UNUSED(evt_wait_lst);
-	CCL_UNUSED(ocl_status);
-	CCL_UNUSED(event);
-	CCL_UNUSED(ocl_ver);
-	CCL_UNUSED(err_internal);
-
-	/* If cf4ocl was not compiled with support for OpenCL >= 1.2, always throw
-	 * error. */
-	g_if_err_create_goto(*err, CCL_ERROR, TRUE,
-		CCL_ERROR_UNSUPPORTED_OCL, error_handler,
-		"%s: Image fill requires cf4ocl to be deployed with "
-		"support for OpenCL version 1.2 or newer.",
-		CCL_STRD);
-
-#else
+#ifdef CL_VERSION_1_2
 
-	/* Check that context platform is >= OpenCL 1.2 */
+	/* Get OpenCL version of the context platform. */
 	ocl_ver = ccl_memobj_get_opencl_version(
 		(CCLMemObj*) img, &err_internal);
 	g_if_err_propagate_goto(err, err_internal, error_handler);
 
-	/* If OpenCL version is not >= 1.2, throw error. */
-	g_if_err_create_goto(*err, CCL_ERROR, ocl_ver < 120,
-		CCL_ERROR_UNSUPPORTED_OCL, error_handler,
-		"%s: Image fill requires OpenCL version 1.2 or newer.",
-		CCL_STRD);
+	/* Use the fill command if the platform supports it. */
+	if (ocl_ver >= 120) {
 
-	/* Fill image. */
-	ocl_status = clEnqueueFillImage(ccl_queue_unwrap(cq),
-		ccl_memobj_unwrap(img), fill_color, origin, region,
-		ccl_event_wait_list_get_num_events(evt_wait_lst),
-		ccl_event_wait_list_get_clevents(evt_wait_lst), &event);
-	g_if_err_create_goto(*err, CCL_OCL_ERROR,
-		CL_SUCCESS != ocl_status, ocl_status, error_handler,
-		"%s: unable to enqueue a fill image command (OpenCL error %d: %s).",
-		CCL_STRD, ocl_status, ccl_err(ocl_status));
+		/* Fill image. */
+		ocl_status = clEnqueueFillImage(ccl_queue_unwrap(cq),
+			ccl_memobj_unwrap(img), fill_color, origin, region,
+			ccl_event_wait_list_get_num_events(evt_wait_lst),
+			ccl_event_wait_list_get_clevents(evt_wait_lst), &event);
+		g_if_err_create_goto(*err, CCL_OCL_ERROR,
+			CL_SUCCESS != ocl_status, ocl_status, error_handler,
+			"%s: unable to enqueue a fill image command " \
+			"(OpenCL error %d: %s).",
+			CCL_STRD, ocl_status, ccl_err(ocl_status));
 
-	/* Wrap event and associate it with the respective command queue.
-	 * The event object will be released automatically when the command
-	 * queue is released. */
-	evt = ccl_queue_produce_event(cq, event);
+		/* Wrap event and associate it with the respective command
+		 * queue. The event object will be released automatically when
+		 * the command queue is released. */
+		evt = ccl_queue_produce_event(cq, event);
 
-	/* Clear event wait list. */
-	ccl_event_wait_list_clear(evt_wait_lst);
+		/* Clear event wait list. */
+		ccl_event_wait_list_clear(evt_wait_lst);
+	}
+
+#else
+
+	CCL_UNUSED(ocl_status);
+	CCL_UNUSED(event);
+	CCL_UNUSED(ocl_ver);
 
 #endif
 
+	/* Otherwise, fall back to a fill kernel. */
+	if (evt == NULL) {
+		evt = ccl_image_enqueue_fill_kernel(img, cq, fill_color, origin,
+			region, evt_wait_lst, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+	}
+
+	/* Record access, for redundant transfer analysis. */
+	ccl_event_add_mem_access(evt, CCL_EVENT_MEM_USE,
+		ccl_memobj_unwrap(img), 0, G_MAXSIZE, NULL);
+
 	/* If we got here, everything is OK. */
 	g_assert(err == NULL || *err == NULL);
 	goto finish;
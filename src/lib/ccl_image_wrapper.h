@@ -50,6 +50,11 @@
  * _cf4ocl_ @ref ug_new_destroy "new/destroy" rule; as such, images should be
  * freed with the ::ccl_image_destroy() destructor.
  *
+ * Images can also be created over existing buffers, without copying data,
+ * using the ::ccl_image_new_from_buffer() constructor. Buffers meant to be
+ * used as 2D image storage should be created with ::ccl_image_buffer_new(),
+ * which pads rows to the pitch alignment required by the devices.
+ *
  * Image wrapper objects can be directly passed as kernel arguments to functions
  * such as ::ccl_program_enqueue_kernel() or ::ccl_kernel_set_arg().
  *
@@ -220,6 +225,24 @@ CCLImage* ccl_image_new(CCLContext* ctx, cl_mem_flags flags,
 	const cl_image_format* image_format, void* host_ptr, CCLErr** err,
 	...);
 
+/* Get the row pitch required for buffers used as 2D image storage. */
+CCL_EXPORT
+size_t ccl_image_get_buffer_row_pitch(CCLContext* ctx,
+	const cl_image_format* image_format, size_t image_width, CCLErr** err);
+
+/* Create a buffer suitable for use as 2D image storage. */
+CCL_EXPORT
+CCLBuffer* ccl_image_buffer_new(CCLContext* ctx, cl_mem_flags flags,
+	const cl_image_format* image_format, size_t image_width,
+	size_t image_height, size_t* row_pitch, CCLErr** err);
+
+/* Create an image which uses an existing buffer as its storage. */
+CCL_EXPORT
+CCLImage* ccl_image_new_from_buffer(CCLContext* ctx, cl_mem_flags flags,
+	const cl_image_format* image_format, CCLBuffer* buf,
+	cl_mem_object_type image_type, size_t image_width,
+	size_t image_height, size_t row_pitch, CCLErr** err);
+
 /* Read from an image or image array object to host memory. */
 CCL_EXPORT
 CCLEvent* ccl_image_enqueue_read(CCLImage* img, CCLQueue* cq,
@@ -361,7 +384,7 @@ CCLEvent* ccl_image_enqueue_fill(CCLImage* img, CCLQueue* cq,
  * @return The OpenCL image memory object.
  * */
 #define ccl_image_unwrap(img) \
-	((cl_mem) ccl_wrapper_unwrap((CCLWrapper*) img))
+	((cl_mem) ccl_wrapper_unwrap_inline((CCLWrapper*) img))
 
 /** @} */
 
@@ -80,6 +80,7 @@ CCLArg* ccl_arg_new(void* value, size_t size) {
 
 	CCLArg* arg = g_slice_new(CCLArg);
 
+	arg->class = CCL_NONE;
 	arg->cl_object = g_memdup((const void*) value, (guint) size);
 	arg->info = (void*) &arg_local_marker;
 	arg->ref_count = (gint) size;
@@ -70,6 +70,8 @@ void* ccl_arg_value(CCLArg* arg);
  * ::ccl_kernel_set_args_and_enqueue_ndrange(), accept kernel arguments
  * as parameters. ::CCLBuffer*, ::CCLImage* and ::CCLSampler* objects
  * can be directly passed as global kernel arguments to these functions.
+ * The same applies to on-device ::CCLQueue* objects (created with
+ * ::ccl_queue_new_on_device()), which are passed as `queue_t` arguments.
  * However, local and private kernel arguments need to be passed using
  * the macros provided in this module, namely ::ccl_arg_local() and
  * ::ccl_arg_priv(), respectively.
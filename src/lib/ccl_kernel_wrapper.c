@@ -29,6 +29,8 @@
 
 #include "ccl_kernel_wrapper.h"
 #include "ccl_program_wrapper.h"
+#include "_ccl_event_wrapper.h"
+#include "_ccl_queue_wrapper.h"
 #include "_ccl_abstract_wrapper.h"
 #include "_ccl_defs.h"
 
@@ -51,6 +53,21 @@ struct ccl_kernel {
 	 * */
 	GHashTable* args;
 
+	/**
+	 * Memory objects currently set as kernel arguments (argument index
+	 * to `cl_mem`), for redundant transfer analysis.
+	 * @private
+	 * */
+	GHashTable* mem_args;
+
+	/**
+	 * How kernel launches access the memory objects in
+	 * ccl_kernel::mem_args (argument index to ::CCLEventMemAccessKind
+	 * plus one), determined the first time they are recorded.
+	 * @private
+	 * */
+	GHashTable* mem_arg_kinds;
+
 };
 
 /**
@@ -71,6 +88,188 @@ static void ccl_kernel_release_fields(CCLKernel* krnl) {
 	if (krnl->args != NULL)
 		g_hash_table_destroy(krnl->args);
 
+	/* Free tables of memory object arguments. */
+	if (krnl->mem_args != NULL)
+		g_hash_table_destroy(krnl->mem_args);
+	if (krnl->mem_arg_kinds != NULL)
+		g_hash_table_destroy(krnl->mem_arg_kinds);
+
+}
+
+/**
+ * @internal
+ * Set kernel arguments which are pending in the argument table with the
+ * clSetKernelArg() OpenCL function, removing them from the table.
+ *
+ * @private @memberof ccl_kernel
+ *
+ * @param[in] krnl A kernel wrapper object.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return `CL_TRUE` if operation is successful, or `CL_FALSE`
+ * otherwise.
+ * */
+static cl_bool ccl_kernel_set_pending_args(CCLKernel* krnl, CCLErr** err) {
+
+	/* OpenCL status flag. */
+	cl_int ocl_status;
+	/* Function return status. */
+	cl_bool ret_status;
+
+	/* Iterator for table of kernel arguments. */
+	GHashTableIter iter;
+	gpointer arg_index_ptr, arg_ptr;
+
+	/* Set pending kernel arguments. */
+	if (krnl->args != NULL) {
+		g_hash_table_iter_init(&iter, krnl->args);
+		while (g_hash_table_iter_next(&iter, &arg_index_ptr, &arg_ptr)) {
+			cl_uint arg_index = GPOINTER_TO_UINT(arg_index_ptr);
+			CCLArg* arg = (CCLArg*) arg_ptr;
+			ocl_status = clSetKernelArg(ccl_kernel_unwrap(krnl), arg_index,
+				ccl_arg_size(arg), ccl_arg_value(arg));
+			g_if_err_create_goto(*err, CCL_OCL_ERROR,
+				CL_SUCCESS != ocl_status, ocl_status, error_handler,
+				"%s: unable to set kernel arg %d (OpenCL error %d: %s).",
+				CCL_STRD, arg_index, ocl_status, ccl_err(ocl_status));
+
+			/* Keep track of memory object arguments, which kernel
+			 * launches may read and modify. */
+			if ((arg->class == CCL_BUFFER) || (arg->class == CCL_IMAGE)) {
+				if (krnl->mem_args == NULL)
+					krnl->mem_args = g_hash_table_new(
+						g_direct_hash, g_direct_equal);
+				g_hash_table_insert(krnl->mem_args, arg_index_ptr,
+					arg->cl_object);
+			} else if (krnl->mem_args != NULL) {
+				g_hash_table_remove(krnl->mem_args, arg_index_ptr);
+			}
+			if (krnl->mem_arg_kinds != NULL)
+				g_hash_table_remove(krnl->mem_arg_kinds, arg_index_ptr);
+
+			g_hash_table_iter_remove(&iter);
+		}
+	}
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	ret_status = CL_TRUE;
+	goto finish;
+
+error_handler:
+
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	ret_status = CL_FALSE;
+
+finish:
+
+	/* Return status. */
+	return ret_status;
+
+}
+
+/**
+ * @internal
+ * Determine how kernel launches access a memory object argument. The
+ * argument is only read if the memory object was created with
+ * `CL_MEM_READ_ONLY`, or if the kernel parameter is a `const` pointer
+ * or a `read_only` image. Otherwise the kernel is assumed to read and
+ * modify it. Kernel parameter qualifiers are only available with OpenCL
+ * 1.2 or newer, and may require programs to be built with the
+ * `-cl-kernel-arg-info` option.
+ *
+ * @private @memberof ccl_kernel
+ *
+ * @param[in] krnl A kernel wrapper object.
+ * @param[in] arg_index Argument index.
+ * @param[in] mem Memory object set as argument.
+ * @return ::CCL_EVENT_MEM_READ or ::CCL_EVENT_MEM_USE.
+ * */
+static CCLEventMemAccessKind ccl_kernel_get_mem_arg_kind(
+	CCLKernel* krnl, cl_uint arg_index, cl_mem mem) {
+
+	/* Memory object flags and type. */
+	cl_mem_flags flags;
+	cl_mem_object_type type;
+
+	if ((clGetMemObjectInfo(mem, CL_MEM_FLAGS, sizeof(cl_mem_flags),
+		&flags, NULL) == CL_SUCCESS) && (flags & CL_MEM_READ_ONLY))
+		return CCL_EVENT_MEM_READ;
+
+#ifdef CL_VERSION_1_2
+
+	if (clGetMemObjectInfo(mem, CL_MEM_TYPE, sizeof(cl_mem_object_type),
+		&type, NULL) != CL_SUCCESS)
+		return CCL_EVENT_MEM_USE;
+
+	if (type == CL_MEM_OBJECT_BUFFER) {
+		if (ccl_kernel_get_arg_info_scalar(krnl, arg_index,
+			CL_KERNEL_ARG_TYPE_QUALIFIER, cl_kernel_arg_type_qualifier,
+			NULL) & CL_KERNEL_ARG_TYPE_CONST)
+			return CCL_EVENT_MEM_READ;
+	} else {
+		if (ccl_kernel_get_arg_info_scalar(krnl, arg_index,
+			CL_KERNEL_ARG_ACCESS_QUALIFIER,
+			cl_kernel_arg_access_qualifier, NULL)
+			== CL_KERNEL_ARG_ACCESS_READ_ONLY)
+			return CCL_EVENT_MEM_READ;
+	}
+
+#else
+
+	CCL_UNUSED(krnl);
+	CCL_UNUSED(arg_index);
+	CCL_UNUSED(type);
+
+#endif
+
+	return CCL_EVENT_MEM_USE;
+
+}
+
+/**
+ * @internal
+ * Record the memory objects set as kernel arguments in the event of a
+ * kernel launch, for redundant transfer analysis. How each argument is
+ * accessed is determined by ccl_kernel_get_mem_arg_kind().
+ *
+ * @private @memberof ccl_kernel
+ *
+ * @param[in] krnl A kernel wrapper object.
+ * @param[in] evt Event of the kernel launch.
+ * */
+static void ccl_kernel_add_mem_accesses(CCLKernel* krnl, CCLEvent* evt) {
+
+	/* Iterator for table of memory object arguments. */
+	GHashTableIter iter;
+	gpointer arg_index_ptr, mem, kind;
+
+	/* Do nothing if tracking is disabled or there are no memory object
+	 * arguments. */
+	if ((ccl_event_get_mem_tracking() == 0) || (krnl->mem_args == NULL))
+		return;
+
+	if (krnl->mem_arg_kinds == NULL)
+		krnl->mem_arg_kinds = g_hash_table_new(
+			g_direct_hash, g_direct_equal);
+
+	g_hash_table_iter_init(&iter, krnl->mem_args);
+	while (g_hash_table_iter_next(&iter, &arg_index_ptr, &mem)) {
+
+		/* Determine access kind once per argument. */
+		kind = g_hash_table_lookup(krnl->mem_arg_kinds, arg_index_ptr);
+		if (kind == NULL) {
+			kind = GINT_TO_POINTER(1 + ccl_kernel_get_mem_arg_kind(krnl,
+				GPOINTER_TO_UINT(arg_index_ptr), (cl_mem) mem));
+			g_hash_table_insert(krnl->mem_arg_kinds, arg_index_ptr, kind);
+		}
+
+		ccl_event_add_mem_access(evt,
+			(CCLEventMemAccessKind) (GPOINTER_TO_INT(kind) - 1),
+			(cl_mem) mem, 0, G_MAXSIZE, NULL);
+	}
+
 }
 
 /**
@@ -199,7 +398,8 @@ void ccl_kernel_destroy(CCLKernel* krnl) {
  * @param[in] krnl A kernel wrapper object.
  * @param[in] arg_index Argument index.
  * @param[in] arg Argument to set. Arguments must be of type ::CCLArg*,
- * ::CCLBuffer*, ::CCLImage* or ::CCLSampler*.
+ * ::CCLBuffer*, ::CCLImage*, ::CCLSampler* or ::CCLQueue* (on-device
+ * queues only).
  * */
 CCL_EXPORT
 void ccl_kernel_set_arg(CCLKernel* krnl, cl_uint arg_index, void* arg) {
@@ -243,8 +443,8 @@ void ccl_kernel_set_arg(CCLKernel* krnl, cl_uint arg_index, void* arg) {
  *
  * @param[in] krnl A kernel wrapper object.
  * @param[in] ... A `NULL`-terminated list of arguments to set.
- * Arguments must be of type ::CCLArg*, ::CCLBuffer*, ::CCLImage* or
- * ::CCLSampler*.
+ * Arguments must be of type ::CCLArg*, ::CCLBuffer*, ::CCLImage*,
+ * ::CCLSampler* or ::CCLQueue* (on-device queues only).
  * */
 CCL_EXPORT
 void ccl_kernel_set_args(CCLKernel* krnl, ...) {
@@ -327,8 +527,8 @@ void ccl_kernel_set_args(CCLKernel* krnl, ...) {
  *
  * @param[in] krnl A kernel wrapper object.
  * @param[in] args A `NULL`-terminated array of arguments to set.
- * Arguments must be of type ::CCLArg*, ::CCLBuffer*, ::CCLImage* or
- * ::CCLSampler*.
+ * Arguments must be of type ::CCLArg*, ::CCLBuffer*, ::CCLImage*,
+ * ::CCLSampler* or ::CCLQueue* (on-device queues only).
  * */
 CCL_EXPORT
 void ccl_kernel_set_args_v(CCLKernel* krnl, void** args) {
@@ -409,26 +609,19 @@ CCLEvent* ccl_kernel_enqueue_ndrange(CCLKernel* krnl, CCLQueue* cq,
 	cl_event event;
 	/* Event wrapper. */
 	CCLEvent* evt;
-
-	/* Iterator for table of kernel arguments. */
-	GHashTableIter iter;
-	gpointer arg_index_ptr, arg_ptr;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
 
 	/* Set pending kernel arguments. */
-	if (krnl->args != NULL) {
-		g_hash_table_iter_init(&iter, krnl->args);
-		while (g_hash_table_iter_next(&iter, &arg_index_ptr, &arg_ptr)) {
-			cl_uint arg_index = GPOINTER_TO_UINT(arg_index_ptr);
-			CCLArg* arg = (CCLArg*) arg_ptr;
-			ocl_status = clSetKernelArg(ccl_kernel_unwrap(krnl), arg_index,
-				ccl_arg_size(arg), ccl_arg_value(arg));
-			g_if_err_create_goto(*err, CCL_OCL_ERROR,
-				CL_SUCCESS != ocl_status, ocl_status, error_handler,
-				"%s: unable to set kernel arg %d (OpenCL error %d: %s).",
-				CCL_STRD, arg_index, ocl_status, ccl_err(ocl_status));
-			g_hash_table_iter_remove(&iter);
-		}
-	}
+	ccl_kernel_set_pending_args(krnl, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Hold back launch if queue is of lower priority. */
+	ccl_queue_qos_gate(cq);
+
+	/* Wait for room in the queue, if it has an in-flight limit. */
+	ccl_queue_inflight_acquire(cq, 0, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
 
 	/* Run kernel. */
 	ocl_status = clEnqueueNDRangeKernel(ccl_queue_unwrap(cq),
@@ -446,6 +639,12 @@ CCLEvent* ccl_kernel_enqueue_ndrange(CCLKernel* krnl, CCLQueue* cq,
 	 * queue is released. */
 	evt = ccl_queue_produce_event(cq, event);
 
+	/* Record the NDRange in the event, for profiling purposes. */
+	ccl_event_set_ndrange(evt, work_dim, global_work_size, local_work_size);
+
+	/* Record memory object arguments, for redundant transfer analysis. */
+	ccl_kernel_add_mem_accesses(krnl, evt);
+
 	/* Clear event wait list. */
 	ccl_event_wait_list_clear(evt_wait_lst);
 
@@ -468,6 +667,470 @@ finish:
 
 }
 
+/**
+ * Enqueues several iterations of one or more kernels for execution on
+ * a device, cycling through the given kernels, such that iteration `i`
+ * executes kernel `krnls[i % num_krnls]`.
+ *
+ * This function is targeted at iterative algorithms, such as
+ * simulations which swap input and output buffers at each step (e.g.
+ * "ping-pong" buffers). Instead of setting the kernel arguments at each
+ * iteration, client code creates one kernel instance per argument
+ * configuration with ::ccl_kernel_new(), sets its arguments once with
+ * ::ccl_kernel_set_args(), and passes the kernel instances to this
+ * function. Pending arguments are set once before the first iteration,
+ * and iterations are then enqueued back to back without any argument
+ * handling.
+ *
+ * Intermediate iterations do not produce events, so the command queue
+ * must be in-order. Events are only created for the last iteration
+ * and for iterations after which the callback is invoked.
+ *
+ * If `cb` is not `NULL`, it is invoked after every `period` iterations,
+ * right after the respective kernel is enqueued, and receives the
+ * iteration index and the event of the iteration (e.g. for enqueuing a
+ * periodic non-blocking readback in another queue). Events added by
+ * the callback to the wait list it receives after iteration `i` will be
+ * waited on by iteration `i + num_krnls`, i.e. by the next iteration
+ * which executes the same kernel instance and therefore writes the same
+ * memory objects. With ping-pong buffers, for example, a readback of
+ * the output of iteration `i` only holds back iteration `i + 2`, and
+ * overlaps with iteration `i + 1`, which only reads that output.
+ *
+ * **Usage example**
+ *
+ * @code{.c}
+ * CCLKernel* krnls[2];
+ * ...
+ * krnls[0] = ccl_kernel_new(prg, "step", &err);
+ * krnls[1] = ccl_kernel_new(prg, "step", &err);
+ * ccl_kernel_set_args(krnls[0], buf1, buf2, NULL);
+ * ccl_kernel_set_args(krnls[1], buf2, buf1, NULL);
+ * evt = ccl_kernel_enqueue_ndrange_iter(krnls, 2, cq, 1, NULL, &gws,
+ *     &lws, 1000, 0, NULL, NULL, NULL, &err);
+ * @endcode
+ *
+ * @warning This function is not thread-safe.
+ *
+ * @public @memberof ccl_kernel
+ *
+ * @param[in] krnls Array of kernel wrapper objects.
+ * @param[in] num_krnls Number of kernel wrapper objects in `krnls`.
+ * @param[in] cq An in-order command queue wrapper object.
+ * @param[in] work_dim The number of dimensions used to specify the
+ * global work-items and work-items in the work-group.
+ * @param[in] global_work_offset Can be used to specify an array of
+ * `work_dim` unsigned values that describe the offset used to calculate
+ * the global ID of a work-item.
+ * @param[in] global_work_size An array of `work_dim` unsigned values
+ * that describe the number of global work-items in `work_dim`
+ * dimensions that will execute the kernel function.
+ * @param[in] local_work_size An array of `work_dim` unsigned values
+ * that describe the number of work-items that make up a work-group that
+ * will execute the specified kernel.
+ * @param[in] num_iters Number of iterations to enqueue.
+ * @param[in] period Invoke `cb` every `period` iterations. Ignored if
+ * `cb` is `NULL`.
+ * @param[in] cb Function to invoke periodically, or `NULL`.
+ * @param[in] user_data Data to pass to `cb`.
+ * @param[in,out] evt_wait_lst List of events that need to complete
+ * before the first iteration can be executed. The list will be cleared
+ * and can be reused by client code.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return Event wrapper object that identifies the last iteration, or
+ * `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLEvent* ccl_kernel_enqueue_ndrange_iter(CCLKernel** krnls,
+	cl_uint num_krnls, CCLQueue* cq, cl_uint work_dim,
+	const size_t* global_work_offset, const size_t* global_work_size,
+	const size_t* local_work_size, cl_uint num_iters, cl_uint period,
+	ccl_kernel_iter_callback cb, void* user_data,
+	CCLEventWaitList* evt_wait_lst, CCLErr** err) {
+
+	/* Make sure krnls is not NULL. */
+	g_return_val_if_fail(krnls != NULL, NULL);
+	/* Make sure there is at least one kernel. */
+	g_return_val_if_fail(num_krnls > 0, NULL);
+	/* Make sure cq is not NULL. */
+	g_return_val_if_fail(cq != NULL, NULL);
+	/* Make sure at least one iteration is requested. */
+	g_return_val_if_fail(num_iters > 0, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* OpenCL status flag. */
+	cl_int ocl_status;
+	/* OpenCL event. */
+	cl_event event;
+	/* Event wrapper. */
+	CCLEvent* evt = NULL;
+	/* Command queue properties. */
+	cl_command_queue_properties props;
+	/* Wait lists for the next num_krnls iterations, populated by the
+	 * callback; iteration i waits on wait list i % num_krnls. */
+	CCLEventWaitList* ewl_ring = NULL;
+	/* Wait list for current iteration. */
+	CCLEventWaitList* ewl = evt_wait_lst;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Iterations are ordered implicitly, so queue must be in-order. */
+	props = ccl_queue_get_info_scalar(cq, CL_QUEUE_PROPERTIES,
+		cl_command_queue_properties, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	g_if_err_create_goto(*err, CCL_ERROR,
+		props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE,
+		CCL_ERROR_ARGS, error_handler,
+		"%s: iterative kernel execution requires an in-order queue.",
+		CCL_STRD);
+
+	/* Set pending arguments of all kernels, once. */
+	for (cl_uint i = 0; i < num_krnls; ++i) {
+		g_return_val_if_fail(krnls[i] != NULL, NULL);
+		ccl_kernel_set_pending_args(krnls[i], &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+	}
+
+	/* Hold back launches if queue is of lower priority. */
+	ccl_queue_qos_gate(cq);
+
+	/* Initialize wait lists for the callback. */
+	ewl_ring = g_new0(CCLEventWaitList, num_krnls);
+
+	/* Enqueue iterations. */
+	for (cl_uint i = 0; i < num_iters; ++i) {
+
+		/* Invoke callback after this iteration? */
+		cl_bool do_cb = (cb != NULL) && (period > 0)
+			&& ((i + 1) % period == 0);
+		/* Does this iteration require an event? */
+		cl_bool need_evt = do_cb || (i == num_iters - 1);
+
+		/* The first iteration waits on the given wait list, the
+		 * following ones on the events added by the callback
+		 * num_krnls iterations before. */
+		if (i > 0) ewl = &ewl_ring[i % num_krnls];
+
+		/* Run kernel. */
+		ocl_status = clEnqueueNDRangeKernel(ccl_queue_unwrap(cq),
+			ccl_kernel_unwrap(krnls[i % num_krnls]), work_dim,
+			global_work_offset, global_work_size, local_work_size,
+			ccl_event_wait_list_get_num_events(ewl),
+			ccl_event_wait_list_get_clevents(ewl),
+			need_evt ? &event : NULL);
+		g_if_err_create_goto(*err, CCL_OCL_ERROR,
+			CL_SUCCESS != ocl_status, ocl_status, error_handler,
+			"%s: unable to enqueue kernel in iteration %d " \
+			"(OpenCL error %d: %s).",
+			CCL_STRD, i, ocl_status, ccl_err(ocl_status));
+
+		/* Clear current wait list, so that it can be populated by the
+		 * callback for iteration i + num_krnls. */
+		ccl_event_wait_list_clear(ewl);
+
+		/* Wrap event and associate it with the command queue. */
+		evt = need_evt ? ccl_queue_produce_event(cq, event) : NULL;
+
+		/* Record memory object arguments of the kernels launched so
+		 * far, for redundant transfer analysis. */
+		for (cl_uint k = 0; (evt != NULL) && (k < num_krnls); ++k)
+			ccl_kernel_add_mem_accesses(krnls[k], evt);
+
+		/* Invoke callback. */
+		if (do_cb) {
+			cb(i, evt, &ewl_ring[i % num_krnls], user_data,
+				&err_internal);
+			g_if_err_propagate_goto(err, err_internal, error_handler);
+		}
+	}
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+	/* An error occurred, return NULL to signal it. */
+	evt = NULL;
+
+finish:
+
+	/* Release events left for iterations which were not enqueued. */
+	for (cl_uint k = 0; (ewl_ring != NULL) && (k < num_krnls); ++k)
+		ccl_event_wait_list_clear(&ewl_ring[k]);
+	g_free(ewl_ring);
+
+	/* Return event of last iteration. */
+	return evt;
+
+}
+
+/* Number of initial slices of a chunked launch which are timed in order to
+ * size the following slices. */
+#define CCL_KERNEL_CHUNK_NUM_CALIB 3
+
+/* Fraction of the range enqueued in the first slice of a chunked launch. */
+#define CCL_KERNEL_CHUNK_INIT_DIV 16
+
+/* Maximum growth of slice size between consecutive slices. */
+#define CCL_KERNEL_CHUNK_MAX_GROWTH 4
+
+/**
+ * Enqueues a kernel for execution on a device, splitting the global
+ * range in several consecutive slices, each one launched with its own
+ * global work offset.
+ *
+ * Long running kernels may trigger the display watchdog of GPUs which
+ * also drive a screen, and block other work submitted to the device
+ * until they finish. This function splits the last dimension of the
+ * global range in slices which take approximately `target_time` seconds
+ * each, so that the device can interleave other work between them. The
+ * first slice covers 1/16th of the range, and the first few slices are
+ * waited on and timed (using event profiling information if the queue
+ * has profiling enabled, or the host clock otherwise). The size of the
+ * following slices is set from the measured throughput, growing at most
+ * four-fold between consecutive slices. Slice sizes are multiples of the
+ * local work size in the last dimension, if given.
+ *
+ * The kernel must not depend on the global size in the last dimension,
+ * since each slice is launched with a fraction of it; kernels should use
+ * `get_global_id()` for indexing, which takes the global work offset
+ * into account.
+ *
+ * If `cb` is not `NULL`, it is invoked between slices (i.e., after every
+ * slice except the last one) with the slice index and event, providing a
+ * yield point for client code. Events added by the callback to the wait
+ * list it receives will be waited on by the next slice.
+ *
+ * The command queue must be in-order. Pending kernel arguments are set
+ * once, before the first slice.
+ *
+ * **Usage example**
+ *
+ * @code{.c}
+ * // Slices of approximately 50 ms each
+ * evt = ccl_kernel_enqueue_ndrange_chunked(krnl, cq, 2, NULL, gws, lws,
+ *     0.05, NULL, NULL, NULL, &err);
+ * @endcode
+ *
+ * @warning This function is not thread-safe.
+ *
+ * @public @memberof ccl_kernel
+ *
+ * @param[in] krnl A kernel wrapper object.
+ * @param[in] cq An in-order command queue wrapper object.
+ * @param[in] work_dim The number of dimensions used to specify the
+ * global work-items and work-items in the work-group.
+ * @param[in] global_work_offset Can be used to specify an array of
+ * `work_dim` unsigned values that describe the offset used to calculate
+ * the global ID of a work-item.
+ * @param[in] global_work_size An array of `work_dim` unsigned values
+ * that describe the number of global work-items in `work_dim`
+ * dimensions that will execute the kernel function.
+ * @param[in] local_work_size An array of `work_dim` unsigned values
+ * that describe the number of work-items that make up a work-group that
+ * will execute the specified kernel.
+ * @param[in] target_time Target duration of each slice, in seconds.
+ * @param[in] cb Function to invoke between slices, or `NULL`.
+ * @param[in] user_data Data to pass to `cb`.
+ * @param[in,out] evt_wait_lst List of events that need to complete
+ * before the first slice can be executed. The list will be cleared
+ * and can be reused by client code.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return Event wrapper object which completes when all slices have
+ * completed, or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLEvent* ccl_kernel_enqueue_ndrange_chunked(CCLKernel* krnl,
+	CCLQueue* cq, cl_uint work_dim, const size_t* global_work_offset,
+	const size_t* global_work_size, const size_t* local_work_size,
+	double target_time, ccl_kernel_iter_callback cb, void* user_data,
+	CCLEventWaitList* evt_wait_lst, CCLErr** err) {
+
+	/* Make sure krnl is not NULL. */
+	g_return_val_if_fail(krnl != NULL, NULL);
+	/* Make sure cq is not NULL. */
+	g_return_val_if_fail(cq != NULL, NULL);
+	/* Make sure global_work_size is not NULL. */
+	g_return_val_if_fail(global_work_size != NULL, NULL);
+	/* Make sure target time is positive. */
+	g_return_val_if_fail(target_time > 0, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* OpenCL status flag. */
+	cl_int ocl_status;
+	/* OpenCL event. */
+	cl_event event;
+	/* Event wrapper. */
+	CCLEvent* evt = NULL;
+	/* Command queue properties. */
+	cl_command_queue_properties props;
+	/* Wait list for next slice, populated by the callback. */
+	CCLEventWaitList ewl_next = NULL;
+	/* Wait list for current slice. */
+	CCLEventWaitList* ewl = evt_wait_lst;
+	/* Wait list used for timing slices. */
+	CCLEventWaitList ewl_calib = NULL;
+	/* Offset and size of current slice. */
+	size_t offset[3], size[3];
+	/* Sliced dimension, its granularity and number of granules. */
+	cl_uint d;
+	size_t gran, num_gran;
+	/* Granules already enqueued and granules in the current slice. */
+	size_t done = 0, slice;
+	/* Slice index. */
+	cl_uint i;
+	/* Slice duration, in seconds, and host time stamp. */
+	double elapsed;
+	gint64 t_start;
+	/* Profiling information. */
+	cl_ulong t_cmd_start, t_cmd_end;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Check the number of dimensions. */
+	g_if_err_create_goto(*err, CCL_ERROR,
+		(work_dim == 0) || (work_dim > 3), CCL_ERROR_ARGS, error_handler,
+		"%s: invalid number of dimensions (%u).", CCL_STRD, work_dim);
+
+	/* Slices are ordered implicitly, so queue must be in-order. */
+	props = ccl_queue_get_info_scalar(cq, CL_QUEUE_PROPERTIES,
+		cl_command_queue_properties, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	g_if_err_create_goto(*err, CCL_ERROR,
+		props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE,
+		CCL_ERROR_ARGS, error_handler,
+		"%s: chunked kernel execution requires an in-order queue.",
+		CCL_STRD);
+
+	/* Slice the last dimension in multiples of the local work size. */
+	d = work_dim - 1;
+	gran = (local_work_size != NULL) ? local_work_size[d] : 1;
+	g_if_err_create_goto(*err, CCL_ERROR,
+		(gran == 0) || (global_work_size[d] % gran != 0),
+		CCL_ERROR_ARGS, error_handler,
+		"%s: global work size is not a multiple of local work size.",
+		CCL_STRD);
+	num_gran = global_work_size[d] / gran;
+	for (cl_uint k = 0; k < work_dim; ++k) {
+		offset[k] = (global_work_offset != NULL) ? global_work_offset[k] : 0;
+		size[k] = global_work_size[k];
+	}
+
+	/* Set pending kernel arguments, once. */
+	ccl_kernel_set_pending_args(krnl, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Enqueue slices. */
+	slice = MAX(num_gran / CCL_KERNEL_CHUNK_INIT_DIV, 1);
+	for (i = 0; done < num_gran; ++i) {
+
+		/* Determine slice extent. */
+		slice = MIN(slice, num_gran - done);
+		offset[d] = ((global_work_offset != NULL)
+			? global_work_offset[d] : 0) + done * gran;
+		size[d] = slice * gran;
+
+		/* Let higher priority work through between slices. */
+		ccl_queue_qos_gate(cq);
+
+		/* Wait for room in the queue, if it has an in-flight limit. */
+		ccl_queue_inflight_acquire(cq, 0, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		/* Run slice. */
+		t_start = g_get_monotonic_time();
+		ocl_status = clEnqueueNDRangeKernel(ccl_queue_unwrap(cq),
+			ccl_kernel_unwrap(krnl), work_dim, offset, size,
+			local_work_size, ccl_event_wait_list_get_num_events(ewl),
+			ccl_event_wait_list_get_clevents(ewl), &event);
+		g_if_err_create_goto(*err, CCL_OCL_ERROR,
+			CL_SUCCESS != ocl_status, ocl_status, error_handler,
+			"%s: unable to enqueue kernel in slice %u " \
+			"(OpenCL error %d: %s).",
+			CCL_STRD, i, ocl_status, ccl_err(ocl_status));
+
+		/* Clear current wait list, next ones are set by the callback. */
+		ccl_event_wait_list_clear(ewl);
+		ewl = &ewl_next;
+
+		/* Wrap event and associate it with the command queue, recording
+		 * memory object arguments for redundant transfer analysis. */
+		evt = ccl_queue_produce_event(cq, event);
+		ccl_kernel_add_mem_accesses(krnl, evt);
+		done += slice;
+
+		/* Time the first slices and size the next ones accordingly. */
+		if ((i < CCL_KERNEL_CHUNK_NUM_CALIB) && (done < num_gran)) {
+
+			ccl_event_wait(ccl_ewl(&ewl_calib, evt, NULL), &err_internal);
+			g_if_err_propagate_goto(err, err_internal, error_handler);
+
+			if (props & CL_QUEUE_PROFILING_ENABLE) {
+				t_cmd_start = ccl_event_get_profiling_info_scalar(evt,
+					CL_PROFILING_COMMAND_START, cl_ulong, &err_internal);
+				g_if_err_propagate_goto(err, err_internal, error_handler);
+				t_cmd_end = ccl_event_get_profiling_info_scalar(evt,
+					CL_PROFILING_COMMAND_END, cl_ulong, &err_internal);
+				g_if_err_propagate_goto(err, err_internal, error_handler);
+				elapsed = (t_cmd_end - t_cmd_start) * 1e-9;
+			} else {
+				elapsed = (g_get_monotonic_time() - t_start)
+					/ (double) G_TIME_SPAN_SECOND;
+			}
+
+			/* Scale slice to target time, limiting its growth. */
+			if (elapsed * CCL_KERNEL_CHUNK_MAX_GROWTH > target_time) {
+				slice = MAX((size_t) (slice * (target_time / elapsed)), 1);
+			} else {
+				slice = slice * CCL_KERNEL_CHUNK_MAX_GROWTH;
+			}
+		}
+
+		/* Yield to client code between slices. */
+		if ((cb != NULL) && (done < num_gran)) {
+			cb(i, evt, &ewl_next, user_data, &err_internal);
+			g_if_err_propagate_goto(err, err_internal, error_handler);
+		}
+	}
+
+	/* Aggregate all slices in a single event. The queue is in-order, so
+	 * a marker completes when all slices have completed. */
+	evt = ccl_enqueue_marker(cq, NULL, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+	/* Release any events left in the next slice wait list. */
+	ccl_event_wait_list_clear(&ewl_next);
+
+	/* An error occurred, return NULL to signal it. */
+	evt = NULL;
+
+finish:
+
+	/* Release timing wait list. */
+	ccl_event_wait_list_clear(&ewl_calib);
+
+	/* Return aggregate event. */
+	return evt;
+
+}
+
 /**
  * Set kernel arguments and enqueue it for execution on a device.
  *
@@ -625,8 +1288,8 @@ CCLEvent* ccl_kernel_set_args_and_enqueue_ndrange(CCLKernel* krnl, CCLQueue* cq,
  * before this command can be executed. The list will be cleared and
  * can be reused by client code.
  * @param[in] args A `NULL`-terminated list of arguments to set.
- * Arguments must be of type ::CCLArg*, ::CCLBuffer*, ::CCLImage* or
- * ::CCLSampler*.
+ * Arguments must be of type ::CCLArg*, ::CCLBuffer*, ::CCLImage*,
+ * ::CCLSampler* or ::CCLQueue* (on-device queues only).
  * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
  * reporting is to be ignored.
  * @return Event wrapper object that identifies this command.
@@ -728,6 +1391,8 @@ CCLEvent* ccl_kernel_enqueue_native(CCLQueue* cq,
 	CCLEvent* evt = NULL;
 	/* List of cl_mem objects. */
 	cl_mem* mem_list = NULL;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
 
 	/* Unwrap memory objects. */
 	if (num_mos > 0) {
@@ -739,6 +1404,13 @@ CCLEvent* ccl_kernel_enqueue_native(CCLQueue* cq,
 		}
 	}
 
+	/* Hold back launch if queue is of lower priority. */
+	ccl_queue_qos_gate(cq);
+
+	/* Wait for room in the queue, if it has an in-flight limit. */
+	ccl_queue_inflight_acquire(cq, 0, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
 	/* Enqueue kernel. */
 	ocl_status = clEnqueueNativeKernel(ccl_queue_unwrap(cq), user_func,
 		args, cb_args, num_mos, (const cl_mem*) mem_list, args_mem_loc,
@@ -754,6 +1426,11 @@ CCLEvent* ccl_kernel_enqueue_native(CCLQueue* cq,
 	 * queue is released. */
 	evt = ccl_queue_produce_event(cq, event);
 
+	/* Record memory objects, for redundant transfer analysis. */
+	for (cl_uint i = 0; i < num_mos; ++i)
+		ccl_event_add_mem_access(
+			evt, CCL_EVENT_MEM_USE, mem_list[i], 0, G_MAXSIZE, NULL);
+
 	/* Clear event wait list. */
 	ccl_event_wait_list_clear(evt_wait_lst);
 
@@ -111,6 +111,24 @@
  * @{
  */
 
+/**
+ * Callback function periodically invoked by
+ * ::ccl_kernel_enqueue_ndrange_iter() and between slices by
+ * ::ccl_kernel_enqueue_ndrange_chunked().
+ *
+ * @param[in] iter Index of the iteration (or slice) which was just
+ * enqueued.
+ * @param[in] evt Event wrapper object of the iteration.
+ * @param[in,out] evt_wait_lst Events added to this list will be waited
+ * on by the next slice or, in ::ccl_kernel_enqueue_ndrange_iter(), by the
+ * next iteration which executes the same kernel instance.
+ * @param[in] user_data User data.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * */
+typedef void (*ccl_kernel_iter_callback)(cl_uint iter, CCLEvent* evt,
+	CCLEventWaitList* evt_wait_lst, void* user_data, CCLErr** err);
+
 /* Get the kernel wrapper for the given OpenCL kernel. */
 CCL_EXPORT
 CCLKernel* ccl_kernel_new_wrap(cl_kernel kernel);
@@ -146,6 +164,25 @@ CCLEvent* ccl_kernel_enqueue_ndrange(CCLKernel* krnl, CCLQueue* cq,
 	const size_t* global_work_size, const size_t* local_work_size,
 	CCLEventWaitList* evt_wait_lst, CCLErr** err);
 
+/* Enqueues several iterations of one or more kernels for execution on
+ * a device, cycling through the given kernels. */
+CCL_EXPORT
+CCLEvent* ccl_kernel_enqueue_ndrange_iter(CCLKernel** krnls,
+	cl_uint num_krnls, CCLQueue* cq, cl_uint work_dim,
+	const size_t* global_work_offset, const size_t* global_work_size,
+	const size_t* local_work_size, cl_uint num_iters, cl_uint period,
+	ccl_kernel_iter_callback cb, void* user_data,
+	CCLEventWaitList* evt_wait_lst, CCLErr** err);
+
+/* Enqueues a kernel for execution on a device, splitting the global
+ * range in slices of approximately the given duration. */
+CCL_EXPORT
+CCLEvent* ccl_kernel_enqueue_ndrange_chunked(CCLKernel* krnl,
+	CCLQueue* cq, cl_uint work_dim, const size_t* global_work_offset,
+	const size_t* global_work_size, const size_t* local_work_size,
+	double target_time, ccl_kernel_iter_callback cb, void* user_data,
+	CCLEventWaitList* evt_wait_lst, CCLErr** err);
+
 /* Set kernel arguments and enqueue it for execution. */
 CCL_EXPORT
 CCLEvent* ccl_kernel_set_args_and_enqueue_ndrange(CCLKernel* krnl,
@@ -382,7 +419,7 @@ CCLWrapperInfo* ccl_kernel_get_arg_info(CCLKernel* krnl, cl_uint idx,
  * @return The OpenCL kernel object.
  * */
 #define ccl_kernel_unwrap(krnl) \
-	((cl_kernel) ccl_wrapper_unwrap((CCLWrapper*) (krnl)))
+	((cl_kernel) ccl_wrapper_unwrap_inline((CCLWrapper*) (krnl)))
 
 
 /** @} */
@@ -0,0 +1,783 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ *
+ * Implementation of a cross-process device load registry.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+/* shm_open(), ftruncate(), mmap() and kill() are hidden by -std=c99. */
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include <string.h>
+#include "ccl_load_registry.h"
+#include "ccl_platform_wrapper.h"
+#include "_ccl_defs.h"
+
+#ifdef G_OS_UNIX
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/**
+ * @internal
+ * Name of the shared memory segment used when none is given.
+ * */
+#define CCL_LOAD_REGISTRY_NAME "/cf4ocl_load"
+
+/**
+ * @internal
+ * Magic number identifying a load registry segment ("CCLL").
+ * */
+#define CCL_LOAD_REGISTRY_MAGIC 0x4c4c4343
+
+/**
+ * @internal
+ * Maximum number of distinct devices in a registry.
+ * */
+#define CCL_LOAD_REGISTRY_MAX_DEVICES 64
+
+/**
+ * @internal
+ * Maximum number of (process, device) contributions in a registry.
+ * */
+#define CCL_LOAD_REGISTRY_MAX_RECORDS 512
+
+/**
+ * @internal
+ * Maximum length of a device key, including the terminating null
+ * character.
+ * */
+#define CCL_LOAD_REGISTRY_KEY_LEN 128
+
+/**
+ * @internal
+ * Number of failed attempts to take the registry lock before
+ * checking whether its owner is still alive.
+ * */
+#define CCL_LOAD_REGISTRY_SPINS 1024
+
+/**
+ * @internal
+ * Load contributed by one process to one device, placed in shared
+ * memory.
+ * */
+typedef struct ccl_load_record {
+
+	/** PID of the contributing process, 0 if the record is free. */
+	gint pid;
+
+	/** Index of the device in the registry. */
+	gint device;
+
+	/** Outstanding work. */
+	gint64 work;
+
+	/** Device memory in use, in bytes. */
+	gint64 mem;
+
+} CCLLoadRecord;
+
+/**
+ * @internal
+ * Layout of the registry shared memory segment. A zero-filled segment
+ * is a valid empty registry, so no initialization step (and no
+ * initialization race) is required.
+ * */
+typedef struct ccl_load_segment {
+
+	/** Magic number, set by the first process to open the segment. */
+	gint magic;
+
+	/** PID of the process holding the registry lock, 0 if free. */
+	gint lock;
+
+	/** Number of devices known to the registry. */
+	gint num_devices;
+
+	/** Padding, keeps the following fields 8-byte aligned. */
+	gint reserved;
+
+	/** Keys of devices known to the registry. */
+	gchar devices[CCL_LOAD_REGISTRY_MAX_DEVICES][CCL_LOAD_REGISTRY_KEY_LEN];
+
+	/** Per-process contributions. */
+	CCLLoadRecord records[CCL_LOAD_REGISTRY_MAX_RECORDS];
+
+} CCLLoadSegment;
+
+/**
+ * Cross-process device load registry.
+ * */
+struct ccl_load_registry {
+
+	/**
+	 * Mapped registry segment.
+	 * @private
+	 * */
+	CCLLoadSegment* seg;
+
+	/**
+	 * PID of this process.
+	 * @private
+	 * */
+	gint pid;
+
+};
+
+#ifdef G_OS_UNIX
+
+/**
+ * @internal
+ * Check whether a process exists.
+ *
+ * @param[in] pid Process ID.
+ * @return `TRUE` if the process exists, `FALSE` otherwise.
+ * */
+static gboolean ccl_load_registry_alive(gint pid) {
+
+	return (kill((pid_t) pid, 0) == 0) || (errno == EPERM);
+
+}
+
+/**
+ * @internal
+ * Take the registry lock, stealing it from its owner if the owner no
+ * longer exists.
+ *
+ * @param[in] reg The load registry.
+ * */
+static void ccl_load_registry_lock(CCLLoadRegistry* reg) {
+
+	gint owner;
+
+	for (guint spins = 1; !g_atomic_int_compare_and_exchange(
+			&reg->seg->lock, 0, reg->pid); ++spins) {
+
+		if (spins % CCL_LOAD_REGISTRY_SPINS == 0) {
+			owner = g_atomic_int_get(&reg->seg->lock);
+			if ((owner != 0) && (owner != reg->pid)
+					&& !ccl_load_registry_alive(owner))
+				g_atomic_int_compare_and_exchange(
+					&reg->seg->lock, owner, 0);
+		}
+		g_thread_yield();
+	}
+
+}
+
+/**
+ * @internal
+ * Release the registry lock.
+ *
+ * @param[in] reg The load registry.
+ * */
+static void ccl_load_registry_unlock(CCLLoadRegistry* reg) {
+
+	g_atomic_int_set(&reg->seg->lock, 0);
+
+}
+
+/**
+ * @internal
+ * Find a device in the registry, must be called with the lock held.
+ *
+ * @param[in] reg The load registry.
+ * @param[in] key Device key.
+ * @param[in] add Add the device if it is not in the registry?
+ * @return Index of the device in the registry, or -1 if the device is
+ * not in the registry (and either `add` is false or the registry is
+ * full).
+ * */
+static gint ccl_load_registry_find(CCLLoadRegistry* reg,
+	const gchar* key, gboolean add) {
+
+	CCLLoadSegment* seg = reg->seg;
+
+	for (gint i = 0; i < seg->num_devices; ++i)
+		if (strncmp(seg->devices[i], key, CCL_LOAD_REGISTRY_KEY_LEN) == 0)
+			return i;
+
+	if (!add || (seg->num_devices >= CCL_LOAD_REGISTRY_MAX_DEVICES))
+		return -1;
+
+	g_strlcpy(seg->devices[seg->num_devices], key,
+		CCL_LOAD_REGISTRY_KEY_LEN);
+	return seg->num_devices++;
+
+}
+
+/**
+ * @internal
+ * Sum the contributions to a device, freeing records of processes
+ * which no longer exist. Must be called with the lock held.
+ *
+ * @param[in] reg The load registry.
+ * @param[in] device Index of the device in the registry.
+ * @param[out] work Total outstanding work.
+ * @param[out] mem Total device memory in use.
+ * @param[out] own_work Outstanding work of this process, may be `NULL`.
+ * */
+static void ccl_load_registry_sum(CCLLoadRegistry* reg, gint device,
+	cl_ulong* work, cl_ulong* mem, cl_ulong* own_work) {
+
+	CCLLoadRecord* rec;
+
+	*work = 0;
+	*mem = 0;
+	if (own_work != NULL) *own_work = 0;
+
+	for (guint i = 0; i < CCL_LOAD_REGISTRY_MAX_RECORDS; ++i) {
+
+		rec = &reg->seg->records[i];
+		if ((rec->pid == 0) || (rec->device != device)) continue;
+
+		if ((rec->pid != reg->pid) && !ccl_load_registry_alive(rec->pid)) {
+			rec->pid = 0;
+			continue;
+		}
+
+		*work += (cl_ulong) rec->work;
+		*mem += (cl_ulong) rec->mem;
+		if ((own_work != NULL) && (rec->pid == reg->pid))
+			*own_work += (cl_ulong) rec->work;
+	}
+
+}
+
+#endif
+
+/**
+ * @internal
+ * Build the key which identifies a device across processes, composed
+ * of platform name, device name and position of the device among
+ * identically named devices of the same platform.
+ *
+ * @param[in] dev Device wrapper.
+ * @param[out] key Location of at least ::CCL_LOAD_REGISTRY_KEY_LEN
+ * characters where to place the key.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return `CL_TRUE` if the key was built, `CL_FALSE` otherwise.
+ * */
+static cl_bool ccl_load_registry_device_key(CCLDevice* dev, gchar* key,
+	CCLErr** err) {
+
+	/* Platform of device. */
+	CCLPlatform* platf = NULL;
+	/* Devices of platform. */
+	CCLDevice* const* devs;
+	cl_uint num_devs;
+	/* Names. */
+	char* platf_name;
+	char* dev_name;
+	char* other_name;
+	/* Position among identically named devices. */
+	cl_uint index = 0;
+	/* Function status. */
+	cl_bool status;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	platf = ccl_platform_new_from_device(dev, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	platf_name = ccl_platform_get_info_array(
+		platf, CL_PLATFORM_NAME, char*, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	dev_name = ccl_device_get_info_array(
+		dev, CL_DEVICE_NAME, char*, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	devs = ccl_platform_get_all_devices(platf, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	num_devs = ccl_platform_get_num_devices(platf, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	for (cl_uint i = 0; i < num_devs; ++i) {
+		if (ccl_device_unwrap(devs[i]) == ccl_device_unwrap(dev)) break;
+		other_name = ccl_device_get_info_array(
+			devs[i], CL_DEVICE_NAME, char*, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+		if (g_strcmp0(dev_name, other_name) == 0) index++;
+	}
+
+	g_snprintf(key, CCL_LOAD_REGISTRY_KEY_LEN, "%s/%s/%u",
+		platf_name, dev_name, index);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	status = CL_TRUE;
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	status = CL_FALSE;
+
+finish:
+
+	/* Release platform wrapper. */
+	if (platf != NULL) ccl_platform_destroy(platf);
+
+	/* Return status. */
+	return status;
+
+}
+
+/**
+ * @addtogroup CCL_LOAD_REGISTRY
+ * @{
+ */
+
+/**
+ * Open a load registry, creating its shared memory segment if it does
+ * not exist. The segment persists after all processes close the
+ * registry; use ::ccl_load_registry_unlink() to remove it.
+ *
+ * @public @memberof ccl_load_registry
+ *
+ * @param[in] name Name of the shared memory segment, as used in
+ * `shm_open()`, or `NULL` to use the default registry,
+ * `/cf4ocl_load`.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return A new load registry object, which should be freed with
+ * ::ccl_load_registry_destroy(), or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLLoadRegistry* ccl_load_registry_new(const char* name, CCLErr** err) {
+
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Load registry object. */
+	CCLLoadRegistry* reg = NULL;
+
+	if (name == NULL) name = CCL_LOAD_REGISTRY_NAME;
+
+#ifndef G_OS_UNIX
+
+	g_if_err_create_goto(*err, CCL_ERROR, TRUE, CCL_ERROR_OTHER,
+		error_handler,
+		"%s: load registries require a POSIX system.", CCL_STRD);
+
+#else
+
+	/* Mapped segment. */
+	CCLLoadSegment* seg = NULL;
+	/* Shared memory file descriptor. */
+	int fd = -1;
+	/* Segment status. */
+	struct stat st;
+
+	/* Open the segment, creating it if necessary. */
+	fd = shm_open(name, O_RDWR | O_CREAT, 0600);
+	g_if_err_create_goto(*err, CCL_ERROR, fd < 0, CCL_ERROR_OPENFILE,
+		error_handler,
+		"%s: unable to open load registry '%s' (%s).",
+		CCL_STRD, name, g_strerror(errno));
+
+	/* Grow it to the registry size; new contents are zero-filled,
+	 * which is a valid empty registry. */
+	g_if_err_create_goto(*err, CCL_ERROR, fstat(fd, &st) != 0,
+		CCL_ERROR_OTHER, error_handler,
+		"%s: unable to get size of load registry '%s' (%s).",
+		CCL_STRD, name, g_strerror(errno));
+	if ((size_t) st.st_size < sizeof(CCLLoadSegment)) {
+		g_if_err_create_goto(*err, CCL_ERROR,
+			ftruncate(fd, (off_t) sizeof(CCLLoadSegment)) != 0,
+			CCL_ERROR_OTHER, error_handler,
+			"%s: unable to resize load registry '%s' (%s).",
+			CCL_STRD, name, g_strerror(errno));
+	}
+
+	/* Map the segment. */
+	seg = mmap(NULL, sizeof(CCLLoadSegment), PROT_READ | PROT_WRITE,
+		MAP_SHARED, fd, 0);
+	if (seg == MAP_FAILED) seg = NULL;
+	g_if_err_create_goto(*err, CCL_ERROR, seg == NULL, CCL_ERROR_OTHER,
+		error_handler,
+		"%s: unable to map load registry '%s' (%s).",
+		CCL_STRD, name, g_strerror(errno));
+
+	/* Claim a fresh segment, or check that an existing one is a load
+	 * registry. */
+	g_atomic_int_compare_and_exchange(
+		&seg->magic, 0, CCL_LOAD_REGISTRY_MAGIC);
+	g_if_err_create_goto(*err, CCL_ERROR,
+		g_atomic_int_get(&seg->magic) != CCL_LOAD_REGISTRY_MAGIC,
+		CCL_ERROR_INVALID_DATA, error_handler,
+		"%s: shared memory segment '%s' is not a load registry.",
+		CCL_STRD, name);
+
+	reg = g_slice_new(CCLLoadRegistry);
+	reg->seg = seg;
+	reg->pid = (gint) getpid();
+
+#endif
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+#ifdef G_OS_UNIX
+	if (seg != NULL) munmap(seg, sizeof(CCLLoadSegment));
+#endif
+
+finish:
+
+#ifdef G_OS_UNIX
+	/* The mapping remains valid after the descriptor is closed. */
+	if (fd >= 0) close(fd);
+#endif
+
+	/* Return new registry. */
+	return reg;
+
+}
+
+/**
+ * Close a load registry, withdrawing all contributions made by this
+ * process. Processes should therefore keep a single registry object
+ * open for each registry.
+ *
+ * @public @memberof ccl_load_registry
+ *
+ * @param[in] reg The load registry, may be `NULL`.
+ * */
+CCL_EXPORT
+void ccl_load_registry_destroy(CCLLoadRegistry* reg) {
+
+	if (reg == NULL) return;
+
+#ifdef G_OS_UNIX
+	ccl_load_registry_lock(reg);
+	for (guint i = 0; i < CCL_LOAD_REGISTRY_MAX_RECORDS; ++i)
+		if (reg->seg->records[i].pid == reg->pid)
+			reg->seg->records[i].pid = 0;
+	ccl_load_registry_unlock(reg);
+	munmap(reg->seg, sizeof(CCLLoadSegment));
+#endif
+
+	g_slice_free(CCLLoadRegistry, reg);
+
+}
+
+/**
+ * Remove a load registry segment from the system. Processes which
+ * have the registry open keep using the old segment, while processes
+ * which open it afterwards get a new, empty, one.
+ *
+ * @param[in] name Name of the shared memory segment, or `NULL` for
+ * the default registry.
+ * */
+CCL_EXPORT
+void ccl_load_registry_unlink(const char* name) {
+
+#ifdef G_OS_UNIX
+	shm_unlink(name != NULL ? name : CCL_LOAD_REGISTRY_NAME);
+#else
+	CCL_UNUSED(name);
+#endif
+
+}
+
+/**
+ * Adjust the load this process places on a device. Values are never
+ * allowed to drop below zero.
+ *
+ * @public @memberof ccl_load_registry
+ *
+ * @param[in] reg The load registry.
+ * @param[in] dev Device wrapper.
+ * @param[in] work_delta Change in outstanding work.
+ * @param[in] mem_delta Change in device memory use, in bytes.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return `CL_TRUE` if the registry was updated, `CL_FALSE` otherwise.
+ * */
+CCL_EXPORT
+cl_bool ccl_load_registry_update(CCLLoadRegistry* reg, CCLDevice* dev,
+	cl_long work_delta, cl_long mem_delta, CCLErr** err) {
+
+	/* Make sure reg and dev are not NULL. */
+	g_return_val_if_fail((reg != NULL) && (dev != NULL), CL_FALSE);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, CL_FALSE);
+
+	/* Device key. */
+	gchar key[CCL_LOAD_REGISTRY_KEY_LEN];
+	/* Which registry table was full, if any. */
+	const char* full = NULL;
+	/* Function status. */
+	cl_bool status;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	ccl_load_registry_device_key(dev, key, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+#ifdef G_OS_UNIX
+
+	CCLLoadRecord* rec = NULL;
+	CCLLoadRecord* free_rec = NULL;
+	gint device;
+
+	ccl_load_registry_lock(reg);
+
+	device = ccl_load_registry_find(reg, key, TRUE);
+	if (device < 0) {
+		full = "device";
+	} else {
+
+		/* Find this process' record for the device, or a free one. */
+		for (guint i = 0; i < CCL_LOAD_REGISTRY_MAX_RECORDS; ++i) {
+			CCLLoadRecord* r = &reg->seg->records[i];
+			if ((r->pid == reg->pid) && (r->device == device)) {
+				rec = r;
+				break;
+			}
+			if ((free_rec == NULL) && ((r->pid == 0)
+					|| ((r->pid != reg->pid)
+						&& !ccl_load_registry_alive(r->pid))))
+				free_rec = r;
+		}
+		if ((rec == NULL) && (free_rec != NULL)) {
+			rec = free_rec;
+			rec->device = device;
+			rec->work = 0;
+			rec->mem = 0;
+			rec->pid = reg->pid;
+		}
+
+		if (rec == NULL) {
+			full = "record";
+		} else {
+			rec->work = MAX(rec->work + work_delta, 0);
+			rec->mem = MAX(rec->mem + mem_delta, 0);
+			/* Give the record back once this process' load is gone. */
+			if ((rec->work == 0) && (rec->mem == 0)) rec->pid = 0;
+		}
+	}
+
+	ccl_load_registry_unlock(reg);
+
+#else
+
+	CCL_UNUSED(work_delta);
+	CCL_UNUSED(mem_delta);
+
+#endif
+
+	g_if_err_create_goto(*err, CCL_ERROR, full != NULL,
+		CCL_ERROR_OTHER, error_handler,
+		"%s: load registry %s table is full.", CCL_STRD, full);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	status = CL_TRUE;
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	status = CL_FALSE;
+
+finish:
+
+	/* Return status. */
+	return status;
+
+}
+
+/**
+ * Get the aggregate load of a device over all live processes which
+ * use the registry.
+ *
+ * @public @memberof ccl_load_registry
+ *
+ * @param[in] reg The load registry.
+ * @param[in] dev Device wrapper.
+ * @param[out] work Return location for the total outstanding work, or
+ * `NULL`.
+ * @param[out] mem Return location for the total device memory in use,
+ * in bytes, or `NULL`.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return `CL_TRUE` if the load was obtained, `CL_FALSE` otherwise.
+ * */
+CCL_EXPORT
+cl_bool ccl_load_registry_query(CCLLoadRegistry* reg, CCLDevice* dev,
+	cl_ulong* work, cl_ulong* mem, CCLErr** err) {
+
+	/* Make sure reg and dev are not NULL. */
+	g_return_val_if_fail((reg != NULL) && (dev != NULL), CL_FALSE);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, CL_FALSE);
+
+	/* Device key. */
+	gchar key[CCL_LOAD_REGISTRY_KEY_LEN];
+	/* Aggregate load. */
+	cl_ulong total_work = 0, total_mem = 0;
+	/* Function status. */
+	cl_bool status;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	ccl_load_registry_device_key(dev, key, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+#ifdef G_OS_UNIX
+	ccl_load_registry_lock(reg);
+	gint device = ccl_load_registry_find(reg, key, FALSE);
+	if (device >= 0)
+		ccl_load_registry_sum(reg, device, &total_work, &total_mem, NULL);
+	ccl_load_registry_unlock(reg);
+#endif
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	status = CL_TRUE;
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	status = CL_FALSE;
+
+finish:
+
+	if (work != NULL) *work = total_work;
+	if (mem != NULL) *mem = total_mem;
+
+	/* Return status. */
+	return status;
+
+}
+
+/**
+ * Suggest a less contended device for the work this process has on
+ * its current device. Moving is suggested only if the outstanding work
+ * of the candidate device, plus the work this process would bring
+ * along, is lower than the outstanding work of the current device, so
+ * that processes following the hint do not keep bouncing between
+ * devices. Long-lived processes can call this function periodically,
+ * for example between jobs.
+ *
+ * @public @memberof ccl_load_registry
+ *
+ * @param[in] reg The load registry.
+ * @param[in] devs Devices this process is able to use.
+ * @param[in] num_devs Number of devices in `devs`.
+ * @param[in] current Index in `devs` of the device currently used.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return Index in `devs` of the suggested device, which is `current`
+ * if this process should stay where it is, or -1 if an error occurs.
+ * */
+CCL_EXPORT
+cl_int ccl_load_registry_rebalance_hint(CCLLoadRegistry* reg,
+	CCLDevice* const* devs, cl_uint num_devs, cl_uint current,
+	CCLErr** err) {
+
+	/* Make sure reg and devs are not NULL. */
+	g_return_val_if_fail((reg != NULL) && (devs != NULL), -1);
+	/* Make sure current is a valid device index. */
+	g_return_val_if_fail(current < num_devs, -1);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, -1);
+
+	/* Device keys. */
+	gchar (*keys)[CCL_LOAD_REGISTRY_KEY_LEN] = NULL;
+	/* Suggested device. */
+	cl_int hint = (cl_int) current;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	keys = g_malloc(num_devs * sizeof(*keys));
+	for (cl_uint i = 0; i < num_devs; ++i) {
+		ccl_load_registry_device_key(devs[i], keys[i], &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+	}
+
+#ifdef G_OS_UNIX
+
+	cl_ulong work, mem, own, cur_work = 0, best_work = 0;
+	gint device;
+
+	ccl_load_registry_lock(reg);
+
+	/* Load on the current device, and this process' share of it. */
+	device = ccl_load_registry_find(reg, keys[current], FALSE);
+	if (device >= 0)
+		ccl_load_registry_sum(reg, device, &cur_work, &mem, &own);
+	else
+		own = 0;
+
+	/* Find the least loaded device to which moving pays off. */
+	for (cl_uint i = 0; i < num_devs; ++i) {
+		if (i == current) continue;
+		device = ccl_load_registry_find(reg, keys[i], FALSE);
+		work = 0;
+		if (device >= 0)
+			ccl_load_registry_sum(reg, device, &work, &mem, NULL);
+		if ((work + own < cur_work)
+				&& (((cl_uint) hint == current) || (work < best_work))) {
+			hint = (cl_int) i;
+			best_work = work;
+		}
+	}
+
+	ccl_load_registry_unlock(reg);
+
+#endif
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	hint = -1;
+
+finish:
+
+	/* Free device keys. */
+	g_free(keys);
+
+	/* Return suggested device. */
+	return hint;
+
+}
+
+/** @} */
@@ -0,0 +1,125 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+ /**
+ * @file
+ *
+ * Definition of a cross-process device load registry.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#ifndef _CCL_LOAD_REGISTRY_H_
+#define _CCL_LOAD_REGISTRY_H_
+
+#include "ccl_common.h"
+#include "ccl_device_wrapper.h"
+
+/**
+ * @defgroup CCL_LOAD_REGISTRY Load registry
+ *
+ * This module provides an optional registry, kept in a named POSIX
+ * shared memory segment (i.e. under `/dev/shm` on Linux), where
+ * processes running on the same node publish how much work they have
+ * outstanding on each device and how much device memory they use.
+ * This allows cooperating processes to spread over the available
+ * devices, instead of all picking the first device which matches
+ * their filters.
+ *
+ * Processes open the registry with ::ccl_load_registry_new(), which
+ * creates the segment if it does not exist yet, and adjust their own
+ * contribution with ::ccl_load_registry_update(). What "outstanding
+ * work" means is up to the application (e.g. number of commands in
+ * flight, or queued jobs), as long as all processes agree on it. The
+ * aggregate load of a device is obtained with
+ * ::ccl_load_registry_query(); contributions of processes which no
+ * longer exist are discarded automatically.
+ *
+ * The registry is mainly used through two functions:
+ *
+ * * The ::ccl_devsel_dep_least_loaded() dependent filter, which
+ * selects the least loaded device among those accepted by previous
+ * filters, for use at context creation.
+ * * ::ccl_load_registry_rebalance_hint(), which long-lived processes
+ * can call periodically to find out whether moving their work to
+ * another device would reduce contention.
+ *
+ * Devices are identified across processes by platform name, device
+ * name and position among identically named devices of the same
+ * platform.
+ *
+ * @note This module requires a POSIX system. On other systems
+ * ::ccl_load_registry_new() always fails with ::CCL_ERROR_OTHER.
+ * Process liveness is checked by PID, so all processes sharing a
+ * registry must live in the same PID namespace.
+ *
+ * _Example:_
+ *
+ * @code{.c}
+ * CCLLoadRegistry* reg = ccl_load_registry_new(NULL, &err);
+ * CCLDevSelFilters filters = NULL;
+ * ccl_devsel_add_indep_filter(&filters, ccl_devsel_indep_type_gpu, NULL);
+ * ccl_devsel_add_dep_filter(&filters, ccl_devsel_dep_least_loaded, reg);
+ * CCLContext* ctx = ccl_context_new_from_filters(&filters, &err);
+ * CCLDevice* dev = ccl_context_get_device(ctx, 0, &err);
+ * ccl_load_registry_update(reg, dev, 1, buf_size, &err);
+ * // ...run job...
+ * ccl_load_registry_update(reg, dev, -1, -(cl_long) buf_size, &err);
+ * @endcode
+ *
+ * @{
+ */
+
+/**
+ * Cross-process device load registry.
+ *
+ * @see ccl_load_registry_new()
+ * */
+typedef struct ccl_load_registry CCLLoadRegistry;
+
+/* Open a load registry, creating it if necessary. */
+CCL_EXPORT
+CCLLoadRegistry* ccl_load_registry_new(const char* name, CCLErr** err);
+
+/* Close a load registry, withdrawing this process' contributions. */
+CCL_EXPORT
+void ccl_load_registry_destroy(CCLLoadRegistry* reg);
+
+/* Remove a load registry segment from the system. */
+CCL_EXPORT
+void ccl_load_registry_unlink(const char* name);
+
+/* Adjust this process' load on a device. */
+CCL_EXPORT
+cl_bool ccl_load_registry_update(CCLLoadRegistry* reg, CCLDevice* dev,
+	cl_long work_delta, cl_long mem_delta, CCLErr** err);
+
+/* Get the aggregate load of a device over all processes. */
+CCL_EXPORT
+cl_bool ccl_load_registry_query(CCLLoadRegistry* reg, CCLDevice* dev,
+	cl_ulong* work, cl_ulong* mem, CCLErr** err);
+
+/* Suggest a less contended device for this process' work. */
+CCL_EXPORT
+cl_int ccl_load_registry_rebalance_hint(CCLLoadRegistry* reg,
+	CCLDevice* const* devs, cl_uint num_devs, cl_uint current,
+	CCLErr** err);
+
+/** @} */
+
+#endif
@@ -166,7 +166,7 @@ CCLEvent* ccl_memobj_enqueue_migrate(CCLMemObj** mos, cl_uint num_mos,
  * @return The OpenCL cl_mem object.
  * */
 #define ccl_memobj_unwrap(mo) \
-	((cl_mem) ccl_wrapper_unwrap((CCLWrapper*) mo))
+	((cl_mem) ccl_wrapper_unwrap_inline((CCLWrapper*) mo))
 
 /** @} */
 
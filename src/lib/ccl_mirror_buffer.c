@@ -0,0 +1,631 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ *
+ * Implementation of host mirror buffers, which pair a host allocation
+ * with a device buffer and only transfer the parts which changed.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#include <string.h>
+#include "ccl_mirror_buffer.h"
+#include "_ccl_defs.h"
+
+/**
+ * @internal
+ * Default page size for dirty tracking, in bytes.
+ * */
+#define CCL_MIRROR_BUFFER_PAGE_SIZE 4096
+
+/**
+ * @internal
+ * Flags describing the state of a page in a mirror buffer. A page with
+ * no flags set is clean, i.e. host and device copies are equal.
+ * */
+enum ccl_mirror_page_state {
+	/** Host and device copies are equal. */
+	CCL_MIRROR_PAGE_CLEAN        = 0,
+	/** Host copy was modified since the last synchronization. */
+	CCL_MIRROR_PAGE_HOST_DIRTY   = 1 << 0,
+	/** Device copy was modified since the last synchronization. */
+	CCL_MIRROR_PAGE_DEVICE_DIRTY = 1 << 1,
+	/** Host copy is only dirty because the mirror buffer was just
+	 * created, so changes on the device may take over the page. */
+	CCL_MIRROR_PAGE_INITIAL      = 1 << 2
+};
+
+/**
+ * Host mirror of a device buffer with per-page dirty tracking.
+ * */
+struct ccl_mirror_buffer {
+
+	/**
+	 * Device buffer.
+	 * @private
+	 * */
+	CCLBuffer* buf;
+
+	/**
+	 * Host copy.
+	 * @private
+	 * */
+	guchar* host;
+
+	/**
+	 * Size of both copies in bytes.
+	 * @private
+	 * */
+	size_t size;
+
+	/**
+	 * Dirty tracking granularity in bytes.
+	 * @private
+	 * */
+	size_t page_size;
+
+	/**
+	 * Number of pages.
+	 * @private
+	 * */
+	size_t num_pages;
+
+	/**
+	 * State of each page, a combination of ::ccl_mirror_page_state
+	 * flags.
+	 * @private
+	 * */
+	guint8* pages;
+
+	/**
+	 * Total bytes uploaded to the device.
+	 * @private
+	 * */
+	size_t bytes_up;
+
+	/**
+	 * Total bytes downloaded from the device.
+	 * @private
+	 * */
+	size_t bytes_down;
+
+};
+
+/**
+ * @internal
+ * Mark all pages overlapping a byte range as modified on one side,
+ * unless any of them has a pending modification on the other side, in
+ * which case marking them would lose one of the modifications. Pages in
+ * their initial state may only be taken over by the device if the range
+ * covers them entirely, since the rest of the page would otherwise be
+ * downloaded without ever having been uploaded.
+ *
+ * @param[in] mb The mirror buffer.
+ * @param[in] offset Start of range in bytes.
+ * @param[in] size Size of range in bytes, 0 meaning up to the end of
+ * the buffer.
+ * @param[in] state ::CCL_MIRROR_PAGE_HOST_DIRTY or
+ * ::CCL_MIRROR_PAGE_DEVICE_DIRTY.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return `CL_TRUE` if the pages were marked, `CL_FALSE` otherwise.
+ * */
+static cl_bool ccl_mirror_buffer_mark(CCLMirrorBuffer* mb, size_t offset,
+	size_t size, guint8 state, CCLErr** err) {
+
+	/* Pages overlapping the range. */
+	size_t first, last;
+	/* Byte range of a page. */
+	size_t page_start, page_end;
+	/* Pending modification on the other side. */
+	guint8 other = (state == CCL_MIRROR_PAGE_HOST_DIRTY)
+		? CCL_MIRROR_PAGE_DEVICE_DIRTY : CCL_MIRROR_PAGE_HOST_DIRTY;
+	/* Function return status. */
+	cl_bool status = CL_FALSE;
+
+	if (offset >= mb->size) return CL_TRUE;
+	if ((size == 0) || (size > mb->size - offset))
+		size = mb->size - offset;
+
+	first = offset / mb->page_size;
+	last = (offset + size - 1) / mb->page_size;
+
+	/* Check for conflicts; the initial host state does not count for
+	 * pages entirely within the range. */
+	for (size_t i = first; i <= last; ++i) {
+		page_start = i * mb->page_size;
+		page_end = MIN(page_start + mb->page_size, mb->size);
+		g_if_err_create_goto(*err, CCL_ERROR,
+			(mb->pages[i] & other)
+			&& (!(mb->pages[i] & CCL_MIRROR_PAGE_INITIAL)
+				|| (page_start < offset) || (page_end > offset + size)),
+			CCL_ERROR_ARGS, error_handler,
+			"%s: page %" G_GSIZE_FORMAT " of mirror buffer was modified "
+			"on the %s since the last synchronization, synchronize it "
+			"before modifying it on the %s.", CCL_STRD, i,
+			other == CCL_MIRROR_PAGE_HOST_DIRTY ? "host" : "device",
+			state == CCL_MIRROR_PAGE_HOST_DIRTY ? "host" : "device");
+	}
+
+	memset(mb->pages + first, state, last - first + 1);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	status = CL_TRUE;
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+finish:
+
+	/* Return status. */
+	return status;
+
+}
+
+/**
+ * @internal
+ * Transfer all runs of pages in the given state, marking them clean.
+ *
+ * @param[in] mb The mirror buffer.
+ * @param[in] cq Command queue wrapper.
+ * @param[in] blocking Perform blocking transfers?
+ * @param[in,out] evt_wait_lst Events the first transfer waits on.
+ * @param[in] state ::CCL_MIRROR_PAGE_HOST_DIRTY to upload or
+ * ::CCL_MIRROR_PAGE_DEVICE_DIRTY to download.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return The event of the last transfer, or `NULL` if no transfer
+ * was required or if an error occurs.
+ * */
+static CCLEvent* ccl_mirror_buffer_sync(CCLMirrorBuffer* mb,
+	CCLQueue* cq, cl_bool blocking, CCLEventWaitList* evt_wait_lst,
+	guint8 state, CCLErr** err) {
+
+	/* Event of the last transfer. */
+	CCLEvent* evt = NULL;
+	/* Current page run and its byte range. */
+	size_t first, last, offset, size;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	for (first = 0; first < mb->num_pages; first = last) {
+
+		/* Find the next run of pages in the required state. */
+		if (!(mb->pages[first] & state)) {
+			last = first + 1;
+			continue;
+		}
+		for (last = first + 1;
+			(last < mb->num_pages) && (mb->pages[last] & state);
+			++last);
+
+		offset = first * mb->page_size;
+		size = MIN(last * mb->page_size, mb->size) - offset;
+
+		/* Transfer it; only the first transfer consumes the wait
+		 * list, which the enqueue functions clear. */
+		if (state == CCL_MIRROR_PAGE_HOST_DIRTY) {
+			evt = ccl_buffer_enqueue_write(mb->buf, cq, blocking,
+				offset, size, mb->host + offset, evt_wait_lst,
+				&err_internal);
+			g_if_err_propagate_goto(err, err_internal, error_handler);
+			mb->bytes_up += size;
+		} else {
+			evt = ccl_buffer_enqueue_read(mb->buf, cq, blocking,
+				offset, size, mb->host + offset, evt_wait_lst,
+				&err_internal);
+			g_if_err_propagate_goto(err, err_internal, error_handler);
+			mb->bytes_down += size;
+		}
+
+		/* Pages are clean once the transfer is enqueued. */
+		memset(mb->pages + first, CCL_MIRROR_PAGE_CLEAN, last - first);
+	}
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	evt = NULL;
+
+finish:
+
+	/* Return event of the last transfer. */
+	return evt;
+
+}
+
+/**
+ * @addtogroup CCL_MIRROR_BUFFER
+ * @{
+ */
+
+/**
+ * Create a new mirror buffer, consisting of a zero-initialized host
+ * allocation and a device buffer of the same size. All pages start as
+ * dirty on the host, but, unlike pages marked with
+ * ::ccl_mirror_buffer_mark_host_dirty(), may be marked as dirty on the
+ * device without synchronizing them first, as long as the marked range
+ * covers them entirely.
+ *
+ * @public @memberof ccl_mirror_buffer
+ *
+ * @param[in] ctx Context wrapper.
+ * @param[in] flags OpenCL memory flags for the device buffer, as used
+ * in clCreateBuffer(). Host pointer flags are not allowed.
+ * @param[in] size Size in bytes of the mirror buffer.
+ * @param[in] page_size Dirty tracking granularity in bytes, or 0 for
+ * the default of 4096 bytes.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return A new mirror buffer, or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLMirrorBuffer* ccl_mirror_buffer_new(CCLContext* ctx,
+	cl_mem_flags flags, size_t size, size_t page_size, CCLErr** err) {
+
+	/* Make sure ctx is not NULL. */
+	g_return_val_if_fail(ctx != NULL, NULL);
+	/* Make sure size is not zero. */
+	g_return_val_if_fail(size > 0, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Mirror buffer. */
+	CCLMirrorBuffer* mb = NULL;
+	/* Device buffer. */
+	CCLBuffer* buf = NULL;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Host pointer flags make no sense for a mirror. */
+	g_if_err_create_goto(*err, CCL_ERROR,
+		flags & (CL_MEM_USE_HOST_PTR | CL_MEM_COPY_HOST_PTR),
+		CCL_ERROR_ARGS, error_handler,
+		"%s: mirror buffers manage their own host memory.",
+		CCL_STRD);
+
+	/* Create device buffer. */
+	buf = ccl_buffer_new(ctx, flags, size, NULL, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Set up mirror. */
+	if (page_size == 0) page_size = CCL_MIRROR_BUFFER_PAGE_SIZE;
+	mb = g_slice_new0(CCLMirrorBuffer);
+	mb->buf = buf;
+	mb->host = g_malloc0(size);
+	mb->size = size;
+	mb->page_size = page_size;
+	mb->num_pages = (size + page_size - 1) / page_size;
+	mb->pages = g_malloc(mb->num_pages);
+	memset(mb->pages, CCL_MIRROR_PAGE_HOST_DIRTY | CCL_MIRROR_PAGE_INITIAL,
+		mb->num_pages);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+finish:
+
+	/* Return new mirror buffer. */
+	return mb;
+
+}
+
+/**
+ * Destroy a mirror buffer, releasing both the host copy and the
+ * device buffer.
+ *
+ * @public @memberof ccl_mirror_buffer
+ *
+ * @param[in] mb The mirror buffer, may be `NULL`.
+ * */
+CCL_EXPORT
+void ccl_mirror_buffer_destroy(CCLMirrorBuffer* mb) {
+
+	if (mb == NULL) return;
+
+	ccl_buffer_destroy(mb->buf);
+	g_free(mb->host);
+	g_free(mb->pages);
+	g_slice_free(CCLMirrorBuffer, mb);
+
+}
+
+/**
+ * Get the host copy of the mirror buffer. Client code which writes to
+ * it directly must call ::ccl_mirror_buffer_mark_host_dirty()
+ * afterwards.
+ *
+ * @public @memberof ccl_mirror_buffer
+ *
+ * @param[in] mb The mirror buffer.
+ * @return The host copy, owned by the mirror buffer.
+ * */
+CCL_EXPORT
+void* ccl_mirror_buffer_get_host(CCLMirrorBuffer* mb) {
+
+	/* Make sure mb is not NULL. */
+	g_return_val_if_fail(mb != NULL, NULL);
+
+	return mb->host;
+
+}
+
+/**
+ * Get the device buffer of the mirror buffer. Client code which
+ * enqueues commands writing to it must call
+ * ::ccl_mirror_buffer_mark_device_dirty() afterwards.
+ *
+ * @public @memberof ccl_mirror_buffer
+ *
+ * @param[in] mb The mirror buffer.
+ * @return The device buffer, owned by the mirror buffer.
+ * */
+CCL_EXPORT
+CCLBuffer* ccl_mirror_buffer_get_buffer(CCLMirrorBuffer* mb) {
+
+	/* Make sure mb is not NULL. */
+	g_return_val_if_fail(mb != NULL, NULL);
+
+	return mb->buf;
+
+}
+
+/**
+ * Get the size in bytes of the mirror buffer.
+ *
+ * @public @memberof ccl_mirror_buffer
+ *
+ * @param[in] mb The mirror buffer.
+ * @return The size in bytes of the mirror buffer.
+ * */
+CCL_EXPORT
+size_t ccl_mirror_buffer_get_size(CCLMirrorBuffer* mb) {
+
+	/* Make sure mb is not NULL. */
+	g_return_val_if_fail(mb != NULL, 0);
+
+	return mb->size;
+
+}
+
+/**
+ * Mark a range of the mirror buffer as modified on the host. All pages
+ * overlapping the range will be uploaded by the next call to
+ * ::ccl_mirror_buffer_sync_to_device().
+ *
+ * If any of these pages was marked as modified on the device since the
+ * last call to ::ccl_mirror_buffer_sync_to_host(), one of the two
+ * modifications would be lost, so no page is marked and an error is
+ * reported.
+ *
+ * @public @memberof ccl_mirror_buffer
+ *
+ * @param[in] mb The mirror buffer.
+ * @param[in] offset Start of the modified range in bytes.
+ * @param[in] size Size of the modified range in bytes, or 0 for the
+ * rest of the buffer.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return `CL_TRUE` if the range was marked, `CL_FALSE` otherwise.
+ * */
+CCL_EXPORT
+cl_bool ccl_mirror_buffer_mark_host_dirty(CCLMirrorBuffer* mb,
+	size_t offset, size_t size, CCLErr** err) {
+
+	/* Make sure mb is not NULL. */
+	g_return_val_if_fail(mb != NULL, CL_FALSE);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, CL_FALSE);
+
+	return ccl_mirror_buffer_mark(
+		mb, offset, size, CCL_MIRROR_PAGE_HOST_DIRTY, err);
+
+}
+
+/**
+ * Copy data into the host copy of the mirror buffer and mark the
+ * range as modified on the host. Nothing is copied if the range
+ * cannot be marked (see ::ccl_mirror_buffer_mark_host_dirty()).
+ *
+ * @public @memberof ccl_mirror_buffer
+ *
+ * @param[in] mb The mirror buffer.
+ * @param[in] offset Offset in bytes where to write the data.
+ * @param[in] size Size in bytes of the data.
+ * @param[in] ptr Data to write.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return `CL_TRUE` if the data was written, `CL_FALSE` otherwise.
+ * */
+CCL_EXPORT
+cl_bool ccl_mirror_buffer_host_write(CCLMirrorBuffer* mb, size_t offset,
+	size_t size, const void* ptr, CCLErr** err) {
+
+	/* Make sure mb is not NULL. */
+	g_return_val_if_fail(mb != NULL, CL_FALSE);
+	/* Make sure ptr is not NULL. */
+	g_return_val_if_fail(ptr != NULL, CL_FALSE);
+	/* Make sure the range is within the buffer. */
+	g_return_val_if_fail(
+		(offset <= mb->size) && (size <= mb->size - offset), CL_FALSE);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, CL_FALSE);
+
+	if (size == 0) return CL_TRUE;
+	if (!ccl_mirror_buffer_mark(
+		mb, offset, size, CCL_MIRROR_PAGE_HOST_DIRTY, err))
+		return CL_FALSE;
+	memcpy(mb->host + offset, ptr, size);
+	return CL_TRUE;
+
+}
+
+/**
+ * Mark a range of the mirror buffer as modified on the device, e.g.
+ * after enqueuing a kernel which writes to the device buffer. All
+ * pages overlapping the range will be downloaded by the next call to
+ * ::ccl_mirror_buffer_sync_to_host().
+ *
+ * If any of these pages was marked as modified on the host since the
+ * last call to ::ccl_mirror_buffer_sync_to_device(), one of the two
+ * modifications would be lost, so no page is marked and an error is
+ * reported. In that case, the host modifications should be uploaded
+ * before enqueuing the commands which modify the device buffer. This
+ * also applies to pages which were never uploaded and are only
+ * partially covered by the range, since their remaining bytes were
+ * never initialized on the device.
+ *
+ * @public @memberof ccl_mirror_buffer
+ *
+ * @param[in] mb The mirror buffer.
+ * @param[in] offset Start of the modified range in bytes.
+ * @param[in] size Size of the modified range in bytes, or 0 for the
+ * rest of the buffer.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return `CL_TRUE` if the range was marked, `CL_FALSE` otherwise.
+ * */
+CCL_EXPORT
+cl_bool ccl_mirror_buffer_mark_device_dirty(CCLMirrorBuffer* mb,
+	size_t offset, size_t size, CCLErr** err) {
+
+	/* Make sure mb is not NULL. */
+	g_return_val_if_fail(mb != NULL, CL_FALSE);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, CL_FALSE);
+
+	return ccl_mirror_buffer_mark(
+		mb, offset, size, CCL_MIRROR_PAGE_DEVICE_DIRTY, err);
+
+}
+
+/**
+ * Upload the ranges modified on the host to the device. Adjacent dirty
+ * pages are coalesced into a single transfer.
+ *
+ * @public @memberof ccl_mirror_buffer
+ *
+ * @param[in] mb The mirror buffer.
+ * @param[in] cq Command queue wrapper object in which to enqueue the
+ * transfers. If it is not in-order and `blocking` is false, only the
+ * returned event is guaranteed to wait on `evt_wait_lst`.
+ * @param[in] blocking Perform blocking transfers? If not, the host
+ * copy must not be modified until the returned event completes.
+ * @param[in,out] evt_wait_lst List of events that need to complete
+ * before the transfers can be executed. The list will be cleared and
+ * can be reused by client code.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return The event of the last transfer, or `NULL` if nothing had to
+ * be transferred or if an error occurs.
+ * */
+CCL_EXPORT
+CCLEvent* ccl_mirror_buffer_sync_to_device(CCLMirrorBuffer* mb,
+	CCLQueue* cq, cl_bool blocking, CCLEventWaitList* evt_wait_lst,
+	CCLErr** err) {
+
+	/* Make sure mb is not NULL. */
+	g_return_val_if_fail(mb != NULL, NULL);
+	/* Make sure cq is not NULL. */
+	g_return_val_if_fail(cq != NULL, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	return ccl_mirror_buffer_sync(mb, cq, blocking, evt_wait_lst,
+		CCL_MIRROR_PAGE_HOST_DIRTY, err);
+
+}
+
+/**
+ * Download the ranges modified on the device to the host. If the
+ * device copy was not modified since the last synchronization, no
+ * command is enqueued. Adjacent dirty pages are coalesced into a
+ * single transfer.
+ *
+ * @public @memberof ccl_mirror_buffer
+ *
+ * @param[in] mb The mirror buffer.
+ * @param[in] cq Command queue wrapper object in which to enqueue the
+ * transfers. If it is not in-order and `blocking` is false, only the
+ * returned event is guaranteed to wait on `evt_wait_lst`.
+ * @param[in] blocking Perform blocking transfers? If not, the host
+ * copy must not be accessed until the returned event completes.
+ * @param[in,out] evt_wait_lst List of events that need to complete
+ * before the transfers can be executed. The list will be cleared and
+ * can be reused by client code.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return The event of the last transfer, or `NULL` if nothing had to
+ * be transferred or if an error occurs.
+ * */
+CCL_EXPORT
+CCLEvent* ccl_mirror_buffer_sync_to_host(CCLMirrorBuffer* mb,
+	CCLQueue* cq, cl_bool blocking, CCLEventWaitList* evt_wait_lst,
+	CCLErr** err) {
+
+	/* Make sure mb is not NULL. */
+	g_return_val_if_fail(mb != NULL, NULL);
+	/* Make sure cq is not NULL. */
+	g_return_val_if_fail(cq != NULL, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	return ccl_mirror_buffer_sync(mb, cq, blocking, evt_wait_lst,
+		CCL_MIRROR_PAGE_DEVICE_DIRTY, err);
+
+}
+
+/**
+ * Get the total number of bytes transferred by the mirror buffer
+ * since it was created.
+ *
+ * @public @memberof ccl_mirror_buffer
+ *
+ * @param[in] mb The mirror buffer.
+ * @param[out] bytes_up Location where to put the number of bytes
+ * uploaded to the device, or `NULL`.
+ * @param[out] bytes_down Location where to put the number of bytes
+ * downloaded from the device, or `NULL`.
+ * */
+CCL_EXPORT
+void ccl_mirror_buffer_get_stats(CCLMirrorBuffer* mb,
+	size_t* bytes_up, size_t* bytes_down) {
+
+	/* Make sure mb is not NULL. */
+	g_return_if_fail(mb != NULL);
+
+	if (bytes_up != NULL) *bytes_up = mb->bytes_up;
+	if (bytes_down != NULL) *bytes_down = mb->bytes_down;
+
+}
+
+/** @} */
@@ -0,0 +1,153 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+ /**
+ * @file
+ *
+ * Definition of host mirror buffers, which pair a host allocation with
+ * a device buffer and only transfer the parts which changed.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#ifndef _CCL_MIRROR_BUFFER_H_
+#define _CCL_MIRROR_BUFFER_H_
+
+#include "ccl_common.h"
+#include "ccl_buffer_wrapper.h"
+#include "ccl_context_wrapper.h"
+#include "ccl_event_wrapper.h"
+#include "ccl_queue_wrapper.h"
+
+/**
+ * @defgroup CCL_MIRROR_BUFFER Mirror buffers
+ *
+ * This module provides host mirror buffers, which pair a host
+ * allocation with a ::CCLBuffer* of the same size and keep track of
+ * which side holds the most recent version of each page, so that
+ * synchronizing both copies only transfers what actually changed.
+ *
+ * Each page of a ::CCLMirrorBuffer* is either clean (both copies are
+ * equal), dirty on the host or dirty on the device. Client code marks
+ * pages as changed:
+ *
+ * * on the host, with ::ccl_mirror_buffer_mark_host_dirty() after
+ * writing to the memory returned by ::ccl_mirror_buffer_get_host(), or
+ * by writing with ::ccl_mirror_buffer_host_write(), which does both;
+ * * on the device, with ::ccl_mirror_buffer_mark_device_dirty() after
+ * enqueuing kernels (or other commands) which write to the buffer
+ * returned by ::ccl_mirror_buffer_get_buffer().
+ *
+ * Then, ::ccl_mirror_buffer_sync_to_device() uploads only the runs of
+ * pages which are dirty on the host, and
+ * ::ccl_mirror_buffer_sync_to_host() downloads only the runs of pages
+ * which are dirty on the device, doing nothing at all if the device copy
+ * has not changed. A page cannot be dirty on both sides, since one of
+ * the modifications would be lost: marking a page which is dirty on the
+ * other side fails with a ::CCL_ERROR_ARGS error, and the page must be
+ * synchronized first. All pages start as dirty on the host, so that the
+ * first upload initializes the device buffer, unless they are entirely
+ * marked as dirty on the device before that.
+ *
+ * Mirror buffers are not thread-safe and should be freed with
+ * ::ccl_mirror_buffer_destroy().
+ *
+ * _Example:_
+ *
+ * @code{.c}
+ * CCLMirrorBuffer* mb = ccl_mirror_buffer_new(
+ *     ctx, CL_MEM_READ_WRITE, size, 0, &err);
+ * cl_float* h = ccl_mirror_buffer_get_host(mb);
+ * h[10] = 1.0f;
+ * ccl_mirror_buffer_mark_host_dirty(mb, 10 * sizeof(cl_float),
+ *     sizeof(cl_float), &err);
+ * ccl_mirror_buffer_sync_to_device(mb, cq, CL_TRUE, NULL, &err);
+ * @endcode
+ * @code{.c}
+ * ccl_kernel_set_args_and_enqueue_ndrange(krnl, cq, 1, NULL, gws, lws,
+ *     NULL, &err, ccl_mirror_buffer_get_buffer(mb), NULL);
+ * ccl_mirror_buffer_mark_device_dirty(mb, 0, 0, &err);
+ * ccl_mirror_buffer_sync_to_host(mb, cq, CL_TRUE, NULL, &err);
+ * @endcode
+ *
+ * @{
+ */
+
+/**
+ * Host mirror of a device buffer with per-page dirty tracking.
+ *
+ * @see ccl_mirror_buffer_new()
+ * */
+typedef struct ccl_mirror_buffer CCLMirrorBuffer;
+
+/* Create a new mirror buffer. */
+CCL_EXPORT
+CCLMirrorBuffer* ccl_mirror_buffer_new(CCLContext* ctx,
+	cl_mem_flags flags, size_t size, size_t page_size, CCLErr** err);
+
+/* Destroy a mirror buffer. */
+CCL_EXPORT
+void ccl_mirror_buffer_destroy(CCLMirrorBuffer* mb);
+
+/* Get the host copy of the mirror buffer. */
+CCL_EXPORT
+void* ccl_mirror_buffer_get_host(CCLMirrorBuffer* mb);
+
+/* Get the device buffer of the mirror buffer. */
+CCL_EXPORT
+CCLBuffer* ccl_mirror_buffer_get_buffer(CCLMirrorBuffer* mb);
+
+/* Get the size in bytes of the mirror buffer. */
+CCL_EXPORT
+size_t ccl_mirror_buffer_get_size(CCLMirrorBuffer* mb);
+
+/* Mark a range of the mirror buffer as modified on the host. */
+CCL_EXPORT
+cl_bool ccl_mirror_buffer_mark_host_dirty(CCLMirrorBuffer* mb,
+	size_t offset, size_t size, CCLErr** err);
+
+/* Copy data into the host copy and mark the range as modified. */
+CCL_EXPORT
+cl_bool ccl_mirror_buffer_host_write(CCLMirrorBuffer* mb, size_t offset,
+	size_t size, const void* ptr, CCLErr** err);
+
+/* Mark a range of the mirror buffer as modified on the device. */
+CCL_EXPORT
+cl_bool ccl_mirror_buffer_mark_device_dirty(CCLMirrorBuffer* mb,
+	size_t offset, size_t size, CCLErr** err);
+
+/* Upload the ranges modified on the host to the device. */
+CCL_EXPORT
+CCLEvent* ccl_mirror_buffer_sync_to_device(CCLMirrorBuffer* mb,
+	CCLQueue* cq, cl_bool blocking, CCLEventWaitList* evt_wait_lst,
+	CCLErr** err);
+
+/* Download the ranges modified on the device to the host. */
+CCL_EXPORT
+CCLEvent* ccl_mirror_buffer_sync_to_host(CCLMirrorBuffer* mb,
+	CCLQueue* cq, cl_bool blocking, CCLEventWaitList* evt_wait_lst,
+	CCLErr** err);
+
+/* Get the total number of bytes transferred by the mirror buffer. */
+CCL_EXPORT
+void ccl_mirror_buffer_get_stats(CCLMirrorBuffer* mb,
+	size_t* bytes_up, size_t* bytes_down);
+
+/** @} */
+
+#endif
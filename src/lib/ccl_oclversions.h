@@ -184,6 +184,12 @@
 
 /* Some of these query constants may not be defined in standard
  * OpenCL headers, so we defined them here if necessary. */
+#ifndef CL_DEVICE_IMAGE_PITCH_ALIGNMENT
+	#define CL_DEVICE_IMAGE_PITCH_ALIGNMENT             0x104A
+#endif
+#ifndef CL_DEVICE_IMAGE_BASE_ADDRESS_ALIGNMENT
+	#define CL_DEVICE_IMAGE_BASE_ADDRESS_ALIGNMENT      0x104B
+#endif
 #ifndef CL_DEVICE_TERMINATE_CAPABILITY_KHR
 	#define CL_DEVICE_TERMINATE_CAPABILITY_KHR          0x200F
 #endif
@@ -218,7 +218,7 @@ cl_uint ccl_platform_get_opencl_version(
  * @return The OpenCL platform object.
  * */
 #define ccl_platform_unwrap(platform) \
-	((cl_platform_id) ccl_wrapper_unwrap((CCLWrapper*) platform))
+	((cl_platform_id) ccl_wrapper_unwrap_inline((CCLWrapper*) platform))
 
 /* Get all device wrappers in platform. */
 CCL_EXPORT
@@ -27,7 +27,38 @@
  * */
 
 #include "ccl_profiler.h"
+#include "ccl_buffer_wrapper.h"
+#include "ccl_kernel_arg.h"
+#include "ccl_kernel_wrapper.h"
+#include "ccl_program_wrapper.h"
 #include "_ccl_defs.h"
+#include "_ccl_event_wrapper.h"
+
+/**
+ * @internal
+ * Size in bytes of the buffers used for measuring peak bandwidth.
+ * */
+#define CCL_PROF_PEAK_BW_SIZE (32 * 1024 * 1024)
+
+/**
+ * @internal
+ * Number of multiply-add iterations performed by each work-item when
+ * measuring peak FLOP/s.
+ * */
+#define CCL_PROF_PEAK_ITERS 256
+
+/**
+ * @internal
+ * Number of work-items per compute unit when measuring peak FLOP/s.
+ * */
+#define CCL_PROF_PEAK_WI_PER_CU 4096
+
+/**
+ * @internal
+ * Number of times each microbenchmark kernel is run, the fastest run
+ * being used.
+ * */
+#define CCL_PROF_PEAK_REPS 3
 
 /**
  * @internal
@@ -81,6 +112,81 @@ typedef struct ccl_prof_sort_data {
 
 } CCLProfSort;
 
+/**
+ * @internal
+ * Work annotated to events with a given name, and the time required to
+ * perform it at the peak capabilities of the respective devices.
+ * */
+typedef struct ccl_prof_work {
+
+	/** Bytes read and written. */
+	cl_ulong bytes;
+
+	/** Floating-point operations. */
+	cl_ulong flops;
+
+	/** Time required to move the bytes at peak bandwidth (s). */
+	double t_memory;
+
+	/** Time required to perform the operations at peak FLOP/s (s). */
+	double t_compute;
+
+	/** Time at the roofline of events which used device time (s). */
+	double t_roofline;
+
+	/** Time actually taken by events which used device time (s). */
+	double t_actual;
+
+	/** Whether the peaks of the device of some event were unknown. */
+	cl_bool no_peaks;
+
+} CCLProfWork;
+
+/**
+ * @internal
+ * Memory object access recorded in a profiled event.
+ * */
+typedef struct ccl_prof_access {
+
+	/** The access, as recorded in the event. */
+	CCLEventMemAccess acc;
+
+	/** Name of the event. */
+	const char* event_name;
+
+	/** Time taken by the event's command, in nanoseconds. */
+	cl_ulong duration;
+
+} CCLProfAccess;
+
+/**
+ * @internal
+ * Region of a memory object whose contents are known to the host, used
+ * for detecting wasted transfers.
+ * */
+typedef struct ccl_prof_region {
+
+	/** Start of region. */
+	size_t offset;
+
+	/** End of region (exclusive), `G_MAXSIZE` for the object end. */
+	size_t end;
+
+	/** Whether the hash of the region contents is known. */
+	cl_bool has_hash;
+
+	/** Hash of the region contents. */
+	guint64 hash;
+
+	/** Name of event which uploaded the region and was not yet read,
+	 * or `NULL` if there is no such upload. */
+	const char* upload_name;
+
+	/** Time taken by the pending upload, in nanoseconds. */
+	cl_ulong upload_time;
+
+} CCLProfRegion;
+
 /**
  * Profile class, contains profiling information of OpenCL
  * queues and events.
@@ -147,6 +253,32 @@ struct ccl_prof {
 	 * */
 	GList* overlaps;
 
+	/**
+	 * Table of work annotated to events (keys are event names, values
+	 * are ::CCLProfWork objects).
+	 * @private
+	 * */
+	GHashTable* works;
+
+	/**
+	 * Memory object accesses recorded in events, if transfer analysis
+	 * is enabled.
+	 * @private
+	 * */
+	GArray* accesses;
+
+	/**
+	 * List of launch scaling fits.
+	 * @private
+	 * */
+	GList* fits;
+
+	/**
+	 * List of wasted transfers.
+	 * @private
+	 * */
+	GList* transfers;
+
 	/**
 	 * Aggregate event statistics iterator.
 	 * @private
@@ -171,6 +303,18 @@ struct ccl_prof {
 	 * */
 	GList* overlap_iter;
 
+	/**
+	 * Launch scaling fits iterator.
+	 * @private
+	 * */
+	GList* fit_iter;
+
+	/**
+	 * Wasted transfers iterator.
+	 * @private
+	 * */
+	GList* transfer_iter;
+
 	/**
 	 * Total time taken by all events.
 	 * @private
@@ -215,6 +359,215 @@ static CCLProfExportOptions export_options = {
 
 };
 
+/* Peak bandwidth and FLOP/s of devices, measured or set by client code
+ * (cl_device_id -> double[2]). */
+static GHashTable* device_peaks = NULL;
+
+/* Access to the device_peaks table should be thread-safe. */
+G_LOCK_DEFINE_STATIC(device_peaks);
+
+/* Source of the microbenchmark kernels used for measuring device peaks.
+ * Peak FLOP/s are measured with eight independent multiply-add chains
+ * per work-item. */
+static const char* ccl_prof_peaks_src =
+	"__kernel void ccl_peak_bw(\n"
+	"	__global const float4* in, __global float4* out) {\n"
+	"	size_t i = get_global_id(0);\n"
+	"	out[i] = in[i];\n"
+	"}\n"
+	"__kernel void ccl_peak_flops(__global float* out, float a, float b) {\n"
+	"	float x0 = (float) get_global_id(0), x1 = x0 + 1.0f,\n"
+	"		x2 = x0 + 2.0f, x3 = x0 + 3.0f, x4 = x0 + 4.0f,\n"
+	"		x5 = x0 + 5.0f, x6 = x0 + 6.0f, x7 = x0 + 7.0f;\n"
+	"	for (uint i = 0; i < " G_STRINGIFY(CCL_PROF_PEAK_ITERS) "; ++i) {\n"
+	"		x0 = mad(x0, a, b); x1 = mad(x1, a, b);\n"
+	"		x2 = mad(x2, a, b); x3 = mad(x3, a, b);\n"
+	"		x4 = mad(x4, a, b); x5 = mad(x5, a, b);\n"
+	"		x6 = mad(x6, a, b); x7 = mad(x7, a, b);\n"
+	"	}\n"
+	"	out[get_global_id(0)] = x0 + x1 + x2 + x3 + x4 + x5 + x6 + x7;\n"
+	"}\n";
+
+/**
+ * @internal
+ * Run a microbenchmark kernel, whose arguments are already set, a few
+ * times and return the duration of the fastest run.
+ *
+ * @param[in] krnl Kernel wrapper object.
+ * @param[in] cq Command queue wrapper object, with profiling enabled.
+ * @param[in] gws Global work size.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return Duration of the fastest run in nanoseconds, or 0 if an error
+ * occurs or the kernel could not be timed.
+ * */
+static cl_ulong ccl_prof_peak_time(
+	CCLKernel* krnl, CCLQueue* cq, size_t gws, CCLErr** err) {
+
+	/* Event wrapper and wait list. */
+	CCLEvent* evt;
+	CCLEventWaitList ewl = NULL;
+	/* Start and end instants. */
+	cl_ulong t_start, t_end;
+	/* Duration of fastest run. */
+	cl_ulong t_min = CL_ULONG_MAX;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	for (cl_uint r = 0; r < CCL_PROF_PEAK_REPS; ++r) {
+
+		evt = ccl_kernel_enqueue_ndrange(krnl, cq, 1, NULL, &gws, NULL,
+			NULL, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		ccl_event_wait(ccl_ewl(&ewl, evt, NULL), &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		t_start = ccl_event_get_profiling_info_scalar(
+			evt, CL_PROFILING_COMMAND_START, cl_ulong, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		t_end = ccl_event_get_profiling_info_scalar(
+			evt, CL_PROFILING_COMMAND_END, cl_ulong, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		t_min = MIN(t_min, t_end > t_start ? t_end - t_start : 0);
+	}
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	t_min = 0;
+
+finish:
+
+	/* Return duration of fastest run. */
+	return t_min;
+
+}
+
+/**
+ * @internal
+ * Measure the peak bandwidth and FLOP/s of a device with a short
+ * microbenchmark.
+ *
+ * @param[in] dev Device wrapper object.
+ * @param[out] bandwidth Return location for peak bandwidth in bytes per
+ * second.
+ * @param[out] flops Return location for peak floating-point operations
+ * per second.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return `CL_TRUE` if function terminates successfully, or `CL_FALSE`
+ * otherwise.
+ * */
+static cl_bool ccl_prof_measure_peaks(CCLDevice* dev, double* bandwidth,
+	double* flops, CCLErr** err) {
+
+	/* Wrappers used by the microbenchmark. */
+	CCLContext* ctx = NULL;
+	CCLQueue* cq = NULL;
+	CCLProgram* prg = NULL;
+	CCLKernel* krnl;
+	CCLBuffer* in = NULL;
+	CCLBuffer* out = NULL;
+	CCLBuffer* res = NULL;
+	/* Buffer size, global work size and number of compute units. */
+	size_t size, gws;
+	cl_ulong max_alloc;
+	cl_uint num_cus;
+	/* Multiply-add constants, chosen so that values don't overflow. */
+	cl_float a = 0.999f, b = 0.5f;
+	/* Duration of fastest runs. */
+	cl_ulong t_bw, t_flops;
+	/* Function return status. */
+	cl_bool status;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Get device limits. */
+	max_alloc = ccl_device_get_info_scalar(
+		dev, CL_DEVICE_MAX_MEM_ALLOC_SIZE, cl_ulong, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	num_cus = ccl_device_get_info_scalar(
+		dev, CL_DEVICE_MAX_COMPUTE_UNITS, cl_uint, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	size = (size_t) MIN(max_alloc, CCL_PROF_PEAK_BW_SIZE) & ~((size_t) 15);
+
+	/* Set up context, queue and microbenchmark kernels. */
+	ctx = ccl_context_new_from_devices(1, &dev, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	cq = ccl_queue_new(ctx, dev, CL_QUEUE_PROFILING_ENABLE, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	prg = ccl_program_new_from_source(ctx, ccl_prof_peaks_src,
+		&err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	ccl_program_build(prg, NULL, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Measure bandwidth by copying between two buffers. */
+	in = ccl_buffer_new(ctx, CL_MEM_READ_ONLY, size, NULL, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	out = ccl_buffer_new(ctx, CL_MEM_WRITE_ONLY, size, NULL,
+		&err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	krnl = ccl_program_get_kernel(prg, "ccl_peak_bw", &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	ccl_kernel_set_args(krnl, in, out, NULL);
+	t_bw = ccl_prof_peak_time(krnl, cq, size / 16, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Measure FLOP/s with enough work-items to fill the device. */
+	gws = (size_t) MAX(num_cus, 1) * CCL_PROF_PEAK_WI_PER_CU;
+	res = ccl_buffer_new(ctx, CL_MEM_WRITE_ONLY, gws * sizeof(cl_float),
+		NULL, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	krnl = ccl_program_get_kernel(prg, "ccl_peak_flops", &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	ccl_kernel_set_args(krnl, res, ccl_arg_priv(a, cl_float),
+		ccl_arg_priv(b, cl_float), NULL);
+	t_flops = ccl_prof_peak_time(krnl, cq, gws, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Both kernels must have used device time. */
+	g_if_err_create_goto(*err, CCL_ERROR, (t_bw == 0) || (t_flops == 0),
+		CCL_ERROR_OTHER, error_handler,
+		"%s: unable to time the device peaks microbenchmark.", CCL_STRD);
+
+	/* Determine peaks. Each work-item of the FLOP/s kernel performs
+	 * eight multiply-adds (two operations each) per iteration. */
+	*bandwidth = 2.0 * size / (t_bw * 1e-9);
+	*flops = (double) gws * CCL_PROF_PEAK_ITERS * 16 / (t_flops * 1e-9);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	status = CL_TRUE;
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	status = CL_FALSE;
+
+finish:
+
+	/* Release microbenchmark objects. */
+	if (res != NULL) ccl_buffer_destroy(res);
+	if (out != NULL) ccl_buffer_destroy(out);
+	if (in != NULL) ccl_buffer_destroy(in);
+	if (prg != NULL) ccl_program_destroy(prg);
+	if (cq != NULL) ccl_queue_destroy(cq);
+	if (ctx != NULL) ccl_context_destroy(ctx);
+
+	/* Return status. */
+	return status;
+
+}
+
 /**
  * @internal
  * Create new event instant.
@@ -315,7 +668,7 @@ static gint ccl_prof_inst_comp(
  * @return New aggregate statistic.
  * */
 static CCLProfAgg* ccl_prof_agg_new(const char* event_name) {
-	CCLProfAgg* agg = g_slice_new(CCLProfAgg);
+	CCLProfAgg* agg = g_slice_new0(CCLProfAgg);
 	agg->event_name = event_name;
 	return agg;
 }
@@ -401,7 +754,7 @@ static CCLProfInfo* ccl_prof_info_new(const char* event_name,
 	cl_ulong t_queued, cl_ulong t_submit, cl_ulong t_start,
 	cl_ulong t_end) {
 
-	CCLProfInfo* info = g_slice_new(CCLProfInfo);
+	CCLProfInfo* info = g_slice_new0(CCLProfInfo);
 
 	info->event_name = event_name;
 	info->command_type = command_type;
@@ -575,88 +928,364 @@ static gint ccl_prof_overlap_comp(
 
 /**
  * @internal
- * Add event for profiling.
+ * Create a new launch scaling fit object.
  *
- * @private @memberof ccl_prof
+ * @private @memberof ccl_prof_fit
  *
- * @param[in] prof Profile object.
- * @param[in] cq_name Command queue name.
- * @param[in] evt Event wrapper object.
- * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
- * reporting is to be ignored.
+ * @param[in] event_name Name of events which the fit refers to.
+ * @return A new launch scaling fit object.
  * */
-static void ccl_prof_add_event(CCLProf* prof, const char* cq_name,
-	CCLEvent* evt, CCLErr** err) {
+static CCLProfFit* ccl_prof_fit_new(const char* event_name) {
+	CCLProfFit* fit = g_slice_new0(CCLProfFit);
+	fit->event_name = event_name;
+	return fit;
+}
 
-	/* Make sure err is NULL or it is not set. */
-	g_return_if_fail(err == NULL || *err == NULL);
-	/* Make sure profile object is not NULL. */
-	g_return_if_fail(prof != NULL);
-	/* Make sure command queue name is not NULL. */
-	g_return_if_fail(cq_name != NULL);
-	/* Make sure event wrapper is not NULL. */
-	g_return_if_fail(evt != NULL);
+/**
+ * @internal
+ * Destroy a launch scaling fit object.
+ *
+ * @private @memberof ccl_prof_fit
+ *
+ * @param[in] fit Launch scaling fit object to destroy.
+ * */
+static void ccl_prof_fit_destroy(CCLProfFit* fit) {
+	g_return_if_fail(fit != NULL);
+	g_slice_free(CCLProfFit, fit);
+}
 
-	/* Event name ID. */
-	cl_uint* event_name_id;
-	/* Specific event ID. */
-	cl_uint event_id;
-	/* Event instants. */
-	cl_ulong instant_queued, instant_submit, instant_start, instant_end;
-	/* Type of command which produced the event. */
-	cl_command_type command_type;
-	/* Event instant objects. */
-	CCLProfInst* evinst_start;
-	CCLProfInst* evinst_end;
-	/* Internal error handling object. */
-	CCLErr* err_internal = NULL;
+/**
+ * @internal
+ * Compares two launch scaling fits for sorting within a GList. It is an
+ * implementation of GCompareDataFunc from GLib.
+ *
+ * @private @memberof ccl_prof_fit
+ *
+ * @param[in] a First launch scaling fit to compare.
+ * @param[in] b Second launch scaling fit to compare.
+ * @param[in] userdata Defines the sort criteria and order.
+ * @return Negative value if a < b; zero if a = b; positive value if a > b.
+ */
+static gint ccl_prof_fit_comp(
+	gconstpointer a, gconstpointer b, gpointer userdata) {
 
-	/* Event name. */
-	const char* event_name;
+	/* Cast input parameters to launch scaling fits. */
+	CCLProfFit* fit1 = (CCLProfFit*) a;
+	CCLProfFit* fit2 = (CCLProfFit*) b;
+	CCLProfSort sort = ccl_prof_get_sort(userdata);
 
-	/* Get event name. */
-	event_name = ccl_event_get_final_name(evt);
+	/* Perform comparison. */
+	switch ((CCLProfFitSort) sort.criteria) {
 
-	/* Get event queued instant. */
-	instant_queued = ccl_event_get_profiling_info_scalar(
-		evt, CL_PROFILING_COMMAND_QUEUED, cl_ulong, &err_internal);
-	g_if_err_propagate_goto(err, err_internal, error_handler);
+		/* Sort fits by event name. */
+		case CCL_PROF_FIT_SORT_NAME:
+			return CCL_PROF_CMP_STR(fit1->event_name, fit2->event_name,
+				sort.order);
 
-	/* Get event submit instant. */
-	instant_submit = ccl_event_get_profiling_info_scalar(
-		evt, CL_PROFILING_COMMAND_SUBMIT, cl_ulong, &err_internal);
-	g_if_err_propagate_goto(err, err_internal, error_handler);
+		/* Sort fits by per-launch overhead. */
+		case CCL_PROF_FIT_SORT_OVERHEAD:
+			return CCL_PROF_CMP_INT(fit1->overhead, fit2->overhead,
+				sort.order);
 
-	/* Get event start instant. */
-	instant_start = ccl_event_get_profiling_info_scalar(
-		evt, CL_PROFILING_COMMAND_START, cl_ulong, &err_internal);
-	g_if_err_propagate_goto(err, err_internal, error_handler);
+		/* We shouldn't get here. */
+		default:
+			g_warning("Unknown PROF_FIT sort criteria/order.");
+			return 0;
+	}
 
-	/* Get event end instant. */
-	instant_end = ccl_event_get_profiling_info_scalar(
-		evt, CL_PROFILING_COMMAND_END, cl_ulong, &err_internal);
-	g_if_err_propagate_goto(err, err_internal, error_handler);
+}
 
-	/* Get command type. */
-	command_type = ccl_event_get_info_scalar(
-		evt, CL_EVENT_COMMAND_TYPE, cl_command_type, &err_internal);
-	g_if_err_propagate_goto(err, err_internal, error_handler);
+/**
+ * @internal
+ * Create a new wasted transfers object.
+ *
+ * @private @memberof ccl_prof_transfer
+ *
+ * @param[in] kind Kind of wasted transfers.
+ * @param[in] event_name Name of events which performed the transfers.
+ * @return A new wasted transfers object.
+ * */
+static CCLProfTransfer* ccl_prof_transfer_new(
+	CCLProfTransferKind kind, const char* event_name) {
+	CCLProfTransfer* transfer = g_slice_new0(CCLProfTransfer);
+	transfer->kind = kind;
+	transfer->event_name = event_name;
+	return transfer;
+}
 
-	/* If we get here, update number of profilable events, and get an ID
-	 * for the given event. */
-	event_id = ++prof->num_events;
+/**
+ * @internal
+ * Destroy a wasted transfers object.
+ *
+ * @private @memberof ccl_prof_transfer
+ *
+ * @param[in] transfer Wasted transfers object to destroy.
+ * */
+static void ccl_prof_transfer_destroy(CCLProfTransfer* transfer) {
+	g_return_if_fail(transfer != NULL);
+	g_slice_free(CCLProfTransfer, transfer);
+}
 
-	/* Check if event name is already registered in the table of event
-	 * names... */
-	if (!g_hash_table_contains(prof->event_names, event_name)) {
-		/* ...if not, register it. */
-		event_name_id =
-			GUINT_TO_POINTER(g_hash_table_size(prof->event_names));
-		g_hash_table_insert(
-			prof->event_names,
-			(gpointer) event_name,
-			(gpointer) event_name_id);
-	}
+/**
+ * @internal
+ * Compares two wasted transfers objects for sorting within a GList. It
+ * is an implementation of GCompareDataFunc from GLib.
+ *
+ * @private @memberof ccl_prof_transfer
+ *
+ * @param[in] a First wasted transfers object to compare.
+ * @param[in] b Second wasted transfers object to compare.
+ * @param[in] userdata Defines the sort criteria and order.
+ * @return Negative value if a < b; zero if a = b; positive value if a > b.
+ */
+static gint ccl_prof_transfer_comp(
+	gconstpointer a, gconstpointer b, gpointer userdata) {
+
+	/* Cast input parameters to wasted transfers objects. */
+	CCLProfTransfer* tr1 = (CCLProfTransfer*) a;
+	CCLProfTransfer* tr2 = (CCLProfTransfer*) b;
+	CCLProfSort sort = ccl_prof_get_sort(userdata);
+
+	/* Perform comparison. */
+	switch ((CCLProfTransferSort) sort.criteria) {
+
+		/* Sort wasted transfers by kind, and then by event name. */
+		case CCL_PROF_TRANSFER_SORT_KIND:
+			if (tr1->kind != tr2->kind)
+				return CCL_PROF_CMP_INT(tr1->kind, tr2->kind, sort.order);
+			return CCL_PROF_CMP_STR(tr1->event_name, tr2->event_name,
+				sort.order);
+
+		/* Sort wasted transfers by time. */
+		case CCL_PROF_TRANSFER_SORT_TIME:
+			return CCL_PROF_CMP_INT(tr1->time, tr2->time, sort.order);
+
+		/* We shouldn't get here. */
+		default:
+			g_warning("Unknown PROF_TRANSFER sort criteria/order.");
+			return 0;
+	}
+
+}
+
+/**
+ * @internal
+ * Account for the work annotated to an event.
+ *
+ * @private @memberof ccl_prof
+ *
+ * @param[in] prof Profile object.
+ * @param[in] cq Command queue wrapper associated with event.
+ * @param[in] event_name Name of event.
+ * @param[in] bytes Bytes read and written by the event's command.
+ * @param[in] flops Floating-point operations performed by the event's
+ * command.
+ * @param[in] duration Time taken by the event's command, in nanoseconds.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * */
+static void ccl_prof_add_work(CCLProf* prof, CCLQueue* cq,
+	const char* event_name, cl_ulong bytes, cl_ulong flops,
+	cl_ulong duration, CCLErr** err) {
+
+	/* Device associated with queue. */
+	CCLDevice* dev;
+	/* Device peaks, and whether they are known. */
+	double peak_bw, peak_flops;
+	cl_bool peaks_known;
+	/* Time required at peak bandwidth and FLOP/s. */
+	double t_memory, t_compute;
+	/* Work annotated to events with the given name. */
+	CCLProfWork* work;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Get peaks of the device associated with the queue. */
+	dev = ccl_queue_get_device(cq, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	peaks_known = ccl_prof_get_device_peaks(dev, &peak_bw, &peak_flops);
+
+	/* Get work annotated to events with the given name so far. */
+	if (prof->works == NULL)
+		prof->works = g_hash_table_new_full(
+			g_str_hash, g_str_equal, NULL, g_free);
+	work = (CCLProfWork*) g_hash_table_lookup(prof->works, event_name);
+	if (work == NULL) {
+		work = g_new0(CCLProfWork, 1);
+		g_hash_table_insert(prof->works, (gpointer) event_name, work);
+	}
+
+	/* Add work of current event. */
+	work->bytes += bytes;
+	work->flops += flops;
+
+	/* Without device peaks there is no roofline information for events
+	 * with this name. */
+	if (!peaks_known) {
+		if (!work->no_peaks)
+			g_warning("Peaks of device used by '%s' events are unknown, " \
+				"no roofline information will be determined for them. " \
+				"Use ccl_prof_measure_device_peaks() or " \
+				"ccl_prof_set_device_peaks() before profiling.",
+				event_name);
+		work->no_peaks = CL_TRUE;
+		goto finish;
+	}
+
+	/* The roofline time is limited by the slowest of memory and
+	 * compute. */
+	t_memory = bytes / peak_bw;
+	t_compute = flops / peak_flops;
+	work->t_memory += t_memory;
+	work->t_compute += t_compute;
+	if (duration > 0) {
+		work->t_roofline += MAX(t_memory, t_compute);
+		work->t_actual += duration * 1e-9;
+	}
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+finish:
+
+	/* Return. */
+	return;
+}
+
+/**
+ * @internal
+ * Add event for profiling.
+ *
+ * @private @memberof ccl_prof
+ *
+ * @param[in] prof Profile object.
+ * @param[in] cq_name Command queue name.
+ * @param[in] cq Command queue wrapper object.
+ * @param[in] evt Event wrapper object.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * */
+static void ccl_prof_add_event(CCLProf* prof, const char* cq_name,
+	CCLQueue* cq, CCLEvent* evt, CCLErr** err) {
+
+	/* Make sure err is NULL or it is not set. */
+	g_return_if_fail(err == NULL || *err == NULL);
+	/* Make sure profile object is not NULL. */
+	g_return_if_fail(prof != NULL);
+	/* Make sure command queue name is not NULL. */
+	g_return_if_fail(cq_name != NULL);
+	/* Make sure event wrapper is not NULL. */
+	g_return_if_fail(evt != NULL);
+
+	/* Event name ID. */
+	cl_uint* event_name_id;
+	/* Specific event ID. */
+	cl_uint event_id;
+	/* Event instants. */
+	cl_ulong instant_queued, instant_submit, instant_start, instant_end;
+	/* Type of command which produced the event. */
+	cl_command_type command_type;
+	/* Work annotated to event. */
+	cl_ulong bytes_read, bytes_written, flops;
+	/* Event instant objects. */
+	CCLProfInst* evinst_start;
+	CCLProfInst* evinst_end;
+	/* Event information object. */
+	CCLProfInfo* info;
+	/* Memory object accesses recorded in event. */
+	const CCLEventMemAccess* accesses;
+	guint num_accesses;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Event name. */
+	const char* event_name;
+
+	/* Get event name. */
+	event_name = ccl_event_get_final_name(evt);
+
+	/* Get event queued instant. */
+	instant_queued = ccl_event_get_profiling_info_scalar(
+		evt, CL_PROFILING_COMMAND_QUEUED, cl_ulong, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Get event submit instant. */
+	instant_submit = ccl_event_get_profiling_info_scalar(
+		evt, CL_PROFILING_COMMAND_SUBMIT, cl_ulong, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Get event start instant. */
+	instant_start = ccl_event_get_profiling_info_scalar(
+		evt, CL_PROFILING_COMMAND_START, cl_ulong, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Get event end instant. */
+	instant_end = ccl_event_get_profiling_info_scalar(
+		evt, CL_PROFILING_COMMAND_END, cl_ulong, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Get command type. */
+	command_type = ccl_event_get_info_scalar(
+		evt, CL_EVENT_COMMAND_TYPE, cl_command_type, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+#ifdef CL_VERSION_2_0
+
+	/* Kernels may enqueue child kernels in on-device queues (OpenCL >= 2.0).
+	 * In such case, use the instant in which the kernel and all its children
+	 * complete as the end instant, so that child kernel time is attributed
+	 * to the parent kernel. Some implementations do not support querying
+	 * this instant, in which case the end instant is kept. */
+	if (command_type == CL_COMMAND_NDRANGE_KERNEL) {
+
+		/* OpenCL version associated with event. */
+		cl_uint ocl_ver = ccl_event_get_opencl_version(evt, &err_internal);
+
+		if ((err_internal == NULL) && (ocl_ver >= 200)) {
+
+			/* Get event complete instant. */
+			cl_ulong instant_complete = ccl_event_get_profiling_info_scalar(
+				evt, CL_PROFILING_COMMAND_COMPLETE, cl_ulong, &err_internal);
+
+			if ((err_internal == NULL) && (instant_complete > instant_end))
+				instant_end = instant_complete;
+		}
+
+		/* Fall back to the end instant on error. */
+		g_clear_error(&err_internal);
+	}
+
+#endif
+
+	/* Account for the work annotated to the event, if any. */
+	if (ccl_event_get_work(evt, &bytes_read, &bytes_written, &flops)) {
+		ccl_prof_add_work(prof, cq, event_name,
+			bytes_read + bytes_written, flops,
+			instant_end > instant_start ? instant_end - instant_start : 0,
+			&err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+	}
+
+	/* If we get here, update number of profilable events, and get an ID
+	 * for the given event. */
+	event_id = ++prof->num_events;
+
+	/* Check if event name is already registered in the table of event
+	 * names... */
+	if (!g_hash_table_contains(prof->event_names, event_name)) {
+		/* ...if not, register it. */
+		event_name_id =
+			GUINT_TO_POINTER(g_hash_table_size(prof->event_names));
+		g_hash_table_insert(
+			prof->event_names,
+			(gpointer) event_name,
+			(gpointer) event_name_id);
+	}
 
 	/* If end instant occurs after start instant... */
 	if (instant_end > instant_start) {
@@ -685,10 +1314,28 @@ static void ccl_prof_add_event(CCLProf* prof, const char* cq_name,
 
 	}
 
-	/* Add event information to list of event information..*/
-	prof->infos = g_list_prepend(prof->infos,
-		(gpointer) ccl_prof_info_new(event_name, command_type, cq_name,
-			instant_queued, instant_submit, instant_start, instant_end));
+	/* Keep the memory object accesses recorded in the event, if any, as
+	 * the event will be released once its queue is processed. */
+	accesses = ccl_event_get_mem_accesses(evt, &num_accesses);
+	if (num_accesses > 0) {
+		if (prof->accesses == NULL)
+			prof->accesses = g_array_new(
+				FALSE, FALSE, sizeof(CCLProfAccess));
+		for (guint i = 0; i < num_accesses; ++i) {
+			CCLProfAccess pacc = { accesses[i], event_name,
+				instant_end > instant_start
+					? instant_end - instant_start : 0 };
+			g_array_append_val(prof->accesses, pacc);
+		}
+	}
+
+	/* Add event information to list of event information, including the
+	 * NDRange of kernel events. */
+	info = ccl_prof_info_new(event_name, command_type, cq_name,
+		instant_queued, instant_submit, instant_start, instant_end);
+	info->work_dim = ccl_event_get_ndrange(
+		evt, info->global_work_size, info->local_work_size);
+	prof->infos = g_list_prepend(prof->infos, (gpointer) info);
 
 	/* If we got here, everything is OK. */
 	g_assert(err == NULL || *err == NULL);
@@ -752,8 +1399,8 @@ static void ccl_prof_process_queues(CCLProf* prof, CCLErr** err) {
 		while ((evt = ccl_queue_iter_event_next((CCLQueue*) cq))) {
 
 			/* Add event for profiling. */
-			ccl_prof_add_event(
-				prof, (const char*) cq_name, evt, &err_internal);
+			ccl_prof_add_event(prof, (const char*) cq_name,
+				(CCLQueue*) cq, evt, &err_internal);
 			if ((err_internal != NULL) &&
 				(((err_internal->domain == CCL_OCL_ERROR) &&
                  (err_internal->code == CL_PROFILING_INFO_NOT_AVAILABLE))
@@ -822,6 +1469,8 @@ static void ccl_prof_calc_agg(CCLProf* prof) {
 	gpointer value_agg;
 	/* Auxiliary aggregate event info variable.*/
 	CCLProfAgg* curr_agg = NULL;
+	/* Work annotated to events with a given name. */
+	CCLProfWork* work;
 
 	/* Create table of aggregate statistics. */
 	agg_table = g_hash_table_new(g_str_hash, g_str_equal);
@@ -833,6 +1482,24 @@ static void ccl_prof_calc_agg(CCLProf* prof) {
 		evagg->absolute_time = 0;
 		g_hash_table_insert(
 			agg_table, event_name, (gpointer) evagg);
+
+		/* Determine roofline information, if events with this name
+		 * were annotated with the work they perform. */
+		work = prof->works != NULL
+			? (CCLProfWork*) g_hash_table_lookup(prof->works, event_name)
+			: NULL;
+		if (work != NULL) {
+			evagg->bytes = work->bytes;
+			evagg->flops = work->flops;
+			evagg->intensity = work->bytes > 0
+				? ((double) work->flops) / ((double) work->bytes) : 0.0;
+			if (!work->no_peaks) {
+				evagg->roofline = work->t_actual > 0
+					? work->t_roofline / work->t_actual : 0.0;
+				evagg->bound = work->t_compute > work->t_memory
+					? CCL_PROF_BOUND_COMPUTE : CCL_PROF_BOUND_MEMORY;
+			}
+		}
 	}
 
 	/* Sort event instants by eid, and then by START, END order. */
@@ -1085,76 +1752,444 @@ static void ccl_prof_calc_overlaps(CCLProf* prof) {
 }
 
 /**
- * @addtogroup CCL_PROFILER
- * @{
- */
+ * @internal
+ * Fit the duration of kernel events with the same name against their
+ * number of work-items, using least squares. Events with the same
+ * number of work-items in all launches are not fitted, as the overhead
+ * cannot be separated from the per-item cost.
+ *
+ * @private @memberof ccl_prof
+ *
+ * @param[in] prof Profile object.
+ * */
+static void ccl_prof_calc_fits(CCLProf* prof) {
+
+	/* Make sure profile object is not NULL. */
+	g_return_if_fail(prof != NULL);
+
+	/* Table of launches per event name, each launch represented by a
+	 * pair of doubles (number of work-items, duration in ns). */
+	GHashTable* launches = g_hash_table_new_full(g_str_hash, g_str_equal,
+		NULL, (GDestroyNotify) g_array_unref);
+	/* Hash table iterator. */
+	GHashTableIter iter;
+	gpointer event_name, value;
+
+	/* Collect launches of kernel events which used device time. */
+	for (GList* it = prof->infos; it != NULL; it = it->next) {
+
+		CCLProfInfo* info = (CCLProfInfo*) it->data;
+		GArray* pts;
+		double pt[2];
+
+		if ((info->work_dim == 0) || (info->t_end <= info->t_start))
+			continue;
+
+		pts = (GArray*) g_hash_table_lookup(launches, info->event_name);
+		if (pts == NULL) {
+			pts = g_array_new(FALSE, FALSE, 2 * sizeof(double));
+			g_hash_table_insert(
+				launches, (gpointer) info->event_name, pts);
+		}
+		pt[0] = (double) info->global_work_size[0]
+			* info->global_work_size[1] * info->global_work_size[2];
+		pt[1] = (double) (info->t_end - info->t_start);
+		g_array_append_val(pts, pt);
+	}
+
+	/* Fit t = overhead + per_item * n for each event name. */
+	g_hash_table_iter_init(&iter, launches);
+	while (g_hash_table_iter_next(&iter, &event_name, &value)) {
+
+		GArray* pts = (GArray*) value;
+		double* pt = (double*) pts->data;
+		double n_mean = 0, t_mean = 0, n_min = G_MAXDOUBLE, n_max = 0;
+		double snn = 0, snt = 0, sn2 = 0, snt0 = 0;
+		CCLProfFit* fit;
+
+		for (guint i = 0; i < pts->len; ++i) {
+			n_mean += pt[2 * i];
+			t_mean += pt[2 * i + 1];
+			n_min = MIN(n_min, pt[2 * i]);
+			n_max = MAX(n_max, pt[2 * i]);
+		}
+		if (n_max <= n_min) continue;
+		n_mean /= pts->len;
+		t_mean /= pts->len;
+
+		for (guint i = 0; i < pts->len; ++i) {
+			double dn = pt[2 * i] - n_mean;
+			snn += dn * dn;
+			snt += dn * (pt[2 * i + 1] - t_mean);
+			sn2 += pt[2 * i] * pt[2 * i];
+			snt0 += pt[2 * i] * pt[2 * i + 1];
+		}
+
+		fit = ccl_prof_fit_new((const char*) event_name);
+		fit->num_launches = pts->len;
+		fit->min_work_items = (size_t) n_min;
+		fit->max_work_items = (size_t) n_max;
+		fit->per_item = snt / snn;
+		fit->overhead = t_mean - fit->per_item * n_mean;
+
+		/* Neither the overhead nor the per-item cost can be negative.
+		 * If one is, refit with it set to zero. */
+		if (fit->overhead < 0) {
+			fit->overhead = 0;
+			fit->per_item = snt0 / sn2;
+		} else if (fit->per_item < 0) {
+			fit->per_item = 0;
+			fit->overhead = t_mean;
+		}
+		fit->break_even = fit->per_item > 0
+			? fit->overhead / fit->per_item : 0;
+
+		prof->fits = g_list_prepend(prof->fits, (gpointer) fit);
+	}
+
+	/* Release launches table. */
+	g_hash_table_destroy(launches);
+
+}
 
 /**
- * Create a new profile object.
+ * @internal
+ * Account for a wasted transfer.
  *
- * @public @memberof ccl_prof
+ * @private @memberof ccl_prof
  *
- * @return A new profile object.
+ * @param[in] prof Profile object.
+ * @param[in] kind Kind of wasted transfer.
+ * @param[in] event_name Name of event which performed the transfer.
+ * @param[in] bytes Bytes wastefully transferred.
+ * @param[in] time Time taken by the transfer, in nanoseconds.
  * */
-CCL_EXPORT
-CCLProf* ccl_prof_new() {
+static void ccl_prof_add_transfer(CCLProf* prof, CCLProfTransferKind kind,
+	const char* event_name, size_t bytes, cl_ulong time) {
+
+	/* Wasted transfers of the given kind and event name. */
+	CCLProfTransfer* transfer = NULL;
+
+	/* Find wasted transfers of the given kind and event name so far. */
+	for (GList* it = prof->transfers; it != NULL; it = it->next) {
+		CCLProfTransfer* tr = (CCLProfTransfer*) it->data;
+		if ((tr->kind == kind)
+			&& (g_strcmp0(tr->event_name, event_name) == 0)) {
+			transfer = tr;
+			break;
+		}
+	}
+	if (transfer == NULL) {
+		transfer = ccl_prof_transfer_new(kind, event_name);
+		prof->transfers = g_list_prepend(prof->transfers, transfer);
+	}
 
-	/* Allocate memory for new profile data structure. */
-	CCLProf* prof = g_slice_new0(CCLProf);
+	/* Account for the current one. */
+	transfer->count++;
+	transfer->bytes += bytes;
+	transfer->time += time;
 
-	/* Set absolute start time to maximum possible. */
-	prof->t_start = CL_ULONG_MAX;
+}
 
-	/* Return new profile data structure */
-	return prof;
+/**
+ * @internal
+ * Compares two memory object accesses by the order in which they were
+ * issued. It is an implementation of GCompareFunc from GLib.
+ *
+ * @private @memberof ccl_prof
+ *
+ * @param[in] a First memory object access to compare.
+ * @param[in] b Second memory object access to compare.
+ * @return Negative value if a < b; zero if a = b; positive value if a > b.
+ */
+static gint ccl_prof_access_comp(gconstpointer a, gconstpointer b) {
+
+	guint seq1 = ((CCLProfAccess*) a)->acc.seq;
+	guint seq2 = ((CCLProfAccess*) b)->acc.seq;
+	return (seq1 > seq2) ? 1 : ((seq1 < seq2) ? -1 : 0);
 
 }
 
 /**
- * Destroy a profile object.
+ * @internal
+ * Find wasted transfers by replaying the memory object accesses recorded
+ * in events in the order they were issued, while keeping track of the
+ * regions of each memory object whose contents are known to the host.
  *
- * @public @memberof ccl_prof
+ * Writes of data identical to a known region are redundant, reads of a
+ * known region are of unmodified data, and writes which are overwritten
+ * before any read are flagged when they are overwritten. Any other
+ * access which may modify a region makes its contents unknown.
  *
- * @param[in] prof Profile object to destroy.
+ * @private @memberof ccl_prof
+ *
+ * @param[in] prof Profile object.
  * */
-CCL_EXPORT
-void ccl_prof_destroy(CCLProf* prof) {
+static void ccl_prof_calc_transfers(CCLProf* prof) {
 
-	/* Profile to destroy cannot be NULL. */
+	/* Make sure profile object is not NULL. */
 	g_return_if_fail(prof != NULL);
 
-	/* Destroy table of event names. */
-	if (prof->event_names != NULL)
-		g_hash_table_destroy(prof->event_names);
+	/* Table of known regions per memory object, values are arrays of
+	 * ::CCLProfRegion objects. */
+	GHashTable* known;
 
-	/* Destroy table of event IDs. */
-	if (prof->event_name_ids != NULL)
-		g_hash_table_destroy(prof->event_name_ids);
+	/* Nothing to do if no accesses were recorded. */
+	if (prof->accesses == NULL) return;
 
-	/* Destroy table of command queue wrappers. */
-	if (prof->queues != NULL)
-		g_hash_table_destroy(prof->queues);
+	/* Replay accesses in the order they were issued. */
+	g_array_sort(prof->accesses, ccl_prof_access_comp);
+	known = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+		NULL, (GDestroyNotify) g_array_unref);
 
-	/* Destroy list of all event instants. */
-	if (prof->instants != NULL)
-		g_list_free_full(
-			prof->instants, (GDestroyNotify) ccl_prof_inst_destroy);
+	for (guint i = 0; i < prof->accesses->len; ++i) {
 
-	/* Destroy list of event profiling information. */
-	if (prof->infos != NULL)
-		g_list_free_full(
-			prof->infos, (GDestroyNotify) ccl_prof_info_destroy);
+		CCLProfAccess* pacc =
+			&g_array_index(prof->accesses, CCLProfAccess, i);
+		CCLEventMemAccess* acc = &pacc->acc;
+		size_t end = acc->size == G_MAXSIZE
+			? G_MAXSIZE : acc->offset + acc->size;
+		GArray* regions;
+		gboolean flagged = FALSE;
 
-	/* Destroy list of aggregate statistics. */
-	if (prof->aggs != NULL)
-		g_list_free_full(
-			prof->aggs, (GDestroyNotify) ccl_prof_agg_destroy);
+		regions = (GArray*) g_hash_table_lookup(known, acc->mem);
+		if (regions == NULL) {
+			regions = g_array_new(FALSE, FALSE, sizeof(CCLProfRegion));
+			g_hash_table_insert(known, acc->mem, regions);
+		}
 
-	/* Free the overlap matrix. */
-	if (prof->overlaps != NULL)
-		g_list_free_full(
+		/* Writes of data identical to a known region are redundant, and
+		 * leave the region as is. */
+		if (acc->kind == CCL_EVENT_MEM_UPLOAD && acc->has_hash) {
+			for (guint j = 0; j < regions->len; ++j) {
+				CCLProfRegion* r =
+					&g_array_index(regions, CCLProfRegion, j);
+				if ((r->offset == acc->offset) && (r->end == end)
+					&& r->has_hash && (r->hash == acc->hash)) {
+					ccl_prof_add_transfer(prof,
+						CCL_PROF_TRANSFER_REDUNDANT, pacc->event_name,
+						acc->size, pacc->duration);
+					flagged = TRUE;
+					break;
+				}
+			}
+			if (flagged) continue;
+		}
+
+		/* Reads of a known region are of unmodified data. */
+		if (acc->kind == CCL_EVENT_MEM_DOWNLOAD) {
+			for (guint j = 0; j < regions->len; ++j) {
+				CCLProfRegion* r =
+					&g_array_index(regions, CCLProfRegion, j);
+				if ((r->offset <= acc->offset) && (end <= r->end)) {
+					ccl_prof_add_transfer(prof,
+						CCL_PROF_TRANSFER_UNMODIFIED, pacc->event_name,
+						acc->size, pacc->duration);
+					flagged = TRUE;
+					break;
+				}
+			}
+		}
+
+		/* Update the regions overlapping the accessed one. */
+		for (guint j = regions->len; j > 0; --j) {
+
+			CCLProfRegion* r =
+				&g_array_index(regions, CCLProfRegion, j - 1);
+
+			if ((r->end <= acc->offset) || (end <= r->offset))
+				continue;
+
+			switch (acc->kind) {
+
+				/* Reads consume pending uploads. */
+				case CCL_EVENT_MEM_DOWNLOAD:
+				case CCL_EVENT_MEM_READ:
+					r->upload_name = NULL;
+					break;
+
+				/* Writes overwrite pending uploads which they cover. */
+				case CCL_EVENT_MEM_UPLOAD:
+				case CCL_EVENT_MEM_WRITE:
+					if ((r->upload_name != NULL) && (acc->offset <= r->offset)
+						&& (r->end <= end)) {
+						ccl_prof_add_transfer(prof,
+							CCL_PROF_TRANSFER_OVERWRITTEN, r->upload_name,
+							r->end - r->offset, r->upload_time);
+					}
+					g_array_remove_index_fast(regions, j - 1);
+					break;
+
+				/* Other accesses make the region contents unknown. */
+				default:
+					g_array_remove_index_fast(regions, j - 1);
+					break;
+			}
+		}
+
+		/* The contents of transferred regions become known to the
+		 * host. */
+		if ((acc->kind == CCL_EVENT_MEM_UPLOAD)
+			|| ((acc->kind == CCL_EVENT_MEM_DOWNLOAD) && !flagged)) {
+
+			CCLProfRegion r = { acc->offset, end, acc->has_hash,
+				acc->hash, NULL, 0 };
+			if (acc->kind == CCL_EVENT_MEM_UPLOAD) {
+				r.upload_name = pacc->event_name;
+				r.upload_time = pacc->duration;
+			}
+			g_array_append_val(regions, r);
+		}
+	}
+
+	/* Release table of known regions. */
+	g_hash_table_destroy(known);
+
+}
+
+/**
+ * @internal
+ * Export profiling information to a given file with the given export
+ * function, automatically opening and closing the file.
+ *
+ * @private @memberof ccl_prof
+ *
+ * @param[in] prof Profile object.
+ * @param[in] filename Name of file where information will be saved to.
+ * @param[in] export_fn Function which exports information to a stream.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return CL_TRUE if function terminates successfully, CL_FALSE
+ * otherwise.
+ * */
+static cl_bool ccl_prof_export_to_file(CCLProf* prof, const char* filename,
+	cl_bool (*export_fn)(CCLProf*, FILE*, CCLErr**), CCLErr** err) {
+
+	/* Aux. var. */
+	cl_bool status;
+
+	/* Internal CCLErr object. */
+	CCLErr* err_internal = NULL;
+
+	/* Open file. */
+	FILE* fp = fopen(filename, "w");
+	g_if_err_create_goto(*err, CCL_ERROR, fp == NULL,
+		CCL_ERROR_OPENFILE, error_handler,
+		"Unable to open file '%s' for exporting.", filename);
+
+	/* Export data. */
+	status = export_fn(prof, fp, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	status = CL_TRUE;
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	status = CL_FALSE;
+
+finish:
+
+	/* Close file. */
+	if (fp) fclose(fp);
+
+	/* Return status. */
+	return status;
+
+}
+
+/**
+ * @addtogroup CCL_PROFILER
+ * @{
+ */
+
+/**
+ * Create a new profile object.
+ *
+ * @public @memberof ccl_prof
+ *
+ * @return A new profile object.
+ * */
+CCL_EXPORT
+CCLProf* ccl_prof_new() {
+
+	/* Allocate memory for new profile data structure. */
+	CCLProf* prof = g_slice_new0(CCLProf);
+
+	/* Set absolute start time to maximum possible. */
+	prof->t_start = CL_ULONG_MAX;
+
+	/* Return new profile data structure */
+	return prof;
+
+}
+
+/**
+ * Destroy a profile object.
+ *
+ * @public @memberof ccl_prof
+ *
+ * @param[in] prof Profile object to destroy.
+ * */
+CCL_EXPORT
+void ccl_prof_destroy(CCLProf* prof) {
+
+	/* Profile to destroy cannot be NULL. */
+	g_return_if_fail(prof != NULL);
+
+	/* Destroy table of event names. */
+	if (prof->event_names != NULL)
+		g_hash_table_destroy(prof->event_names);
+
+	/* Destroy table of event IDs. */
+	if (prof->event_name_ids != NULL)
+		g_hash_table_destroy(prof->event_name_ids);
+
+	/* Destroy table of command queue wrappers. */
+	if (prof->queues != NULL)
+		g_hash_table_destroy(prof->queues);
+
+	/* Destroy table of annotated work. */
+	if (prof->works != NULL)
+		g_hash_table_destroy(prof->works);
+
+	/* Destroy array of memory object accesses. */
+	if (prof->accesses != NULL)
+		g_array_free(prof->accesses, TRUE);
+
+	/* Destroy list of all event instants. */
+	if (prof->instants != NULL)
+		g_list_free_full(
+			prof->instants, (GDestroyNotify) ccl_prof_inst_destroy);
+
+	/* Destroy list of event profiling information. */
+	if (prof->infos != NULL)
+		g_list_free_full(
+			prof->infos, (GDestroyNotify) ccl_prof_info_destroy);
+
+	/* Destroy list of aggregate statistics. */
+	if (prof->aggs != NULL)
+		g_list_free_full(
+			prof->aggs, (GDestroyNotify) ccl_prof_agg_destroy);
+
+	/* Free the overlap matrix. */
+	if (prof->overlaps != NULL)
+		g_list_free_full(
 			prof->overlaps, (GDestroyNotify) ccl_prof_overlap_destroy);
 
+	/* Destroy list of launch scaling fits. */
+	if (prof->fits != NULL)
+		g_list_free_full(
+			prof->fits, (GDestroyNotify) ccl_prof_fit_destroy);
+
+	/* Destroy list of wasted transfers. */
+	if (prof->transfers != NULL)
+		g_list_free_full(
+			prof->transfers, (GDestroyNotify) ccl_prof_transfer_destroy);
+
 	/* Free the summary string. */
 	if (prof->summary != NULL)
 		g_free(prof->summary);
@@ -1325,6 +2360,12 @@ cl_bool ccl_prof_calc(CCLProf* prof, CCLErr** err) {
 	/* Determine event overlaps. */
 	ccl_prof_calc_overlaps(prof);
 
+	/* Fit launch scaling of kernel events. */
+	ccl_prof_calc_fits(prof);
+
+	/* Find wasted transfers. */
+	ccl_prof_calc_transfers(prof);
+
 	/* If we got here, everything is OK. */
 	g_assert(err == NULL || *err == NULL);
 	status = CL_TRUE;
@@ -1616,6 +2657,158 @@ const CCLProfOverlap* ccl_prof_iter_overlap_next(CCLProf* prof) {
 	return (const CCLProfOverlap*) ovlp;
 }
 
+/**
+ * Return the launch scaling fit for events with the given name.
+ *
+ * @public @memberof ccl_prof
+ *
+ * @param[in] prof Profile object.
+ * @param[in] event_name Event name.
+ * @return Launch scaling fit for events with the given name, or `NULL`
+ * if no fit is available for them, e.g. if they are not kernel events,
+ * or if all launches had the same number of work-items.
+ */
+CCL_EXPORT
+const CCLProfFit* ccl_prof_get_fit(CCLProf* prof, const char* event_name) {
+
+	/* Make sure prof is not NULL. */
+	g_return_val_if_fail(prof != NULL, NULL);
+	/* Make sure event name is not NULL. */
+	g_return_val_if_fail(event_name != NULL, NULL);
+	/* This function can only be called after calculations are made. */
+	g_return_val_if_fail(prof->calc == TRUE, NULL);
+
+	/* Find the fit for the given event. */
+	for (GList* it = prof->fits; it != NULL; it = it->next) {
+		if (g_strcmp0(event_name,
+				((CCLProfFit*) it->data)->event_name) == 0)
+			return (const CCLProfFit*) it->data;
+	}
+
+	/* Not found. */
+	return NULL;
+}
+
+/**
+ * Initialize an iterator for launch scaling fits.
+ *
+ * @public @memberof ccl_prof
+ *
+ * @param[in] prof Profile object.
+ * @param[in] sort Bitfield of ::CCLProfFitSort OR ::CCLProfSortOrder,
+ * for example `CCL_PROF_FIT_SORT_OVERHEAD | CCL_PROF_SORT_DESC`.
+ * */
+CCL_EXPORT
+void ccl_prof_iter_fit_init(CCLProf* prof, int sort) {
+
+	/* Make sure prof is not NULL. */
+	g_return_if_fail(prof != NULL);
+	/* This function can only be called after calculations are made. */
+	g_return_if_fail(prof->calc == TRUE);
+
+	/* Sort list of fits as requested by client. */
+	prof->fits = g_list_sort_with_data(
+		prof->fits, ccl_prof_fit_comp, &sort);
+
+	/* Set the iterator as the first element in list. */
+	prof->fit_iter = prof->fits;
+}
+
+/**
+ * Return the next launch scaling fit.
+ *
+ * @public @memberof ccl_prof
+ *
+ * @param[in] prof Profile object.
+ * @return The next launch scaling fit.
+ * */
+CCL_EXPORT
+const CCLProfFit* ccl_prof_iter_fit_next(CCLProf* prof) {
+
+	/* Make sure prof is not NULL. */
+	g_return_val_if_fail(prof != NULL, NULL);
+	/* This function can only be called after calculations are made. */
+	g_return_val_if_fail(prof->calc == TRUE, NULL);
+
+	/* The fit to return. */
+	CCLProfFit* fit;
+
+	/* Check if there are any more left. */
+	if (prof->fit_iter != NULL) {
+		/* Yes, send current one, pass to the next. */
+		fit = (CCLProfFit*) prof->fit_iter->data;
+		prof->fit_iter = prof->fit_iter->next;
+	} else {
+		/* Nothing left. */
+		fit = NULL;
+	}
+
+	/* Return the fit. */
+	return (const CCLProfFit*) fit;
+}
+
+/**
+ * Initialize an iterator for wasted transfers. Wasted transfers are
+ * only found if transfer analysis was enabled with
+ * ::ccl_prof_set_transfer_mode() when the respective commands were
+ * enqueued.
+ *
+ * @public @memberof ccl_prof
+ *
+ * @param[in] prof Profile object.
+ * @param[in] sort Bitfield of ::CCLProfTransferSort OR
+ * ::CCLProfSortOrder, for example
+ * `CCL_PROF_TRANSFER_SORT_TIME | CCL_PROF_SORT_DESC`.
+ * */
+CCL_EXPORT
+void ccl_prof_iter_transfer_init(CCLProf* prof, int sort) {
+
+	/* Make sure prof is not NULL. */
+	g_return_if_fail(prof != NULL);
+	/* This function can only be called after calculations are made. */
+	g_return_if_fail(prof->calc == TRUE);
+
+	/* Sort list of wasted transfers as requested by client. */
+	prof->transfers = g_list_sort_with_data(
+		prof->transfers, ccl_prof_transfer_comp, &sort);
+
+	/* Set the iterator as the first element in list. */
+	prof->transfer_iter = prof->transfers;
+}
+
+/**
+ * Return the next wasted transfers object.
+ *
+ * @public @memberof ccl_prof
+ *
+ * @param[in] prof Profile object.
+ * @return The next wasted transfers object.
+ * */
+CCL_EXPORT
+const CCLProfTransfer* ccl_prof_iter_transfer_next(CCLProf* prof) {
+
+	/* Make sure prof is not NULL. */
+	g_return_val_if_fail(prof != NULL, NULL);
+	/* This function can only be called after calculations are made. */
+	g_return_val_if_fail(prof->calc == TRUE, NULL);
+
+	/* The wasted transfers object to return. */
+	CCLProfTransfer* transfer;
+
+	/* Check if there are any more left. */
+	if (prof->transfer_iter != NULL) {
+		/* Yes, send current one, pass to the next. */
+		transfer = (CCLProfTransfer*) prof->transfer_iter->data;
+		prof->transfer_iter = prof->transfer_iter->next;
+	} else {
+		/* Nothing left. */
+		transfer = NULL;
+	}
+
+	/* Return the wasted transfers object. */
+	return (const CCLProfTransfer*) transfer;
+}
+
 /**
  * Get duration of all events in nanoseconds.
  *
@@ -1662,11 +2855,63 @@ cl_ulong ccl_prof_get_eff_duration(CCLProf* prof) {
 	return prof->total_events_eff_time;
 }
 
+/**
+ * Get the mean and maximum latency, in nanoseconds, of the events of the
+ * given queue, i.e. the time between each command being queued and
+ * completing. This is useful for comparing queues of different
+ * quality-of-service classes (see ::ccl_queue_new_qos()), by adding them to
+ * the profile object with the name of their class.
+ *
+ * @public @memberof ccl_prof
+ *
+ * @param[in] prof Profile object.
+ * @param[in] cq_name Name of queue, as given to ::ccl_prof_add_queue().
+ * @param[out] max_latency Return location for the maximum latency of the
+ * queue's events, in nanoseconds, or `NULL` if not required.
+ * @return The mean latency of the queue's events in nanoseconds, or zero if
+ * no events are associated with the queue.
+ * */
+CCL_EXPORT
+cl_ulong ccl_prof_get_queue_latency(
+	CCLProf* prof, const char* cq_name, cl_ulong* max_latency) {
+
+	/* Make sure prof is not NULL. */
+	g_return_val_if_fail(prof != NULL, 0);
+	/* Make sure cq_name is not NULL. */
+	g_return_val_if_fail(cq_name != NULL, 0);
+	/* This function can only be called after calculations are made. */
+	g_return_val_if_fail(prof->calc == TRUE, 0);
+
+	/* Sum and maximum of latencies. */
+	cl_ulong total = 0, max = 0;
+	/* Number of events of queue. */
+	cl_ulong num_evts = 0;
+
+	/* Cycle through event information objects. */
+	for (GList* it = prof->infos; it != NULL; it = it->next) {
+
+		CCLProfInfo* info = (CCLProfInfo*) it->data;
+
+		if (g_strcmp0(info->queue_name, cq_name) == 0) {
+			cl_ulong latency = info->t_end - info->t_queued;
+			total += latency;
+			max = MAX(max, latency);
+			++num_evts;
+		}
+	}
+
+	/* Return requested data. */
+	if (max_latency != NULL) *max_latency = max;
+	return num_evts > 0 ? total / num_evts : 0;
+
+}
+
 /**
  * Print a summary of the profiling info. More specifically,
  * this function prints a table of aggregate event statistics (sorted
- * by absolute time), and a table of event overlaps (sorted by overlap
- * duration).
+ * by absolute time), a table with the roofline information of events
+ * annotated with ::ccl_event_set_work(), if any, and a table of event
+ * overlaps (sorted by overlap duration).
  *
  * For more control of where and how this summary is printed, use the
  * ccl_prof_get_summary() function.
@@ -1724,6 +2969,8 @@ const char* ccl_prof_get_summary(
 	const CCLProfAgg* agg = NULL;
 	/* Current overlap to print. */
 	const CCLProfOverlap* ovlp = NULL;
+	/* Were any events annotated with the work they perform? */
+	gboolean has_roofline = FALSE;
 	/* The summary string. */
 	GString* str_obj = g_string_new("\n");
 
@@ -1756,6 +3003,89 @@ const char* ccl_prof_get_summary(
 			"                                    ---------------------------------\n");
 	}
 
+	/* *** Show roofline of annotated events *** */
+
+	for (GList* it = prof->aggs; it != NULL; it = it->next) {
+		if (((CCLProfAgg*) it->data)->bound != CCL_PROF_BOUND_NONE) {
+			has_roofline = TRUE;
+			break;
+		}
+	}
+	if (has_roofline) {
+		g_string_append_printf(str_obj,
+			" Roofline by event         :\n");
+		g_string_append_printf(str_obj,
+			"   ------------------------------------------------------------------\n");
+		g_string_append_printf(str_obj,
+			"   | Event name                     | FLOP/byte | Roof. %% | Bound   |\n");
+		g_string_append_printf(str_obj,
+			"   ------------------------------------------------------------------\n");
+		ccl_prof_iter_agg_init(prof, agg_sort);
+		while ((agg = ccl_prof_iter_agg_next(prof)) != NULL) {
+			if (agg->bound == CCL_PROF_BOUND_NONE) continue;
+			g_string_append_printf(str_obj,
+				"   | %-30.30s | %9.3f | %7.2f | %-7s |\n",
+				agg->event_name,
+				agg->intensity,
+				agg->roofline * 100.0,
+				agg->bound == CCL_PROF_BOUND_COMPUTE ? "compute" : "memory");
+		}
+		g_string_append_printf(str_obj,
+			"   ------------------------------------------------------------------\n");
+	}
+
+	/* *** Show launch scaling fits *** */
+
+	if (prof->fits != NULL) {
+		const CCLProfFit* fit;
+		g_string_append_printf(str_obj,
+			" Launch scaling by event   :\n");
+		g_string_append_printf(str_obj,
+			"   ------------------------------------------------------------------\n");
+		g_string_append_printf(str_obj,
+			"   | Event name                     | Overhead (s)  | Per item (s)  |\n");
+		g_string_append_printf(str_obj,
+			"   ------------------------------------------------------------------\n");
+		ccl_prof_iter_fit_init(prof,
+			CCL_PROF_FIT_SORT_OVERHEAD | CCL_PROF_SORT_DESC);
+		while ((fit = ccl_prof_iter_fit_next(prof)) != NULL) {
+			g_string_append_printf(str_obj,
+				"   | %-30.30s | %13.4e | %13.4e |\n",
+				fit->event_name,
+				fit->overhead * 1e-9,
+				fit->per_item * 1e-9);
+		}
+		g_string_append_printf(str_obj,
+			"   ------------------------------------------------------------------\n");
+	}
+
+	/* *** Show wasted transfers *** */
+
+	if (prof->transfers != NULL) {
+		const CCLProfTransfer* transfer;
+		const char* issues[] = { "redundant", "unmodified", "overwritten" };
+		g_string_append_printf(str_obj,
+			" Redundant transfers       :\n");
+		g_string_append_printf(str_obj,
+			"   ------------------------------------------------------------------\n");
+		g_string_append_printf(str_obj,
+			"   | Event name           | Issue       | Bytes      | Time (s)     |\n");
+		g_string_append_printf(str_obj,
+			"   ------------------------------------------------------------------\n");
+		ccl_prof_iter_transfer_init(prof,
+			CCL_PROF_TRANSFER_SORT_TIME | CCL_PROF_SORT_DESC);
+		while ((transfer = ccl_prof_iter_transfer_next(prof)) != NULL) {
+			g_string_append_printf(str_obj,
+				"   | %-20.20s | %-11s | %10.3e | %12.4e |\n",
+				transfer->event_name,
+				issues[transfer->kind],
+				(double) transfer->bytes,
+				transfer->time * 1e-9);
+		}
+		g_string_append_printf(str_obj,
+			"   ------------------------------------------------------------------\n");
+	}
+
 	/* *** Show overlaps *** */
 
 	if (g_list_length(prof->overlaps) > 0) {
@@ -1944,39 +3274,270 @@ cl_bool ccl_prof_export_info_file(
 	/* This function can only be called after calculations are made. */
 	g_return_val_if_fail(prof->calc == TRUE, CL_FALSE);
 
-	/* Aux. var. */
-	cl_bool status;
+	/* Export data to file. */
+	return ccl_prof_export_to_file(
+		prof, filename, ccl_prof_export_info, err);
 
-	/* Internal CCLErr object. */
-	CCLErr* err_internal = NULL;
+}
 
-	/* Open file. */
-	FILE* fp = fopen(filename, "w");
-	g_if_err_create_goto(*err, CCL_ERROR, fp == NULL,
-		CCL_ERROR_OPENFILE, error_handler,
-		"Unable to open file '%s' for exporting.", filename);
+/**
+ * Export aggregate event information to a given stream.
+ *
+ * Each line of the exported data will have the following format,
+ * ordered by event name:
+ *
+ *     event-name abs-time rel-time bytes flops intensity roofline bound
+ *
+ * where `abs-time` is in nanoseconds, `rel-time` and `roofline` are
+ * fractions between 0 and 1, and `bound` is one of `none`, `memory` or
+ * `compute`. The `bytes`, `flops`, `intensity` and `roofline` fields
+ * are zero for events which were not annotated with
+ * ::ccl_event_set_work() (see ::CCLProfAgg for details). For example:
+ *
+ *     READ_BUFFER    1200     0.120000    0          0          0.000000  0.000000  none
+ *     saxpy          8800     0.880000    12582912   2097152    0.166667  0.712000  memory
+ *
+ * The field separator, newline and event name delimiter are taken from
+ * the export options (see ccl_prof_set_export_opts()).
+ *
+ * @public @memberof ccl_prof
+ *
+ * @param[in] prof Profile object.
+ * @param[out] stream Stream where export info to.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return CL_TRUE if function terminates successfully, CL_FALSE
+ * otherwise.
+ * */
+CCL_EXPORT
+cl_bool ccl_prof_export_agg(CCLProf* prof, FILE* stream, CCLErr** err) {
 
-	/* Export data. */
-	status = ccl_prof_export_info(prof, fp, &err_internal);
-	g_if_err_propagate_goto(err, err_internal, error_handler);
+	/* Make sure prof is not NULL. */
+	g_return_val_if_fail(prof != NULL, CL_FALSE);
+	/* Make sure stream is not NULL. */
+	g_return_val_if_fail(stream != NULL, CL_FALSE);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, CL_FALSE);
+	/* This function can only be called after calculations are made. */
+	g_return_val_if_fail(prof->calc == TRUE, CL_FALSE);
+
+	/* Stream write status. */
+	int write_status;
+	/* Return status. */
+	cl_bool ret_status;
+	/* Current aggregate event information. */
+	const CCLProfAgg* agg;
+	/* Names of roofline bounds. */
+	const char* bounds[] = { "none", "memory", "compute" };
+
+	/* Sort aggregate event information by name, ascending. */
+	ccl_prof_iter_agg_init(prof, CCL_PROF_AGG_SORT_NAME | CCL_PROF_SORT_ASC);
+
+	/* Iterate through aggregate event information and export it. */
+	while ((agg = ccl_prof_iter_agg_next(prof)) != NULL) {
+
+		/* Write to stream. */
+		write_status = fprintf(stream,
+			"%s%s%s%s%lu%s%f%s%lu%s%lu%s%f%s%f%s%s%s",
+			export_options.evname_delim,
+			agg->event_name,
+			export_options.evname_delim,
+			export_options.separator,
+			(unsigned long) agg->absolute_time,
+			export_options.separator,
+			agg->relative_time,
+			export_options.separator,
+			(unsigned long) agg->bytes,
+			export_options.separator,
+			(unsigned long) agg->flops,
+			export_options.separator,
+			agg->intensity,
+			export_options.separator,
+			agg->roofline,
+			export_options.separator,
+			bounds[agg->bound],
+			export_options.newline);
+
+		g_if_err_create_goto(*err, CCL_ERROR, write_status < 0,
+			CCL_ERROR_STREAM_WRITE, error_handler,
+			"Error while exporting aggregate profiling information" \
+			"(writing to stream).");
+
+	}
 
 	/* If we got here, everything is OK. */
 	g_assert(err == NULL || *err == NULL);
-	status = CL_TRUE;
+	ret_status = CL_TRUE;
 	goto finish;
 
 error_handler:
 	/* If we got here there was an error, verify that it is so. */
 	g_assert(err == NULL || *err != NULL);
-	status = CL_FALSE;
+	ret_status = CL_FALSE;
 
 finish:
 
-	/* Close file. */
-	if (fp) fclose(fp);
+	/* Return status. */
+	return ret_status;
 
-	/* Return file contents in string form. */
-	return status;
+}
+
+/**
+ * Helper function which exports aggregate event information to a given
+ * file, automatically opening and closing the file. See the
+ * ccl_prof_export_agg() for more information.
+ *
+ * @public @memberof ccl_prof
+ *
+ * @param[in] prof Profile object.
+ * @param[in] filename Name of file where information will be saved to.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return CL_TRUE if function terminates successfully, CL_FALSE
+ * otherwise.
+ * */
+CCL_EXPORT
+cl_bool ccl_prof_export_agg_file(
+	CCLProf* prof, const char* filename, CCLErr** err) {
+
+	/* Make sure prof is not NULL. */
+	g_return_val_if_fail(prof != NULL, CL_FALSE);
+	/* Make sure filename is not NULL. */
+	g_return_val_if_fail(filename != NULL, CL_FALSE);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, CL_FALSE);
+	/* This function can only be called after calculations are made. */
+	g_return_val_if_fail(prof->calc == TRUE, CL_FALSE);
+
+	/* Export data to file. */
+	return ccl_prof_export_to_file(
+		prof, filename, ccl_prof_export_agg, err);
+
+}
+
+/**
+ * Get the peak memory bandwidth and floating-point throughput of a
+ * device, as used for the roofline information determined by
+ * ::ccl_prof_calc().
+ *
+ * Peaks are only known if previously measured with
+ * ::ccl_prof_measure_device_peaks() or set with
+ * ::ccl_prof_set_device_peaks(). This function is thread-safe.
+ *
+ * @public @memberof ccl_prof
+ *
+ * @param[in] dev Device wrapper object.
+ * @param[out] bandwidth Return location for peak bandwidth in bytes per
+ * second.
+ * @param[out] flops Return location for peak floating-point operations
+ * per second.
+ * @return CL_TRUE if the peaks of the device are known, CL_FALSE
+ * otherwise, in which case the return locations are not modified.
+ * */
+CCL_EXPORT
+cl_bool ccl_prof_get_device_peaks(
+	CCLDevice* dev, double* bandwidth, double* flops) {
+
+	/* Make sure dev is not NULL. */
+	g_return_val_if_fail(dev != NULL, CL_FALSE);
+	/* Make sure return locations are not NULL. */
+	g_return_val_if_fail((bandwidth != NULL) && (flops != NULL), CL_FALSE);
+
+	/* Peaks of device. */
+	double* peaks = NULL;
+
+	G_LOCK(device_peaks);
+
+	if (device_peaks != NULL)
+		peaks = (double*) g_hash_table_lookup(
+			device_peaks, ccl_device_unwrap(dev));
+	if (peaks != NULL) {
+		*bandwidth = peaks[0];
+		*flops = peaks[1];
+	}
+
+	G_UNLOCK(device_peaks);
+
+	/* Return whether peaks are known. */
+	return peaks != NULL;
+
+}
+
+/**
+ * Measure the peak memory bandwidth and floating-point throughput of a
+ * device with a short microbenchmark (a buffer copy and a chain of
+ * single-precision multiply-adds), replacing any previously measured or
+ * set values. Peaks measured with this function are used for the
+ * roofline information of subsequent calls to ::ccl_prof_calc().
+ *
+ * The microbenchmark creates its own context and allocates up to
+ * 64 MiB of device memory, so it should be called before the device is
+ * under load. This function is thread-safe.
+ *
+ * @public @memberof ccl_prof
+ *
+ * @param[in] dev Device wrapper object.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return CL_TRUE if function terminates successfully, CL_FALSE
+ * otherwise.
+ * */
+CCL_EXPORT
+cl_bool ccl_prof_measure_device_peaks(CCLDevice* dev, CCLErr** err) {
+
+	/* Make sure dev is not NULL. */
+	g_return_val_if_fail(dev != NULL, CL_FALSE);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, CL_FALSE);
+
+	/* Measured peaks. */
+	double bandwidth, flops;
+
+	/* Measure peaks without holding the lock, and store them. */
+	if (!ccl_prof_measure_peaks(dev, &bandwidth, &flops, err))
+		return CL_FALSE;
+	ccl_prof_set_device_peaks(dev, bandwidth, flops);
+
+	return CL_TRUE;
+
+}
+
+/**
+ * Set the peak memory bandwidth and floating-point throughput of a
+ * device, e.g. from its specifications, replacing any previously
+ * measured or set values. Peaks set with this function are used for the
+ * roofline information of subsequent calls to ::ccl_prof_calc().
+ *
+ * @public @memberof ccl_prof
+ *
+ * @param[in] dev Device wrapper object.
+ * @param[in] bandwidth Peak bandwidth in bytes per second.
+ * @param[in] flops Peak floating-point operations per second.
+ * */
+CCL_EXPORT
+void ccl_prof_set_device_peaks(
+	CCLDevice* dev, double bandwidth, double flops) {
+
+	/* Make sure dev is not NULL. */
+	g_return_if_fail(dev != NULL);
+	/* Make sure peaks are positive. */
+	g_return_if_fail((bandwidth > 0) && (flops > 0));
+
+	/* Peaks of device. */
+	double* peaks = g_new(double, 2);
+	peaks[0] = bandwidth;
+	peaks[1] = flops;
+
+	G_LOCK(device_peaks);
+
+	/* Initialize table if required. */
+	if (device_peaks == NULL)
+		device_peaks = g_hash_table_new_full(
+			g_direct_hash, g_direct_equal, NULL, g_free);
+
+	g_hash_table_replace(device_peaks, ccl_device_unwrap(dev), peaks);
+
+	G_UNLOCK(device_peaks);
 
 }
 
@@ -2004,4 +3565,31 @@ CCL_EXPORT
 	return export_options;
 }
 
+/**
+ * Set how host-side transfers are tracked for redundant transfer
+ * analysis. The mode applies to the whole program, and only commands
+ * enqueued while the mode is not ::CCL_PROF_TRANSFER_OFF are analysed.
+ *
+ * @public @memberof ccl_prof
+ *
+ * @param[in] mode How host-side transfers are tracked.
+ * */
+CCL_EXPORT
+void ccl_prof_set_transfer_mode(CCLProfTransferMode mode) {
+	ccl_event_set_mem_tracking((int) mode);
+}
+
+/**
+ * Get how host-side transfers are tracked for redundant transfer
+ * analysis.
+ *
+ * @public @memberof ccl_prof
+ *
+ * @return How host-side transfers are tracked.
+ * */
+CCL_EXPORT
+CCLProfTransferMode ccl_prof_get_transfer_mode() {
+	return (CCLProfTransferMode) ccl_event_get_mem_tracking();
+}
+
 /** @}*/
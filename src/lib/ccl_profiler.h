@@ -88,6 +88,22 @@
  * ::CCLProfOverlap* objects can be iterated over using the
  * ::ccl_prof_iter_overlap_init() and ::ccl_prof_iter_overlap_next()
  * functions.
+ * 5. _Launch scaling fits_: for kernel events launched with
+ * ::ccl_kernel_enqueue_ndrange() (which records the NDRange in the
+ * event), a fit of the event duration against the number of
+ * work-items, represented by the ::CCLProfFit* class, which separates
+ * the fixed per-launch overhead from the per-work-item cost. A
+ * sequence of ::CCLProfFit* objects can be iterated over using the
+ * ::ccl_prof_iter_fit_init() and ::ccl_prof_iter_fit_next() functions,
+ * and a specific fit can be obtained by event name using the
+ * ::ccl_prof_get_fit() function.
+ * 6. _Redundant transfers_: if transfer analysis was enabled with
+ * ::ccl_prof_set_transfer_mode() before the commands were enqueued,
+ * wasted host-device transfers, represented by the ::CCLProfTransfer*
+ * class and aggregated by event name and ::CCLProfTransferKind. A
+ * sequence of ::CCLProfTransfer* objects can be iterated over using the
+ * ::ccl_prof_iter_transfer_init() and ::ccl_prof_iter_transfer_next()
+ * functions.
  *
  * While this information can be subject to different types of
  * examination by client code, the profiler module also offers some
@@ -184,6 +200,37 @@
  * of different types (e.g., aggregate reads and writes into a single
  * "comms" event).
  *
+ * Kernel events can additionally be annotated with the bytes they read
+ * and write and the floating-point operations they perform, using the
+ * ::ccl_event_set_work() function. For annotated events,
+ * ::ccl_prof_calc() determines the arithmetic intensity, whether they
+ * are memory or compute bound, and the fraction of the device's
+ * roofline they attain (see ::CCLProfAgg). This requires the peak
+ * bandwidth and FLOP/s of each device, which are measured with a short
+ * microbenchmark by ::ccl_prof_measure_device_peaks() or given with
+ * ::ccl_prof_set_device_peaks(); otherwise ::ccl_prof_calc() warns and
+ * determines no roofline information for the events. This information
+ * is shown by the summary functions and exported by
+ * ::ccl_prof_export_agg().
+ *
+ * Redundant transfer analysis is enabled for the whole program with
+ * ::ccl_prof_set_transfer_mode(). While enabled, the commands enqueued
+ * through _cf4ocl_ record in their events the memory objects they
+ * access, and host-side buffer reads and writes hash the transferred
+ * data, either fully or by sampling evenly spaced blocks (which is
+ * cheaper, but may mistake different data for identical data). Following
+ * the order in which commands were issued, ::ccl_prof_calc() then flags
+ * writes of data identical to what the device already holds, reads of
+ * data the device did not modify since the host last read or wrote it,
+ * and writes which are overwritten before being read. Kernels are
+ * assumed to only read memory object arguments which were created with
+ * `CL_MEM_READ_ONLY`, or which are passed to `const` pointer or
+ * `read_only` image parameters (this requires OpenCL 1.2, and possibly
+ * building the program with the `-cl-kernel-arg-info` option), and to
+ * read and modify all other memory object arguments. Image regions and
+ * rectangular buffer regions are not tracked, so that transfers are only
+ * flagged when they are certainly wasted.
+ *
  * The @ref ccl_plot_events script can be used to plot a Gantt-like
  * chart of the events which took place in the queues. Running the
  * following command...
@@ -220,6 +267,24 @@ typedef enum {
 } CCLProfSortOrder;
 
 
+/**
+ * Roofline bound of aggregate events, determined from the work annotated
+ * to them with ::ccl_event_set_work().
+ * */
+typedef enum {
+
+	/** Events were not annotated with the work they perform, or the
+	 * peaks of their device are unknown. */
+	CCL_PROF_BOUND_NONE    = 0,
+
+	/** Events are limited by the device's memory bandwidth. */
+	CCL_PROF_BOUND_MEMORY  = 1,
+
+	/** Events are limited by the device's floating-point throughput. */
+	CCL_PROF_BOUND_COMPUTE = 2
+
+} CCLProfBound;
+
 /**
  * Aggregate event info.
  */
@@ -245,6 +310,45 @@ typedef struct ccl_prof_agg {
 	 * */
 	double relative_time;
 
+	/**
+	 * Total bytes read and written by annotated events with name
+	 * equal to ::CCLProfAgg::event_name.
+	 * @public
+	 * */
+	cl_ulong bytes;
+
+	/**
+	 * Total floating-point operations performed by annotated events
+	 * with name equal to ::CCLProfAgg::event_name.
+	 * @public
+	 * */
+	cl_ulong flops;
+
+	/**
+	 * Arithmetic intensity, in floating-point operations per byte, of
+	 * annotated events with name equal to ::CCLProfAgg::event_name.
+	 * Zero if no bytes were annotated.
+	 * @public
+	 * */
+	double intensity;
+
+	/**
+	 * Fraction of the roofline attained by annotated events with name
+	 * equal to ::CCLProfAgg::event_name, i.e. the time these events
+	 * would take running at the device's attainable performance for
+	 * their arithmetic intensity divided by the time they actually
+	 * took. Zero if the peaks of their device are unknown.
+	 * @public
+	 * */
+	double roofline;
+
+	/**
+	 * Whether annotated events with name equal to
+	 * ::CCLProfAgg::event_name are memory or compute bound.
+	 * @public
+	 * */
+	CCLProfBound bound;
+
 } CCLProfAgg;
 
 
@@ -313,6 +417,27 @@ typedef struct ccl_prof_info {
 	 * */
 	cl_ulong t_end;
 
+	/**
+	 * Number of dimensions of the NDRange of kernel events launched with
+	 * ::ccl_kernel_enqueue_ndrange(), 0 for other events.
+	 * @public
+	 * */
+	cl_uint work_dim;
+
+	/**
+	 * Global work size of kernel events (unused dimensions are set to
+	 * 1).
+	 * @public
+	 * */
+	size_t global_work_size[3];
+
+	/**
+	 * Local work size of kernel events, zeros if left to the OpenCL
+	 * implementation.
+	 * @public
+	 * */
+	size_t local_work_size[3];
+
 } CCLProfInfo;
 
 /**
@@ -443,6 +568,156 @@ typedef enum {
 
 } CCLProfOverlapSort;
 
+/**
+ * Fit of the duration of kernel events with a given name against their
+ * number of work-items, `t = overhead + per_item * n`.
+ * */
+typedef struct ccl_prof_fit {
+
+	/**
+	 * Name of events which the fit refers to.
+	 * @public
+	 * */
+	const char* event_name;
+
+	/**
+	 * Number of launches used in the fit.
+	 * @public
+	 * */
+	cl_uint num_launches;
+
+	/**
+	 * Smallest number of work-items of the launches.
+	 * @public
+	 * */
+	size_t min_work_items;
+
+	/**
+	 * Largest number of work-items of the launches.
+	 * @public
+	 * */
+	size_t max_work_items;
+
+	/**
+	 * Fixed per-launch overhead in nanoseconds.
+	 * @public
+	 * */
+	double overhead;
+
+	/**
+	 * Cost per work-item in nanoseconds.
+	 * @public
+	 * */
+	double per_item;
+
+	/**
+	 * Number of work-items at which the per-item cost equals the
+	 * per-launch overhead, zero if the per-item cost is zero. Launches
+	 * much smaller than this are dominated by the overhead, and are
+	 * worth batching.
+	 * @public
+	 * */
+	double break_even;
+
+} CCLProfFit;
+
+/**
+ * Sort criteria for launch scaling fits (::CCLProfFit).
+ */
+typedef enum {
+
+	/** Sort fits by event name. */
+	CCL_PROF_FIT_SORT_NAME     = 0xc0,
+
+	/** Sort fits by per-launch overhead. */
+	CCL_PROF_FIT_SORT_OVERHEAD = 0xd0
+
+} CCLProfFitSort;
+
+/**
+ * How host-side transfers are tracked for redundant transfer analysis.
+ * */
+typedef enum ccl_prof_transfer_mode {
+
+	/** Transfers are not tracked (default). */
+	CCL_PROF_TRANSFER_OFF     = 0,
+
+	/** Transferred data is hashed by sampling evenly spaced blocks. */
+	CCL_PROF_TRANSFER_SAMPLED = 1,
+
+	/** All transferred data is hashed. */
+	CCL_PROF_TRANSFER_FULL    = 2
+
+} CCLProfTransferMode;
+
+/**
+ * Kinds of wasted transfers found by redundant transfer analysis.
+ * */
+typedef enum ccl_prof_transfer_kind {
+
+	/** Write of data identical to what the device already holds. */
+	CCL_PROF_TRANSFER_REDUNDANT   = 0,
+
+	/** Read of data which the device did not modify since the host last
+	 * read or wrote it. */
+	CCL_PROF_TRANSFER_UNMODIFIED  = 1,
+
+	/** Write which is overwritten before being read. */
+	CCL_PROF_TRANSFER_OVERWRITTEN = 2
+
+} CCLProfTransferKind;
+
+/**
+ * Wasted transfers of a given kind performed by events with a given
+ * name.
+ * */
+typedef struct ccl_prof_transfer {
+
+	/**
+	 * Kind of wasted transfers.
+	 * @public
+	 * */
+	CCLProfTransferKind kind;
+
+	/**
+	 * Name of events which performed the transfers.
+	 * @public
+	 * */
+	const char* event_name;
+
+	/**
+	 * Number of wasted transfers.
+	 * @public
+	 * */
+	cl_uint count;
+
+	/**
+	 * Bytes wastefully transferred.
+	 * @public
+	 * */
+	cl_ulong bytes;
+
+	/**
+	 * Time taken by the wasted transfers in nanoseconds.
+	 * @public
+	 * */
+	cl_ulong time;
+
+} CCLProfTransfer;
+
+/**
+ * Sort criteria for wasted transfers (::CCLProfTransfer).
+ */
+typedef enum {
+
+	/** Sort wasted transfers by kind and event name. */
+	CCL_PROF_TRANSFER_SORT_KIND = 0xe0,
+
+	/** Sort wasted transfers by time. */
+	CCL_PROF_TRANSFER_SORT_TIME = 0xf0
+
+} CCLProfTransferSort;
+
 /**
  * Export options.
  * */
@@ -552,6 +827,26 @@ void ccl_prof_iter_overlap_init(CCLProf* prof, int sort);
 CCL_EXPORT
 const CCLProfOverlap* ccl_prof_iter_overlap_next(CCLProf* prof);
 
+/* Return the launch scaling fit for events with the given name. */
+CCL_EXPORT
+const CCLProfFit* ccl_prof_get_fit(CCLProf* prof, const char* event_name);
+
+/* Initialize an iterator for launch scaling fits. */
+CCL_EXPORT
+void ccl_prof_iter_fit_init(CCLProf* prof, int sort);
+
+/* Return the next launch scaling fit. */
+CCL_EXPORT
+const CCLProfFit* ccl_prof_iter_fit_next(CCLProf* prof);
+
+/* Initialize an iterator for wasted transfers. */
+CCL_EXPORT
+void ccl_prof_iter_transfer_init(CCLProf* prof, int sort);
+
+/* Return the next wasted transfers object. */
+CCL_EXPORT
+const CCLProfTransfer* ccl_prof_iter_transfer_next(CCLProf* prof);
+
 /* Get duration of all events in nanoseconds. */
 CCL_EXPORT
 cl_ulong ccl_prof_get_duration(CCLProf* prof);
@@ -561,6 +856,11 @@ cl_ulong ccl_prof_get_duration(CCLProf* prof);
 CCL_EXPORT
 cl_ulong ccl_prof_get_eff_duration(CCLProf* prof);
 
+/* Get the mean and maximum latency of the events of the given queue. */
+CCL_EXPORT
+cl_ulong ccl_prof_get_queue_latency(
+	CCLProf* prof, const char* cq_name, cl_ulong* max_latency);
+
 /* Print a summary of the profiling info. More specifically,
  * this function prints a table of aggregate event statistics (sorted
  * by absolute time), and a table of event overlaps (sorted by overlap
@@ -587,6 +887,44 @@ CCL_EXPORT
 cl_bool ccl_prof_export_info_file(
 	CCLProf* profile, const char* filename, CCLErr** err);
 
+/* Export aggregate event information, including roofline
+ * information, to a given stream. */
+CCL_EXPORT
+cl_bool ccl_prof_export_agg(CCLProf* prof, FILE* stream, CCLErr** err);
+
+/* Helper function which exports aggregate event information to a given
+ * file. */
+CCL_EXPORT
+cl_bool ccl_prof_export_agg_file(
+	CCLProf* prof, const char* filename, CCLErr** err);
+
+/* Get the peak memory bandwidth and floating-point throughput of a
+ * device. */
+CCL_EXPORT
+cl_bool ccl_prof_get_device_peaks(
+	CCLDevice* dev, double* bandwidth, double* flops);
+
+/* Measure the peak memory bandwidth and floating-point throughput of a
+ * device. */
+CCL_EXPORT
+cl_bool ccl_prof_measure_device_peaks(CCLDevice* dev, CCLErr** err);
+
+/* Set the peak memory bandwidth and floating-point throughput of a
+ * device. */
+CCL_EXPORT
+void ccl_prof_set_device_peaks(
+	CCLDevice* dev, double bandwidth, double flops);
+
+/* Set how host-side transfers are tracked for redundant transfer
+ * analysis. */
+CCL_EXPORT
+void ccl_prof_set_transfer_mode(CCLProfTransferMode mode);
+
+/* Get how host-side transfers are tracked for redundant transfer
+ * analysis. */
+CCL_EXPORT
+CCLProfTransferMode ccl_prof_get_transfer_mode();
+
 /* Set export options using a ::CCLProfExportOptions struct. */
 CCL_EXPORT
 void ccl_prof_set_export_opts(CCLProfExportOptions export_opts);
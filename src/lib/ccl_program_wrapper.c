@@ -27,6 +27,8 @@
  * */
 
 #include "ccl_program_wrapper.h"
+#include "ccl_buffer_wrapper.h"
+#include "_ccl_program_wrapper.h"
 #include "_ccl_abstract_dev_container_wrapper.h"
 #include "_ccl_defs.h"
 
@@ -34,6 +36,18 @@
 #define CCL_VALIDFILECHARS "abcdefghijklmnopqrstuvwxyzABCDEFGH" \
 	"IJKLMNOPQRSTUVWXYZ0123456789_."
 
+/* Size in bytes of the scratch buffer passed to global and constant
+ * kernel arguments when pre-warming kernels. */
+#define CCL_PROGRAM_PREWARM_SCRATCH 4096
+
+/* Size in bytes of local memory passed to local kernel arguments when
+ * pre-warming kernels. */
+#define CCL_PROGRAM_PREWARM_LOCAL 256
+
+/* Largest private kernel argument, in bytes, which can be derived when
+ * pre-warming kernels (a 16-component vector of 8-byte scalars). */
+#define CCL_PROGRAM_PREWARM_PRIV_MAX 128
+
 /**
  * Program wrapper class.
  *
@@ -1673,8 +1687,8 @@ CCLEvent* ccl_program_enqueue_kernel(CCLProgram* prg,
  * before this command can be executed. The list will be cleared and
  * can be reused by client code.
  * @param[in] args A `NULL`-terminated array of arguments to set.
- * Arguments must be of type ::CCLArg*, ::CCLBuffer*, ::CCLImage* or
- * ::CCLSampler*.
+ * Arguments must be of type ::CCLArg*, ::CCLBuffer*, ::CCLImage*,
+ * ::CCLSampler* or ::CCLQueue* (on-device queues only).
  * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
  * reporting is to be ignored.
  * @return Event wrapper object that identifies this command.
@@ -1701,6 +1715,387 @@ CCLEvent* ccl_program_enqueue_kernel_v(CCLProgram* prg,
 	return evt;
 }
 
+/**
+ * @internal
+ * Determine the size of a private kernel argument from its OpenCL C
+ * type name, as given by the `CL_KERNEL_ARG_TYPE_NAME` argument
+ * information parameter.
+ *
+ * @private @memberof ccl_program
+ *
+ * @param[in] type_name OpenCL C type name, e.g. `uint` or `float4`.
+ * @return Size in bytes of the argument, or 0 if the type is not a
+ * built-in scalar or vector type.
+ * */
+size_t ccl_program_prewarm_arg_size(const char* type_name) {
+
+	/* Built-in scalar types and their sizes. */
+	static const struct { const char* name; size_t size; } scalars[] = {
+		{ "char", 1 }, { "uchar", 1 }, { "short", 2 }, { "ushort", 2 },
+		{ "half", 2 }, { "int", 4 }, { "uint", 4 }, { "float", 4 },
+		{ "long", 8 }, { "ulong", 8 }, { "double", 8 } };
+
+	/* Vector width and end of vector suffix. */
+	guint64 width;
+	char* end;
+
+	/* Type name with unsigned types in short form. */
+	char short_name[32];
+
+	/* Some implementations spell out unsigned types. */
+	if (g_str_has_prefix(type_name, "unsigned ")) {
+		g_snprintf(short_name, sizeof(short_name), "u%s",
+			type_name + strlen("unsigned "));
+		type_name = short_name;
+	}
+
+	for (guint i = 0; i < G_N_ELEMENTS(scalars); ++i) {
+
+		/* Does the type name start with this scalar type name? */
+		size_t len = strlen(scalars[i].name);
+		const char* suffix = type_name + len;
+		if (strncmp(type_name, scalars[i].name, len)) continue;
+
+		/* Scalar type. */
+		if (*suffix == '\0') return scalars[i].size;
+
+		/* Vector type, three-component vectors take as much space as
+		 * four-component ones. */
+		if ((*suffix < '1') || (*suffix > '9')) continue;
+		width = g_ascii_strtoull(suffix, &end, 10);
+		if (*end != '\0') continue;
+		if ((width == 2) || (width == 4) || (width == 8) || (width == 16))
+			return scalars[i].size * width;
+		if (width == 3)
+			return scalars[i].size * 4;
+
+	}
+
+	/* Not a built-in scalar or vector type. */
+	return 0;
+
+}
+
+/**
+ * @internal
+ * Pre-warm a kernel, launching it once with minimal geometry and
+ * scratch arguments.
+ *
+ * @private @memberof ccl_program
+ *
+ * @param[in] prg The program wrapper object.
+ * @param[in] cq Throwaway command queue where to launch the kernel.
+ * @param[in] scratch Scratch buffer for global and constant arguments.
+ * @param[in] kernel_name Name of kernel function.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return Time in seconds taken to create the kernel and complete its
+ * first launch, or a negative value if the kernel arguments could not be
+ * derived or an error occurred.
+ * */
+static double ccl_program_prewarm_kernel(CCLProgram* prg, CCLQueue* cq,
+	CCLBuffer* scratch, const char* kernel_name, CCLErr** err) {
+
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, -1.0);
+
+	/* Kernel wrapper, distinct from the one kept by the program so that
+	 * the arguments set by client code are left untouched. */
+	CCLKernel* krnl = NULL;
+	/* Kernel launch event and wait list. */
+	CCLEvent* evt;
+	CCLEventWaitList ewl = NULL;
+	/* Launch geometry. */
+	cl_uint work_dim = 1;
+	size_t gws[3] = { 1, 1, 1 };
+	size_t* reqd_lws;
+	const size_t* lws = NULL;
+	/* Zeroed bytes for private arguments. */
+	cl_ulong zeros[CCL_PROGRAM_PREWARM_PRIV_MAX / sizeof(cl_ulong)] = { 0 };
+	/* Number of kernel arguments. */
+	cl_uint num_args;
+	/* Start time, in microseconds. */
+	gint64 t_start;
+	/* Warm-up cost. */
+	double cost = -1.0;
+	/* Device where the kernel is launched. */
+	CCLDevice* dev;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Lazy finalization may happen when the kernel object is created or
+	 * when it is first launched, so time both. */
+	t_start = g_get_monotonic_time();
+
+	/* Create kernel. */
+	krnl = ccl_kernel_new(prg, kernel_name, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Get number of arguments. */
+	num_args = ccl_kernel_get_info_scalar(
+		krnl, CL_KERNEL_NUM_ARGS, cl_uint, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Derive a scratch value for each argument from its address space
+	 * and type. */
+	for (cl_uint i = 0; i < num_args; ++i) {
+
+#ifdef CL_VERSION_1_2
+
+		CCLWrapperInfo* info;
+		cl_kernel_arg_address_qualifier addr;
+		const char* type_name;
+		size_t size;
+
+		/* Argument information may be unavailable, e.g. on platforms
+		 * older than OpenCL 1.2 or when the program was not built with
+		 * -cl-kernel-arg-info. Skip the kernel in that case. */
+		info = ccl_kernel_get_arg_info(
+			krnl, i, CL_KERNEL_ARG_ADDRESS_QUALIFIER, &err_internal);
+		if (info == NULL) goto skip;
+		addr = *((cl_kernel_arg_address_qualifier*) info->value);
+		info = ccl_kernel_get_arg_info(
+			krnl, i, CL_KERNEL_ARG_TYPE_NAME, &err_internal);
+		if (info == NULL) goto skip;
+		type_name = (const char*) info->value;
+
+		switch (addr) {
+			case CL_KERNEL_ARG_ADDRESS_GLOBAL:
+			case CL_KERNEL_ARG_ADDRESS_CONSTANT:
+				/* Only buffers can be derived, not images or pipes. */
+				if (!g_str_has_suffix(type_name, "*")) goto skip;
+				ccl_kernel_set_arg(krnl, i, scratch);
+				break;
+			case CL_KERNEL_ARG_ADDRESS_LOCAL:
+				ccl_kernel_set_arg(krnl, i,
+					ccl_arg_local(CCL_PROGRAM_PREWARM_LOCAL, cl_uchar));
+				break;
+			default:
+				/* Only built-in scalar and vector types can be derived,
+				 * not samplers, structures or other types. */
+				size = ccl_program_prewarm_arg_size(type_name);
+				if (size == 0) goto skip;
+				ccl_kernel_set_arg(krnl, i, ccl_arg_full(zeros, size));
+		}
+
+#else
+
+		/* Argument information is not available. */
+		goto skip;
+
+#endif
+
+	}
+
+	/* Honor a required work-group size, if any. */
+	dev = ccl_queue_get_device(cq, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	reqd_lws = ccl_kernel_get_workgroup_info_array(krnl, dev,
+		CL_KERNEL_COMPILE_WORK_GROUP_SIZE, size_t*, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	if (reqd_lws[0] > 0) {
+		work_dim = 3;
+		for (cl_uint d = 0; d < 3; ++d)
+			gws[d] = MAX(reqd_lws[d], 1);
+		lws = gws;
+	}
+
+	/* Launch kernel and wait for it to complete. */
+	evt = ccl_kernel_enqueue_ndrange(krnl, cq, work_dim, NULL, gws, lws,
+		NULL, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	ccl_event_wait(ccl_ewl(&ewl, evt, NULL), &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Determine warm-up cost. */
+	cost = (g_get_monotonic_time() - t_start) / 1e6;
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+skip:
+
+	/* Kernel arguments could not be derived, this is not an error. */
+	g_clear_error(&err_internal);
+	g_debug("Kernel '%s' not pre-warmed, its arguments could not be "
+		"derived.", kernel_name);
+	goto finish;
+
+error_handler:
+
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+finish:
+
+	/* Release kernel. */
+	if (krnl != NULL) ccl_kernel_destroy(krnl);
+
+	/* Return warm-up cost. */
+	return cost;
+
+}
+
+/**
+ * Pre-warm the kernels of a built program, removing the latency of lazy
+ * kernel finalization from their first real launch. On several drivers,
+ * the first launch of each kernel triggers a just-in-time finalization
+ * step which can take several milliseconds.
+ *
+ * Each kernel is created and launched once on a throwaway command queue
+ * for the given device, with minimal geometry (a single work-item, or a
+ * single work-group if the kernel requires a specific work-group size).
+ * Scratch arguments are derived from the kernel argument information:
+ * global and constant pointers get a small zeroed buffer, local pointers
+ * a small local memory allocation, and built-in scalar and vector types
+ * zeroed values. Kernels whose arguments cannot be derived (e.g. images,
+ * samplers or structures, or when argument information is unavailable)
+ * are skipped. Kernel argument information requires OpenCL 1.2 and, on
+ * some implementations, that the program is built with the
+ * `-cl-kernel-arg-info` option. Kernel wrappers kept by the program are
+ * not used, so their arguments remain untouched.
+ *
+ * Kernels are launched with zeroed arguments, so they should not
+ * misbehave (e.g. loop forever) in that case.
+ *
+ * @public @memberof ccl_program
+ *
+ * @param[in] prg The program wrapper object, which must be built.
+ * @param[in] dev Device where to pre-warm kernels. If `NULL`, the first
+ * device associated with the program is used.
+ * @param[in] kernel_names `NULL`-terminated list of names of the kernels
+ * to pre-warm. If `NULL`, all the kernels in the program are pre-warmed,
+ * which requires OpenCL 1.2.
+ * @param[in] callback Function called after each kernel is pre-warmed,
+ * receiving its warm-up cost in seconds, or a negative cost if the kernel
+ * was skipped. Can be `NULL`.
+ * @param[in] user_data Data passed to `callback`.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return ::CL_TRUE if the operation was successful, ::CL_FALSE
+ * otherwise.
+ * */
+CCL_EXPORT
+cl_bool ccl_program_prewarm(CCLProgram* prg, CCLDevice* dev,
+	const char** kernel_names, ccl_program_prewarm_callback callback,
+	void* user_data, CCLErr** err) {
+
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, CL_FALSE);
+	/* Make sure prg is not NULL. */
+	g_return_val_if_fail(prg != NULL, CL_FALSE);
+
+	/* Context, throwaway queue and scratch buffer. */
+	cl_context context;
+	CCLContext* ctx = NULL;
+	CCLQueue* cq = NULL;
+	CCLBuffer* scratch = NULL;
+	void* scratch_host = NULL;
+	/* All kernel names in program, if none were given. */
+	char** all_names = NULL;
+	/* Warm-up cost of current kernel. */
+	double cost;
+	/* Function return status. */
+	cl_bool status;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Use first device in program if none was given. */
+	if (dev == NULL) {
+		dev = ccl_program_get_device(prg, 0, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+	}
+
+	/* If no kernel names were given, get all kernels in program. */
+	if (kernel_names == NULL) {
+
+#ifdef CL_VERSION_1_2
+
+		cl_uint ocl_ver;
+		const char* names;
+
+		ocl_ver = ccl_program_get_opencl_version(prg, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+		g_if_err_create_goto(*err, CCL_ERROR, ocl_ver < 120,
+			CCL_ERROR_UNSUPPORTED_OCL, error_handler,
+			"%s: listing the kernels in a program requires OpenCL version "
+			"1.2 or newer.", CCL_STRD);
+
+		names = ccl_program_get_info_array(
+			prg, CL_PROGRAM_KERNEL_NAMES, char*, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+		all_names = g_strsplit(names, ";", -1);
+		kernel_names = (const char**) all_names;
+
+#else
+
+		g_if_err_create_goto(*err, CCL_ERROR, CL_TRUE,
+			CCL_ERROR_UNSUPPORTED_OCL, error_handler,
+			"%s: listing the kernels in a program requires cf4ocl to be "
+			"deployed with support for OpenCL version 1.2 or newer.",
+			CCL_STRD);
+
+#endif
+
+	}
+
+	/* Get program context. */
+	context = ccl_program_get_info_scalar(
+		prg, CL_PROGRAM_CONTEXT, cl_context, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	ctx = ccl_context_new_wrap(context);
+
+	/* Create throwaway queue. */
+	cq = ccl_queue_new(ctx, dev, 0, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Create zeroed scratch buffer. */
+	scratch_host = g_malloc0(CCL_PROGRAM_PREWARM_SCRATCH);
+	scratch = ccl_buffer_new(ctx, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+		CCL_PROGRAM_PREWARM_SCRATCH, scratch_host, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Pre-warm kernels. */
+	for (guint i = 0; kernel_names[i] != NULL; ++i) {
+
+		/* Skip empty names, e.g. of programs without kernels. */
+		if (*kernel_names[i] == '\0') continue;
+
+		cost = ccl_program_prewarm_kernel(
+			prg, cq, scratch, kernel_names[i], &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		if (callback != NULL)
+			callback(kernel_names[i], cost, user_data);
+
+	}
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	status = CL_TRUE;
+	goto finish;
+
+error_handler:
+
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	status = CL_FALSE;
+
+finish:
+
+	/* Release temporary objects. */
+	if (scratch != NULL) ccl_buffer_destroy(scratch);
+	if (scratch_host != NULL) g_free(scratch_host);
+	if (cq != NULL) ccl_queue_destroy(cq);
+	if (ctx != NULL) ccl_context_unref(ctx);
+	if (all_names != NULL) g_strfreev(all_names);
+
+	/* Return status. */
+	return status;
+
+}
+
 /**
  * @internal
  * Load the program binaries into the binaries table of the program
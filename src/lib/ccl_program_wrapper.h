@@ -206,6 +206,20 @@ typedef struct ccl_program_binary CCLProgramBinary;
 typedef void (CL_CALLBACK* ccl_program_callback)(
 	cl_program program, void* user_data);
 
+/**
+ * Prototype of callback functions which receive the warm-up cost of
+ * kernels pre-warmed with ::ccl_program_prewarm().
+ *
+ * @public @memberof ccl_program
+ *
+ * @param[in] kernel_name Name of kernel function.
+ * @param[in] cost Time in seconds taken to create the kernel and complete
+ * its first launch, or a negative value if the kernel was skipped.
+ * @param[in] user_data A pointer to user supplied data.
+ * */
+typedef void (*ccl_program_prewarm_callback)(
+	const char* kernel_name, double cost, void* user_data);
+
 /* *********** */
 /* WRAPPER API */
 /* *********** */
@@ -366,6 +380,12 @@ CCLEvent* ccl_program_enqueue_kernel_v(CCLProgram* prg,
 	const size_t* local_work_size, CCLEventWaitList* evt_wait_lst,
 	void** args, CCLErr** err);
 
+/* Pre-warm the kernels of a built program. */
+CCL_EXPORT
+cl_bool ccl_program_prewarm(CCLProgram* prg, CCLDevice* dev,
+	const char** kernel_names, ccl_program_prewarm_callback callback,
+	void* user_data, CCLErr** err);
+
 /* ************************* */
 /* BINARY HANDLING FUNCTIONS */
 /* ************************* */
@@ -566,7 +586,7 @@ CCLDevice* const* ccl_program_get_all_devices(CCLProgram* prg,
  * @return The OpenCL program object.
  * */
 #define ccl_program_unwrap(prg) \
-	((cl_program) ccl_wrapper_unwrap((CCLWrapper*) prg))
+	((cl_program) ccl_wrapper_unwrap_inline((CCLWrapper*) prg))
 
 /** @} */
 
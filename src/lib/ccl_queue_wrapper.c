@@ -27,6 +27,7 @@
  * */
 
 #include "ccl_queue_wrapper.h"
+#include "_ccl_queue_wrapper.h"
 #include "_ccl_abstract_wrapper.h"
 #include "_ccl_defs.h"
 
@@ -67,8 +68,295 @@ struct ccl_queue {
 	 * */
 	GHashTableIter evt_iter;
 
+	/**
+	 * Quality-of-service class.
+	 * @private
+	 * */
+	CCLQueueQoS qos;
+
+	/**
+	 * Is the quality-of-service class mapped to device priority hints?
+	 * @private
+	 * */
+	cl_bool qos_hints;
+
+	/**
+	 * Maximum number of commands in flight (zero if unlimited).
+	 * @private
+	 * */
+	cl_uint inflight_max_cmds;
+
+	/**
+	 * Maximum number of bytes in flight (zero if unlimited).
+	 * @private
+	 * */
+	size_t inflight_max_bytes;
+
+	/**
+	 * Block when the in-flight limit is reached (otherwise fail)?
+	 * @private
+	 * */
+	cl_bool inflight_blocking;
+
+	/**
+	 * Commands in flight (::ccl_queue_inflight objects).
+	 * @private
+	 * */
+	GQueue* inflight;
+
+	/**
+	 * Number of bytes in flight.
+	 * @private
+	 * */
+	size_t inflight_bytes;
+
+	/**
+	 * Number of bytes of the command about to be enqueued.
+	 * @private
+	 * */
+	size_t inflight_next_bytes;
+
+	/**
+	 * Number of enqueue calls which had to wait for room.
+	 * @private
+	 * */
+	cl_ulong num_throttled;
+
+	/**
+	 * Number of enqueue calls which failed for lack of room.
+	 * @private
+	 * */
+	cl_ulong num_would_block;
+
+	/**
+	 * Time spent waiting for room, in microseconds.
+	 * @private
+	 * */
+	gint64 time_throttled;
+
 };
 
+/**
+ * @internal
+ * A command in flight in a queue with an in-flight limit.
+ * */
+struct ccl_queue_inflight {
+
+	/**
+	 * OpenCL event associated with the command.
+	 * @private
+	 * */
+	cl_event event;
+
+	/**
+	 * Number of bytes transferred by the command.
+	 * @private
+	 * */
+	size_t bytes;
+
+};
+
+/**
+ * @internal
+ * Release a command in flight.
+ *
+ * @param[in] cmd Command in flight.
+ * */
+static void ccl_queue_inflight_destroy(struct ccl_queue_inflight* cmd) {
+
+	clReleaseEvent(cmd->event);
+	g_slice_free(struct ccl_queue_inflight, cmd);
+
+}
+
+/**
+ * @internal
+ * Remove completed commands from the in-flight list of the given queue.
+ *
+ * @param[in] cq The command queue wrapper object.
+ * */
+static void ccl_queue_inflight_prune(CCLQueue* cq) {
+
+	/* Command execution status. */
+	cl_int exec_status;
+	/* OpenCL status flag. */
+	cl_int ocl_status;
+
+	if (cq->inflight == NULL) return;
+
+	for (GList* link = cq->inflight->head; link != NULL; ) {
+
+		struct ccl_queue_inflight* cmd =
+			(struct ccl_queue_inflight*) link->data;
+		GList* next = link->next;
+
+		ocl_status = clGetEventInfo(cmd->event,
+			CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(cl_int),
+			&exec_status, NULL);
+
+		/* Completed or failed commands are no longer in flight. */
+		if ((ocl_status != CL_SUCCESS) || (exec_status <= CL_COMPLETE)) {
+			cq->inflight_bytes -= cmd->bytes;
+			ccl_queue_inflight_destroy(cmd);
+			g_queue_delete_link(cq->inflight, link);
+		}
+
+		link = next;
+	}
+}
+
+/**
+ * @internal
+ * Is there room in the in-flight window of the queue for a command which
+ * transfers the given number of bytes? A command larger than the byte limit
+ * is accepted when no other bytes are in flight.
+ *
+ * @param[in] cq The command queue wrapper object.
+ * @param[in] bytes Number of bytes transferred by the command.
+ * @return `CL_TRUE` if the command fits, `CL_FALSE` otherwise.
+ * */
+static cl_bool ccl_queue_inflight_fits(CCLQueue* cq, size_t bytes) {
+
+	cl_uint cmds = cq->inflight != NULL ? cq->inflight->length : 0;
+
+	if ((cq->inflight_max_cmds > 0) && (cmds >= cq->inflight_max_cmds))
+		return CL_FALSE;
+	if ((cq->inflight_max_bytes > 0) && (cq->inflight_bytes > 0)
+		&& (cq->inflight_bytes + bytes > cq->inflight_max_bytes))
+		return CL_FALSE;
+	return CL_TRUE;
+
+}
+
+/* Outstanding commands of high priority queues for which no device priority
+ * hints are available, per device (cl_device_id -> GPtrArray of cl_event). */
+static GHashTable* qos_pending = NULL;
+
+/* Access to the qos_pending table should be thread-safe. */
+G_LOCK_DEFINE_STATIC(qos_pending);
+
+/**
+ * @internal
+ * Release and remove completed commands from an array of outstanding
+ * high priority commands. Must be called with the `qos_pending` lock held.
+ *
+ * @param[in] evts Array of outstanding OpenCL events.
+ * */
+static void ccl_queue_qos_prune(GPtrArray* evts) {
+
+	/* Command execution status. */
+	cl_int exec_status;
+	/* OpenCL status flag. */
+	cl_int ocl_status;
+
+	for (guint i = 0; i < evts->len; ) {
+
+		cl_event event = (cl_event) g_ptr_array_index(evts, i);
+
+		ocl_status = clGetEventInfo(event,
+			CL_EVENT_COMMAND_EXECUTION_STATUS, sizeof(cl_int),
+			&exec_status, NULL);
+
+		/* Completed or failed commands are no longer outstanding. */
+		if ((ocl_status != CL_SUCCESS) || (exec_status <= CL_COMPLETE)) {
+			clReleaseEvent(event);
+			g_ptr_array_remove_index_fast(evts, i);
+		} else {
+			++i;
+		}
+	}
+}
+
+/**
+ * @internal
+ * Keep track of a command enqueued on a high priority queue for which no
+ * device priority hints are available, so that low priority queues on the
+ * same device can be held back while it is outstanding.
+ *
+ * @param[in] cq A high priority command queue wrapper object.
+ * @param[in] event OpenCL event associated with the command.
+ * */
+static void ccl_queue_qos_track(CCLQueue* cq, cl_event event) {
+
+	/* Device of the command queue. */
+	cl_device_id dev = ccl_device_unwrap(cq->dev);
+	/* Outstanding commands on the device. */
+	GPtrArray* evts;
+
+	G_LOCK(qos_pending);
+
+	/* Initialize table if required. */
+	if (qos_pending == NULL)
+		qos_pending = g_hash_table_new(g_direct_hash, g_direct_equal);
+
+	/* Get or create array of outstanding commands for device. */
+	evts = (GPtrArray*) g_hash_table_lookup(qos_pending, dev);
+	if (evts == NULL) {
+		evts = g_ptr_array_new();
+		g_hash_table_insert(qos_pending, dev, evts);
+	}
+
+	/* Discard completed commands and add the new one. */
+	ccl_queue_qos_prune(evts);
+	clRetainEvent(event);
+	g_ptr_array_add(evts, event);
+
+	G_UNLOCK(qos_pending);
+
+}
+
+/**
+ * @internal
+ * Stop tracking the commands of a high priority queue which is being
+ * released.
+ *
+ * @param[in] cq A high priority command queue wrapper object.
+ * */
+static void ccl_queue_qos_forget(CCLQueue* cq) {
+
+	/* Device of the command queue. */
+	cl_device_id dev = ccl_device_unwrap(cq->dev);
+	/* Outstanding commands on the device. */
+	GPtrArray* evts;
+	/* Command queue of an outstanding command. */
+	cl_command_queue queue;
+
+	G_LOCK(qos_pending);
+
+	evts = qos_pending != NULL
+		? (GPtrArray*) g_hash_table_lookup(qos_pending, dev)
+		: NULL;
+
+	if (evts != NULL) {
+
+		/* Remove commands belonging to the given queue. */
+		for (guint i = 0; i < evts->len; ) {
+			cl_event event = (cl_event) g_ptr_array_index(evts, i);
+			if ((clGetEventInfo(event, CL_EVENT_COMMAND_QUEUE,
+				sizeof(cl_command_queue), &queue, NULL) != CL_SUCCESS)
+				|| (queue == ccl_queue_unwrap(cq))) {
+				clReleaseEvent(event);
+				g_ptr_array_remove_index_fast(evts, i);
+			} else {
+				++i;
+			}
+		}
+
+		/* Release array and table if they're empty. */
+		if (evts->len == 0) {
+			g_hash_table_remove(qos_pending, dev);
+			g_ptr_array_free(evts, TRUE);
+			if (g_hash_table_size(qos_pending) == 0) {
+				g_hash_table_destroy(qos_pending);
+				qos_pending = NULL;
+			}
+		}
+	}
+
+	G_UNLOCK(qos_pending);
+
+}
+
 /**
  * @internal
  * Implementation of ccl_wrapper_release_fields() function for
@@ -87,13 +375,23 @@ static void ccl_queue_release_fields(CCLQueue* cq) {
 	 * they're set. */
 	 if (cq->ctx != NULL)
 		ccl_context_unref(cq->ctx);
-	 if (cq->dev != NULL)
+	 if (cq->dev != NULL) {
+		/* Stop tracking host-scheduled high priority commands. */
+		if ((cq->qos == CCL_QUEUE_QOS_HIGH) && (!cq->qos_hints))
+			ccl_queue_qos_forget(cq);
 		ccl_device_unref(cq->dev);
+	 }
 
 	/* Destroy the events table. */
 	if (cq->evts != NULL) {
 		g_hash_table_destroy(cq->evts);
 	}
+
+	/* Release commands in flight. */
+	if (cq->inflight != NULL) {
+		g_queue_free_full(cq->inflight,
+			(GDestroyNotify) ccl_queue_inflight_destroy);
+	}
 }
 
 /**
@@ -340,6 +638,286 @@ CCLQueue* ccl_queue_new(CCLContext* ctx, CCLDevice* dev,
 
 }
 
+/**
+ * Create a new command queue wrapper object with the given quality-of-service
+ * class.
+ *
+ * High and low priority classes are mapped to the `CL_QUEUE_PRIORITY_KHR`
+ * and `CL_QUEUE_THROTTLE_KHR` queue properties if the device supports the
+ * `cl_khr_priority_hints` and `cl_khr_throttle_hints` extensions,
+ * respectively, and the platform supports OpenCL >= 2.0 (required for
+ * passing these properties). If priority hints are not available, a host-side
+ * scheduler is used instead: kernel launches on low priority queues are held
+ * back until commands previously enqueued on high priority queues of the
+ * same device complete. Whether device priority hints are used can be checked
+ * with ::ccl_queue_get_qos_hints().
+ *
+ * To compare latency between classes, add each queue to a profiler object
+ * under the name of its class and use ::ccl_prof_get_queue_latency().
+ *
+ * **Usage example**
+ *
+ * @code{.c}
+ * CCLQueue* cq_rt = ccl_queue_new_qos(ctx, dev, CL_QUEUE_PROFILING_ENABLE,
+ *     CCL_QUEUE_QOS_HIGH, &err);
+ * CCLQueue* cq_bg = ccl_queue_new_qos(ctx, dev, CL_QUEUE_PROFILING_ENABLE,
+ *     CCL_QUEUE_QOS_LOW, &err);
+ * @endcode
+ *
+ * @public @memberof ccl_queue
+ *
+ * @param[in] ctx Context wrapper object.
+ * @param[in] dev Device wrapper object, must be associated with `ctx`. If
+ * `NULL`, the first device in the context is used.
+ * @param[in] properties Bitfield of command queue properties.
+ * @param[in] qos Quality-of-service class of the queue.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return The ::CCLQueue wrapper for the given device and context,
+ * or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLQueue* ccl_queue_new_qos(CCLContext* ctx, CCLDevice* dev,
+	cl_command_queue_properties properties, CCLQueueQoS qos, CCLErr** err) {
+
+	/* Make sure ctx is not NULL. */
+	g_return_val_if_fail(ctx != NULL, NULL);
+	/* Make sure qos is a valid class. */
+	g_return_val_if_fail(qos <= CCL_QUEUE_QOS_LOW, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* The command queue wrapper object. */
+	CCLQueue* cq = NULL;
+	/* Internal error object. */
+	CCLErr* err_internal = NULL;
+	/* Queue properties, including priority and throttle hints. */
+	cl_queue_properties prop_full[7];
+	/* Number of queue property values. */
+	cl_uint num_props = 0;
+	/* Were device priority hints used? */
+	cl_bool hints = CL_FALSE;
+
+	/* If dev is NULL, get first device in context. */
+	if (dev == NULL) {
+		dev = ccl_context_get_device(ctx, 0, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+	}
+
+	/* Regular queue properties. */
+	prop_full[num_props++] = CL_QUEUE_PROPERTIES;
+	prop_full[num_props++] = properties;
+
+#if defined(CL_VERSION_2_0) && defined(CL_QUEUE_PRIORITY_KHR)
+
+	/* Determine if hints can be passed to the device. */
+	if (qos != CCL_QUEUE_QOS_NORMAL) {
+
+		/* OpenCL platform version of the given context. */
+		cl_uint platf_ver;
+		/* Device extensions. */
+		char* exts;
+
+		/* Hints are queue properties, which require OpenCL >= 2.0. */
+		platf_ver = ccl_context_get_opencl_version(ctx, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		if (platf_ver >= 200) {
+
+			exts = ccl_device_get_info_array(
+				dev, CL_DEVICE_EXTENSIONS, char*, &err_internal);
+			g_if_err_propagate_goto(err, err_internal, error_handler);
+
+			/* Priority hints. */
+			if (strstr(exts, "cl_khr_priority_hints") != NULL) {
+				prop_full[num_props++] = CL_QUEUE_PRIORITY_KHR;
+				prop_full[num_props++] = qos == CCL_QUEUE_QOS_HIGH
+					? CL_QUEUE_PRIORITY_HIGH_KHR
+					: CL_QUEUE_PRIORITY_LOW_KHR;
+				hints = CL_TRUE;
+			}
+
+#ifdef CL_QUEUE_THROTTLE_KHR
+			/* Throttle hints. */
+			if (strstr(exts, "cl_khr_throttle_hints") != NULL) {
+				prop_full[num_props++] = CL_QUEUE_THROTTLE_KHR;
+				prop_full[num_props++] = qos == CCL_QUEUE_QOS_HIGH
+					? CL_QUEUE_THROTTLE_HIGH_KHR
+					: CL_QUEUE_THROTTLE_LOW_KHR;
+			}
+#endif
+
+		}
+	}
+
+#endif
+
+	/* Terminate properties list. */
+	prop_full[num_props] = 0;
+
+	/* Create queue. */
+	cq = ccl_queue_new_full(ctx, dev, prop_full, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Keep quality-of-service class. */
+	cq->qos = qos;
+	cq->qos_hints = hints;
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+finish:
+
+	/* Return the new command queue wrapper object. */
+	return cq;
+
+}
+
+/**
+ * Create a new on-device command queue wrapper object, i.e. a queue to
+ * which kernels running on the device can enqueue child kernels (device-side
+ * enqueue). Requires OpenCL >= 2.0.
+ *
+ * On-device queues are always out-of-order. If `is_default` is true, the
+ * queue becomes the device's default on-device queue, which is the queue
+ * returned by `get_default_queue()` in kernel code. On-device queues can be
+ * passed directly as `queue_t` kernel arguments, e.g. with
+ * ::ccl_kernel_set_arg() or ::ccl_kernel_set_args().
+ *
+ * **Usage example**
+ *
+ * @code{.c}
+ * CCLQueue* dq = ccl_queue_new_on_device(ctx, dev, 0, 0, CL_TRUE, &err);
+ * ...
+ * ccl_kernel_set_args_and_enqueue_ndrange(krnl, cq, 1, NULL, &gws, &lws,
+ *     NULL, &err, buf, dq, NULL);
+ * @endcode
+ *
+ * @public @memberof ccl_queue
+ *
+ * @param[in] ctx Context wrapper object.
+ * @param[in] dev Device wrapper object, must be associated with `ctx`. If
+ * `NULL`, the first device in the context is used.
+ * @param[in] properties Additional command queue properties (e.g.
+ * `CL_QUEUE_PROFILING_ENABLE`).
+ * @param[in] size Size hint for the queue in bytes. If zero, the device
+ * preferred size (`CL_DEVICE_QUEUE_ON_DEVICE_PREFERRED_SIZE`) is used. Must
+ * not be larger than `CL_DEVICE_QUEUE_ON_DEVICE_MAX_SIZE`.
+ * @param[in] is_default Create the default on-device queue?
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return The on-device ::CCLQueue wrapper, or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLQueue* ccl_queue_new_on_device(CCLContext* ctx, CCLDevice* dev,
+	cl_command_queue_properties properties, cl_uint size,
+	cl_bool is_default, CCLErr** err) {
+
+	/* Make sure ctx is not NULL. */
+	g_return_val_if_fail(ctx != NULL, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* The command queue wrapper object. */
+	CCLQueue* cq = NULL;
+	/* Internal error object. */
+	CCLErr* err_internal = NULL;
+
+#ifndef CL_VERSION_2_0
+
+	CCL_UNUSED(dev);
+	CCL_UNUSED(properties);
+	CCL_UNUSED(size);
+	CCL_UNUSED(is_default);
+	CCL_UNUSED(err_internal);
+
+	/* If cf4ocl was not compiled with support for OpenCL >= 2.0, always throw
+	 * error. */
+	g_if_err_create_goto(*err, CCL_ERROR, TRUE,
+		CCL_ERROR_UNSUPPORTED_OCL, error_handler,
+		"%s: On-device queues require cf4ocl to be deployed with "
+		"support for OpenCL version 2.0 or newer.",
+		CCL_STRD);
+
+#else
+
+	/* OpenCL version of the context platform and of the device. */
+	cl_uint ocl_ver;
+	/* Maximum on-device queue size. */
+	cl_uint max_size;
+
+	/* If dev is NULL, get first device in context. */
+	if (dev == NULL) {
+		dev = ccl_context_get_device(ctx, 0, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+	}
+
+	/* Check that context platform is >= OpenCL 2.0. */
+	ocl_ver = ccl_context_get_opencl_version(ctx, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	g_if_err_create_goto(*err, CCL_ERROR, ocl_ver < 200,
+		CCL_ERROR_UNSUPPORTED_OCL, error_handler,
+		"%s: On-device queues require OpenCL version 2.0 or newer.",
+		CCL_STRD);
+
+	/* Check that device is >= OpenCL 2.0. */
+	ocl_ver = ccl_device_get_opencl_version(dev, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	g_if_err_create_goto(*err, CCL_ERROR, ocl_ver < 200,
+		CCL_ERROR_UNSUPPORTED_OCL, error_handler,
+		"%s: On-device queues require an OpenCL 2.0 or newer device.",
+		CCL_STRD);
+
+	/* Determine queue size. */
+	max_size = ccl_device_get_info_scalar(dev,
+		CL_DEVICE_QUEUE_ON_DEVICE_MAX_SIZE, cl_uint, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	if (size == 0) {
+		size = ccl_device_get_info_scalar(dev,
+			CL_DEVICE_QUEUE_ON_DEVICE_PREFERRED_SIZE, cl_uint,
+			&err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+	}
+	g_if_err_create_goto(*err, CCL_ERROR, size > max_size,
+		CCL_ERROR_ARGS, error_handler,
+		"%s: On-device queue size (%u) is larger than the maximum " \
+		"allowed by the device (%u).",
+		CCL_STRD, size, max_size);
+
+	/* On-device queues must be out-of-order. */
+	properties |= CL_QUEUE_ON_DEVICE | CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE;
+	if (is_default) properties |= CL_QUEUE_ON_DEVICE_DEFAULT;
+
+	/* Create queue. */
+	{
+		const cl_queue_properties prop_full[] = {
+			CL_QUEUE_PROPERTIES, properties, CL_QUEUE_SIZE, size, 0 };
+		cq = ccl_queue_new_full(ctx, dev, prop_full, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+	}
+
+#endif
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+finish:
+
+	/* Return the new command queue wrapper object. */
+	return cq;
+
+}
+
 /**
  * Decrements the reference count of the command queue wrapper
  * object. If it reaches 0, the command queue wrapper object is
@@ -465,6 +1043,307 @@ finish:
 
 }
 
+/**
+ * Get the quality-of-service class of the given command queue.
+ *
+ * @public @memberof ccl_queue
+ *
+ * @param[in] cq The command queue wrapper object.
+ * @return The quality-of-service class of the command queue, which is
+ * ::CCL_QUEUE_QOS_NORMAL for queues not created with ::ccl_queue_new_qos().
+ * */
+CCL_EXPORT
+CCLQueueQoS ccl_queue_get_qos(CCLQueue* cq) {
+
+	/* Make sure cq is not NULL. */
+	g_return_val_if_fail(cq != NULL, CCL_QUEUE_QOS_NORMAL);
+
+	/* Return quality-of-service class. */
+	return cq->qos;
+
+}
+
+/**
+ * Was the quality-of-service class of the given command queue mapped to
+ * device priority hints? If not, and the queue is not of the
+ * ::CCL_QUEUE_QOS_NORMAL class, the host-side scheduler is used.
+ *
+ * @public @memberof ccl_queue
+ *
+ * @param[in] cq The command queue wrapper object.
+ * @return `CL_TRUE` if the queue was created with the
+ * `CL_QUEUE_PRIORITY_KHR` property, `CL_FALSE` otherwise.
+ * */
+CCL_EXPORT
+cl_bool ccl_queue_get_qos_hints(CCLQueue* cq) {
+
+	/* Make sure cq is not NULL. */
+	g_return_val_if_fail(cq != NULL, CL_FALSE);
+
+	/* Return whether hints were used. */
+	return cq->qos_hints;
+
+}
+
+/**
+ * Limit the number of commands and/or bytes in flight in the command queue,
+ * i.e. enqueued but not yet completed.
+ *
+ * Once the limit is reached, kernel launches (except
+ * ::ccl_kernel_enqueue_ndrange_iter()) and buffer read, write and copy
+ * commands on this queue either block until enough in-flight commands
+ * complete, or fail with ::CCL_ERROR_WOULD_BLOCK, depending on `blocking`.
+ * Other commands count towards the limit but are never held back. Time
+ * spent waiting is reported by ::ccl_queue_get_throttle_stats().
+ *
+ * Limits only apply to commands enqueued after this function is called.
+ *
+ * @public @memberof ccl_queue
+ *
+ * @param[in] cq The command queue wrapper object.
+ * @param[in] max_cmds Maximum number of commands in flight, or zero for no
+ * limit on the number of commands.
+ * @param[in] max_bytes Maximum number of bytes transferred by buffer
+ * commands in flight, or zero for no limit on bytes. A single command larger
+ * than this limit is accepted if no other bytes are in flight.
+ * @param[in] blocking Block when the limit is reached? If `CL_FALSE`,
+ * enqueue functions fail with ::CCL_ERROR_WOULD_BLOCK instead.
+ * */
+CCL_EXPORT
+void ccl_queue_set_inflight_limit(CCLQueue* cq, cl_uint max_cmds,
+	size_t max_bytes, cl_bool blocking) {
+
+	/* Make sure cq is not NULL. */
+	g_return_if_fail(cq != NULL);
+
+	cq->inflight_max_cmds = max_cmds;
+	cq->inflight_max_bytes = max_bytes;
+	cq->inflight_blocking = blocking;
+
+	/* Initialize in-flight list, if required. */
+	if ((cq->inflight == NULL) && ((max_cmds > 0) || (max_bytes > 0)))
+		cq->inflight = g_queue_new();
+
+}
+
+/**
+ * Get the number of commands and bytes in flight in the command queue. Only
+ * commands enqueued after an in-flight limit was set with
+ * ::ccl_queue_set_inflight_limit() are accounted for.
+ *
+ * @public @memberof ccl_queue
+ *
+ * @param[in] cq The command queue wrapper object.
+ * @param[out] bytes Return location for the number of bytes in flight, or
+ * `NULL` if not required.
+ * @return The number of commands in flight.
+ * */
+CCL_EXPORT
+cl_uint ccl_queue_get_inflight(CCLQueue* cq, size_t* bytes) {
+
+	/* Make sure cq is not NULL. */
+	g_return_val_if_fail(cq != NULL, 0);
+
+	/* Discard completed commands. */
+	ccl_queue_inflight_prune(cq);
+
+	if (bytes != NULL) *bytes = cq->inflight_bytes;
+	return cq->inflight != NULL ? cq->inflight->length : 0;
+
+}
+
+/**
+ * Get statistics about enqueue calls held back by the in-flight limit of
+ * the command queue.
+ *
+ * @public @memberof ccl_queue
+ *
+ * @param[in] cq The command queue wrapper object.
+ * @param[out] num_throttled Return location for the number of enqueue calls
+ * which had to wait for room, or `NULL` if not required.
+ * @param[out] num_would_block Return location for the number of enqueue
+ * calls which failed with ::CCL_ERROR_WOULD_BLOCK, or `NULL` if not required.
+ * @param[out] time_throttled Return location for the total time spent
+ * waiting for room, in seconds, or `NULL` if not required.
+ * */
+CCL_EXPORT
+void ccl_queue_get_throttle_stats(CCLQueue* cq, cl_ulong* num_throttled,
+	cl_ulong* num_would_block, double* time_throttled) {
+
+	/* Make sure cq is not NULL. */
+	g_return_if_fail(cq != NULL);
+
+	if (num_throttled != NULL) *num_throttled = cq->num_throttled;
+	if (num_would_block != NULL) *num_would_block = cq->num_would_block;
+	if (time_throttled != NULL)
+		*time_throttled = cq->time_throttled / (double) G_TIME_SPAN_SECOND;
+
+}
+
+/**
+ * @internal
+ * Wait for room in the in-flight window of the queue before enqueuing a
+ * command which transfers the given number of bytes. Does nothing if the
+ * queue has no in-flight limit.
+ *
+ * @private @memberof ccl_queue
+ *
+ * @param[in] cq The command queue wrapper object.
+ * @param[in] bytes Number of bytes transferred by the command.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return `CL_TRUE` if the command can be enqueued, `CL_FALSE` otherwise
+ * (either because the queue is full and non-blocking, or because an error
+ * occurred while waiting).
+ * */
+cl_bool ccl_queue_inflight_acquire(CCLQueue* cq, size_t bytes,
+	CCLErr** err) {
+
+	/* Make sure cq is not NULL. */
+	g_return_val_if_fail(cq != NULL, CL_FALSE);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, CL_FALSE);
+
+	/* Function return status. */
+	cl_bool status;
+	/* OpenCL status flag. */
+	cl_int ocl_status;
+	/* Time when waiting started. */
+	gint64 t_start;
+
+	/* Nothing to do if queue has no limit. */
+	if (cq->inflight == NULL) return CL_TRUE;
+
+	/* Discard completed commands. */
+	ccl_queue_inflight_prune(cq);
+
+	if (!ccl_queue_inflight_fits(cq, bytes)) {
+
+		/* Fail if queue is non-blocking. */
+		if (!cq->inflight_blocking) {
+			cq->num_would_block++;
+			g_if_err_create_goto(*err, CCL_ERROR, TRUE,
+				CCL_ERROR_WOULD_BLOCK, error_handler,
+				"%s: in-flight limit of command queue reached.", CCL_STRD);
+		}
+
+		/* Otherwise, wait for the oldest command until there's room. */
+		cq->num_throttled++;
+		t_start = g_get_monotonic_time();
+		do {
+			struct ccl_queue_inflight* cmd =
+				(struct ccl_queue_inflight*) g_queue_peek_head(cq->inflight);
+			ocl_status = clWaitForEvents(1, &cmd->event);
+			cq->inflight_bytes -= cmd->bytes;
+			ccl_queue_inflight_destroy(g_queue_pop_head(cq->inflight));
+			g_if_err_create_goto(*err, CCL_OCL_ERROR,
+				CL_SUCCESS != ocl_status, ocl_status, error_handler,
+				"%s: error while waiting for in-flight command "
+				"(OpenCL error %d: %s).",
+				CCL_STRD, ocl_status, ccl_err(ocl_status));
+			ccl_queue_inflight_prune(cq);
+		} while (!ccl_queue_inflight_fits(cq, bytes));
+		cq->time_throttled += g_get_monotonic_time() - t_start;
+	}
+
+	/* Keep size of command about to be enqueued. */
+	cq->inflight_next_bytes = bytes;
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	status = CL_TRUE;
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	status = CL_FALSE;
+
+finish:
+
+	/* Return status. */
+	return status;
+
+}
+
+/**
+ * @internal
+ * Forget the number of bytes kept by ccl_queue_inflight_acquire() for a
+ * command which failed to be enqueued, so that they are not accounted to
+ * the next command.
+ *
+ * @private @memberof ccl_queue
+ *
+ * @param[in] cq The command queue wrapper object.
+ * */
+void ccl_queue_inflight_cancel(CCLQueue* cq) {
+
+	/* Make sure cq is not NULL. */
+	g_return_if_fail(cq != NULL);
+
+	cq->inflight_next_bytes = 0;
+
+}
+
+/**
+ * @internal
+ * Hold back a kernel launch on a low priority queue while commands enqueued
+ * on high priority queues of the same device are outstanding. Does nothing
+ * for other queues, or if device priority hints are used.
+ *
+ * Errors in the awaited commands are not reported here, as they are
+ * reported through the events of the high priority commands themselves.
+ *
+ * @private @memberof ccl_queue
+ *
+ * @param[in] cq The command queue wrapper object.
+ * */
+void ccl_queue_qos_gate(CCLQueue* cq) {
+
+	/* Make sure cq is not NULL. */
+	g_return_if_fail(cq != NULL);
+
+	/* Outstanding commands on the device. */
+	GPtrArray* evts;
+	/* Local copy of outstanding commands. */
+	cl_event* wait_evts = NULL;
+	/* Number of outstanding commands. */
+	guint num_wait_evts = 0;
+
+	/* Only low priority queues without hints are held back. */
+	if ((cq->qos != CCL_QUEUE_QOS_LOW) || (cq->qos_hints))
+		return;
+
+	/* Take a snapshot of outstanding high priority commands. */
+	G_LOCK(qos_pending);
+	evts = qos_pending != NULL
+		? (GPtrArray*) g_hash_table_lookup(
+			qos_pending, ccl_device_unwrap(cq->dev))
+		: NULL;
+	if (evts != NULL) {
+		ccl_queue_qos_prune(evts);
+		num_wait_evts = evts->len;
+		if (num_wait_evts > 0) {
+			wait_evts = g_slice_alloc(sizeof(cl_event) * num_wait_evts);
+			for (guint i = 0; i < num_wait_evts; ++i) {
+				wait_evts[i] = (cl_event) g_ptr_array_index(evts, i);
+				clRetainEvent(wait_evts[i]);
+			}
+		}
+	}
+	G_UNLOCK(qos_pending);
+
+	/* Wait for them without holding the lock. Commands may belong to
+	 * different contexts, so they're waited for one at a time. */
+	for (guint i = 0; i < num_wait_evts; ++i) {
+		clWaitForEvents(1, &wait_evts[i]);
+		clReleaseEvent(wait_evts[i]);
+	}
+	if (wait_evts != NULL)
+		g_slice_free1(sizeof(cl_event) * num_wait_evts, wait_evts);
+
+}
+
 /**
  * @internal
  * Create an event wrapper from a given OpenCL event object and
@@ -501,6 +1380,22 @@ CCLEvent* ccl_queue_produce_event(CCLQueue* cq, cl_event event) {
 	 * queue. */
 	g_hash_table_add(cq->evts, (gpointer) evt);
 
+	/* Track commands of high priority queues scheduled on the host. */
+	if ((cq->qos == CCL_QUEUE_QOS_HIGH) && (!cq->qos_hints))
+		ccl_queue_qos_track(cq, event);
+
+	/* Keep command in flight, if the queue has an in-flight limit. */
+	if (cq->inflight != NULL) {
+		struct ccl_queue_inflight* cmd =
+			g_slice_new(struct ccl_queue_inflight);
+		clRetainEvent(event);
+		cmd->event = event;
+		cmd->bytes = cq->inflight_next_bytes;
+		cq->inflight_bytes += cmd->bytes;
+		cq->inflight_next_bytes = 0;
+		g_queue_push_tail(cq->inflight, cmd);
+	}
+
 	/* Return the wrapped event. */
 	return evt;
 
@@ -48,6 +48,18 @@
  * features such as on-device queues to client code. If OpenCL >= 2.0 features
  * are requested for platforms which do not support them, a warning will be
  * logged and the queue will be created without the unsupported features.
+ * On-device queues for device-side enqueue can be created with the
+ * ::ccl_queue_new_on_device() constructor, which fails with an error if the
+ * platform or device does not support them. On-device queue wrappers can be
+ * passed directly as `queue_t` kernel arguments.
+ *
+ * Queues belonging to a quality-of-service class (see ::CCLQueueQoS) are
+ * created with the ::ccl_queue_new_qos() constructor. High and low priority
+ * classes are mapped to the `cl_khr_priority_hints` and
+ * `cl_khr_throttle_hints` queue properties when the device supports them.
+ * Otherwise, a host-side scheduler holds back kernel launches on low
+ * priority queues while kernels enqueued on high priority queues of the same
+ * device are outstanding.
  *
  * Instantiation and destruction of queue wrappers follows the _cf4ocl_
  * @ref ug_new_destroy "new/destroy" rule; as such, queues should be freed with
@@ -80,6 +92,24 @@
  * @{
  */
 
+/**
+ * Quality-of-service class of a command queue.
+ *
+ * @see ccl_queue_new_qos()
+ * */
+typedef enum ccl_queue_qos {
+
+	/** Regular queue, no priority or throttling hints. */
+	CCL_QUEUE_QOS_NORMAL = 0,
+
+	/** High priority, latency-sensitive work. */
+	CCL_QUEUE_QOS_HIGH = 1,
+
+	/** Low priority, background or batch work. */
+	CCL_QUEUE_QOS_LOW = 2
+
+} CCLQueueQoS;
+
 /* Get the command queue wrapper for the given OpenCL command
  * queue. */
 CCL_EXPORT
@@ -95,6 +125,18 @@ CCL_EXPORT
 CCLQueue* ccl_queue_new(CCLContext* ctx, CCLDevice* dev,
 	cl_command_queue_properties properties, CCLErr** err);
 
+/* Create a new on-device command queue wrapper object. */
+CCL_EXPORT
+CCLQueue* ccl_queue_new_on_device(CCLContext* ctx, CCLDevice* dev,
+	cl_command_queue_properties properties, cl_uint size,
+	cl_bool is_default, CCLErr** err);
+
+/* Create a new command queue wrapper object with the given
+ * quality-of-service class. */
+CCL_EXPORT
+CCLQueue* ccl_queue_new_qos(CCLContext* ctx, CCLDevice* dev,
+	cl_command_queue_properties properties, CCLQueueQoS qos, CCLErr** err);
+
 /* Decrements the reference count of the command queue wrapper
  * object. If it reaches 0, the command queue wrapper object is
  * destroyed. */
@@ -111,6 +153,31 @@ CCLContext* ccl_queue_get_context(CCLQueue* cq, CCLErr** err);
 CCL_EXPORT
 CCLDevice* ccl_queue_get_device(CCLQueue* cq, CCLErr** err);
 
+/* Get the quality-of-service class of the given command queue. */
+CCL_EXPORT
+CCLQueueQoS ccl_queue_get_qos(CCLQueue* cq);
+
+/* Was the quality-of-service class mapped to device priority hints? */
+CCL_EXPORT
+cl_bool ccl_queue_get_qos_hints(CCLQueue* cq);
+
+/* Limit the number of commands and bytes in flight in the command
+ * queue. */
+CCL_EXPORT
+void ccl_queue_set_inflight_limit(CCLQueue* cq, cl_uint max_cmds,
+	size_t max_bytes, cl_bool blocking);
+
+/* Get the number of commands and bytes in flight in the command
+ * queue. */
+CCL_EXPORT
+cl_uint ccl_queue_get_inflight(CCLQueue* cq, size_t* bytes);
+
+/* Get statistics about enqueue calls held back by the in-flight
+ * limit. */
+CCL_EXPORT
+void ccl_queue_get_throttle_stats(CCLQueue* cq, cl_ulong* num_throttled,
+	cl_ulong* num_would_block, double* time_throttled);
+
 /* Create an event wrapper from a given OpenCL event object and
  * associate it with the command queue. */
 CCL_EXPORT
@@ -227,7 +294,7 @@ CCLEvent* ccl_enqueue_marker(CCLQueue* cq,
  * @return The OpenCL command queue object.
  * */
 #define ccl_queue_unwrap(cq) \
-	((cl_command_queue) ccl_wrapper_unwrap((CCLWrapper*) cq))
+	((cl_command_queue) ccl_wrapper_unwrap_inline((CCLWrapper*) cq))
 
 /** @} */
 
@@ -185,7 +185,7 @@ CCLSampler* ccl_sampler_new_full(CCLContext* ctx,
  * @return The OpenCL sampler object.
  * */
 #define ccl_sampler_unwrap(smplr) \
-	((cl_sampler) ccl_wrapper_unwrap((CCLWrapper*) smplr))
+	((cl_sampler) ccl_wrapper_unwrap_inline((CCLWrapper*) smplr))
 
 /** @} */
 
@@ -0,0 +1,518 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ *
+ * Implementation of a runtime session cache for contexts, queues and
+ * programs.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#include "ccl_session.h"
+#include "_ccl_defs.h"
+
+/**
+ * @internal
+ * Number of objects kept by a session when no capacity is given.
+ * */
+#define CCL_SESSION_CAPACITY 64
+
+/**
+ * @internal
+ * Cached object.
+ * */
+typedef struct ccl_session_entry {
+
+	/** Cache key. */
+	gchar* key;
+
+	/** Cached wrapper, holding one reference owned by the cache. */
+	CCLWrapper* obj;
+
+	/** Function which releases the cached wrapper. */
+	GDestroyNotify destroy;
+
+	/** Context of cached queues and programs, referenced by the entry
+	 * so that its address is not reused while the entry exists;
+	 * `NULL` for cached contexts. */
+	CCLContext* ctx;
+
+} CCLSessionEntry;
+
+/**
+ * Runtime session cache.
+ * */
+struct ccl_session {
+
+	/**
+	 * Protects all other fields.
+	 * @private
+	 * */
+	GMutex mutex;
+
+	/**
+	 * Maps keys to links in the `lru` list.
+	 * @private
+	 * */
+	GHashTable* table;
+
+	/**
+	 * Cached entries, most recently used first.
+	 * @private
+	 * */
+	GQueue lru;
+
+	/**
+	 * Maximum number of cached objects.
+	 * @private
+	 * */
+	cl_uint capacity;
+
+	/**
+	 * Number of requests served from the cache.
+	 * @private
+	 * */
+	cl_ulong hits;
+
+	/**
+	 * Number of requests which required creating a new object.
+	 * @private
+	 * */
+	cl_ulong misses;
+
+	/**
+	 * Number of objects evicted from the cache.
+	 * @private
+	 * */
+	cl_ulong evictions;
+
+};
+
+/**
+ * @internal
+ * Release a cache entry and the objects it references.
+ *
+ * @param[in] entry Cache entry.
+ * */
+static void ccl_session_entry_destroy(CCLSessionEntry* entry) {
+
+	entry->destroy(entry->obj);
+	if (entry->ctx != NULL) ccl_context_destroy(entry->ctx);
+	g_free(entry->key);
+	g_slice_free(CCLSessionEntry, entry);
+
+}
+
+/**
+ * @internal
+ * Look up an object in the cache, marking it as most recently used.
+ * Counts a hit or a miss.
+ *
+ * @param[in] sess The session cache.
+ * @param[in] key Cache key.
+ * @return The cached object with its reference count incremented, or
+ * `NULL` if not found.
+ * */
+static CCLWrapper* ccl_session_lookup(CCLSession* sess,
+	const gchar* key) {
+
+	GList* link;
+	CCLWrapper* obj = NULL;
+
+	g_mutex_lock(&sess->mutex);
+
+	link = g_hash_table_lookup(sess->table, key);
+	if (link != NULL) {
+		g_queue_unlink(&sess->lru, link);
+		g_queue_push_head_link(&sess->lru, link);
+		obj = ((CCLSessionEntry*) link->data)->obj;
+		ccl_wrapper_ref(obj);
+		sess->hits++;
+	} else {
+		sess->misses++;
+	}
+
+	g_mutex_unlock(&sess->mutex);
+
+	return obj;
+
+}
+
+/**
+ * @internal
+ * Insert a newly created object in the cache, evicting the least
+ * recently used objects if capacity is exceeded. If another thread
+ * inserted an object with the same key in the meantime, that object
+ * is used instead and the new one is released.
+ *
+ * @param[in] sess The session cache.
+ * @param[in] key Cache key.
+ * @param[in] obj New object; its reference is taken over by the cache.
+ * @param[in] destroy Function which releases the object.
+ * @param[in] ctx Context to reference while the entry exists, or
+ * `NULL`.
+ * @return The cached object with its reference count incremented.
+ * */
+static CCLWrapper* ccl_session_insert(CCLSession* sess,
+	const gchar* key, CCLWrapper* obj, GDestroyNotify destroy,
+	CCLContext* ctx) {
+
+	GList* link;
+	CCLSessionEntry* entry;
+
+	g_mutex_lock(&sess->mutex);
+
+	link = g_hash_table_lookup(sess->table, key);
+	if (link != NULL) {
+
+		/* Lost the race to another thread, use its object. */
+		destroy(obj);
+		obj = ((CCLSessionEntry*) link->data)->obj;
+
+	} else {
+
+		entry = g_slice_new(CCLSessionEntry);
+		entry->key = g_strdup(key);
+		entry->obj = obj;
+		entry->destroy = destroy;
+		entry->ctx = ctx;
+		if (ctx != NULL) ccl_context_ref(ctx);
+		g_queue_push_head(&sess->lru, entry);
+		g_hash_table_insert(sess->table, entry->key, sess->lru.head);
+
+		/* Evict least recently used objects. */
+		while (sess->lru.length > sess->capacity) {
+			entry = g_queue_pop_tail(&sess->lru);
+			g_hash_table_remove(sess->table, entry->key);
+			ccl_session_entry_destroy(entry);
+			sess->evictions++;
+		}
+	}
+
+	ccl_wrapper_ref(obj);
+
+	g_mutex_unlock(&sess->mutex);
+
+	return obj;
+
+}
+
+/**
+ * @addtogroup CCL_SESSION
+ * @{
+ */
+
+/**
+ * Create a new session cache.
+ *
+ * @public @memberof ccl_session
+ *
+ * @param[in] capacity Maximum number of cached objects (contexts,
+ * queues and programs together), or 0 for the default of 64.
+ * @return A new session cache, which should be freed with
+ * ::ccl_session_destroy().
+ * */
+CCL_EXPORT
+CCLSession* ccl_session_new(cl_uint capacity) {
+
+	CCLSession* sess = g_slice_new0(CCLSession);
+
+	g_mutex_init(&sess->mutex);
+	sess->table = g_hash_table_new(g_str_hash, g_str_equal);
+	g_queue_init(&sess->lru);
+	sess->capacity = (capacity > 0) ? capacity : CCL_SESSION_CAPACITY;
+
+	return sess;
+
+}
+
+/**
+ * Destroy a session cache, releasing the references it holds on all
+ * cached objects. Objects still held by client code remain valid.
+ *
+ * @public @memberof ccl_session
+ *
+ * @param[in] sess The session cache, may be `NULL`.
+ * */
+CCL_EXPORT
+void ccl_session_destroy(CCLSession* sess) {
+
+	CCLSessionEntry* entry;
+
+	if (sess == NULL) return;
+
+	/* Queue and program entries hold their own context reference, so
+	 * entries can be released in any order. */
+	g_hash_table_destroy(sess->table);
+	while ((entry = g_queue_pop_head(&sess->lru)) != NULL)
+		ccl_session_entry_destroy(entry);
+
+	g_mutex_clear(&sess->mutex);
+	g_slice_free(CCLSession, sess);
+
+}
+
+/**
+ * Get a context for the devices selected by the given filters. Device
+ * selection is performed on every call, but a context is only created
+ * if none is cached for the selected devices.
+ *
+ * @public @memberof ccl_session
+ *
+ * @param[in] sess The session cache.
+ * @param[in] filters Filters for selecting device, which are freed and
+ * set to `NULL`, as in ::ccl_context_new_from_filters().
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return A context wrapper, which should be released with
+ * ::ccl_context_destroy(), or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLContext* ccl_session_get_context(CCLSession* sess,
+	CCLDevSelFilters* filters, CCLErr** err) {
+
+	/* Make sure sess is not NULL. */
+	g_return_val_if_fail(sess != NULL, NULL);
+	/* Make sure filters is not NULL. */
+	g_return_val_if_fail(filters != NULL, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Context wrapper. */
+	CCLContext* ctx = NULL;
+	/* Selected devices. */
+	CCLDevSelDevices devices = NULL;
+	/* Cache key. */
+	GString* key = NULL;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Select devices. */
+	devices = ccl_devsel_select(filters, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	g_if_err_create_goto(*err, CCL_ERROR, devices->len == 0,
+		CCL_ERROR_DEVICE_NOT_FOUND, error_handler,
+		"%s: no device found for selected filters.", CCL_STRD);
+
+	/* Key is given by the selected devices, in order. */
+	key = g_string_new("C");
+	for (guint i = 0; i < devices->len; ++i)
+		g_string_append_printf(key, ":%p", (void*)
+			ccl_device_unwrap((CCLDevice*) devices->pdata[i]));
+
+	ctx = (CCLContext*) ccl_session_lookup(sess, key->str);
+	if (ctx == NULL) {
+		ctx = ccl_context_new_from_devices(
+			devices->len, (CCLDevice**) devices->pdata, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+		ctx = (CCLContext*) ccl_session_insert(sess, key->str,
+			(CCLWrapper*) ctx, (GDestroyNotify) ccl_context_destroy,
+			NULL);
+	}
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+finish:
+
+	/* Free selected devices and key. */
+	if (devices != NULL) ccl_devsel_devices_destroy(devices);
+	if (key != NULL) g_string_free(key, TRUE);
+
+	/* Return context. */
+	return ctx;
+
+}
+
+/**
+ * Get a command queue private to the calling thread. Different
+ * threads asking for a queue with the same parameters get different
+ * queues.
+ *
+ * @public @memberof ccl_session
+ *
+ * @param[in] sess The session cache.
+ * @param[in] ctx Context wrapper, usually obtained with
+ * ::ccl_session_get_context().
+ * @param[in] dev Device wrapper, or `NULL` for the first device in the
+ * context, as in ::ccl_queue_new().
+ * @param[in] properties Queue properties.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return A queue wrapper, which should be released with
+ * ::ccl_queue_destroy(), or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLQueue* ccl_session_get_queue(CCLSession* sess, CCLContext* ctx,
+	CCLDevice* dev, cl_command_queue_properties properties,
+	CCLErr** err) {
+
+	/* Make sure sess and ctx are not NULL. */
+	g_return_val_if_fail((sess != NULL) && (ctx != NULL), NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Queue wrapper. */
+	CCLQueue* cq = NULL;
+	/* Cache key. */
+	gchar* key;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	key = g_strdup_printf("Q:%p:%p:%p:%lx", (void*) g_thread_self(),
+		(void*) ctx, (void*) dev, (unsigned long) properties);
+
+	cq = (CCLQueue*) ccl_session_lookup(sess, key);
+	if (cq == NULL) {
+		cq = ccl_queue_new(ctx, dev, properties, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+		cq = (CCLQueue*) ccl_session_insert(sess, key, (CCLWrapper*) cq,
+			(GDestroyNotify) ccl_queue_destroy, ctx);
+	}
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+finish:
+
+	/* Free key. */
+	g_free(key);
+
+	/* Return queue. */
+	return cq;
+
+}
+
+/**
+ * Get a program built from the given source code and build options
+ * for all devices in the context. Programs are identified by a hash of
+ * their source code.
+ *
+ * @public @memberof ccl_session
+ *
+ * @param[in] sess The session cache.
+ * @param[in] ctx Context wrapper, usually obtained with
+ * ::ccl_session_get_context().
+ * @param[in] source Program source code.
+ * @param[in] options Build options, may be `NULL`.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return A built program wrapper, which should be released with
+ * ::ccl_program_destroy(), or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLProgram* ccl_session_get_program(CCLSession* sess, CCLContext* ctx,
+	const char* source, const char* options, CCLErr** err) {
+
+	/* Make sure sess and ctx are not NULL. */
+	g_return_val_if_fail((sess != NULL) && (ctx != NULL), NULL);
+	/* Make sure source is not NULL. */
+	g_return_val_if_fail(source != NULL, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Program wrapper. */
+	CCLProgram* prg = NULL;
+	/* Source hash and cache key. */
+	gchar* hash;
+	gchar* key;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	hash = g_compute_checksum_for_string(G_CHECKSUM_SHA256, source, -1);
+	key = g_strdup_printf("P:%p:%s:%s", (void*) ctx, hash,
+		options != NULL ? options : "");
+	g_free(hash);
+
+	prg = (CCLProgram*) ccl_session_lookup(sess, key);
+	if (prg == NULL) {
+		prg = ccl_program_new_from_source(ctx, source, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+		ccl_program_build(prg, options, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+		prg = (CCLProgram*) ccl_session_insert(sess, key,
+			(CCLWrapper*) prg, (GDestroyNotify) ccl_program_destroy,
+			ctx);
+	}
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+	/* Don't return a program which failed to build. */
+	if (prg != NULL) {
+		ccl_program_destroy(prg);
+		prg = NULL;
+	}
+
+finish:
+
+	/* Free key. */
+	g_free(key);
+
+	/* Return program. */
+	return prg;
+
+}
+
+/**
+ * Get session cache statistics. The hit rate is given by
+ * `hits / (hits + misses)`.
+ *
+ * @public @memberof ccl_session
+ *
+ * @param[in] sess The session cache.
+ * @param[out] hits Return location for the number of requests served
+ * from the cache, or `NULL`.
+ * @param[out] misses Return location for the number of requests which
+ * required creating a new object, or `NULL`.
+ * @param[out] evictions Return location for the number of evicted
+ * objects, or `NULL`.
+ * */
+CCL_EXPORT
+void ccl_session_get_stats(CCLSession* sess, cl_ulong* hits,
+	cl_ulong* misses, cl_ulong* evictions) {
+
+	/* Make sure sess is not NULL. */
+	g_return_if_fail(sess != NULL);
+
+	g_mutex_lock(&sess->mutex);
+	if (hits != NULL) *hits = sess->hits;
+	if (misses != NULL) *misses = sess->misses;
+	if (evictions != NULL) *evictions = sess->evictions;
+	g_mutex_unlock(&sess->mutex);
+
+}
+
+/** @} */
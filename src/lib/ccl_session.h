@@ -0,0 +1,131 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+ /**
+ * @file
+ *
+ * Definition of a runtime session cache for contexts, queues and
+ * programs.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#ifndef _CCL_SESSION_H_
+#define _CCL_SESSION_H_
+
+#include "ccl_common.h"
+#include "ccl_context_wrapper.h"
+#include "ccl_device_selector.h"
+#include "ccl_program_wrapper.h"
+#include "ccl_queue_wrapper.h"
+
+/**
+ * @defgroup CCL_SESSION Session cache
+ *
+ * This module provides a session cache which lets request-driven code
+ * reuse contexts, command queues and built programs instead of
+ * creating them for every request.
+ *
+ * A ::CCLSession* object is meant to be created once per process and
+ * shared by all threads (it is thread-safe). It hands out:
+ *
+ * * contexts, with ::ccl_session_get_context(), keyed by the devices
+ * which the given filters select;
+ * * built programs, with ::ccl_session_get_program(), keyed by
+ * context, source code and build options;
+ * * command queues, with ::ccl_session_get_queue(), keyed by context,
+ * device and queue properties, and private to the calling thread.
+ *
+ * Returned objects are shared between callers, with their reference
+ * count incremented, and must be released with the respective
+ * `destroy` function as usual, following the _cf4ocl_
+ * @ref ug_new_destroy "new/destroy" rule. Cached programs must not be
+ * rebuilt.
+ *
+ * The session keeps at most the given number of objects, evicting the
+ * least recently used ones when that number is exceeded. Evicted
+ * objects remain valid for callers which still hold them. Hit, miss
+ * and eviction counts can be obtained with ::ccl_session_get_stats().
+ *
+ * Queues of threads which have terminated are only released when
+ * evicted or when the session is destroyed.
+ *
+ * _Example:_
+ *
+ * @code{.c}
+ * CCLSession* sess = ccl_session_new(0);
+ * @endcode
+ * @code{.c}
+ * // For each request:
+ * CCLDevSelFilters filters = NULL;
+ * ccl_devsel_add_indep_filter(&filters, ccl_devsel_indep_type_gpu, NULL);
+ * CCLContext* ctx = ccl_session_get_context(sess, &filters, &err);
+ * CCLDevice* dev = ccl_context_get_device(ctx, 0, &err);
+ * CCLQueue* cq = ccl_session_get_queue(sess, ctx, dev, 0, &err);
+ * CCLProgram* prg = ccl_session_get_program(sess, ctx, src, NULL, &err);
+ * // ...use ctx, cq and prg...
+ * ccl_program_destroy(prg);
+ * ccl_queue_destroy(cq);
+ * ccl_context_destroy(ctx);
+ * @endcode
+ * @code{.c}
+ * ccl_session_destroy(sess);
+ * @endcode
+ *
+ * @{
+ */
+
+/**
+ * Runtime session cache.
+ *
+ * @see ccl_session_new()
+ * */
+typedef struct ccl_session CCLSession;
+
+/* Create a new session cache. */
+CCL_EXPORT
+CCLSession* ccl_session_new(cl_uint capacity);
+
+/* Destroy a session cache, releasing all cached objects. */
+CCL_EXPORT
+void ccl_session_destroy(CCLSession* sess);
+
+/* Get a context for the devices selected by the given filters. */
+CCL_EXPORT
+CCLContext* ccl_session_get_context(CCLSession* sess,
+	CCLDevSelFilters* filters, CCLErr** err);
+
+/* Get a command queue private to the calling thread. */
+CCL_EXPORT
+CCLQueue* ccl_session_get_queue(CCLSession* sess, CCLContext* ctx,
+	CCLDevice* dev, cl_command_queue_properties properties,
+	CCLErr** err);
+
+/* Get a program built from the given source and options. */
+CCL_EXPORT
+CCLProgram* ccl_session_get_program(CCLSession* sess, CCLContext* ctx,
+	const char* source, const char* options, CCLErr** err);
+
+/* Get session cache statistics. */
+CCL_EXPORT
+void ccl_session_get_stats(CCLSession* sess, cl_ulong* hits,
+	cl_ulong* misses, cl_ulong* evictions);
+
+/** @} */
+
+#endif
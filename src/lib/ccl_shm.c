@@ -0,0 +1,914 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+/**
+ * @file
+ *
+ * Implementation of buffers backed by POSIX shared memory and of a
+ * lock-free slot ring for handing off data between processes.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+/* shm_open(), ftruncate() and mmap() are hidden by -std=c99. */
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "ccl_shm.h"
+#include "ccl_device_wrapper.h"
+#include "_ccl_defs.h"
+
+#ifdef G_OS_UNIX
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/**
+ * @internal
+ * Magic number identifying an initialized slot ring segment ("CCLR").
+ * */
+#define CCL_SHM_RING_MAGIC 0x52434c43
+
+/**
+ * @internal
+ * States of a slot in a shared memory ring.
+ * */
+enum ccl_shm_slot_state {
+	/** Slot is free and can be acquired by the producer. */
+	CCL_SHM_SLOT_FREE    = 0,
+	/** Slot is being filled by the producer. */
+	CCL_SHM_SLOT_WRITING = 1,
+	/** Slot was published and can be acquired by the consumer. */
+	CCL_SHM_SLOT_READY   = 2,
+	/** Slot is being used by the consumer. */
+	CCL_SHM_SLOT_READING = 3
+};
+
+/**
+ * @internal
+ * Per-slot control block, placed in shared memory.
+ * */
+typedef struct ccl_shm_ring_slot {
+
+	/** Slot state, one of ::ccl_shm_slot_state. */
+	gint state;
+
+	/** Padding, keeps `bytes` 8-byte aligned. */
+	guint32 reserved;
+
+	/** Number of valid bytes published in the slot. */
+	guint64 bytes;
+
+} CCLShmRingSlot;
+
+/**
+ * @internal
+ * Ring header, placed at the start of the shared memory segment and
+ * immediately followed by the array of slot control blocks.
+ * */
+typedef struct ccl_shm_ring_header {
+
+	/** Set to ::CCL_SHM_RING_MAGIC once the header is initialized. */
+	gint magic;
+
+	/** Number of slots. */
+	guint32 num_slots;
+
+	/** Usable size of each slot in bytes. */
+	guint64 slot_size;
+
+	/** Distance in bytes between the start of consecutive slots. */
+	guint64 slot_stride;
+
+	/** Offset in bytes of the first slot from the segment start. */
+	guint64 data_offset;
+
+	/** Next slot to be acquired by the producer. */
+	gint head;
+
+	/** Next slot to be acquired by the consumer. */
+	gint tail;
+
+} CCLShmRingHeader;
+
+/**
+ * Lock-free slot ring over a named shared memory segment.
+ *
+ * The ring object itself is local to the process; all state shared
+ * between producer and consumer lives in the mapped segment.
+ * */
+struct ccl_shm_ring {
+
+	/**
+	 * Start of the mapped segment.
+	 * @private
+	 * */
+	void* base;
+
+	/**
+	 * Size of the mapped segment in bytes.
+	 * @private
+	 * */
+	size_t map_size;
+
+	/**
+	 * Ring header in the mapped segment.
+	 * @private
+	 * */
+	CCLShmRingHeader* hdr;
+
+	/**
+	 * Slot control blocks in the mapped segment.
+	 * @private
+	 * */
+	CCLShmRingSlot* slots;
+
+	/**
+	 * Segment name if this handle created it, `NULL` otherwise.
+	 * @private
+	 * */
+	char* name;
+
+};
+
+/**
+ * @internal
+ * Shared memory mapping owned by a buffer, released by the buffer's
+ * destructor callback.
+ * */
+typedef struct ccl_shm_mapping {
+
+	/** Start of the mapped segment. */
+	void* ptr;
+
+	/** Size of the mapped segment in bytes. */
+	size_t size;
+
+	/** Segment name if the segment is to be unlinked, `NULL`
+	 * otherwise. */
+	char* name;
+
+} CCLShmMapping;
+
+/**
+ * @internal
+ * Get the size of a memory page.
+ *
+ * @return The size of a memory page in bytes.
+ * */
+static size_t ccl_shm_page_size() {
+
+#ifdef G_OS_UNIX
+	long page = sysconf(_SC_PAGESIZE);
+	return page > 0 ? (size_t) page : 4096;
+#else
+	return 4096;
+#endif
+
+}
+
+/**
+ * @internal
+ * Round a value up to the next multiple of the given alignment.
+ *
+ * @param[in] value Value to round up.
+ * @param[in] align Alignment, must be larger than zero.
+ * @return The rounded value.
+ * */
+static size_t ccl_shm_round_up(size_t value, size_t align) {
+
+	return ((value + align - 1) / align) * align;
+
+}
+
+/**
+ * @internal
+ * Open and map a named shared memory segment.
+ *
+ * @param[in] name Segment name, as used in `shm_open()`.
+ * @param[in,out] size If `create` is true, the requested size, which
+ * on return is rounded up to the page size. Otherwise, the minimum
+ * size of the existing segment (0 for no minimum), which on return
+ * holds the actual segment size.
+ * @param[in] create Create a new segment (failing if it already
+ * exists) or open an existing one?
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return Pointer to the start of the mapped segment, or `NULL` if an
+ * error occurs.
+ * */
+static void* ccl_shm_map(const char* name, size_t* size, cl_bool create,
+	CCLErr** err) {
+
+	/* Mapped segment. */
+	void* ptr = NULL;
+
+#ifndef G_OS_UNIX
+
+	CCL_UNUSED(name);
+	CCL_UNUSED(size);
+	CCL_UNUSED(create);
+
+	g_if_err_create_goto(*err, CCL_ERROR, TRUE, CCL_ERROR_OTHER,
+		error_handler,
+		"%s: shared memory buffers require a POSIX system.",
+		CCL_STRD);
+
+#else
+
+	/* Shared memory file descriptor. */
+	int fd = -1;
+	/* Segment status. */
+	struct stat st;
+
+	/* Open or create the segment. */
+	fd = shm_open(name,
+		create ? O_RDWR | O_CREAT | O_EXCL : O_RDWR, 0600);
+	g_if_err_create_goto(*err, CCL_ERROR, fd < 0, CCL_ERROR_OPENFILE,
+		error_handler,
+		"%s: unable to open shared memory segment '%s' (%s).",
+		CCL_STRD, name, g_strerror(errno));
+
+	if (create) {
+
+		/* Set the size of the new segment. */
+		*size = ccl_shm_round_up(*size, ccl_shm_page_size());
+		g_if_err_create_goto(*err, CCL_ERROR,
+			ftruncate(fd, (off_t) *size) != 0, CCL_ERROR_OTHER,
+			error_handler,
+			"%s: unable to resize shared memory segment '%s' (%s).",
+			CCL_STRD, name, g_strerror(errno));
+
+	} else {
+
+		/* Determine the size of the existing segment. */
+		g_if_err_create_goto(*err, CCL_ERROR, fstat(fd, &st) != 0,
+			CCL_ERROR_OTHER, error_handler,
+			"%s: unable to get size of shared memory segment '%s' (%s).",
+			CCL_STRD, name, g_strerror(errno));
+		g_if_err_create_goto(*err, CCL_ERROR,
+			(st.st_size <= 0) || ((size_t) st.st_size < *size),
+			CCL_ERROR_ARGS, error_handler,
+			"%s: shared memory segment '%s' has %ld bytes, %lu required.",
+			CCL_STRD, name, (long) st.st_size, (unsigned long) *size);
+		*size = (size_t) st.st_size;
+
+	}
+
+	/* Map the segment. */
+	ptr = mmap(NULL, *size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (ptr == MAP_FAILED) ptr = NULL;
+	g_if_err_create_goto(*err, CCL_ERROR, ptr == NULL, CCL_ERROR_OTHER,
+		error_handler,
+		"%s: unable to map shared memory segment '%s' (%s).",
+		CCL_STRD, name, g_strerror(errno));
+
+#endif
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+#ifdef G_OS_UNIX
+	/* Don't leave behind a segment we created. */
+	if (create && (fd >= 0)) shm_unlink(name);
+#endif
+
+finish:
+
+#ifdef G_OS_UNIX
+	/* The mapping remains valid after the descriptor is closed. */
+	if (fd >= 0) close(fd);
+#endif
+
+	/* Return mapped segment. */
+	return ptr;
+
+}
+
+/**
+ * @internal
+ * Unmap a shared memory segment, optionally unlinking it.
+ *
+ * @param[in] ptr Start of the mapped segment.
+ * @param[in] size Size of the mapped segment in bytes.
+ * @param[in] name Segment name if it is to be unlinked, `NULL`
+ * otherwise.
+ * */
+static void ccl_shm_unmap(void* ptr, size_t size, const char* name) {
+
+#ifdef G_OS_UNIX
+	munmap(ptr, size);
+	if (name != NULL) shm_unlink(name);
+#else
+	CCL_UNUSED(ptr);
+	CCL_UNUSED(size);
+	CCL_UNUSED(name);
+#endif
+
+}
+
+/**
+ * @internal
+ * Check that a host pointer satisfies the base address alignment
+ * (`CL_DEVICE_MEM_BASE_ADDR_ALIGN`) of all devices in a context, so
+ * that it can be used with `CL_MEM_USE_HOST_PTR` without the
+ * implementation falling back to a copy.
+ *
+ * @param[in] ctx Context wrapper.
+ * @param[in] ptr Host pointer to check.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return `CL_TRUE` if the pointer is adequately aligned, `CL_FALSE`
+ * otherwise or if an error occurs.
+ * */
+static cl_bool ccl_shm_check_align(CCLContext* ctx, const void* ptr,
+	CCLErr** err) {
+
+	/* Number of devices in context. */
+	cl_uint num_devs;
+	/* Device base address alignment in bits. */
+	cl_uint align;
+	/* Device wrapper. */
+	CCLDevice* dev;
+	/* Function return status. */
+	cl_bool status = CL_FALSE;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	num_devs = ccl_context_get_num_devices(ctx, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	for (cl_uint i = 0; i < num_devs; ++i) {
+
+		dev = ccl_context_get_device(ctx, i, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		align = ccl_device_get_info_scalar(dev,
+			CL_DEVICE_MEM_BASE_ADDR_ALIGN, cl_uint, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		g_if_err_create_goto(*err, CCL_ERROR,
+			(align >= 8) && (GPOINTER_TO_SIZE(ptr) % (align / 8) != 0),
+			CCL_ERROR_ARGS, error_handler,
+			"%s: shared memory is not aligned to the %u-byte base "
+			"address alignment of device %u.",
+			CCL_STRD, align / 8, i);
+	}
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	status = CL_TRUE;
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+finish:
+
+	/* Return status. */
+	return status;
+
+}
+
+/**
+ * @internal
+ * Buffer destructor callback which releases the buffer's shared
+ * memory mapping.
+ *
+ * @param[in] memobj The released OpenCL buffer.
+ * @param[in] user_data The ::CCLShmMapping owned by the buffer.
+ * */
+static void CL_CALLBACK ccl_shm_buffer_destructor(
+	cl_mem memobj, void* user_data) {
+
+	CCLShmMapping* map = (CCLShmMapping*) user_data;
+
+	CCL_UNUSED(memobj);
+
+	ccl_shm_unmap(map->ptr, map->size, map->name);
+	g_free(map->name);
+	g_slice_free(CCLShmMapping, map);
+
+}
+
+/**
+ * @addtogroup CCL_SHM
+ * @{
+ */
+
+/**
+ * Create a buffer backed by a named POSIX shared memory segment.
+ *
+ * The segment is mapped into the calling process and directly used
+ * as the buffer's storage (`CL_MEM_USE_HOST_PTR`), so that data
+ * written into the segment by another process reaches the device
+ * without intermediate copies. The mapping is checked against the
+ * base address alignment of all devices in the context. It is
+ * released, and the segment unlinked if it was created by this
+ * function, when the OpenCL buffer is released.
+ *
+ * @public @memberof ccl_buffer
+ * @note Requires a POSIX system and OpenCL >= 1.1.
+ *
+ * @param[in] ctx Context wrapper.
+ * @param[in] flags OpenCL memory flags as used in clCreateBuffer();
+ * `CL_MEM_USE_HOST_PTR` is added automatically and must not be
+ * combined with `CL_MEM_ALLOC_HOST_PTR` or `CL_MEM_COPY_HOST_PTR`.
+ * @param[in] name Segment name, as used in `shm_open()` (e.g.
+ * `"/frames"`).
+ * @param[in] size Buffer size in bytes. If `create` is false, can be
+ * 0, in which case the whole segment is used.
+ * @param[in] create If true, a new segment is created (and this
+ * function fails if it already exists); otherwise an existing segment
+ * is opened.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return A new buffer wrapper object, or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLBuffer* ccl_buffer_new_from_shm(CCLContext* ctx, cl_mem_flags flags,
+	const char* name, size_t size, cl_bool create, CCLErr** err) {
+
+	/* Make sure ctx is not NULL. */
+	g_return_val_if_fail(ctx != NULL, NULL);
+	/* Make sure name is not NULL. */
+	g_return_val_if_fail(name != NULL, NULL);
+	/* Make sure size is given when creating a segment. */
+	g_return_val_if_fail(!create || size > 0, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Buffer wrapper. */
+	CCLBuffer* buf = NULL;
+	/* Mapping information handed to the destructor callback. */
+	CCLShmMapping* map = NULL;
+	/* Mapped segment and its size. */
+	void* ptr = NULL;
+	size_t map_size = size;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Map the segment. */
+	ptr = ccl_shm_map(name, &map_size, create, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	if (size == 0) size = map_size;
+
+	/* Check alignment for all devices in context. */
+	ccl_shm_check_align(ctx, ptr, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Wrap the mapped segment in a buffer. */
+	buf = ccl_buffer_new(ctx, flags | CL_MEM_USE_HOST_PTR, size, ptr,
+		&err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Release the mapping together with the buffer. */
+	map = g_slice_new(CCLShmMapping);
+	map->ptr = ptr;
+	map->size = map_size;
+	map->name = create ? g_strdup(name) : NULL;
+	ccl_memobj_set_destructor_callback((CCLMemObj*) buf,
+		ccl_shm_buffer_destructor, map, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+	/* The destructor callback was not set, release everything here. */
+	if (buf != NULL) ccl_buffer_destroy(buf);
+	if (map != NULL) {
+		g_free(map->name);
+		g_slice_free(CCLShmMapping, map);
+	}
+	if (ptr != NULL) ccl_shm_unmap(ptr, map_size, create ? name : NULL);
+	buf = NULL;
+
+finish:
+
+	/* Return new buffer wrapper. */
+	return buf;
+
+}
+
+/**
+ * Create or open a slot ring in a named POSIX shared memory segment.
+ *
+ * Each slot starts at a page boundary, so that slot memory can be
+ * used directly by OpenCL buffers (see
+ * ::ccl_shm_ring_new_slot_buffer()). Typically the consumer (OpenCL)
+ * process creates the ring and the producer process opens it.
+ *
+ * @public @memberof ccl_shm_ring
+ * @note Requires a POSIX system.
+ *
+ * @param[in] name Segment name, as used in `shm_open()`.
+ * @param[in] num_slots Number of slots. If `create` is false, can be
+ * 0, otherwise it must match the existing ring.
+ * @param[in] slot_size Usable size of each slot in bytes. If `create`
+ * is false, can be 0, otherwise it must match the existing ring.
+ * @param[in] create If true, a new segment is created (and this
+ * function fails if it already exists); otherwise an existing ring is
+ * opened.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return A new slot ring object, which should be freed with
+ * ::ccl_shm_ring_destroy(), or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLShmRing* ccl_shm_ring_new(const char* name, cl_uint num_slots,
+	size_t slot_size, cl_bool create, CCLErr** err) {
+
+	/* Make sure name is not NULL. */
+	g_return_val_if_fail(name != NULL, NULL);
+	/* Make sure ring geometry is given when creating a segment. */
+	g_return_val_if_fail(!create || (num_slots > 0 && slot_size > 0),
+		NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Slot ring object. */
+	CCLShmRing* ring = NULL;
+	/* Ring header. */
+	CCLShmRingHeader* hdr;
+	/* Mapped segment and its size. */
+	void* ptr = NULL;
+	size_t map_size = 0;
+	/* Page size. */
+	size_t page = ccl_shm_page_size();
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Determine segment size if we're creating it. */
+	if (create) {
+		map_size = ccl_shm_round_up(sizeof(CCLShmRingHeader)
+				+ num_slots * sizeof(CCLShmRingSlot), page)
+			+ num_slots * ccl_shm_round_up(slot_size, page);
+	}
+
+	/* Map the segment. */
+	ptr = ccl_shm_map(name, &map_size, create, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+	hdr = (CCLShmRingHeader*) ptr;
+
+	if (create) {
+
+		/* Initialize header and slots; the magic number is set last so
+		 * that other processes never see a half-initialized ring. */
+		CCLShmRingSlot* slots = (CCLShmRingSlot*) (hdr + 1);
+		hdr->num_slots = num_slots;
+		hdr->slot_size = slot_size;
+		hdr->slot_stride = ccl_shm_round_up(slot_size, page);
+		hdr->data_offset = ccl_shm_round_up(sizeof(CCLShmRingHeader)
+			+ num_slots * sizeof(CCLShmRingSlot), page);
+		g_atomic_int_set(&hdr->head, 0);
+		g_atomic_int_set(&hdr->tail, 0);
+		for (cl_uint i = 0; i < num_slots; ++i) {
+			slots[i].bytes = 0;
+			g_atomic_int_set(&slots[i].state, CCL_SHM_SLOT_FREE);
+		}
+		g_atomic_int_set(&hdr->magic, CCL_SHM_RING_MAGIC);
+
+	} else {
+
+		/* Validate the existing ring. */
+		g_if_err_create_goto(*err, CCL_ERROR,
+			(map_size < sizeof(CCLShmRingHeader))
+			|| (g_atomic_int_get(&hdr->magic) != CCL_SHM_RING_MAGIC),
+			CCL_ERROR_INVALID_DATA, error_handler,
+			"%s: shared memory segment '%s' does not contain an "
+			"initialized slot ring.",
+			CCL_STRD, name);
+		g_if_err_create_goto(*err, CCL_ERROR,
+			hdr->data_offset + hdr->num_slots * hdr->slot_stride
+				> map_size,
+			CCL_ERROR_INVALID_DATA, error_handler,
+			"%s: slot ring in shared memory segment '%s' is truncated.",
+			CCL_STRD, name);
+		g_if_err_create_goto(*err, CCL_ERROR,
+			((num_slots != 0) && (num_slots != hdr->num_slots))
+			|| ((slot_size != 0) && (slot_size != hdr->slot_size)),
+			CCL_ERROR_ARGS, error_handler,
+			"%s: slot ring in shared memory segment '%s' has %u slots "
+			"of %lu bytes, requested %u slots of %lu bytes.",
+			CCL_STRD, name, hdr->num_slots,
+			(unsigned long) hdr->slot_size, num_slots,
+			(unsigned long) slot_size);
+
+	}
+
+	/* Set up process-local ring object. */
+	ring = g_slice_new(CCLShmRing);
+	ring->base = ptr;
+	ring->map_size = map_size;
+	ring->hdr = hdr;
+	ring->slots = (CCLShmRingSlot*) (hdr + 1);
+	ring->name = create ? g_strdup(name) : NULL;
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+	/* Release the mapping, if any. */
+	if (ptr != NULL) ccl_shm_unmap(ptr, map_size, create ? name : NULL);
+
+finish:
+
+	/* Return new ring. */
+	return ring;
+
+}
+
+/**
+ * Unmap a slot ring. If the ring segment was created by this handle,
+ * it is also unlinked.
+ *
+ * @public @memberof ccl_shm_ring
+ *
+ * @param[in] ring The slot ring object, may be `NULL`.
+ * */
+CCL_EXPORT
+void ccl_shm_ring_destroy(CCLShmRing* ring) {
+
+	if (ring == NULL) return;
+
+	ccl_shm_unmap(ring->base, ring->map_size, ring->name);
+	g_free(ring->name);
+	g_slice_free(CCLShmRing, ring);
+
+}
+
+/**
+ * Get the number of slots in the ring.
+ *
+ * @public @memberof ccl_shm_ring
+ *
+ * @param[in] ring The slot ring object.
+ * @return The number of slots in the ring.
+ * */
+CCL_EXPORT
+cl_uint ccl_shm_ring_get_num_slots(CCLShmRing* ring) {
+
+	/* Make sure ring is not NULL. */
+	g_return_val_if_fail(ring != NULL, 0);
+
+	return ring->hdr->num_slots;
+
+}
+
+/**
+ * Get the capacity in bytes of each slot in the ring.
+ *
+ * @public @memberof ccl_shm_ring
+ *
+ * @param[in] ring The slot ring object.
+ * @return The capacity in bytes of each slot.
+ * */
+CCL_EXPORT
+size_t ccl_shm_ring_get_slot_size(CCLShmRing* ring) {
+
+	/* Make sure ring is not NULL. */
+	g_return_val_if_fail(ring != NULL, 0);
+
+	return (size_t) ring->hdr->slot_size;
+
+}
+
+/**
+ * Get a host pointer to the given slot. The pointer is page-aligned
+ * and valid in the calling process until the ring is destroyed.
+ *
+ * @public @memberof ccl_shm_ring
+ *
+ * @param[in] ring The slot ring object.
+ * @param[in] slot Slot index.
+ * @return A host pointer to the start of the slot.
+ * */
+CCL_EXPORT
+void* ccl_shm_ring_get_slot(CCLShmRing* ring, cl_uint slot) {
+
+	/* Make sure ring is not NULL. */
+	g_return_val_if_fail(ring != NULL, NULL);
+	/* Make sure slot is valid. */
+	g_return_val_if_fail(slot < ring->hdr->num_slots, NULL);
+
+	return (char*) ring->base + ring->hdr->data_offset
+		+ slot * ring->hdr->slot_stride;
+
+}
+
+/**
+ * Create a buffer which directly uses the memory of the given slot
+ * (`CL_MEM_USE_HOST_PTR`). Slot buffers are usually created once per
+ * slot and reused for every frame handed off through that slot. They
+ * must be destroyed before the ring.
+ *
+ * @public @memberof ccl_shm_ring
+ *
+ * @param[in] ring The slot ring object.
+ * @param[in] ctx Context wrapper.
+ * @param[in] flags OpenCL memory flags as used in clCreateBuffer();
+ * `CL_MEM_USE_HOST_PTR` is added automatically.
+ * @param[in] slot Slot index.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return A new buffer wrapper object, or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLBuffer* ccl_shm_ring_new_slot_buffer(CCLShmRing* ring,
+	CCLContext* ctx, cl_mem_flags flags, cl_uint slot, CCLErr** err) {
+
+	/* Make sure ring is not NULL. */
+	g_return_val_if_fail(ring != NULL, NULL);
+	/* Make sure ctx is not NULL. */
+	g_return_val_if_fail(ctx != NULL, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Buffer wrapper. */
+	CCLBuffer* buf = NULL;
+	/* Slot memory. */
+	void* ptr;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Check slot index. */
+	g_if_err_create_goto(*err, CCL_ERROR, slot >= ring->hdr->num_slots,
+		CCL_ERROR_ARGS, error_handler,
+		"%s: invalid slot %u, ring has %u slots.",
+		CCL_STRD, slot, ring->hdr->num_slots);
+	ptr = ccl_shm_ring_get_slot(ring, slot);
+
+	/* Check alignment for all devices in context. */
+	ccl_shm_check_align(ctx, ptr, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Wrap slot memory in a buffer. */
+	buf = ccl_buffer_new(ctx, flags | CL_MEM_USE_HOST_PTR,
+		(size_t) ring->hdr->slot_size, ptr, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+
+finish:
+
+	/* Return new buffer wrapper. */
+	return buf;
+
+}
+
+/**
+ * Acquire the next free slot for writing. Only one process (or
+ * thread) may act as producer for a given ring.
+ *
+ * @public @memberof ccl_shm_ring
+ *
+ * @param[in] ring The slot ring object.
+ * @return The index of the acquired slot, or -1 if all slots are in
+ * use (i.e. the consumer is lagging behind).
+ * */
+CCL_EXPORT
+cl_int ccl_shm_ring_produce_acquire(CCLShmRing* ring) {
+
+	/* Make sure ring is not NULL. */
+	g_return_val_if_fail(ring != NULL, -1);
+
+	gint slot = g_atomic_int_get(&ring->hdr->head);
+
+	if (!g_atomic_int_compare_and_exchange(&ring->slots[slot].state,
+			CCL_SHM_SLOT_FREE, CCL_SHM_SLOT_WRITING))
+		return -1;
+
+	return slot;
+
+}
+
+/**
+ * Publish a slot previously acquired with
+ * ::ccl_shm_ring_produce_acquire(), making it available to the
+ * consumer.
+ *
+ * @public @memberof ccl_shm_ring
+ *
+ * @param[in] ring The slot ring object.
+ * @param[in] slot Index of the slot to publish.
+ * @param[in] bytes Number of valid bytes written into the slot.
+ * */
+CCL_EXPORT
+void ccl_shm_ring_produce_commit(CCLShmRing* ring, cl_uint slot,
+	size_t bytes) {
+
+	/* Make sure ring is not NULL. */
+	g_return_if_fail(ring != NULL);
+	/* Make sure slot was acquired by the producer. */
+	g_return_if_fail((gint) slot == g_atomic_int_get(&ring->hdr->head));
+	g_return_if_fail(g_atomic_int_get(&ring->slots[slot].state)
+		== CCL_SHM_SLOT_WRITING);
+	/* Make sure data fits in the slot. */
+	g_return_if_fail(bytes <= ring->hdr->slot_size);
+
+	/* The atomic store of the state orders the size (and the slot
+	 * contents) before the hand-off. */
+	ring->slots[slot].bytes = bytes;
+	g_atomic_int_set(&ring->slots[slot].state, CCL_SHM_SLOT_READY);
+	g_atomic_int_set(&ring->hdr->head,
+		(gint) ((slot + 1) % ring->hdr->num_slots));
+
+}
+
+/**
+ * Acquire the oldest published slot for reading. Only one process (or
+ * thread) may act as consumer for a given ring.
+ *
+ * @public @memberof ccl_shm_ring
+ *
+ * @param[in] ring The slot ring object.
+ * @param[out] bytes Location where to put the number of valid bytes in
+ * the slot, or `NULL`.
+ * @return The index of the acquired slot, or -1 if no slot has been
+ * published.
+ * */
+CCL_EXPORT
+cl_int ccl_shm_ring_consume_acquire(CCLShmRing* ring, size_t* bytes) {
+
+	/* Make sure ring is not NULL. */
+	g_return_val_if_fail(ring != NULL, -1);
+
+	gint slot = g_atomic_int_get(&ring->hdr->tail);
+
+	if (!g_atomic_int_compare_and_exchange(&ring->slots[slot].state,
+			CCL_SHM_SLOT_READY, CCL_SHM_SLOT_READING))
+		return -1;
+
+	if (bytes != NULL) *bytes = (size_t) ring->slots[slot].bytes;
+
+	return slot;
+
+}
+
+/**
+ * Hand a slot previously acquired with ::ccl_shm_ring_consume_acquire()
+ * back to the producer. All device commands using the slot's memory
+ * must have completed before calling this function.
+ *
+ * @public @memberof ccl_shm_ring
+ *
+ * @param[in] ring The slot ring object.
+ * @param[in] slot Index of the slot to release.
+ * */
+CCL_EXPORT
+void ccl_shm_ring_consume_release(CCLShmRing* ring, cl_uint slot) {
+
+	/* Make sure ring is not NULL. */
+	g_return_if_fail(ring != NULL);
+	/* Make sure slot was acquired by the consumer. */
+	g_return_if_fail((gint) slot == g_atomic_int_get(&ring->hdr->tail));
+	g_return_if_fail(g_atomic_int_get(&ring->slots[slot].state)
+		== CCL_SHM_SLOT_READING);
+
+	g_atomic_int_set(&ring->hdr->tail,
+		(gint) ((slot + 1) % ring->hdr->num_slots));
+	g_atomic_int_set(&ring->slots[slot].state, CCL_SHM_SLOT_FREE);
+
+}
+
+/** @} */
@@ -0,0 +1,171 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+ /**
+ * @file
+ *
+ * Definition of buffers backed by POSIX shared memory and of a
+ * lock-free slot ring for handing off data between processes.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#ifndef _CCL_SHM_H_
+#define _CCL_SHM_H_
+
+#include "ccl_common.h"
+#include "ccl_buffer_wrapper.h"
+#include "ccl_context_wrapper.h"
+
+/**
+ * @defgroup CCL_SHM Shared memory
+ *
+ * This module provides buffers backed by named POSIX shared memory
+ * segments, allowing a separate producer process (e.g. an ingest
+ * process) to hand data over to an OpenCL consumer without copying
+ * it through sockets or pipes.
+ *
+ * The ::ccl_buffer_new_from_shm() constructor maps a named segment
+ * (created with `shm_open()`) into the calling process and wraps it
+ * in a ::CCLBuffer* using `CL_MEM_USE_HOST_PTR`. On CPU devices and
+ * devices with unified host memory this is zero-copy; on discrete
+ * devices it costs at most one DMA transfer per use.
+ *
+ * For streaming workloads, the ::CCLShmRing* object lays out a
+ * fixed number of equally sized slots in a shared segment, together
+ * with a small header which implements a single-producer /
+ * single-consumer lock-free hand-off protocol:
+ *
+ * 1. The producer calls ::ccl_shm_ring_produce_acquire() to obtain
+ * the next free slot, fills it through ::ccl_shm_ring_get_slot(), and
+ * publishes it with ::ccl_shm_ring_produce_commit().
+ * 2. The consumer calls ::ccl_shm_ring_consume_acquire() to obtain
+ * the oldest published slot, uses it (typically through a buffer
+ * created once with ::ccl_shm_ring_new_slot_buffer()), and hands it
+ * back to the producer with ::ccl_shm_ring_consume_release().
+ *
+ * The acquire functions never block; they return -1 if no slot is
+ * available, in which case clients may retry later. Slots are handed
+ * off in FIFO order. The consumer should only release a slot after
+ * all device commands using the slot buffer have completed.
+ *
+ * Since the producer modifies slot memory outside of OpenCL's
+ * control, consumers should map a slot buffer for writing
+ * (`CL_MAP_WRITE_INVALIDATE_REGION` where available) and immediately
+ * unmap it after acquiring a slot and before using it in device
+ * commands. This is cheap for `CL_MEM_USE_HOST_PTR` buffers, and makes
+ * implementations which cache host memory on the device pick up the
+ * new contents.
+ *
+ * Shared memory segments are unlinked when the object (ring or
+ * buffer) which created them is destroyed; processes which already
+ * mapped the segment keep access to it until they destroy their own
+ * objects.
+ *
+ * @note This module requires a POSIX system. On other systems the
+ * constructors in this module always fail with ::CCL_ERROR_OTHER.
+ *
+ * _Example:_
+ *
+ * @code{.c}
+ * // Producer process
+ * CCLShmRing* ring = ccl_shm_ring_new("/frames", 0, 0, CL_FALSE, NULL);
+ * cl_int slot = ccl_shm_ring_produce_acquire(ring);
+ * if (slot >= 0) {
+ *     memcpy(ccl_shm_ring_get_slot(ring, slot), frame, frame_size);
+ *     ccl_shm_ring_produce_commit(ring, slot, frame_size);
+ * }
+ * @endcode
+ * @code{.c}
+ * // Consumer process
+ * CCLShmRing* ring = ccl_shm_ring_new("/frames", 4, frame_size, CL_TRUE, &err);
+ * CCLBuffer* slot_bufs[4];
+ * for (cl_uint i = 0; i < 4; ++i)
+ *     slot_bufs[i] = ccl_shm_ring_new_slot_buffer(
+ *         ring, ctx, CL_MEM_READ_ONLY, i, &err);
+ * size_t bytes;
+ * cl_int slot = ccl_shm_ring_consume_acquire(ring, &bytes);
+ * if (slot >= 0) {
+ *     // ...map/unmap slot_bufs[slot], enqueue kernels, wait...
+ *     ccl_shm_ring_consume_release(ring, slot);
+ * }
+ * @endcode
+ *
+ * @{
+ */
+
+/**
+ * Lock-free slot ring over a named shared memory segment.
+ *
+ * @see ccl_shm_ring_new()
+ * */
+typedef struct ccl_shm_ring CCLShmRing;
+
+/* Create a buffer backed by a named POSIX shared memory segment. */
+CCL_EXPORT
+CCLBuffer* ccl_buffer_new_from_shm(CCLContext* ctx, cl_mem_flags flags,
+	const char* name, size_t size, cl_bool create, CCLErr** err);
+
+/* Create or open a slot ring in a named POSIX shared memory
+ * segment. */
+CCL_EXPORT
+CCLShmRing* ccl_shm_ring_new(const char* name, cl_uint num_slots,
+	size_t slot_size, cl_bool create, CCLErr** err);
+
+/* Unmap a slot ring, unlinking its segment if this handle created
+ * it. */
+CCL_EXPORT
+void ccl_shm_ring_destroy(CCLShmRing* ring);
+
+/* Get the number of slots in the ring. */
+CCL_EXPORT
+cl_uint ccl_shm_ring_get_num_slots(CCLShmRing* ring);
+
+/* Get the capacity in bytes of each slot in the ring. */
+CCL_EXPORT
+size_t ccl_shm_ring_get_slot_size(CCLShmRing* ring);
+
+/* Get a host pointer to the given slot. */
+CCL_EXPORT
+void* ccl_shm_ring_get_slot(CCLShmRing* ring, cl_uint slot);
+
+/* Create a buffer which directly uses the memory of the given slot. */
+CCL_EXPORT
+CCLBuffer* ccl_shm_ring_new_slot_buffer(CCLShmRing* ring,
+	CCLContext* ctx, cl_mem_flags flags, cl_uint slot, CCLErr** err);
+
+/* Acquire the next free slot for writing (producer side). */
+CCL_EXPORT
+cl_int ccl_shm_ring_produce_acquire(CCLShmRing* ring);
+
+/* Publish a previously acquired slot to the consumer. */
+CCL_EXPORT
+void ccl_shm_ring_produce_commit(CCLShmRing* ring, cl_uint slot,
+	size_t bytes);
+
+/* Acquire the oldest published slot for reading (consumer side). */
+CCL_EXPORT
+cl_int ccl_shm_ring_consume_acquire(CCLShmRing* ring, size_t* bytes);
+
+/* Hand a previously acquired slot back to the producer. */
+CCL_EXPORT
+void ccl_shm_ring_consume_release(CCLShmRing* ring, cl_uint slot);
+
+/** @} */
+
+#endif
@@ -0,0 +1,647 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+ /**
+ * @file
+ *
+ * Implementation of an uploader which sends compressible data to
+ * buffers in compressed form, decoding it on the device.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#include <string.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "ccl_uploader.h"
+#include "ccl_kernel_arg.h"
+#include "ccl_kernel_wrapper.h"
+#include "ccl_program_wrapper.h"
+#include "_ccl_defs.h"
+
+/**
+ * @internal
+ * Size of independently decoded blocks, in bytes.
+ * */
+#define CCL_UPLOADER_BLOCK_SIZE 4096
+
+/**
+ * @internal
+ * Writes smaller than this always use the raw path.
+ * */
+#define CCL_UPLOADER_MIN_SIZE 65536
+
+/**
+ * @internal
+ * Longest literal and repeat runs of the code.
+ * */
+#define CCL_UPLOADER_MAX_LITERAL 128
+#define CCL_UPLOADER_MAX_REPEAT 130
+
+/**
+ * @internal
+ * Default transfer and decoding bandwidths, in bytes per second.
+ * */
+#define CCL_UPLOADER_TRANSFER_BW 6e9
+#define CCL_UPLOADER_DECODE_BW 24e9
+
+/**
+ * @internal
+ * Name of the decoding kernel.
+ * */
+#define CCL_UPLOADER_KERNEL "ccl_rle_decode"
+
+/**
+ * @internal
+ * Source of the decoding kernel. The stream starts with the offsets of
+ * each block (plus the end offset of the last one), followed by the
+ * encoded blocks.
+ * */
+static const char* ccl_uploader_src =
+	"__kernel void " CCL_UPLOADER_KERNEL "(__global const uchar* src,\n"
+	"	__global uchar* dst, ulong dst_off, uint num_blocks)\n"
+	"{\n"
+	"	uint b = get_global_id(0);\n"
+	"	if (b >= num_blocks) return;\n"
+	"	__global const uint* offs = (__global const uint*) src;\n"
+	"	__global const uchar* in = src + offs[b];\n"
+	"	__global const uchar* end = src + offs[b + 1];\n"
+	"	__global uchar* out = dst + dst_off + (ulong) b * "
+		G_STRINGIFY(CCL_UPLOADER_BLOCK_SIZE) ";\n"
+	"	while (in < end) {\n"
+	"		uint c = *in++;\n"
+	"		if (c < 128) {\n"
+	"			for (uint k = 0; k <= c; ++k) *out++ = *in++;\n"
+	"		} else {\n"
+	"			uchar v = *in++;\n"
+	"			for (uint k = 0; k < c - 125; ++k) *out++ = v;\n"
+	"		}\n"
+	"	}\n"
+	"}\n";
+
+/**
+ * Compressed uploader.
+ * */
+struct ccl_uploader {
+
+	/**
+	 * Context of target buffers.
+	 * @private
+	 * */
+	CCLContext* ctx;
+
+	/**
+	 * Program with the decoding kernel, built on first use.
+	 * @private
+	 * */
+	CCLProgram* prg;
+
+	/**
+	 * Upload mode.
+	 * @private
+	 * */
+	CCLUploadMode mode;
+
+	/**
+	 * Host to device transfer bandwidth, in bytes per second.
+	 * @private
+	 * */
+	double transfer_bw;
+
+	/**
+	 * Device decoding bandwidth, in bytes per second.
+	 * @private
+	 * */
+	double decode_bw;
+
+	/**
+	 * Number of raw writes.
+	 * @private
+	 * */
+	cl_ulong num_raw;
+
+	/**
+	 * Number of compressed writes.
+	 * @private
+	 * */
+	cl_ulong num_compressed;
+
+	/**
+	 * Bytes written to buffers.
+	 * @private
+	 * */
+	cl_ulong bytes_in;
+
+	/**
+	 * Bytes sent to the device.
+	 * @private
+	 * */
+	cl_ulong bytes_sent;
+
+};
+
+/**
+ * @internal
+ * Length of the run of bytes equal to the first one, comparing sixteen
+ * bytes at a time with SSE2, or eight bytes at a time otherwise.
+ *
+ * @param[in] p Start of run.
+ * @param[in] n Maximum run length.
+ * @return Run length, at least one.
+ * */
+static size_t ccl_uploader_run(const guchar* p, size_t n) {
+
+	/* Run length. */
+	size_t r = 0;
+
+#ifdef __SSE2__
+
+	/* First byte replicated over a vector. */
+	__m128i pat = _mm_set1_epi8((char) p[0]);
+	/* Mask of bytes equal to the first one. */
+	int eq;
+
+	/* The first differing byte ends the run. */
+	while (r + sizeof(__m128i) <= n) {
+		eq = _mm_movemask_epi8(_mm_cmpeq_epi8(
+			_mm_loadu_si128((const __m128i*) (p + r)), pat));
+		if (eq != 0xFFFF)
+			return r + g_bit_nth_lsf((gulong) (~eq & 0xFFFF), -1);
+		r += sizeof(__m128i);
+	}
+
+#else
+
+	/* First byte replicated over a word. */
+	guint64 pat = p[0] * G_GUINT64_CONSTANT(0x0101010101010101);
+	/* Current word. */
+	guint64 w;
+
+	while (r + sizeof(guint64) <= n) {
+		memcpy(&w, p + r, sizeof(guint64));
+		if (w != pat) break;
+		r += sizeof(guint64);
+	}
+
+#endif
+
+	while ((r < n) && (p[r] == p[0])) ++r;
+
+	return r;
+
+}
+
+/**
+ * @internal
+ * Append literal bytes to the stream.
+ *
+ * @param[in,out] out Compressed stream.
+ * @param[in] p Literal bytes.
+ * @param[in] n Number of literal bytes.
+ * */
+static void ccl_uploader_put_literals(GByteArray* out, const guchar* p,
+	size_t n) {
+
+	while (n > 0) {
+		guint8 len = (guint8) MIN(n, CCL_UPLOADER_MAX_LITERAL);
+		guint8 c = len - 1;
+		g_byte_array_append(out, &c, 1);
+		g_byte_array_append(out, p, len);
+		p += len;
+		n -= len;
+	}
+
+}
+
+/**
+ * @internal
+ * Encode host data in blocks.
+ *
+ * @param[in] data Data to encode.
+ * @param[in] size Size of data in bytes.
+ * @param[in] max_size Give up if the stream becomes larger than this.
+ * @return The compressed stream, which should be freed with
+ * g_byte_array_unref(), or `NULL` if it would be larger than
+ * `max_size`.
+ * */
+static GByteArray* ccl_uploader_encode(const guchar* data, size_t size,
+	size_t max_size) {
+
+	/* Number of blocks. */
+	size_t num_blocks = (size + CCL_UPLOADER_BLOCK_SIZE - 1)
+		/ CCL_UPLOADER_BLOCK_SIZE;
+	/* Size of block offset table. */
+	size_t hdr_size = (num_blocks + 1) * sizeof(cl_uint);
+	/* Compressed stream. */
+	GByteArray* out;
+	/* End offset of last block. */
+	cl_uint end_off;
+
+	/* Block offsets are 32-bit. */
+	if ((hdr_size > max_size) || (size > G_MAXUINT32 / 2)) return NULL;
+
+	out = g_byte_array_sized_new(MIN(max_size, size / 4 + hdr_size));
+	g_byte_array_set_size(out, hdr_size);
+
+	for (size_t b = 0; b < num_blocks; ++b) {
+
+		/* Block limits. */
+		const guchar* blk = data + b * CCL_UPLOADER_BLOCK_SIZE;
+		size_t len = MIN(size - b * CCL_UPLOADER_BLOCK_SIZE,
+			CCL_UPLOADER_BLOCK_SIZE);
+		/* Current position and start of pending literals. */
+		size_t i = 0, lit = 0;
+		/* Block offset. */
+		cl_uint off = out->len;
+
+		memcpy(out->data + b * sizeof(cl_uint), &off, sizeof(cl_uint));
+
+		while (i < len) {
+			size_t run = ccl_uploader_run(
+				blk + i, MIN(len - i, CCL_UPLOADER_MAX_REPEAT));
+			if (run >= 3) {
+				guint8 tok[2] = { (guint8) (run + 125), blk[i] };
+				ccl_uploader_put_literals(out, blk + lit, i - lit);
+				g_byte_array_append(out, tok, 2);
+				i += run;
+				lit = i;
+			} else {
+				i += run;
+			}
+		}
+		ccl_uploader_put_literals(out, blk + lit, i - lit);
+
+		/* Give up if compression doesn't pay off. */
+		if (out->len > max_size) {
+			g_byte_array_unref(out);
+			return NULL;
+		}
+	}
+
+	/* End offset of last block. */
+	end_off = out->len;
+	memcpy(out->data + num_blocks * sizeof(cl_uint), &end_off,
+		sizeof(cl_uint));
+
+	return out;
+
+}
+
+/**
+ * @internal
+ * Check if the device of a queue shares memory with the host, in which
+ * case compression does not reduce the cost of a write.
+ *
+ * @param[in] cq Command queue wrapper object.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return `CL_TRUE` if the device shares memory with the host,
+ * `CL_FALSE` otherwise or if an error occurs.
+ * */
+static cl_bool ccl_uploader_is_unified(CCLQueue* cq, CCLErr** err) {
+
+	/* Unified memory? */
+	cl_bool unified = CL_FALSE;
+	/* Queue device and its type. */
+	CCLDevice* dev;
+	cl_device_type type;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	dev = ccl_queue_get_device(cq, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	type = ccl_device_get_info_scalar(
+		dev, CL_DEVICE_TYPE, cl_device_type, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	if (type & CL_DEVICE_TYPE_CPU) {
+		unified = CL_TRUE;
+	} else {
+#ifdef CL_DEVICE_HOST_UNIFIED_MEMORY
+		/* Deprecated in OpenCL 2.0, so a failed query just means we
+		 * don't know. */
+		unified = ccl_device_get_info_scalar(dev,
+			CL_DEVICE_HOST_UNIFIED_MEMORY, cl_bool, &err_internal);
+		if (err_internal != NULL) {
+			g_clear_error(&err_internal);
+			unified = CL_FALSE;
+		}
+#endif
+	}
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	unified = CL_FALSE;
+
+finish:
+
+	/* Return decision. */
+	return unified;
+
+}
+
+/**
+ * @addtogroup CCL_UPLOADER
+ * @{
+ */
+
+/**
+ * Create a new uploader.
+ *
+ * @public @memberof ccl_uploader
+ *
+ * @param[in] ctx Context of the buffers to write to.
+ * @param[in] mode How to send data to the device.
+ * @return A new uploader, which should be destroyed with
+ * ::ccl_uploader_destroy().
+ * */
+CCL_EXPORT
+CCLUploader* ccl_uploader_new(CCLContext* ctx, CCLUploadMode mode) {
+
+	/* Make sure ctx is not NULL. */
+	g_return_val_if_fail(ctx != NULL, NULL);
+
+	CCLUploader* up = g_slice_new0(CCLUploader);
+
+	up->ctx = ctx;
+	ccl_context_ref(ctx);
+	up->mode = mode;
+	up->transfer_bw = CCL_UPLOADER_TRANSFER_BW;
+	up->decode_bw = CCL_UPLOADER_DECODE_BW;
+
+	return up;
+
+}
+
+/**
+ * Destroy an uploader.
+ *
+ * @public @memberof ccl_uploader
+ *
+ * @param[in] up Uploader to destroy.
+ * */
+CCL_EXPORT
+void ccl_uploader_destroy(CCLUploader* up) {
+
+	/* Make sure up is not NULL. */
+	g_return_if_fail(up != NULL);
+
+	if (up->prg != NULL) ccl_program_destroy(up->prg);
+	ccl_context_unref(up->ctx);
+	g_slice_free(CCLUploader, up);
+
+}
+
+/**
+ * Set the bandwidths used for choosing the upload path in
+ * ::CCL_UPLOAD_AUTO mode. The compressed path is used when the
+ * compression ratio is larger than
+ * `1 / (1 - transfer_bw / decode_bw)`. By default, a transfer
+ * bandwidth of 6 GB/s and a decoding bandwidth of 24 GB/s are assumed,
+ * so data must compress at least by a third.
+ *
+ * @public @memberof ccl_uploader
+ *
+ * @param[in] up Uploader.
+ * @param[in] transfer_bw Host to device transfer bandwidth, in bytes
+ * per second.
+ * @param[in] decode_bw Device decoding bandwidth, in bytes of decoded
+ * data per second.
+ * */
+CCL_EXPORT
+void ccl_uploader_set_bandwidths(CCLUploader* up, double transfer_bw,
+	double decode_bw) {
+
+	/* Make sure up is not NULL. */
+	g_return_if_fail(up != NULL);
+	/* Make sure bandwidths are positive. */
+	g_return_if_fail((transfer_bw > 0) && (decode_bw > 0));
+
+	up->transfer_bw = transfer_bw;
+	up->decode_bw = decode_bw;
+
+}
+
+/**
+ * Write to a buffer object from host memory, possibly in compressed
+ * form, according to the uploader mode.
+ *
+ * On the compressed path, the host data is encoded and copied into a
+ * temporary device buffer before this function returns, so `ptr` can
+ * be reused immediately even for non-blocking writes. On the raw path
+ * this function behaves as ::ccl_buffer_enqueue_write().
+ *
+ * @public @memberof ccl_uploader
+ *
+ * @param[in] up Uploader.
+ * @param[in] buf Buffer object where to write data.
+ * @param[in] cq Command queue wrapper object in which to enqueue the
+ * write.
+ * @param[in] blocking_write Indicates if the write operation is
+ * blocking or non-blocking.
+ * @param[in] offset The offset in bytes in the buffer object to write
+ * to.
+ * @param[in] size The size in bytes of data being written.
+ * @param[in] ptr The pointer to buffer in host memory where data is to
+ * be written from.
+ * @param[in,out] evt_wait_lst List of events that need to complete
+ * before this command can be executed. The list will be cleared and
+ * can be reused by client code.
+ * @param[out] err Return location for a ::CCLErr object, or `NULL` if error
+ * reporting is to be ignored.
+ * @return Event wrapper object that identifies the write (or decoding)
+ * command, or `NULL` if an error occurs.
+ * */
+CCL_EXPORT
+CCLEvent* ccl_uploader_enqueue_write(CCLUploader* up, CCLBuffer* buf,
+	CCLQueue* cq, cl_bool blocking_write, size_t offset, size_t size,
+	const void* ptr, CCLEventWaitList* evt_wait_lst, CCLErr** err) {
+
+	/* Make sure up is not NULL. */
+	g_return_val_if_fail(up != NULL, NULL);
+	/* Make sure buf is not NULL. */
+	g_return_val_if_fail(buf != NULL, NULL);
+	/* Make sure cq is not NULL. */
+	g_return_val_if_fail(cq != NULL, NULL);
+	/* Make sure ptr is not NULL. */
+	g_return_val_if_fail(ptr != NULL, NULL);
+	/* Make sure err is NULL or it is not set. */
+	g_return_val_if_fail(err == NULL || *err == NULL, NULL);
+
+	/* Event wrapper to return. */
+	CCLEvent* evt = NULL;
+	/* Compressed stream. */
+	GByteArray* stream = NULL;
+	/* Compressed stream in device memory. */
+	CCLBuffer* dev_stream = NULL;
+	/* Decoding kernel. */
+	CCLKernel* krnl;
+	/* Kernel arguments. */
+	cl_ulong dst_off = offset;
+	cl_uint num_blocks;
+	/* Global work size. */
+	size_t gws;
+	/* Internal error handling object. */
+	CCLErr* err_internal = NULL;
+
+	/* Try to compress, unless raw writes are requested or known to be
+	 * faster. */
+	if (up->mode == CCL_UPLOAD_COMPRESSED) {
+
+		/* There must be something to decode. */
+		g_if_err_create_goto(*err, CCL_ERROR, size == 0,
+			CCL_ERROR_ARGS, error_handler,
+			"%s: compressed writes require a size larger than zero.",
+			CCL_STRD);
+
+		stream = ccl_uploader_encode(ptr, size, G_MAXSIZE);
+		g_if_err_create_goto(*err, CCL_ERROR, stream == NULL,
+			CCL_ERROR_ARGS, error_handler,
+			"%s: write of %" G_GSIZE_FORMAT " bytes is too large to " \
+			"be compressed.", CCL_STRD, size);
+
+	} else if ((up->mode == CCL_UPLOAD_AUTO)
+		&& (size >= CCL_UPLOADER_MIN_SIZE)
+		&& (up->decode_bw > up->transfer_bw)) {
+
+		cl_bool unified = ccl_uploader_is_unified(cq, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		/* Compressed stream plus decoding must take less time than the
+		 * raw write. */
+		if (!unified)
+			stream = ccl_uploader_encode(ptr, size,
+				(size_t) (size * (1.0 - up->transfer_bw / up->decode_bw)));
+	}
+
+	/* Raw path. */
+	if (stream == NULL) {
+
+		evt = ccl_buffer_enqueue_write(buf, cq, blocking_write, offset,
+			size, (void*) ptr, evt_wait_lst, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		up->num_raw++;
+		up->bytes_in += size;
+		up->bytes_sent += size;
+		goto finish;
+	}
+
+	/* Compressed path. Build decoding kernel, if not yet built. */
+	if (up->prg == NULL) {
+
+		CCLProgram* prg = ccl_program_new_from_source(
+			up->ctx, ccl_uploader_src, &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		ccl_program_build(prg, NULL, &err_internal);
+		if (err_internal != NULL) ccl_program_destroy(prg);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+
+		up->prg = prg;
+	}
+
+	krnl = ccl_program_get_kernel(up->prg, CCL_UPLOADER_KERNEL,
+		&err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Send compressed stream. */
+	dev_stream = ccl_buffer_new(up->ctx,
+		CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR, stream->len,
+		stream->data, &err_internal);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Decode it into the target buffer, one work-item per block. */
+	num_blocks = (cl_uint) ((size + CCL_UPLOADER_BLOCK_SIZE - 1)
+		/ CCL_UPLOADER_BLOCK_SIZE);
+	gws = num_blocks;
+	evt = ccl_kernel_set_args_and_enqueue_ndrange(krnl, cq, 1, NULL,
+		&gws, NULL, evt_wait_lst, &err_internal,
+		dev_stream, buf, ccl_arg_priv(dst_off, cl_ulong),
+		ccl_arg_priv(num_blocks, cl_uint), NULL);
+	g_if_err_propagate_goto(err, err_internal, error_handler);
+
+	/* Wait for decoding, if required. */
+	if (blocking_write) {
+		CCLEventWaitList ewl = NULL;
+		ccl_event_wait(ccl_ewl(&ewl, evt, NULL), &err_internal);
+		g_if_err_propagate_goto(err, err_internal, error_handler);
+	}
+
+	up->num_compressed++;
+	up->bytes_in += size;
+	up->bytes_sent += stream->len;
+
+	/* If we got here, everything is OK. */
+	g_assert(err == NULL || *err == NULL);
+	goto finish;
+
+error_handler:
+	/* If we got here there was an error, verify that it is so. */
+	g_assert(err == NULL || *err != NULL);
+	evt = NULL;
+
+finish:
+
+	/* Release temporary objects. The device stream is only freed by
+	 * OpenCL once the decoding kernel completes. */
+	if (dev_stream != NULL) ccl_buffer_destroy(dev_stream);
+	if (stream != NULL) g_byte_array_unref(stream);
+
+	/* Return event. */
+	return evt;
+
+}
+
+/**
+ * Get uploader statistics.
+ *
+ * @public @memberof ccl_uploader
+ *
+ * @param[in] up Uploader.
+ * @param[out] num_raw Location where to put the number of raw writes,
+ * or `NULL`.
+ * @param[out] num_compressed Location where to put the number of
+ * compressed writes, or `NULL`.
+ * @param[out] bytes_in Location where to put the number of bytes
+ * written to buffers, or `NULL`.
+ * @param[out] bytes_sent Location where to put the number of bytes
+ * actually sent to the device, or `NULL`.
+ * */
+CCL_EXPORT
+void ccl_uploader_get_stats(CCLUploader* up, cl_ulong* num_raw,
+	cl_ulong* num_compressed, cl_ulong* bytes_in, cl_ulong* bytes_sent) {
+
+	/* Make sure up is not NULL. */
+	g_return_if_fail(up != NULL);
+
+	if (num_raw != NULL) *num_raw = up->num_raw;
+	if (num_compressed != NULL) *num_compressed = up->num_compressed;
+	if (bytes_in != NULL) *bytes_in = up->bytes_in;
+	if (bytes_sent != NULL) *bytes_sent = up->bytes_sent;
+
+}
+
+/** @} */
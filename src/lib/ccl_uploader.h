@@ -0,0 +1,128 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+ /**
+ * @file
+ *
+ * Definition of an uploader which sends compressible data to buffers
+ * in compressed form, decoding it on the device.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#ifndef _CCL_UPLOADER_H_
+#define _CCL_UPLOADER_H_
+
+#include "ccl_common.h"
+#include "ccl_buffer_wrapper.h"
+#include "ccl_context_wrapper.h"
+#include "ccl_event_wrapper.h"
+#include "ccl_queue_wrapper.h"
+
+/**
+ * @defgroup CCL_UPLOADER Compressed uploads
+ *
+ * This module provides an uploader which writes host data to buffers
+ * either as is, or compressed with a run-length code and decoded into
+ * the target buffer by an OpenCL kernel. Data such as masks, label
+ * images or sparse arrays often compresses several times over, in
+ * which case sending the compressed stream and decoding it on the
+ * device is faster than a bandwidth-bound raw write.
+ *
+ * Data is split in independent blocks of 4 KiB, each decoded by one
+ * work-item. Within a block, a control byte `c` below 128 is followed by
+ * `c + 1` literal bytes, while a control byte of 128 or more is followed
+ * by a single byte which is repeated `c - 125` times. Runs are found on
+ * the host by comparing eight bytes at a time.
+ *
+ * In ::CCL_UPLOAD_AUTO mode, the compressed path is used when the
+ * compressed stream plus its decoding is estimated to take less time
+ * than the raw write, given the transfer and decoding bandwidths
+ * (which can be tuned with ::ccl_uploader_set_bandwidths()). Encoding
+ * stops early, and the raw path is used, as soon as the stream becomes
+ * too large for compression to pay off. Small writes and devices which
+ * share memory with the host always use the raw path.
+ *
+ * The decoding kernel is built the first time it is needed. Uploaders
+ * should not be used concurrently by several threads.
+ *
+ * _Example:_
+ *
+ * @code{.c}
+ * CCLUploader* up = ccl_uploader_new(ctx, CCL_UPLOAD_AUTO);
+ * @endcode
+ * @code{.c}
+ * ccl_uploader_enqueue_write(up, buf, cq, CL_TRUE, 0, size, mask,
+ *     NULL, &err);
+ * @endcode
+ * @code{.c}
+ * ccl_uploader_destroy(up);
+ * @endcode
+ *
+ * @{
+ */
+
+/**
+ * How ::ccl_uploader_enqueue_write() sends data to the device.
+ * */
+typedef enum ccl_upload_mode {
+
+	/** Compress when it is estimated to be faster than a raw write. */
+	CCL_UPLOAD_AUTO       = 0,
+	/** Always use a raw write. */
+	CCL_UPLOAD_RAW        = 1,
+	/** Always compress and decode on the device. */
+	CCL_UPLOAD_COMPRESSED = 2
+
+} CCLUploadMode;
+
+/**
+ * Compressed uploader.
+ *
+ * @see ccl_uploader_new()
+ * */
+typedef struct ccl_uploader CCLUploader;
+
+/* Create a new uploader. */
+CCL_EXPORT
+CCLUploader* ccl_uploader_new(CCLContext* ctx, CCLUploadMode mode);
+
+/* Destroy an uploader. */
+CCL_EXPORT
+void ccl_uploader_destroy(CCLUploader* up);
+
+/* Set the bandwidths used for choosing the upload path. */
+CCL_EXPORT
+void ccl_uploader_set_bandwidths(CCLUploader* up, double transfer_bw,
+	double decode_bw);
+
+/* Write to a buffer object from host memory, possibly in compressed
+ * form. */
+CCL_EXPORT
+CCLEvent* ccl_uploader_enqueue_write(CCLUploader* up, CCLBuffer* buf,
+	CCLQueue* cq, cl_bool blocking_write, size_t offset, size_t size,
+	const void* ptr, CCLEventWaitList* evt_wait_lst, CCLErr** err);
+
+/* Get uploader statistics. */
+CCL_EXPORT
+void ccl_uploader_get_stats(CCLUploader* up, cl_ulong* num_raw,
+	cl_ulong* num_compressed, cl_ulong* bytes_in, cl_ulong* bytes_sent);
+
+/** @} */
+
+#endif
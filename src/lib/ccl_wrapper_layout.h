@@ -0,0 +1,110 @@
+/*
+ * This file is part of cf4ocl (C Framework for OpenCL).
+ *
+ * cf4ocl is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ *
+ * cf4ocl is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with cf4ocl. If not, see
+ * <http://www.gnu.org/licenses/>.
+ * */
+
+ /**
+ * @file
+ *
+ * Definition of the stable layout prefix shared by all wrapper objects,
+ * and of inline accessors for the wrapped OpenCL objects.
+ *
+ * @copyright [GNU Lesser General Public License version 3 (LGPLv3)](http://www.gnu.org/licenses/lgpl.html)
+ * */
+
+#ifndef _CCL_WRAPPER_LAYOUT_H_
+#define _CCL_WRAPPER_LAYOUT_H_
+
+#include "ccl_common.h"
+
+/**
+ * @defgroup CCL_WRAPPER_LAYOUT Wrapper layout
+ *
+ * This module exposes the first fields of every wrapper object, which
+ * are the class of the wrapped object and the wrapped OpenCL object
+ * itself. The remaining fields of wrapper objects are private, but
+ * this prefix is part of the _cf4ocl_ ABI and does not change between
+ * releases with the same major version.
+ *
+ * The `ccl_*_unwrap()` macros use ::ccl_wrapper_unwrap_inline(), which
+ * reads the wrapped object directly from the prefix instead of calling
+ * the exported ::ccl_wrapper_unwrap() function. Unwrapping happens
+ * several times per enqueued command, both in client code and within
+ * the library, so avoiding the function call removes part of the
+ * per-command overhead.
+ *
+ * As with all other functions, the `NULL` check performed by
+ * ::ccl_wrapper_unwrap_inline() is compiled out if `G_DISABLE_CHECKS` is
+ * defined. The library itself is built this way in `Release` builds,
+ * unless the `DISABLE_CHECKS` CMake option is turned off.
+ *
+ * @{
+ */
+
+/**
+ * Stable layout prefix of all wrapper objects.
+ * */
+typedef struct ccl_wrapper_prefix {
+
+	/**
+	 * The class or type of wrapped OpenCL object.
+	 * @public
+	 * */
+	CCLClass type;
+
+	/**
+	 * The wrapped OpenCL object.
+	 * @public
+	 * */
+	void* cl_object;
+
+} CCLWrapperPrefix;
+
+/**
+ * Get the wrapped OpenCL object, without a function call.
+ *
+ * @param[in] wrapper The wrapper object.
+ * @return The wrapped OpenCL object, or `NULL` if `wrapper` is `NULL`.
+ * */
+static inline void* ccl_wrapper_unwrap_inline(const CCLWrapper* wrapper) {
+
+	/* Make sure wrapper is not NULL. */
+	g_return_val_if_fail(wrapper != NULL, NULL);
+
+	/* Return the OpenCL wrapped object. */
+	return ((const CCLWrapperPrefix*) wrapper)->cl_object;
+}
+
+/**
+ * Get the class of the wrapped OpenCL object, without a function call.
+ *
+ * @param[in] wrapper The wrapper object.
+ * @return The class of the wrapped OpenCL object, or ::CCL_NONE if
+ * `wrapper` is `NULL`.
+ * */
+static inline CCLClass ccl_wrapper_get_class_inline(
+	const CCLWrapper* wrapper) {
+
+	/* Make sure wrapper is not NULL. */
+	g_return_val_if_fail(wrapper != NULL, CCL_NONE);
+
+	/* Return the class of the OpenCL wrapped object. */
+	return ((const CCLWrapperPrefix*) wrapper)->type;
+}
+
+/** @} */
+
+#endif
@@ -33,18 +33,23 @@ extern "C" {
 #endif
 
 #include <cf4ocl2/ccl_abstract_wrapper.h>
+#include <cf4ocl2/ccl_batch.h>
 #include <cf4ocl2/ccl_buffer_wrapper.h>
 #include <cf4ocl2/ccl_common.h>
 #include <cf4ocl2/ccl_context_wrapper.h>
+#include <cf4ocl2/ccl_cost_model.h>
 #include <cf4ocl2/ccl_device_query.h>
 #include <cf4ocl2/ccl_device_selector.h>
 #include <cf4ocl2/ccl_device_wrapper.h>
 #include <cf4ocl2/ccl_errors.h>
 #include <cf4ocl2/ccl_event_wrapper.h>
+#include <cf4ocl2/ccl_fusion.h>
 #include <cf4ocl2/ccl_image_wrapper.h>
 #include <cf4ocl2/ccl_kernel_arg.h>
 #include <cf4ocl2/ccl_kernel_wrapper.h>
+#include <cf4ocl2/ccl_load_registry.h>
 #include <cf4ocl2/ccl_memobj_wrapper.h>
+#include <cf4ocl2/ccl_mirror_buffer.h>
 #include <cf4ocl2/ccl_oclversions.h>
 #include <cf4ocl2/ccl_platforms.h>
 #include <cf4ocl2/ccl_platform_wrapper.h>
@@ -52,6 +57,10 @@ extern "C" {
 #include <cf4ocl2/ccl_program_wrapper.h>
 #include <cf4ocl2/ccl_queue_wrapper.h>
 #include <cf4ocl2/ccl_sampler_wrapper.h>
+#include <cf4ocl2/ccl_session.h>
+#include <cf4ocl2/ccl_shm.h>
+#include <cf4ocl2/ccl_uploader.h>
+#include <cf4ocl2/ccl_wrapper_layout.h>
 
 #ifdef __cplusplus
 }
@@ -56,6 +56,29 @@ setup() {
 
 }
 
+# Test streaming canonical example
+@test "Streaming canonical example" {
+
+	# Use small dataset and tiles, with an incomplete last tile
+	run ${CCL_EXBIN_PATH}/canon_stream ${CCL_TEST_DEVICE_INDEX} 1000000 65536
+
+	# Check output
+	[[ "$output" =~  "Kernel execution produced the expected results." ]]
+
+	# There should be no problems
+	[ "$status" -eq 0 ]
+
+	# Same test with host array source
+	run ${CCL_EXBIN_PATH}/canon_stream ${CCL_TEST_DEVICE_INDEX} 1000000 65536 array
+
+	# Check output
+	[[ "$output" =~  "Kernel execution produced the expected results." ]]
+
+	# There should be no problems
+	[ "$status" -eq 0 ]
+
+}
+
 # Test celullar automata example
 @test "Cellular automata example" {
 
@@ -64,11 +87,70 @@ setup() {
 	# There should be no problems
 	[ "$status" -eq 0 ]
 
-	# Check if images files were created
+	# Check if images files were created (initial state plus one image
+	# per iteration)
 	CCL_EXCA_NIMGS=`ls out000*.png -la | wc -l`
-	[ "$CCL_EXCA_NIMGS" -eq 64 ]
+	[ "$CCL_EXCA_NIMGS" -eq 65 ]
 	rm -rf out000*.png
 
+	# Test a larger, non-square grid, saving every 10 iterations
+	run ${CCL_EXBIN_PATH}/ca ${CCL_TEST_DEVICE_INDEX} 0 300 200 50 10
+
+	# There should be no problems
+	[ "$status" -eq 0 ]
+
+	# Check throughput is reported and image files were created
+	[[ "$output" =~ "Iterations per second" ]]
+	CCL_EXCA_NIMGS=`ls out000*.png -la | wc -l`
+	[ "$CCL_EXCA_NIMGS" -eq 6 ]
+	rm -rf out000*.png
+
+}
+
+# Test convolution example
+@test "Convolution example" {
+
+	# Use small image and radii so that the test runs quickly
+	run ${CCL_EXBIN_PATH}/convolution ${CCL_TEST_DEVICE_INDEX} float 256 3
+
+	# Check output
+	[[ "$output" =~ "All kernel variants produced the same results." ]]
+
+	# There should be no problems
+	[ "$status" -eq 0 ]
+
+	# Same test with uchar data
+	run ${CCL_EXBIN_PATH}/convolution ${CCL_TEST_DEVICE_INDEX} uchar 256 3
+
+	# Check output
+	[[ "$output" =~ "All kernel variants produced the same results." ]]
+
+	# There should be no problems
+	[ "$status" -eq 0 ]
+
+}
+
+# Test multi-device cellular automata example
+@test "Multi-device cellular automata example" {
+
+	# Use a small grid so that the test runs quickly
+	run ${CCL_EXBIN_PATH}/ca_multi all 0 256 256 20
+
+	# Check output
+	[[ "$output" =~ "All decompositions produced the expected results." ]]
+
+	# There should be no problems
+	[ "$status" -eq 0 ]
+
+	# Same test with halo exchange through host memory
+	run ${CCL_EXBIN_PATH}/ca_multi all 0 256 256 20 host
+
+	# Check output
+	[[ "$output" =~ "All decompositions produced the expected results." ]]
+
+	# There should be no problems
+	[ "$status" -eq 0 ]
+
 }
 
 # Test device filter example
@@ -134,3 +216,42 @@ setup() {
 	rm -rf out.png
 
 }
+
+# Test transfer benchmark example
+@test "Transfer benchmark example" {
+
+	run ${CCL_EXBIN_PATH}/transfer_bench ${CCL_TEST_DEVICE_INDEX} 16 2
+
+	# Check output
+	[[ "$output" =~  "All transfer modes produced the expected results." ]]
+
+	# There should be no problems
+	[ "$status" -eq 0 ]
+
+}
+
+# Test fusion benchmark example
+@test "Fusion benchmark example" {
+
+	run ${CCL_EXBIN_PATH}/fusion_bench ${CCL_TEST_DEVICE_INDEX} 1 2
+
+	# Check output
+	[[ "$output" =~  "Fused and unfused chains produced the same results." ]]
+
+	# There should be no problems
+	[ "$status" -eq 0 ]
+
+}
+
+# Test batch benchmark example
+@test "Batch benchmark example" {
+
+	run ${CCL_EXBIN_PATH}/batch_bench ${CCL_TEST_DEVICE_INDEX} 64 64
+
+	# Check output
+	[[ "$output" =~  "Batched and per-problem launches produced the same results." ]]
+
+	# There should be no problems
+	[ "$status" -eq 0 ]
+
+}
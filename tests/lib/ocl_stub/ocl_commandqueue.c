@@ -41,6 +41,7 @@ clCreateCommandQueue(cl_context context, cl_device_id device,
 	queue->device = device;
 	queue->properties = properties;
 	queue->ref_count = 1;
+	queue->size = 0;
 
 	return queue;
 
@@ -52,11 +53,42 @@ clCreateCommandQueueWithProperties(cl_context context,
 	cl_device_id device, const cl_queue_properties* properties,
 	cl_int* errcode_ret) {
 
+	cl_command_queue queue;
+	cl_command_queue_properties queue_props = 0;
+	cl_uint queue_size = 0;
+
+	/* Parse zero-terminated list of properties. */
+	for (cl_uint i = 0; (properties != NULL) && (properties[i] != 0);
+			i += 2) {
+		if (properties[i] == CL_QUEUE_PROPERTIES) {
+			queue_props = (cl_command_queue_properties) properties[i + 1];
+		} else if (properties[i] == CL_QUEUE_SIZE) {
+			queue_size = (cl_uint) properties[i + 1];
+		} else {
+			seterrcode(errcode_ret, CL_INVALID_VALUE);
+			return NULL;
+		}
+	}
+
+	/* On-device queues must be out-of-order, and only they have a size. */
+	if (((queue_props & CL_QUEUE_ON_DEVICE)
+			&& !(queue_props & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE))
+		|| ((queue_props & CL_QUEUE_ON_DEVICE_DEFAULT)
+			&& !(queue_props & CL_QUEUE_ON_DEVICE))
+		|| ((queue_size > 0) && !(queue_props & CL_QUEUE_ON_DEVICE))) {
+		seterrcode(errcode_ret, CL_INVALID_VALUE);
+		return NULL;
+	}
+
 	CCL_BEGIN_IGNORE_DEPRECATIONS
-	return clCreateCommandQueue(context, device, *properties,
+	queue = clCreateCommandQueue(context, device, queue_props,
 		errcode_ret);
 	CCL_END_IGNORE_DEPRECATIONS
 
+	queue->size = queue_size;
+
+	return queue;
+
 }
 #endif
 
@@ -101,6 +133,10 @@ clGetCommandQueueInfo(cl_command_queue command_queue,
 				ccl_test_basic_info(cl_uint, command_queue, ref_count);
 			case CL_QUEUE_PROPERTIES:
 				ccl_test_basic_info(cl_command_queue_properties, command_queue, properties);
+#ifdef CL_VERSION_2_0
+			case CL_QUEUE_SIZE:
+				ccl_test_basic_info(cl_uint, command_queue, size);
+#endif
 			default:
 				status = CL_INVALID_VALUE;
 		}
@@ -116,6 +116,8 @@ clGetDeviceInfo(cl_device_id device, cl_device_info param_name,
 				ccl_test_basic_info(size_t, device, image_max_buffer_size);
 			case CL_DEVICE_IMAGE_MAX_ARRAY_SIZE:
 				ccl_test_basic_info(size_t, device, image_max_array_size);
+			case CL_DEVICE_IMAGE_PITCH_ALIGNMENT:
+				ccl_test_basic_info(cl_uint, device, image_pitch_alignment);
 			case CL_DEVICE_LINKER_AVAILABLE:
 				ccl_test_basic_info(cl_bool, device, linker_available);
 			case CL_DEVICE_LOCAL_MEM_SIZE:
@@ -204,6 +206,12 @@ clGetDeviceInfo(cl_device_id device, cl_device_info param_name,
 				ccl_test_basic_info(size_t, device, profiling_timer_resolution);
 			case CL_DEVICE_QUEUE_PROPERTIES:
 				ccl_test_basic_info(cl_command_queue_properties, device, queue_properties);
+#ifdef CL_VERSION_2_0
+			case CL_DEVICE_QUEUE_ON_DEVICE_MAX_SIZE:
+				ccl_test_basic_info(cl_uint, device, queue_on_device_max_size);
+			case CL_DEVICE_QUEUE_ON_DEVICE_PREFERRED_SIZE:
+				ccl_test_basic_info(cl_uint, device, queue_on_device_preferred_size);
+#endif
 			case CL_DEVICE_SINGLE_FP_CONFIG:
 				ccl_test_basic_info(cl_device_fp_config, device, single_fp_config);
 			case CL_DEVICE_TYPE:
@@ -41,11 +41,13 @@ clEnqueueNDRangeKernel(cl_command_queue command_queue, cl_kernel kernel,
 	(void)(global_work_offset);
 	(void)(global_work_size);
 	(void)(local_work_size);
-	(void)(num_events_in_wait_list);
-	(void)(event_wait_list);
 
-	/* Set event. */
+	/* Set event, which only completes when the events in the wait list
+	 * do. */
 	ocl_stub_create_event(event, command_queue, CL_COMMAND_NDRANGE_KERNEL);
+	if (event != NULL)
+		ocl_stub_event_wait_on(
+			*event, num_events_in_wait_list, event_wait_list);
 
 	/* All good. */
 	return CL_SUCCESS;
@@ -180,11 +182,13 @@ clEnqueueWriteBuffer(cl_command_queue command_queue, cl_mem buffer,
 
 	/* These are ignored. */
 	(void)(blocking_write);
-	(void)(num_events_in_wait_list);
-	(void)(event_wait_list);
 
-	/* Set event. */
+	/* Set event, which only completes when the events in the wait list
+	 * do. */
 	ocl_stub_create_event(event, command_queue, CL_COMMAND_WRITE_BUFFER);
+	if (event != NULL)
+		ocl_stub_event_wait_on(
+			*event, num_events_in_wait_list, event_wait_list);
 
 	/* Write to buffer. */
 	g_memmove(((cl_uchar*) buffer->mem) + offset, ptr, size);
@@ -932,10 +936,10 @@ clEnqueueMarkerWithWaitList(cl_command_queue command_queue,
 	cl_uint num_events_in_wait_list, const cl_event* event_wait_list,
 	cl_event* event) {
 
-	(void)(num_events_in_wait_list);
-	(void)(event_wait_list);
-
 	ocl_stub_create_event(event, command_queue, CL_COMMAND_MARKER);
+	if (event != NULL)
+		ocl_stub_event_wait_on(
+			*event, num_events_in_wait_list, event_wait_list);
 	return CL_SUCCESS;
 
 }
@@ -26,7 +26,7 @@
 
 #include "ocl_env.h"
 
-const cl_uint ccl_test_num_platforms = 3;
+const cl_uint ccl_test_num_platforms = 4;
 
 const struct _cl_platform_id ccl_test_platforms[] = {
 	{
@@ -57,7 +57,7 @@ const struct _cl_platform_id ccl_test_platforms[] = {
 				.endian_little = CL_TRUE,
 				.error_correction_support = CL_FALSE,
 				.execution_capabilities = CL_EXEC_KERNEL,
-				.extensions = "cl_khr_int64_base_atomics cl_khr_fp16 cl_khr_gl_sharing cl_khr_gl_event cl_khr_d3d10_sharing cl_khr_dx9_media_sharing cl_khr_d3d11_sharing",
+				.extensions = "cl_khr_int64_base_atomics cl_khr_fp16 cl_khr_gl_sharing cl_khr_gl_event cl_khr_d3d10_sharing cl_khr_dx9_media_sharing cl_khr_d3d11_sharing cl_khr_image2d_from_buffer",
 				.global_mem_cache_size = 16384,
 				.global_mem_cache_type = CL_READ_ONLY_CACHE,
 				.global_mem_cacheline_size = 32,
@@ -72,6 +72,7 @@ const struct _cl_platform_id ccl_test_platforms[] = {
 				.image3d_max_width = 4096,
 				.image_max_buffer_size = 33554432,
 				.image_max_array_size = 16384,
+				.image_pitch_alignment = 16,
 				.linker_available = CL_TRUE,
 				.local_mem_size =  32768,
 				.local_mem_type = CL_LOCAL,
@@ -391,6 +392,101 @@ const struct _cl_platform_id ccl_test_platforms[] = {
 				.ref_count = 1
 			}
 		}
+	},
+	{
+		.profile = "FULL_PROFILE",
+		.version = "OpenCL 2.0",
+		.name = "cf4ocl test platform #3",
+		.vendor = "FakenMC p3",
+		.extensions = "cl_khr_icd",
+		.image_formats = (const cl_image_format[]) {
+			{
+				.image_channel_order = CL_RGBA,
+				.image_channel_data_type = CL_UNORM_INT8
+			}
+		},
+		.num_image_formats = 1,
+		.num_devices = 1,
+		.devices = (const struct _cl_device_id[]) {
+			{
+				.address_bits = 64,
+				.available = CL_TRUE,
+				.built_in_kernels = "",
+				.compiler_available = CL_TRUE,
+				.double_fp_config = CL_FP_DENORM | CL_FP_INF_NAN | CL_FP_ROUND_TO_ZERO | CL_FP_ROUND_TO_INF | CL_FP_FMA,
+				.endian_little = CL_TRUE,
+				.error_correction_support = CL_TRUE,
+				.execution_capabilities = CL_EXEC_KERNEL,
+				.extensions = "cl_khr_int64_base_atomics cl_khr_int64_extended_atomics",
+				.global_mem_cache_size = 4194304,
+				.global_mem_cache_type = CL_READ_WRITE_CACHE,
+				.global_mem_cacheline_size = 64,
+				.global_mem_size = 2147483648,
+				.half_fp_config = CL_FP_DENORM | CL_FP_INF_NAN | CL_FP_ROUND_TO_ZERO | CL_FP_ROUND_TO_INF | CL_FP_FMA,
+				.host_unified_memory = CL_TRUE,
+				.image_support = CL_FALSE,
+				.image2d_max_height = 0,
+				.image2d_max_width = 0,
+				.image3d_max_depth = 0,
+				.image3d_max_height = 0,
+				.image3d_max_width = 0,
+				.image_max_buffer_size = 0,
+				.image_max_array_size = 0,
+				.linker_available = CL_TRUE,
+				.local_mem_size =  65536,
+				.local_mem_type = CL_GLOBAL,
+				.max_clock_frequency = 2500,
+				.max_compute_units = 4,
+				.max_constant_args = 9,
+				.max_constant_buffer_size = 65536,
+				.max_mem_alloc_size = 2147483648,
+				.max_parameter_size = 1024,
+				.max_read_image_args = 0,
+				.max_samplers = 0,
+				.max_work_group_size = 1024,
+				.max_work_item_dimensions = 3,
+				.max_work_item_sizes = (size_t const[]) {512, 256, 8, 0},
+				.max_write_image_args = 0,
+				.mem_base_addr_align = 1024,
+				.min_data_type_align_size = 0, /* Deprecated in OpenCL 1.2 */
+				.name = "cf4ocl OpenCL 2.0 device",
+				.native_vector_width_char = 8,
+				.native_vector_width_short = 4,
+				.native_vector_width_int = 2,
+				.native_vector_width_long = 1,
+				.native_vector_width_float = 2,
+				.native_vector_width_double = 1,
+				.native_vector_width_half = 4,
+				.opencl_c_version = "OpenCL C 2.0",
+				.parent_device = NULL,
+				.partition_max_sub_devices = 0,
+				.partition_properties = (cl_device_partition_property const[]) {0},
+				.partition_affinity_domain = 0,
+				.partition_type = (cl_device_partition_property[]) {0},
+				.platform_id = (const cl_platform_id) &ccl_test_platforms[3],
+				.preferred_vector_width_char = 8,
+				.preferred_vector_width_short = 4,
+				.preferred_vector_width_int = 2,
+				.preferred_vector_width_long = 1,
+				.preferred_vector_width_float = 2,
+				.preferred_vector_width_double = 1,
+				.preferred_vector_width_half = 4,
+				.printf_buffer_size = 1048576,
+				.preferred_interop_user_sync = CL_FALSE,
+				.profile = "FULL_PROFILE",
+				.profiling_timer_resolution = 100,
+				.queue_properties = CL_QUEUE_PROFILING_ENABLE | CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE,
+				.queue_on_device_max_size = 262144,
+				.queue_on_device_preferred_size = 16384,
+				.single_fp_config = CL_FP_DENORM | CL_FP_INF_NAN | CL_FP_ROUND_TO_ZERO | CL_FP_ROUND_TO_INF | CL_FP_FMA,
+				.type = CL_DEVICE_TYPE_GPU,
+				.vendor = "FakenMC",
+				.vendor_id = 0xFFFF,
+				.version = "OpenCL 2.0 cf4ocl",
+				.driver_version = "2.0.0",
+				.ref_count = 1
+			}
+		}
 	}
 };
 
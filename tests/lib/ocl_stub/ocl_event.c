@@ -61,6 +61,12 @@ clGetEventProfilingInfo(cl_event event, cl_profiling_info param_name,
 				ccl_test_basic_info(cl_ulong, event, t_start);
 			case CL_PROFILING_COMMAND_END:
 				ccl_test_basic_info(cl_ulong, event, t_end);
+#ifdef CL_VERSION_2_0
+			/* No child kernels are executed, so commands complete when
+			 * they end. */
+			case CL_PROFILING_COMMAND_COMPLETE:
+				ccl_test_basic_info(cl_ulong, event, t_end);
+#endif
 			default:
 				status = CL_INVALID_VALUE;
 		}
@@ -80,6 +86,7 @@ clGetEventInfo(cl_event event, cl_event_info param_name,
 	if (event == NULL) {
 		status = CL_INVALID_EVENT;
 	} else {
+		ocl_stub_event_update(event);
 		switch (param_name) {
 			case CL_EVENT_COMMAND_QUEUE:
 				ccl_test_basic_info(cl_command_queue, event, command_queue);
@@ -122,6 +129,7 @@ clReleaseEvent(cl_event event) {
 	/* Decrement reference count and check if it reaches 0. */
 	if (g_atomic_int_dec_and_test(&event->ref_count)) {
 
+		ocl_stub_event_release_wait_list(event);
 		g_slice_free(struct _cl_event, event);
 
 	}
@@ -133,10 +141,20 @@ clReleaseEvent(cl_event event) {
 CL_API_ENTRY cl_int CL_API_CALL
 clWaitForEvents(cl_uint num_events, const cl_event* event_list) {
 
-	(void)(num_events);
-	(void)(event_list);
+	cl_int status = CL_SUCCESS;
+	cl_int exec_status;
+
+	/* Commands complete immediately, unless they wait for other events
+	 * such as user events, in which case poll until they complete. */
+	for (cl_uint i = 0; i < num_events; ++i) {
+		while ((exec_status = ocl_stub_event_update(event_list[i]))
+				> CL_COMPLETE)
+			g_usleep(1000);
+		if (exec_status < 0)
+			status = CL_EXEC_STATUS_ERROR_FOR_EVENTS_IN_WAIT_LIST;
+	}
 
-	return CL_SUCCESS;
+	return status;
 }
 
 #ifdef CL_VERSION_1_1
@@ -167,7 +185,7 @@ clSetUserEventStatus(cl_event event, cl_int execution_status) {
 	} else if ((execution_status != CL_COMPLETE) && (execution_status >= 0)) {
 		status = CL_INVALID_VALUE;
 	} else {
-		event->exec_status = execution_status;
+		ocl_stub_event_set_status(event, execution_status);
 		status = CL_SUCCESS;
 	}
 	return status;
@@ -91,8 +91,8 @@ clCreateImage(cl_context context, cl_mem_flags flags,
 	const cl_image_desc* image_desc, void* host_ptr,
 	cl_int* errcode_ret) {
 
-	/* Very basic, only support 2D and 3D images and no image-buffer
-	 * auto mapping.*/
+	/* Very basic, only support 2D and 3D images, 1D image buffers and
+	 * 2D images from buffers.*/
 
 	cl_mem image = NULL;
 
@@ -102,6 +102,30 @@ clCreateImage(cl_context context, cl_mem_flags flags,
 #ifdef CL_VERSION_1_2
 	} else if (image_desc == NULL) {
 		seterrcode(errcode_ret, CL_INVALID_IMAGE_DESCRIPTOR);
+	} else if (image_desc->buffer != NULL) { /* Image from buffer. */
+
+		/* Image shares memory with buffer, like a sub-buffer. */
+		cl_mem buffer = image_desc->buffer;
+		seterrcode(errcode_ret, CL_SUCCESS);
+		image = g_slice_new(struct _cl_mem);
+		buffer->ref_count++;
+		image->ref_count = 1;
+		image->flags = (flags != 0) ? flags : buffer->flags;
+		image->size = buffer->size;
+		image->host_ptr = buffer->host_ptr;
+		image->map_count = 0;
+		image->context = buffer->context;
+		image->associated_object = buffer;
+		image->offset = 0;
+		image->mem = buffer->mem;
+		image->callbacks = NULL;
+		image->image_elem_size = image_elem_size(*image_format);
+		image->image_format = *image_format;
+		image->image_desc = *image_desc;
+		if (image->image_desc.image_row_pitch == 0)
+			image->image_desc.image_row_pitch =
+				image_desc->image_width * image->image_elem_size;
+		image->type = image_desc->image_type;
 #endif
 	} else { /* No error, create image. */
 
@@ -45,6 +45,9 @@ struct _cl_event {
 	cl_command_type command_type;
 	cl_int exec_status;
 	cl_uint ref_count;
+	/* Events which must complete before this event's command does. */
+	cl_event* wait_list;
+	cl_uint num_wait;
 	/* Registered callbacks. */
 #ifdef CL_VERSION_1_1
 	void (CL_CALLBACK *pfn_notify[3])(cl_event, cl_int, void*);
@@ -59,6 +62,7 @@ struct _cl_command_queue {
 	cl_device_id device;
 	cl_uint ref_count;
 	cl_command_queue_properties properties;
+	cl_uint size;
 };
 
 struct _cl_device_id {
@@ -85,6 +89,7 @@ struct _cl_device_id {
 	const size_t image3d_max_width;
 	const size_t image_max_buffer_size;
 	const size_t image_max_array_size;
+	const cl_uint image_pitch_alignment;
 	const cl_bool linker_available;
 	const cl_ulong local_mem_size;
 	const cl_device_local_mem_type local_mem_type;
@@ -129,6 +134,8 @@ struct _cl_device_id {
 	const char* profile;
 	const size_t profiling_timer_resolution;
 	const cl_command_queue_properties queue_properties;
+	const cl_uint queue_on_device_max_size;
+	const cl_uint queue_on_device_preferred_size;
 	const cl_device_fp_config single_fp_config;
 	const cl_device_type type;
 	const char* vendor;
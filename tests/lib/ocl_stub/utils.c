@@ -54,3 +54,77 @@ void ocl_stub_create_event(
 		(*event)->ref_count = 1;
 	}
 }
+
+/* Events whose commands wait for other events are completed when the
+ * awaited events are, possibly by another thread. */
+static GRecMutex event_status_mutex;
+
+/* Release events awaited by the command of an event. */
+void ocl_stub_event_release_wait_list(cl_event event) {
+
+	g_rec_mutex_lock(&event_status_mutex);
+	for (cl_uint i = 0; i < event->num_wait; ++i)
+		clReleaseEvent(event->wait_list[i]);
+	g_free(event->wait_list);
+	event->wait_list = NULL;
+	event->num_wait = 0;
+	g_rec_mutex_unlock(&event_status_mutex);
+}
+
+/* Update and return the execution status of an event, completing its
+ * command if the events it waits for are complete. */
+cl_int ocl_stub_event_update(cl_event event) {
+
+	cl_int exec_status;
+
+	g_rec_mutex_lock(&event_status_mutex);
+	if (event->num_wait > 0) {
+		cl_int wait_status = CL_COMPLETE;
+		for (cl_uint i = 0; i < event->num_wait; ++i) {
+			cl_int s = ocl_stub_event_update(event->wait_list[i]);
+			if (s < 0) {
+				wait_status = CL_EXEC_STATUS_ERROR_FOR_EVENTS_IN_WAIT_LIST;
+				break;
+			} else if (s > CL_COMPLETE) {
+				wait_status = CL_SUBMITTED;
+			}
+		}
+		if (wait_status <= CL_COMPLETE) {
+			ocl_stub_event_release_wait_list(event);
+			event->t_start = g_get_real_time();
+			event->t_end = g_get_real_time();
+			event->exec_status = wait_status;
+		}
+	}
+	exec_status = event->exec_status;
+	g_rec_mutex_unlock(&event_status_mutex);
+
+	return exec_status;
+}
+
+/* Set the execution status of an event. */
+void ocl_stub_event_set_status(cl_event event, cl_int exec_status) {
+
+	g_rec_mutex_lock(&event_status_mutex);
+	event->exec_status = exec_status;
+	g_rec_mutex_unlock(&event_status_mutex);
+}
+
+/* Make the command of an event wait for the given events. */
+void ocl_stub_event_wait_on(
+	cl_event event, cl_uint num_events, const cl_event* event_list) {
+
+	if ((event == NULL) || (num_events == 0) || (event_list == NULL))
+		return;
+
+	g_rec_mutex_lock(&event_status_mutex);
+	event->wait_list = g_new(cl_event, num_events);
+	for (cl_uint i = 0; i < num_events; ++i) {
+		clRetainEvent(event_list[i]);
+		event->wait_list[i] = event_list[i];
+	}
+	event->num_wait = num_events;
+	event->exec_status = CL_SUBMITTED;
+	ocl_stub_event_update(event);
+	g_rec_mutex_unlock(&event_status_mutex);
+}
@@ -34,6 +34,15 @@ guint veclen(void* vector, size_t elem_size);
 void ocl_stub_create_event(
 	cl_event* event, cl_command_queue queue, cl_command_type ctype);
 
+void ocl_stub_event_wait_on(
+	cl_event event, cl_uint num_events, const cl_event* event_list);
+
+cl_int ocl_stub_event_update(cl_event event);
+
+void ocl_stub_event_set_status(cl_event event, cl_int exec_status);
+
+void ocl_stub_event_release_wait_list(cl_event event);
+
 #define seterrcode(errcode_ret, errcode) \
 	if ((errcode_ret) != NULL) *(errcode_ret) = (errcode)
 
@@ -398,6 +398,366 @@ static void map_unmap_test() {
 
 }
 
+/**
+ * Tests multi-threaded map-based transfers.
+ * */
+static void read_write_mt_test() {
+
+	/* Test variables. */
+	CCLContext* ctx = NULL;
+	CCLDevice* d = NULL;
+	CCLQueue* q = NULL;
+	CCLBuffer* b = NULL;
+	CCLEvent* evt = NULL;
+	CCLErr* err = NULL;
+	/* Large enough to be split among threads, and not a multiple of
+	 * the copy granularity. */
+	size_t buf_size = 3 * 1024 * 1024 + 13;
+	guchar* h_in = g_malloc(buf_size);
+	guchar* h_out = g_malloc(buf_size);
+	CCLBufferTransferMode modes[] = { CCL_BUFFER_TRANSFER_DRIVER,
+		CCL_BUFFER_TRANSFER_MAPPED, CCL_BUFFER_TRANSFER_AUTO };
+
+	/* Get the test context with the pre-defined device. */
+	ctx = ccl_test_context_new(&err);
+	g_assert_no_error(err);
+
+	/* Get first device in context and create a command queue. */
+	d = ccl_context_get_device(ctx, 0, &err);
+	g_assert_no_error(err);
+	q = ccl_queue_new(ctx, d, 0, &err);
+	g_assert_no_error(err);
+
+	/* Create buffer. */
+	b = ccl_buffer_new(ctx, CL_MEM_READ_WRITE, buf_size, NULL, &err);
+	g_assert_no_error(err);
+
+	/* Write with each mode, read back with each mode. */
+	for (guint w = 0; w < G_N_ELEMENTS(modes); ++w) {
+
+		for (guint i = 0; i < buf_size; ++i)
+			h_in[i] = (guchar) g_test_rand_int();
+
+		evt = ccl_buffer_enqueue_write_mt(b, q, modes[w], 0, buf_size,
+			h_in, NULL, &err);
+		g_assert_no_error(err);
+		g_assert(evt != NULL);
+
+		for (guint r = 0; r < G_N_ELEMENTS(modes); ++r) {
+
+			memset(h_out, 0, buf_size);
+			evt = ccl_buffer_enqueue_read_mt(b, q, modes[r], 0,
+				buf_size, h_out, NULL, &err);
+			g_assert_no_error(err);
+			g_assert(evt != NULL);
+			ccl_queue_finish(q, &err);
+			g_assert_no_error(err);
+
+			g_assert(memcmp(h_in, h_out, buf_size) == 0);
+		}
+	}
+
+	/* Partial transfer with an offset. */
+	memset(h_out, 0, buf_size);
+	ccl_buffer_enqueue_read_mt(b, q, CCL_BUFFER_TRANSFER_MAPPED, 1001,
+		buf_size - 2002, h_out, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(memcmp(h_in + 1001, h_out, buf_size - 2002) == 0);
+
+	/* Destroy stuff. */
+	ccl_buffer_destroy(b);
+	ccl_queue_destroy(q);
+	ccl_context_destroy(ctx);
+	g_free(h_in);
+	g_free(h_out);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
+/**
+ * Tests compressed uploads.
+ * */
+static void uploader_test() {
+
+	/* Test variables. */
+	CCLContext* ctx = NULL;
+	CCLDevice* d = NULL;
+	CCLQueue* q = NULL;
+	CCLBuffer* b = NULL;
+	CCLUploader* up = NULL;
+	CCLEvent* evt = NULL;
+	CCLErr* err = NULL;
+	/* Several blocks, the last one incomplete. */
+	const size_t size = 64 * 4096 + 1234;
+	const size_t offset = 1000;
+	guchar* h_in = g_malloc(size);
+	guchar* h_out = g_malloc(size);
+	cl_ulong num_raw, num_compressed, bytes_in, bytes_sent;
+
+	/* Get the test context with the pre-defined device. */
+	ctx = ccl_test_context_new(&err);
+	g_assert_no_error(err);
+
+	/* Get first device in context and create a command queue. */
+	d = ccl_context_get_device(ctx, 0, &err);
+	g_assert_no_error(err);
+	q = ccl_queue_new(ctx, d, 0, &err);
+	g_assert_no_error(err);
+
+	/* Create buffer. */
+	b = ccl_buffer_new(ctx, CL_MEM_READ_WRITE, size + offset, NULL, &err);
+	g_assert_no_error(err);
+
+	/* Sparse label data: long runs with scattered short literals. */
+	for (size_t i = 0; i < size; ++i)
+		h_in[i] = (guchar) ((i / 5000) % 3);
+	for (size_t i = 0; i < size; i += 997)
+		h_in[i] = (guchar) g_test_rand_int();
+
+	/* Compressed write, with an offset. */
+	up = ccl_uploader_new(ctx, CCL_UPLOAD_COMPRESSED);
+	evt = ccl_uploader_enqueue_write(up, b, q, CL_TRUE, offset, size,
+		h_in, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(evt != NULL);
+
+	ccl_uploader_get_stats(up, &num_raw, &num_compressed, &bytes_in,
+		&bytes_sent);
+	g_assert_cmpuint(num_raw, ==, 0);
+	g_assert_cmpuint(num_compressed, ==, 1);
+	g_assert_cmpuint(bytes_in, ==, size);
+	g_assert_cmpuint(bytes_sent, <, size / 10);
+
+	/* Check that the data was decoded on the device (not available with
+	 * OpenCL stub). */
+	ccl_buffer_enqueue_read(b, q, CL_TRUE, offset, size, h_out, NULL,
+		&err);
+	g_assert_no_error(err);
+#ifndef OPENCL_STUB
+	g_assert(memcmp(h_in, h_out, size) == 0);
+#endif
+
+	/* Empty compressed writes are rejected. */
+	evt = ccl_uploader_enqueue_write(up, b, q, CL_TRUE, 0, 0, h_in, NULL,
+		&err);
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+	g_assert(evt == NULL);
+	g_clear_error(&err);
+	ccl_uploader_destroy(up);
+
+	/* Raw writes are regular buffer writes. */
+	up = ccl_uploader_new(ctx, CCL_UPLOAD_RAW);
+	evt = ccl_uploader_enqueue_write(up, b, q, CL_TRUE, 0, size,
+		h_in, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(evt != NULL);
+	ccl_buffer_enqueue_read(b, q, CL_TRUE, 0, size, h_out, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(memcmp(h_in, h_out, size) == 0);
+	ccl_uploader_get_stats(up, &num_raw, &num_compressed, NULL, NULL);
+	g_assert_cmpuint(num_raw, ==, 1);
+	g_assert_cmpuint(num_compressed, ==, 0);
+	ccl_uploader_destroy(up);
+
+	/* In automatic mode, incompressible data is written raw. */
+	for (size_t i = 0; i < size; ++i)
+		h_in[i] = (guchar) g_test_rand_int();
+	up = ccl_uploader_new(ctx, CCL_UPLOAD_AUTO);
+	evt = ccl_uploader_enqueue_write(up, b, q, CL_TRUE, 0, size,
+		h_in, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(evt != NULL);
+	ccl_buffer_enqueue_read(b, q, CL_TRUE, 0, size, h_out, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(memcmp(h_in, h_out, size) == 0);
+	ccl_uploader_get_stats(up, &num_raw, &num_compressed, &bytes_in,
+		&bytes_sent);
+	g_assert_cmpuint(num_raw, ==, 1);
+	g_assert_cmpuint(num_compressed, ==, 0);
+	g_assert_cmpuint(bytes_in, ==, bytes_sent);
+
+	/* Small writes are also written raw. */
+	memset(h_in, 0, 1024);
+	evt = ccl_uploader_enqueue_write(up, b, q, CL_TRUE, 0, 1024,
+		h_in, NULL, &err);
+	g_assert_no_error(err);
+	ccl_uploader_get_stats(up, &num_raw, NULL, NULL, NULL);
+	g_assert_cmpuint(num_raw, ==, 2);
+
+	/* Destroy stuff. */
+	ccl_uploader_destroy(up);
+	ccl_buffer_destroy(b);
+	ccl_queue_destroy(q);
+	ccl_context_destroy(ctx);
+	g_free(h_in);
+	g_free(h_out);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
+/**
+ * Tests host mirror buffers and their dirty range tracking.
+ * */
+static void mirror_test() {
+
+	/* Test variables. */
+	CCLContext* ctx = NULL;
+	CCLDevice* d = NULL;
+	CCLQueue* q = NULL;
+	CCLMirrorBuffer* mb = NULL;
+	CCLEvent* evt = NULL;
+	CCLErr* err = NULL;
+	const size_t page = 256;
+	const size_t size = 10 * page + 100;
+	size_t up, down;
+	guchar* host;
+	guchar h_dev[10 * 256 + 100];
+	guchar h_in[256];
+
+	/* Get the test context with the pre-defined device. */
+	ctx = ccl_test_context_new(&err);
+	g_assert_no_error(err);
+
+	/* Get first device in context and create a command queue. */
+	d = ccl_context_get_device(ctx, 0, &err);
+	g_assert_no_error(err);
+	q = ccl_queue_new(ctx, d, 0, &err);
+	g_assert_no_error(err);
+
+	/* Create mirror buffer. */
+	mb = ccl_mirror_buffer_new(ctx, CL_MEM_READ_WRITE, size, page, &err);
+	g_assert_no_error(err);
+	g_assert_cmpuint(ccl_mirror_buffer_get_size(mb), ==, size);
+	host = ccl_mirror_buffer_get_host(mb);
+	for (guint i = 0; i < size; ++i)
+		host[i] = (guchar) i;
+
+	/* Host pointer flags are not accepted. */
+	g_assert(ccl_mirror_buffer_new(ctx, CL_MEM_USE_HOST_PTR, size, 0,
+		&err) == NULL);
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+	g_clear_error(&err);
+
+	/* First upload transfers everything, the second one nothing. */
+	evt = ccl_mirror_buffer_sync_to_device(mb, q, CL_TRUE, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(evt != NULL);
+	evt = ccl_mirror_buffer_sync_to_device(mb, q, CL_TRUE, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(evt == NULL);
+	ccl_mirror_buffer_get_stats(mb, &up, &down);
+	g_assert_cmpuint(up, ==, size);
+	g_assert_cmpuint(down, ==, 0);
+
+	/* Device copy didn't change, so nothing is downloaded. */
+	evt = ccl_mirror_buffer_sync_to_host(mb, q, CL_TRUE, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(evt == NULL);
+
+	/* Modify page 1 and pages 3-4 on the host. */
+	for (guint i = 0; i < page; ++i)
+		h_in[i] = (guchar) (255 - i);
+	ccl_mirror_buffer_host_write(mb, page + 10, 8, h_in, &err);
+	g_assert_no_error(err);
+	memset(host + 3 * page + 5, 7, page);
+	ccl_mirror_buffer_mark_host_dirty(mb, 3 * page + 5, page, &err);
+	g_assert_no_error(err);
+
+	/* Pages dirty on the host cannot be marked dirty on the device
+	 * before being uploaded, and remain dirty on the host. */
+	g_assert(!ccl_mirror_buffer_mark_device_dirty(mb, 4 * page, 10, &err));
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+	g_clear_error(&err);
+
+	/* Only the dirty pages are uploaded. */
+	ccl_mirror_buffer_sync_to_device(mb, q, CL_TRUE, NULL, &err);
+	g_assert_no_error(err);
+	ccl_mirror_buffer_get_stats(mb, &up, &down);
+	g_assert_cmpuint(up, ==, size + 3 * page);
+
+	/* Modify page 5 and the partial last page on the device. */
+	ccl_buffer_enqueue_write(ccl_mirror_buffer_get_buffer(mb), q, CL_TRUE,
+		5 * page, page, h_in, NULL, &err);
+	g_assert_no_error(err);
+	ccl_mirror_buffer_mark_device_dirty(mb, 5 * page, page, &err);
+	g_assert_no_error(err);
+	ccl_buffer_enqueue_write(ccl_mirror_buffer_get_buffer(mb), q, CL_TRUE,
+		10 * page, 100, h_in, NULL, &err);
+	g_assert_no_error(err);
+	ccl_mirror_buffer_mark_device_dirty(mb, 10 * page, 0, &err);
+	g_assert_no_error(err);
+
+	/* Likewise, pages dirty on the device cannot be written on the host
+	 * before being downloaded, and the host copy is left untouched. */
+	g_assert(!ccl_mirror_buffer_host_write(mb, 5 * page, 8, h_in + 8,
+		&err));
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+	g_clear_error(&err);
+	g_assert_cmpuint(host[5 * page], ==, (guchar) (5 * page));
+
+	/* Only the dirty pages are downloaded. */
+	evt = ccl_mirror_buffer_sync_to_host(mb, q, CL_TRUE, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(evt != NULL);
+	ccl_mirror_buffer_get_stats(mb, &up, &down);
+	g_assert_cmpuint(down, ==, page + 100);
+	g_assert_cmpuint(host[5 * page + 3], ==, h_in[3]);
+	g_assert_cmpuint(host[10 * page + 99], ==, h_in[99]);
+
+	/* Both copies must now be equal. */
+	ccl_buffer_enqueue_read(ccl_mirror_buffer_get_buffer(mb), q, CL_TRUE,
+		0, size, h_dev, NULL, &err);
+	g_assert_no_error(err);
+	for (guint i = 0; i < size; ++i)
+		g_assert_cmpuint(host[i], ==, h_dev[i]);
+	ccl_mirror_buffer_destroy(mb);
+
+	/* Pages which were never uploaded can only be marked dirty on the
+	 * device if the range covers them entirely, including the partial
+	 * last page. */
+	mb = ccl_mirror_buffer_new(ctx, CL_MEM_READ_WRITE, size, page, &err);
+	g_assert_no_error(err);
+	g_assert(!ccl_mirror_buffer_mark_device_dirty(mb, 10, 8, &err));
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+	g_clear_error(&err);
+	g_assert(!ccl_mirror_buffer_mark_device_dirty(mb, page, page + 1,
+		&err));
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+	g_clear_error(&err);
+	g_assert(ccl_mirror_buffer_mark_device_dirty(mb, page, 2 * page,
+		&err));
+	g_assert_no_error(err);
+	g_assert(ccl_mirror_buffer_mark_device_dirty(mb, 10 * page, 0,
+		&err));
+	g_assert_no_error(err);
+
+	/* The remaining pages are still uploaded, and the marked ones
+	 * downloaded. */
+	ccl_mirror_buffer_sync_to_device(mb, q, CL_TRUE, NULL, &err);
+	g_assert_no_error(err);
+	ccl_mirror_buffer_sync_to_host(mb, q, CL_TRUE, NULL, &err);
+	g_assert_no_error(err);
+	ccl_mirror_buffer_get_stats(mb, &up, &down);
+	g_assert_cmpuint(up, ==, 8 * page);
+	g_assert_cmpuint(down, ==, 2 * page + 100);
+
+	/* Destroy stuff. */
+	ccl_mirror_buffer_destroy(mb);
+	ccl_queue_destroy(q);
+	ccl_context_destroy(ctx);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
 #ifdef CL_VERSION_1_1
 
 /**
@@ -709,6 +1069,120 @@ static void fill_test() {
 
 }
 
+#endif
+
+/**
+ * Tests buffer fill on platforms without clEnqueueFillBuffer(), which
+ * falls back to a fill kernel.
+ * */
+static void fill_fallback_test() {
+
+	/* Test variables. */
+	CCLPlatforms* ps;
+	CCLPlatform* p;
+	CCLContext* ctx = NULL;
+	CCLDevice* d = NULL;
+	CCLBuffer* b = NULL;
+	CCLQueue* q;
+	CCLEvent* evt;
+	guchar pattern[128];
+	guchar h[1000];
+	const size_t buf_size = sizeof(h);
+	CCLErr* err = NULL;
+
+	/* Get a context which doesn't support OpenCL 1.2, if possible. */
+	ps = ccl_platforms_new(&err);
+	g_assert_no_error(err);
+	for (guint i = 0; i < ccl_platforms_count(ps); ++i) {
+		p = ccl_platforms_get(ps, i);
+		cl_uint ocl_ver = ccl_platform_get_opencl_version(p, &err);
+		if (ocl_ver < 120) {
+			ctx = ccl_context_new_from_devices(
+				ccl_platform_get_num_devices(p, NULL),
+				ccl_platform_get_all_devices(p, NULL),
+				&err);
+			g_assert_no_error(err);
+			break;
+		}
+	}
+
+	/* If not possible to find a pre-1.2 context, finish this test. */
+	if (ctx == NULL) {
+		g_test_message("'%s' test not performed because no platform " \
+			"without OpenCL 1.2 support was found", CCL_STRD);
+		ccl_platforms_destroy(ps);
+		return;
+	}
+
+	/* Get first device in context. */
+	d = ccl_context_get_device(ctx, 0, &err);
+	g_assert_no_error(err);
+
+	/* Create a command queue. */
+	q = ccl_queue_new(ctx, d, 0, &err);
+	g_assert_no_error(err);
+
+	/* Create regular buffer. */
+	b = ccl_buffer_new(ctx, CL_MEM_READ_WRITE, buf_size, NULL, &err);
+	g_assert_no_error(err);
+
+	for (guint i = 0; i < sizeof(pattern); ++i)
+		pattern[i] = (guchar) g_test_rand_int();
+
+	/* Fill with all pattern sizes, with a region which is not aligned
+	 * to the fill kernel's 16-byte chunks (unless the pattern is
+	 * larger than that). */
+	for (size_t ps_size = 1; ps_size <= 128; ps_size *= 2) {
+
+		size_t offset = ps_size < 16 ? 3 * ps_size : ps_size;
+		size_t size = ((buf_size - 2 * offset) / ps_size) * ps_size;
+
+		memset(h, 0, buf_size);
+		ccl_buffer_enqueue_write(b, q, CL_TRUE, 0, buf_size, h, NULL,
+			&err);
+		g_assert_no_error(err);
+
+		evt = ccl_buffer_enqueue_fill(
+			b, q, pattern, ps_size, offset, size, NULL, &err);
+		g_assert_no_error(err);
+		g_assert(evt != NULL);
+
+		ccl_buffer_enqueue_read(b, q, CL_TRUE, 0, buf_size, h, NULL,
+			&err);
+		g_assert_no_error(err);
+
+		/* Check data is OK (not available with OpenCL stub, which
+		 * doesn't run kernels). */
+#ifndef OPENCL_STUB
+		for (size_t i = 0; i < buf_size; ++i) {
+			if ((i < offset) || (i >= offset + size))
+				g_assert_cmpuint(h[i], ==, 0);
+			else
+				g_assert_cmpuint(h[i], ==, pattern[(i - offset) % ps_size]);
+		}
+#endif
+	}
+
+	/* Invalid pattern sizes should throw error. */
+	evt = ccl_buffer_enqueue_fill(b, q, pattern, 3, 0, 9, NULL, &err);
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+	g_assert(evt == NULL);
+	g_clear_error(&err);
+
+	/* Free stuff. */
+	ccl_buffer_destroy(b);
+	ccl_queue_destroy(q);
+	ccl_context_destroy(ctx);
+	ccl_platforms_destroy(ps);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
+#ifdef CL_VERSION_1_2
+
 /**
  * Tests memory object migration.
  * */
@@ -789,6 +1263,218 @@ static void migrate_test() {
 }
 
 
+#endif
+
+#ifdef G_OS_UNIX
+
+/**
+ * Tests the shared memory slot ring hand-off protocol and slot
+ * buffers.
+ * */
+static void shm_ring_test() {
+
+	/* Test variables. */
+	CCLContext* ctx = NULL;
+	CCLDevice* d = NULL;
+	CCLQueue* q = NULL;
+	CCLShmRing* cons = NULL;
+	CCLShmRing* prod = NULL;
+	CCLBuffer* slot_bufs[3];
+	CCLErr* err = NULL;
+	cl_uint h_out[CCL_TEST_BUFFER_SIZE];
+	size_t slot_size = sizeof(cl_uint) * CCL_TEST_BUFFER_SIZE;
+	size_t bytes;
+	cl_int slot;
+	gchar* name = g_strdup_printf("/ccl_test_ring_%u", g_test_rand_int());
+
+	/* Get the test context with the pre-defined device. */
+	ctx = ccl_test_context_new(&err);
+	g_assert_no_error(err);
+
+	/* Get first device in context and create a command queue. */
+	d = ccl_context_get_device(ctx, 0, &err);
+	g_assert_no_error(err);
+	q = ccl_queue_new(ctx, d, 0, &err);
+	g_assert_no_error(err);
+
+	/* Consumer creates the ring, producer opens it. */
+	cons = ccl_shm_ring_new(name, 3, slot_size, CL_TRUE, &err);
+	g_assert_no_error(err);
+	prod = ccl_shm_ring_new(name, 0, 0, CL_FALSE, &err);
+	g_assert_no_error(err);
+	g_assert_cmpuint(ccl_shm_ring_get_num_slots(prod), ==, 3);
+	g_assert_cmpuint(ccl_shm_ring_get_slot_size(prod), ==, slot_size);
+
+	/* Creating the same ring again must fail. */
+	g_assert(ccl_shm_ring_new(name, 3, slot_size, CL_TRUE, &err) == NULL);
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_OPENFILE);
+	g_clear_error(&err);
+
+	/* Opening a ring with a mismatched geometry must fail. */
+	g_assert(ccl_shm_ring_new(name, 4, 0, CL_FALSE, &err) == NULL);
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+	g_clear_error(&err);
+
+	/* Create one buffer per slot. */
+	for (cl_uint i = 0; i < 3; ++i) {
+		slot_bufs[i] = ccl_shm_ring_new_slot_buffer(
+			cons, ctx, CL_MEM_READ_ONLY, i, &err);
+		g_assert_no_error(err);
+	}
+
+	/* Nothing was published yet. */
+	g_assert_cmpint(ccl_shm_ring_consume_acquire(cons, &bytes), ==, -1);
+
+	/* Push more frames than there are slots through the ring. */
+	for (cl_uint frame = 0; frame < 7; ++frame) {
+
+		/* Producer fills and publishes a slot. */
+		slot = ccl_shm_ring_produce_acquire(prod);
+		g_assert_cmpint(slot, ==, (cl_int) (frame % 3));
+		cl_uint* data = ccl_shm_ring_get_slot(prod, slot);
+		for (cl_uint i = 0; i < CCL_TEST_BUFFER_SIZE; ++i)
+			data[i] = frame * CCL_TEST_BUFFER_SIZE + i;
+		ccl_shm_ring_produce_commit(prod, slot, slot_size / 2);
+
+		/* Consumer gets the same slot and reads it through the
+		 * device. */
+		slot = ccl_shm_ring_consume_acquire(cons, &bytes);
+		g_assert_cmpint(slot, ==, (cl_int) (frame % 3));
+		g_assert_cmpuint(bytes, ==, slot_size / 2);
+		ccl_buffer_enqueue_read(slot_bufs[slot], q, CL_TRUE, 0, bytes,
+			h_out, NULL, &err);
+		g_assert_no_error(err);
+		for (cl_uint i = 0; i < bytes / sizeof(cl_uint); ++i)
+			g_assert_cmpuint(h_out[i], ==, frame * CCL_TEST_BUFFER_SIZE + i);
+		ccl_shm_ring_consume_release(cons, slot);
+	}
+
+	/* Fill the ring without consuming: the producer must back off. */
+	for (cl_uint i = 0; i < 3; ++i) {
+		slot = ccl_shm_ring_produce_acquire(prod);
+		g_assert_cmpint(slot, >=, 0);
+		ccl_shm_ring_produce_commit(prod, slot, 0);
+	}
+	g_assert_cmpint(ccl_shm_ring_produce_acquire(prod), ==, -1);
+
+	/* Freeing one slot lets the producer continue. */
+	slot = ccl_shm_ring_consume_acquire(cons, NULL);
+	g_assert_cmpint(slot, >=, 0);
+	ccl_shm_ring_consume_release(cons, slot);
+	g_assert_cmpint(ccl_shm_ring_produce_acquire(prod), ==, slot);
+
+	/* Destroy stuff. */
+	for (cl_uint i = 0; i < 3; ++i)
+		ccl_buffer_destroy(slot_bufs[i]);
+	ccl_shm_ring_destroy(prod);
+	ccl_shm_ring_destroy(cons);
+	ccl_queue_destroy(q);
+	ccl_context_destroy(ctx);
+
+	/* The creator unlinked the segment, so it can't be opened anymore. */
+	g_assert(ccl_shm_ring_new(name, 0, 0, CL_FALSE, &err) == NULL);
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_OPENFILE);
+	g_clear_error(&err);
+	g_free(name);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
+#ifdef CL_VERSION_1_1
+
+/**
+ * Tests buffers backed by named shared memory segments.
+ * */
+static void shm_buffer_test() {
+
+	/* Test variables. */
+	CCLContext* ctx = NULL;
+	CCLDevice* d = NULL;
+	CCLQueue* q = NULL;
+	CCLBuffer* b1 = NULL;
+	CCLBuffer* b2 = NULL;
+	CCLErr* err = NULL;
+	cl_uint* h_map;
+	size_t buf_size = sizeof(cl_uint) * CCL_TEST_BUFFER_SIZE;
+	size_t mem_size;
+	gchar* name = g_strdup_printf("/ccl_test_buf_%u", g_test_rand_int());
+
+	/* Get the test context with the pre-defined device. */
+	ctx = ccl_test_context_new(&err);
+	g_assert_no_error(err);
+
+	/* Get first device in context and create a command queue. */
+	d = ccl_context_get_device(ctx, 0, &err);
+	g_assert_no_error(err);
+	q = ccl_queue_new(ctx, d, 0, &err);
+	g_assert_no_error(err);
+
+	/* Create a buffer over a new segment. */
+	b1 = ccl_buffer_new_from_shm(ctx, CL_MEM_READ_WRITE, name, buf_size,
+		CL_TRUE, &err);
+	g_assert_no_error(err);
+
+	/* Check that the buffer uses host memory. */
+	cl_mem_flags flags = ccl_memobj_get_info_scalar(
+		b1, CL_MEM_FLAGS, cl_mem_flags, &err);
+	g_assert_no_error(err);
+	g_assert_cmphex(flags, ==, CL_MEM_READ_WRITE | CL_MEM_USE_HOST_PTR);
+
+	/* Open the same segment, as another process would, using the
+	 * whole segment. */
+	b2 = ccl_buffer_new_from_shm(ctx, CL_MEM_READ_ONLY, name, 0,
+		CL_FALSE, &err);
+	g_assert_no_error(err);
+	mem_size = ccl_memobj_get_info_scalar(b2, CL_MEM_SIZE, size_t, &err);
+	g_assert_no_error(err);
+	g_assert_cmpuint(mem_size, >=, buf_size);
+
+	/* Write data through the first buffer. */
+	h_map = ccl_buffer_enqueue_map(b1, q, CL_TRUE, CL_MAP_WRITE, 0,
+		buf_size, NULL, NULL, &err);
+	g_assert_no_error(err);
+	for (cl_uint i = 0; i < CCL_TEST_BUFFER_SIZE; ++i)
+		h_map[i] = i * 3;
+	ccl_memobj_enqueue_unmap((CCLMemObj*) b1, q, h_map, NULL, &err);
+	g_assert_no_error(err);
+	ccl_queue_finish(q, &err);
+	g_assert_no_error(err);
+
+	/* Read it back through the second buffer. */
+	h_map = ccl_buffer_enqueue_map(b2, q, CL_TRUE, CL_MAP_READ, 0,
+		buf_size, NULL, NULL, &err);
+	g_assert_no_error(err);
+	for (cl_uint i = 0; i < CCL_TEST_BUFFER_SIZE; ++i)
+		g_assert_cmpuint(h_map[i], ==, i * 3);
+	ccl_memobj_enqueue_unmap((CCLMemObj*) b2, q, h_map, NULL, &err);
+	g_assert_no_error(err);
+	ccl_queue_finish(q, &err);
+	g_assert_no_error(err);
+
+	/* Creating the same segment again must fail. */
+	g_assert(ccl_buffer_new_from_shm(ctx, CL_MEM_READ_WRITE, name,
+		buf_size, CL_TRUE, &err) == NULL);
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_OPENFILE);
+	g_clear_error(&err);
+
+	/* Destroy stuff. */
+	ccl_buffer_destroy(b2);
+	ccl_buffer_destroy(b1);
+	ccl_queue_destroy(q);
+	ccl_context_destroy(ctx);
+	g_free(name);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
+#endif
+
 #endif
 
 /**
@@ -825,6 +1511,18 @@ int main(int argc, char** argv) {
 		"/wrappers/buffer/map-unmap",
 		map_unmap_test);
 
+	g_test_add_func(
+		"/wrappers/buffer/read-write-mt",
+		read_write_mt_test);
+
+	g_test_add_func(
+		"/wrappers/buffer/mirror",
+		mirror_test);
+
+	g_test_add_func(
+		"/wrappers/buffer/uploader",
+		uploader_test);
+
 #ifdef CL_VERSION_1_1
 	g_test_add_func(
 		"/wrappers/buffer/destruct_callback",
@@ -849,6 +1547,22 @@ int main(int argc, char** argv) {
 		migrate_test);
 #endif
 
+	g_test_add_func(
+		"/wrappers/buffer/fill-fallback",
+		fill_fallback_test);
+
+#ifdef G_OS_UNIX
+	g_test_add_func(
+		"/wrappers/buffer/shm-ring",
+		shm_ring_test);
+
+#ifdef CL_VERSION_1_1
+	g_test_add_func(
+		"/wrappers/buffer/shm",
+		shm_buffer_test);
+#endif
+#endif
+
 	return g_test_run();
 }
 
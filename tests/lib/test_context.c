@@ -216,6 +216,14 @@ static void create_info_destroy_test() {
 	ctx = ccl_context_new_wrap(context);
 	g_assert(ccl_context_unwrap(ctx) == context);
 
+	/* The inline accessors read the same object and class through the
+	 * stable wrapper prefix as the exported functions. */
+	g_assert(ccl_wrapper_unwrap((CCLWrapper*) ctx) == context);
+	g_assert_cmpint(ccl_wrapper_get_class_inline((CCLWrapper*) ctx), ==,
+		CCL_CONTEXT);
+	g_assert_cmpstr(ccl_wrapper_get_class_name((CCLWrapper*) ctx), ==,
+		"Context");
+
 	/* Get the first device wrapper from the context wrapper, check that
 	 * the unwrapped cl_device_id corresponds to the cl_device_id with
 	 * which the cl_context was created. */
@@ -880,6 +888,107 @@ static void device_container_test() {
 	g_assert(ccl_wrapper_memcheck());
 }
 
+/**
+ * @internal
+ * Thread function which gets a queue from a session cache.
+ * */
+static gpointer session_queue_thread(gpointer data) {
+
+	CCLErr* err = NULL;
+	CCLSession* sess = ((gpointer*) data)[0];
+	CCLContext* ctx = ((gpointer*) data)[1];
+	CCLQueue* cq = ccl_session_get_queue(sess, ctx, NULL, 0, &err);
+	g_assert_no_error(err);
+	return cq;
+
+}
+
+/**
+ * Tests the session cache.
+ * */
+static void session_test() {
+
+	/* Test variables. */
+	CCLSession* sess = NULL;
+	CCLDevSelFilters filters = NULL;
+	CCLContext* ctx1 = NULL;
+	CCLContext* ctx2 = NULL;
+	CCLQueue* cq1 = NULL;
+	CCLQueue* cq2 = NULL;
+	CCLQueue* cq3 = NULL;
+	CCLProgram* prg1 = NULL;
+	CCLProgram* prg2 = NULL;
+	CCLProgram* prg3 = NULL;
+	CCLErr* err = NULL;
+	GThread* thread;
+	gpointer thread_data[2];
+	cl_uint dev_idx = 0;
+	cl_ulong hits, misses, evictions;
+
+	/* Create a session cache which holds three objects. */
+	sess = ccl_session_new(3);
+
+	/* The same device selection yields the same context. */
+	ccl_devsel_add_dep_filter(&filters, ccl_devsel_dep_index, &dev_idx);
+	ctx1 = ccl_session_get_context(sess, &filters, &err);
+	g_assert_no_error(err);
+	g_assert(filters == NULL);
+	ccl_devsel_add_dep_filter(&filters, ccl_devsel_dep_index, &dev_idx);
+	ctx2 = ccl_session_get_context(sess, &filters, &err);
+	g_assert_no_error(err);
+	g_assert(ctx1 == ctx2);
+
+	/* Queues are shared within a thread, but not between threads. */
+	cq1 = ccl_session_get_queue(sess, ctx1, NULL, 0, &err);
+	g_assert_no_error(err);
+	cq2 = ccl_session_get_queue(sess, ctx1, NULL, 0, &err);
+	g_assert_no_error(err);
+	g_assert(cq1 == cq2);
+	ccl_queue_destroy(cq2);
+	thread_data[0] = sess;
+	thread_data[1] = ctx1;
+	thread = g_thread_new("session", session_queue_thread, thread_data);
+	cq3 = g_thread_join(thread);
+	g_assert(cq3 != cq1);
+
+	/* Programs are shared for the same source and options. */
+	prg1 = ccl_session_get_program(
+		sess, ctx1, CCL_TEST_PROGRAM_SUM_CONTENT, NULL, &err);
+	g_assert_no_error(err);
+	prg2 = ccl_session_get_program(
+		sess, ctx1, CCL_TEST_PROGRAM_SUM_CONTENT, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(prg1 == prg2);
+	ccl_program_destroy(prg2);
+	prg3 = ccl_session_get_program(
+		sess, ctx1, CCL_TEST_PROGRAM_SUM_CONTENT, "-DCCL_TEST", &err);
+	g_assert_no_error(err);
+	g_assert(prg3 != prg1);
+
+	/* Check statistics; the context and the first queue were evicted,
+	 * but remain valid. */
+	ccl_session_get_stats(sess, &hits, &misses, &evictions);
+	g_assert_cmpuint(hits, ==, 3);
+	g_assert_cmpuint(misses, ==, 5);
+	g_assert_cmpuint(evictions, ==, 2);
+	ccl_queue_finish(cq1, &err);
+	g_assert_no_error(err);
+
+	/* Destroy stuff. */
+	ccl_program_destroy(prg3);
+	ccl_program_destroy(prg1);
+	ccl_queue_destroy(cq3);
+	ccl_queue_destroy(cq1);
+	ccl_context_destroy(ctx2);
+	ccl_context_destroy(ctx1);
+	ccl_session_destroy(sess);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
 /**
  * Main function.
  * @param[in] argc Number of command line arguments.
@@ -906,5 +1015,9 @@ int main(int argc, char** argv) {
 		"/wrappers/context/device-container",
 		device_container_test);
 
+	g_test_add_func(
+		"/wrappers/context/session",
+		session_test);
+
 	return g_test_run();
 }
@@ -58,6 +58,107 @@ static void devices_new_destroy_test() {
 
 }
 
+#ifdef G_OS_UNIX
+
+/**
+ * Tests the cross-process load registry and the least loaded device
+ * dependent filter.
+ * */
+static void least_loaded_test() {
+
+	/* Error reporting object. */
+	CCLErr* err = NULL;
+
+	/* Load registry, with a name private to this test run. */
+	CCLLoadRegistry* reg = NULL;
+	gchar* name = g_strdup_printf("/ccl_test_load_%u", g_test_rand_int());
+
+	/* Devices. */
+	CCLDevSelDevices all = NULL;
+	CCLDevSelDevices sel = NULL;
+	CCLDevSelFilters filters = NULL;
+	CCLDevice* dev0;
+
+	/* Loads. */
+	cl_ulong work, mem, min_work;
+	cl_int hint;
+
+	/* Open registry. */
+	ccl_load_registry_unlink(name);
+	reg = ccl_load_registry_new(name, &err);
+	g_assert_no_error(err);
+
+	/* Get all devices. */
+	all = ccl_devsel_devices_new(&err);
+	g_assert_no_error(err);
+	g_assert_cmpuint(all->len, >, 0);
+	dev0 = (CCLDevice*) all->pdata[0];
+
+	/* Unknown devices have no load. */
+	ccl_load_registry_query(reg, dev0, &work, &mem, &err);
+	g_assert_no_error(err);
+	g_assert_cmpuint(work, ==, 0);
+	g_assert_cmpuint(mem, ==, 0);
+
+	/* Add load to first device; loads never become negative. */
+	ccl_load_registry_update(reg, dev0, 5, 1000, &err);
+	g_assert_no_error(err);
+	ccl_load_registry_update(reg, dev0, -2, -2000, &err);
+	g_assert_no_error(err);
+	ccl_load_registry_query(reg, dev0, &work, &mem, &err);
+	g_assert_no_error(err);
+	g_assert_cmpuint(work, ==, 3);
+	g_assert_cmpuint(mem, ==, 0);
+
+	/* The filter selects one of the least loaded devices. */
+	ccl_devsel_add_dep_filter(&filters, ccl_devsel_dep_least_loaded, reg);
+	sel = ccl_devsel_select(&filters, &err);
+	g_assert_no_error(err);
+	g_assert_cmpuint(sel->len, ==, 1);
+	min_work = G_MAXUINT64;
+	for (guint i = 0; i < all->len; ++i) {
+		ccl_load_registry_query(
+			reg, (CCLDevice*) all->pdata[i], &work, NULL, &err);
+		g_assert_no_error(err);
+		min_work = MIN(min_work, work);
+	}
+	ccl_load_registry_query(
+		reg, (CCLDevice*) sel->pdata[0], &work, NULL, &err);
+	g_assert_no_error(err);
+	g_assert_cmpuint(work, ==, min_work);
+	if (all->len > 1)
+		g_assert(ccl_device_unwrap((CCLDevice*) sel->pdata[0])
+			!= ccl_device_unwrap(dev0));
+	ccl_devsel_devices_destroy(sel);
+
+	/* Moving all of this process' work elsewhere would not reduce
+	 * contention, so the hint is to stay. */
+	hint = ccl_load_registry_rebalance_hint(reg,
+		(CCLDevice* const*) all->pdata, all->len, 0, &err);
+	g_assert_no_error(err);
+	g_assert_cmpint(hint, ==, 0);
+
+	/* Closing the registry withdraws this process' load. */
+	ccl_load_registry_destroy(reg);
+	reg = ccl_load_registry_new(name, &err);
+	g_assert_no_error(err);
+	ccl_load_registry_query(reg, dev0, &work, &mem, &err);
+	g_assert_no_error(err);
+	g_assert_cmpuint(work, ==, 0);
+
+	/* Destroy stuff. */
+	ccl_load_registry_destroy(reg);
+	ccl_load_registry_unlink(name);
+	g_free(name);
+	ccl_devsel_devices_destroy(all);
+
+	/* Confirm that memory allocated by wrappers has been properly freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
+#endif
+
 /**
  * Main function.
  * @param[in] argc Number of command line arguments.
@@ -71,6 +172,10 @@ int main(int argc, char** argv) {
 	g_test_add_func("/devsel/devices_new_destroy_test",
 		devices_new_destroy_test);
 
+#ifdef G_OS_UNIX
+	g_test_add_func("/devsel/least_loaded_test", least_loaded_test);
+#endif
+
 	return g_test_run();
 
 }
@@ -715,8 +715,283 @@ static void fill_test(
 
 }
 
+
+/**
+ * Tests creation of images which use existing buffers as storage.
+ * */
+static void from_buffer_test(
+	CCLContext** ctx_fixt, gconstpointer user_data) {
+
+	/* Test variables. */
+	CCLDevice* d = NULL;
+	CCLBuffer* buf = NULL;
+	CCLImage* img = NULL;
+	CCLQueue* q;
+	cl_image_format image_format = { CL_RGBA, CL_UNSIGNED_INT8 };
+	size_t row_pitch;
+	size_t width;
+	CCLErr* err = NULL;
+	CCL_UNUSED(user_data);
+
+	/* Check that a context is set. */
+	if (*ctx_fixt == NULL) {
+		/* If not, skip test. */
+		g_test_message("No device found for image from buffer test.");
+		return;
+	}
+
+	/* Get first device in context. */
+	d = ccl_context_get_device(*ctx_fixt, 0, &err);
+	g_assert_no_error(err);
+
+	/* Create a command queue. */
+	q = ccl_queue_new(*ctx_fixt, d, 0, &err);
+	g_assert_no_error(err);
+
+	/* Create a plain buffer and a 1D image buffer over it. */
+	buf = ccl_buffer_new(*ctx_fixt, CL_MEM_READ_WRITE,
+		CCL_TEST_IMAGE_WIDTH * sizeof(cl_uint), NULL, &err);
+	g_assert_no_error(err);
+	img = ccl_image_new_from_buffer(*ctx_fixt, 0, &image_format, buf,
+		CL_MEM_OBJECT_IMAGE1D_BUFFER, CCL_TEST_IMAGE_WIDTH, 0, 0, &err);
+	g_assert_no_error(err);
+	ccl_image_destroy(img);
+
+	/* A 1D image buffer larger than the buffer should not be created. */
+	img = ccl_image_new_from_buffer(*ctx_fixt, 0, &image_format, buf,
+		CL_MEM_OBJECT_IMAGE1D_BUFFER, CCL_TEST_IMAGE_WIDTH + 1, 0, 0,
+		&err);
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+	g_assert(img == NULL);
+	g_clear_error(&err);
+	ccl_buffer_destroy(buf);
+
+	/* Determine row pitch for 2D images from buffers. */
+	row_pitch = ccl_image_get_buffer_row_pitch(
+		*ctx_fixt, &image_format, CCL_TEST_IMAGE_WIDTH, &err);
+	if ((err != NULL) && (err->code == CCL_ERROR_UNSUPPORTED_OCL)) {
+		/* Device does not support 2D images from buffers. */
+		g_test_message("Device does not support 2D images from buffers.");
+		g_clear_error(&err);
+		ccl_queue_destroy(q);
+		return;
+	}
+	g_assert_no_error(err);
+	g_assert_cmpuint(row_pitch, >=, CCL_TEST_IMAGE_WIDTH * sizeof(cl_uint));
+	g_assert_cmpuint(row_pitch % sizeof(cl_uint), ==, 0);
+
+	/* Create buffer with proper pitch and a 2D image over it. */
+	buf = ccl_image_buffer_new(*ctx_fixt, CL_MEM_READ_WRITE, &image_format,
+		CCL_TEST_IMAGE_WIDTH, CCL_TEST_IMAGE_HEIGHT, &row_pitch, &err);
+	g_assert_no_error(err);
+	img = ccl_image_new_from_buffer(*ctx_fixt, 0, &image_format, buf,
+		CL_MEM_OBJECT_IMAGE2D, CCL_TEST_IMAGE_WIDTH, CCL_TEST_IMAGE_HEIGHT,
+		row_pitch, &err);
+	g_assert_no_error(err);
+
+	/* Check image dimensions. */
+	width = ccl_image_get_info_scalar(img, CL_IMAGE_WIDTH, size_t, &err);
+	g_assert_no_error(err);
+	g_assert_cmpuint(width, ==, CCL_TEST_IMAGE_WIDTH);
+
+#ifndef OPENCL_STUB
+
+	/* Write to buffer and check data is visible through the image
+	 * (not possible with the OpenCL stub). */
+	{
+		cl_uint himg_in[CCL_TEST_IMAGE_WIDTH * CCL_TEST_IMAGE_HEIGHT];
+		cl_uint himg_out[CCL_TEST_IMAGE_WIDTH * CCL_TEST_IMAGE_HEIGHT];
+		const size_t origin[3] = {0, 0, 0};
+		const size_t region[3] =
+			{CCL_TEST_IMAGE_WIDTH * sizeof(cl_uint), CCL_TEST_IMAGE_HEIGHT, 1};
+		const size_t img_region[3] =
+			{CCL_TEST_IMAGE_WIDTH, CCL_TEST_IMAGE_HEIGHT, 1};
+
+		for (guint i = 0;
+				i < CCL_TEST_IMAGE_WIDTH * CCL_TEST_IMAGE_HEIGHT; ++i)
+			himg_in[i] = (cl_uint) g_test_rand_int();
+
+		ccl_buffer_enqueue_write_rect(buf, q, CL_TRUE, origin, origin,
+			region, row_pitch, 0, CCL_TEST_IMAGE_WIDTH * sizeof(cl_uint), 0,
+			himg_in, NULL, &err);
+		g_assert_no_error(err);
+
+		ccl_image_enqueue_read(img, q, CL_TRUE, origin, img_region, 0, 0,
+			himg_out, NULL, &err);
+		g_assert_no_error(err);
+
+		for (guint i = 0;
+				i < CCL_TEST_IMAGE_WIDTH * CCL_TEST_IMAGE_HEIGHT; ++i)
+			g_assert_cmphex(himg_in[i], ==, himg_out[i]);
+	}
+
+#endif
+
+	ccl_image_destroy(img);
+
+	/* A row pitch which does not respect the device alignment should
+	 * not be accepted. */
+	img = ccl_image_new_from_buffer(*ctx_fixt, 0, &image_format, buf,
+		CL_MEM_OBJECT_IMAGE2D, CCL_TEST_IMAGE_WIDTH,
+		CCL_TEST_IMAGE_HEIGHT - 1, row_pitch + 1, &err);
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+	g_assert(img == NULL);
+	g_clear_error(&err);
+
+	/* Free stuff. */
+	ccl_buffer_destroy(buf);
+	ccl_queue_destroy(q);
+
+}
 #endif
 
+/**
+ * Tests image fill on platforms without clEnqueueFillImage(), which
+ * falls back to a fill kernel.
+ * */
+static void fill_fallback_test() {
+
+	/* Test variables. */
+	CCLPlatforms* ps;
+	CCLPlatform* p;
+	CCLDevice* d = NULL;
+	CCLContext* ctx = NULL;
+	CCLImage* img = NULL;
+	CCLQueue* q;
+	CCLEvent* evt;
+	cl_image_format image_format = { CL_RGBA, CL_UNORM_INT8 };
+	guint32 himg_out[CCL_TEST_IMAGE_WIDTH * CCL_TEST_IMAGE_HEIGHT];
+	const size_t origin[3] = {0, 0, 0};
+	const size_t region[3] = {CCL_TEST_IMAGE_WIDTH, CCL_TEST_IMAGE_HEIGHT, 1};
+	const size_t fill_origin[3] = {3, 5, 0};
+	const size_t fill_region[3] = {17, 11, 1};
+	const cl_float4 color = {{ 0.0f, 1.0f, 0.2f, 0.6f }};
+	const cl_float4 color_first = {{ 1.0f, 0.0f, 0.0f, 1.0f }};
+	const guint32 black = 0;
+	CCLErr* err = NULL;
+
+	/* Get all OpenCL platforms in system. */
+	ps = ccl_platforms_new(&err);
+	g_assert_no_error(err);
+
+	/* Find an image-supporting device in a platform without OpenCL
+	 * 1.2 support. */
+	for (guint i = 0; (i < ccl_platforms_count(ps)) && (d == NULL); ++i) {
+
+		p = ccl_platforms_get(ps, i);
+		if (ccl_platform_get_opencl_version(p, &err) >= 120)
+			continue;
+		g_assert_no_error(err);
+
+		for (guint j = 0;
+				j < ccl_platform_get_num_devices(p, NULL); ++j) {
+
+			CCLDevice* dev = ccl_platform_get_device(p, j, &err);
+			g_assert_no_error(err);
+			if (ccl_device_get_info_scalar(
+					dev, CL_DEVICE_IMAGE_SUPPORT, cl_bool, &err)) {
+				d = dev;
+				break;
+			}
+			g_assert_no_error(err);
+		}
+	}
+
+	/* If not possible to find such a device, finish this test. */
+	if (d == NULL) {
+		g_test_message("'%s' test not performed because no image " \
+			"device without OpenCL 1.2 support was found", CCL_STRD);
+		ccl_platforms_destroy(ps);
+		return;
+	}
+
+	/* Create a context and a command queue for the device. */
+	ctx = ccl_context_new_from_devices(1, &d, &err);
+	g_assert_no_error(err);
+	q = ccl_queue_new(ctx, d, 0, &err);
+	g_assert_no_error(err);
+
+	/* Create 2D image and clear it. */
+	img = ccl_image_new(
+		ctx, CL_MEM_READ_WRITE, &image_format, NULL, &err,
+		"image_type", (cl_mem_object_type) CL_MEM_OBJECT_IMAGE2D,
+		"image_width", (size_t) CCL_TEST_IMAGE_WIDTH,
+		"image_height", (size_t) CCL_TEST_IMAGE_HEIGHT,
+		NULL);
+	g_assert_no_error(err);
+
+	for (guint i = 0; i < CCL_TEST_IMAGE_WIDTH * CCL_TEST_IMAGE_HEIGHT; ++i)
+		himg_out[i] = black;
+	ccl_image_enqueue_write(img, q, CL_TRUE, origin, region, 0, 0,
+		himg_out, NULL, &err);
+	g_assert_no_error(err);
+
+	/* Fill part of the image with color, twice, so that the second fill
+	 * gets the fill kernel from the program's kernel cache. */
+	evt = ccl_image_enqueue_fill(
+		img, q, &color_first, fill_origin, fill_region, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(evt != NULL);
+	evt = ccl_image_enqueue_fill(
+		img, q, &color, fill_origin, fill_region, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(evt != NULL);
+
+	/* Read image data back to host. */
+	ccl_image_enqueue_read(img, q, CL_TRUE, origin, region, 0, 0,
+		himg_out, NULL, &err);
+	g_assert_no_error(err);
+
+	/* Check if data is Ok (not possible with the OpenCL stub, which
+	 * doesn't run kernels). */
+#ifndef OPENCL_STUB
+	for (guint y = 0; y < CCL_TEST_IMAGE_HEIGHT; ++y) {
+		for (guint x = 0; x < CCL_TEST_IMAGE_WIDTH; ++x) {
+			guchar* px =
+				(guchar*) &himg_out[y * CCL_TEST_IMAGE_WIDTH + x];
+			if ((x >= fill_origin[0])
+					&& (x < fill_origin[0] + fill_region[0])
+					&& (y >= fill_origin[1])
+					&& (y < fill_origin[1] + fill_region[1])) {
+				g_assert_cmpuint(px[0], ==, 0);
+				g_assert_cmpuint(px[1], ==, 255);
+				g_assert_cmpuint(px[2], ==, 51);
+				g_assert_cmpuint(px[3], ==, 153);
+			} else {
+				g_assert_cmphex(himg_out[y * CCL_TEST_IMAGE_WIDTH + x],
+					==, black);
+			}
+		}
+	}
+#endif
+	ccl_image_destroy(img);
+
+	/* Read-only images can't be filled by the fill kernel. */
+	img = ccl_image_new(
+		ctx, CL_MEM_READ_ONLY, &image_format, NULL, &err,
+		"image_type", (cl_mem_object_type) CL_MEM_OBJECT_IMAGE2D,
+		"image_width", (size_t) CCL_TEST_IMAGE_WIDTH,
+		"image_height", (size_t) CCL_TEST_IMAGE_HEIGHT,
+		NULL);
+	g_assert_no_error(err);
+	evt = ccl_image_enqueue_fill(
+		img, q, &color, fill_origin, fill_region, NULL, &err);
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+	g_assert(evt == NULL);
+	g_clear_error(&err);
+
+	/* Free stuff. */
+	ccl_image_destroy(img);
+	ccl_queue_destroy(q);
+	ccl_context_destroy(ctx);
+	ccl_platforms_destroy(ps);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
 /**
  * Main function.
  * @param[in] argc Number of command line arguments.
@@ -770,8 +1045,17 @@ int main(int argc, char** argv) {
 		CCLContext*, &ocl_min_ver, context_with_image_support_setup,
 		fill_test,
 		context_with_image_support_teardown);
+	g_test_add(
+		"/wrappers/image/from-buffer",
+		CCLContext*, &ocl_min_ver, context_with_image_support_setup,
+		from_buffer_test,
+		context_with_image_support_teardown);
 #endif
 
+	g_test_add_func(
+		"/wrappers/image/fill-fallback",
+		fill_fallback_test);
+
 	return g_test_run();
 }
 
@@ -1176,6 +1176,530 @@ static void native_test() {
 	g_assert(ccl_wrapper_memcheck());
 }
 
+/**
+ * Callback for iterative kernel execution test, counts invocations.
+ * */
+static void iter_test_cb(cl_uint iter, CCLEvent* evt,
+	CCLEventWaitList* evt_wait_lst, void* user_data, CCLErr** err) {
+
+	cl_uint* num_cb = (cl_uint*) user_data;
+
+	/* Callback should be invoked every third iteration. */
+	g_assert_cmpuint((iter + 1) % 3, ==, 0);
+	g_assert(evt != NULL);
+	g_assert(evt_wait_lst != NULL);
+	g_assert(err == NULL || *err == NULL);
+
+	/* The wait list targets iteration iter + 2, which has not been
+	 * gated by previous callbacks. Gate it with this iteration's event
+	 * (events left for iterations which are not enqueued are released
+	 * by ccl_kernel_enqueue_ndrange_iter()). */
+	g_assert_cmpuint(
+		ccl_event_wait_list_get_num_events(evt_wait_lst), ==, 0);
+	ccl_event_wait_list_add(evt_wait_lst, evt, NULL);
+
+	(*num_cb)++;
+
+}
+
+/**
+ * Tests iterative execution of kernels with ping-pong argument sets.
+ * */
+static void iter_test() {
+
+	/* Test variables. */
+	CCLContext* ctx = NULL;
+	CCLProgram* prg = NULL;
+	CCLKernel* krnls[2] = { NULL, NULL };
+	CCLQueue* cq = NULL;
+	CCLBuffer* bufs[2] = { NULL, NULL };
+	CCLEvent* evt = NULL;
+	CCLErr* err = NULL;
+	size_t gws = CCL_TEST_KERNEL_BUF_SIZE;
+	size_t lws = CCL_TEST_KERNEL_LWS;
+	cl_uint host_buf[CCL_TEST_KERNEL_BUF_SIZE];
+	cl_uint host_buf_aux[CCL_TEST_KERNEL_BUF_SIZE];
+	cl_uint num_iters = 10;
+	cl_uint num_cb = 0;
+
+	/* Initialize host data. */
+	for (cl_uint i = 0; i < CCL_TEST_KERNEL_BUF_SIZE; ++i) {
+		host_buf[i] = i + 1;
+	}
+
+	/* Create a context with devices from first available platform. */
+	ctx = ccl_test_context_new(&err);
+	g_assert_no_error(err);
+
+	/* Create a new program from source and build it. */
+	prg = ccl_program_new_from_source(ctx, CCL_TEST_KERNEL_CONTENT, &err);
+	g_assert_no_error(err);
+	ccl_program_build(prg, NULL, &err);
+	g_assert_no_error(err);
+
+	/* Create an in-order command queue. */
+	cq = ccl_queue_new(ctx, NULL, 0, &err);
+	g_assert_no_error(err);
+
+	/* Create two kernel instances, each with its own buffer. */
+	for (cl_uint i = 0; i < 2; ++i) {
+		bufs[i] = ccl_buffer_new(ctx,
+			CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+			CCL_TEST_KERNEL_BUF_SIZE * sizeof(cl_uint), host_buf, &err);
+		g_assert_no_error(err);
+		krnls[i] = ccl_kernel_new(prg, CCL_TEST_KERNEL_NAME, &err);
+		g_assert_no_error(err);
+		ccl_kernel_set_args(krnls[i], bufs[i], NULL);
+	}
+
+	/* Run iterations without callback. */
+	evt = ccl_kernel_enqueue_ndrange_iter(krnls, 2, cq, 1, NULL, &gws,
+		&lws, num_iters, 0, NULL, NULL, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(evt != NULL);
+
+	/* Run iterations with callback every three iterations. */
+	evt = ccl_kernel_enqueue_ndrange_iter(krnls, 2, cq, 1, NULL, &gws,
+		&lws, num_iters, 3, iter_test_cb, &num_cb, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(evt != NULL);
+	g_assert_cmpuint(num_cb, ==, num_iters / 3);
+
+	/* Wait for everything to finish. */
+	ccl_queue_finish(cq, &err);
+	g_assert_no_error(err);
+
+	/* Check results are as expected (not available with OpenCL stub).
+	 * Each kernel instance ran half of the iterations in each call. */
+	for (cl_uint j = 0; j < 2; ++j) {
+
+		ccl_buffer_enqueue_read(bufs[j], cq, CL_TRUE, 0,
+			CCL_TEST_KERNEL_BUF_SIZE * sizeof(cl_uint), host_buf_aux,
+			NULL, &err);
+		g_assert_no_error(err);
+
+#ifndef OPENCL_STUB
+		for (cl_uint i = 0; i < CCL_TEST_KERNEL_BUF_SIZE; ++i) {
+			g_assert_cmpuint(host_buf[i] + num_iters, ==, host_buf_aux[i]);
+		}
+#endif
+
+	}
+
+	/* Destroy stuff. */
+	for (cl_uint i = 0; i < 2; ++i) {
+		ccl_kernel_destroy(krnls[i]);
+		ccl_buffer_destroy(bufs[i]);
+	}
+	ccl_queue_destroy(cq);
+	ccl_program_destroy(prg);
+	ccl_context_destroy(ctx);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
+/**
+ * State of the chunked kernel execution test callback.
+ * */
+typedef struct chunked_test_data {
+	cl_uint num_cb;
+	CCLContext* ctx;
+	CCLEvent* uevt;
+	GThread* thread;
+	gint released;
+} ChunkedTestData;
+
+/**
+ * @internal
+ * Thread function which completes the user event added by the chunked
+ * kernel execution test callback, after a while.
+ * */
+static gpointer chunked_test_release(gpointer data) {
+
+	CCLErr* err = NULL;
+	ChunkedTestData* td = (ChunkedTestData*) data;
+
+	g_usleep(50000);
+	g_atomic_int_set(&td->released, 1);
+	ccl_user_event_set_status(td->uevt, CL_COMPLETE, &err);
+	g_assert_no_error(err);
+	return NULL;
+
+}
+
+/**
+ * @internal
+ * Waits for the release thread of the chunked kernel execution test and
+ * destroys its user event.
+ * */
+static void chunked_test_join(ChunkedTestData* td) {
+
+	g_thread_join(td->thread);
+	g_assert_cmpint(g_atomic_int_get(&td->released), ==, 1);
+	ccl_event_destroy(td->uevt);
+	td->uevt = NULL;
+	td->thread = NULL;
+
+}
+
+/**
+ * Callback for chunked kernel execution test, counts invocations and
+ * gates the next slice with a user event, completed later by another
+ * thread.
+ * */
+static void chunked_test_cb(cl_uint iter, CCLEvent* evt,
+	CCLEventWaitList* evt_wait_lst, void* user_data, CCLErr** err) {
+
+	ChunkedTestData* td = (ChunkedTestData*) user_data;
+	CCLEventWaitList ewl = NULL;
+	CCLErr* err_wait = NULL;
+
+	/* Callback should be invoked once per slice, in order. */
+	g_assert_cmpuint(iter, ==, td->num_cb);
+	g_assert(evt != NULL);
+	g_assert(evt_wait_lst != NULL);
+	g_assert(err == NULL || *err == NULL);
+
+	/* This slice waited on the user event added by the previous
+	 * callback, so it only completes after that event is released. */
+	if (iter > 0) {
+		ccl_event_wait(ccl_ewl(&ewl, evt, NULL), &err_wait);
+		g_assert_no_error(err_wait);
+		g_assert_cmpint(g_atomic_int_get(&td->released), ==, 1);
+		chunked_test_join(td);
+	}
+
+	/* Gate the next slice with a user event. */
+	td->uevt = ccl_user_event_new(td->ctx, &err_wait);
+	g_assert_no_error(err_wait);
+	ccl_event_wait_list_add(evt_wait_lst, td->uevt, NULL);
+	g_atomic_int_set(&td->released, 0);
+	td->thread = g_thread_new("chunked", chunked_test_release, td);
+
+	td->num_cb++;
+
+}
+
+/**
+ * Tests chunked execution of kernels.
+ * */
+static void chunked_test() {
+
+	/* Test variables. */
+	CCLContext* ctx = NULL;
+	CCLProgram* prg = NULL;
+	CCLKernel* krnl = NULL;
+	CCLQueue* cq = NULL;
+	CCLBuffer* buf = NULL;
+	CCLEvent* evt = NULL;
+	CCLEventWaitList ewl = NULL;
+	CCLErr* err = NULL;
+	size_t gws = 64 * CCL_TEST_KERNEL_LWS;
+	size_t lws = CCL_TEST_KERNEL_LWS;
+	size_t gwo = CCL_TEST_KERNEL_LWS;
+	cl_uint host_buf[65 * CCL_TEST_KERNEL_LWS];
+	cl_uint host_buf_aux[65 * CCL_TEST_KERNEL_LWS];
+	ChunkedTestData td = { 0, NULL, NULL, NULL, 0 };
+
+	/* Initialize host data. */
+	for (cl_uint i = 0; i < 65 * CCL_TEST_KERNEL_LWS; ++i) {
+		host_buf[i] = i;
+	}
+
+	/* Create a context with devices from first available platform. */
+	ctx = ccl_test_context_new(&err);
+	g_assert_no_error(err);
+
+	/* Create a new program from source and build it. */
+	prg = ccl_program_new_from_source(ctx, CCL_TEST_KERNEL_CONTENT, &err);
+	g_assert_no_error(err);
+	ccl_program_build(prg, NULL, &err);
+	g_assert_no_error(err);
+
+	/* Create an in-order command queue. */
+	cq = ccl_queue_new(ctx, NULL, 0, &err);
+	g_assert_no_error(err);
+
+	/* Create kernel and buffer. */
+	buf = ccl_buffer_new(ctx, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+		sizeof(host_buf), host_buf, &err);
+	g_assert_no_error(err);
+	krnl = ccl_kernel_new(prg, CCL_TEST_KERNEL_NAME, &err);
+	g_assert_no_error(err);
+	ccl_kernel_set_args(krnl, buf, NULL);
+	td.ctx = ctx;
+
+	/* Invalid number of dimensions should throw error. */
+	evt = ccl_kernel_enqueue_ndrange_chunked(krnl, cq, 0, NULL, &gws,
+		&lws, 0.01, NULL, NULL, NULL, &err);
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+	g_assert(evt == NULL);
+	g_clear_error(&err);
+
+	/* Run in chunks with an offset, skipping the first work-group. */
+	evt = ccl_kernel_enqueue_ndrange_chunked(krnl, cq, 1, &gwo, &gws,
+		&lws, 0.01, chunked_test_cb, &td, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(evt != NULL);
+
+	/* The range is split in several slices, with yield points between
+	 * them. */
+	g_assert_cmpuint(td.num_cb, >=, 1);
+
+	/* Wait for the aggregate event, and for the user event which gates
+	 * the last slice. */
+	ccl_event_wait(ccl_ewl(&ewl, evt, NULL), &err);
+	g_assert_no_error(err);
+	chunked_test_join(&td);
+
+	/* Check that every work-item ran exactly once (not available with
+	 * OpenCL stub). */
+	ccl_buffer_enqueue_read(buf, cq, CL_TRUE, 0, sizeof(host_buf_aux),
+		host_buf_aux, NULL, &err);
+	g_assert_no_error(err);
+
+#ifndef OPENCL_STUB
+	for (cl_uint i = 0; i < 65 * CCL_TEST_KERNEL_LWS; ++i) {
+		g_assert_cmpuint(host_buf[i] + (i < gwo ? 0 : 1),
+			==, host_buf_aux[i]);
+	}
+#endif
+
+	/* Destroy stuff. */
+	ccl_kernel_destroy(krnl);
+	ccl_buffer_destroy(buf);
+	ccl_queue_destroy(cq);
+	ccl_program_destroy(prg);
+	ccl_context_destroy(ctx);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
+/**
+ * Tests the fusion composer.
+ * */
+static void fusion_test() {
+
+	/* Test variables. */
+	CCLErr* err = NULL;
+	CCLContext* ctx = NULL;
+	CCLQueue* cq = NULL;
+	CCLFusion* fus = NULL;
+	CCLBuffer* a = NULL;
+	CCLBuffer* b = NULL;
+	CCLBuffer* c = NULL;
+	CCLEvent* evt = NULL;
+	char* src;
+	cl_float a_h[19], b_h[19];
+	cl_int c_h[19];
+	size_t n = 19;
+
+	/* Initialize host data. */
+	for (cl_uint i = 0; i < n; ++i) {
+		a_h[i] = (cl_float) i;
+		b_h[i] = (cl_float) (2 * i);
+	}
+
+	/* Set up context, queue and buffers. */
+	ctx = ccl_test_context_new(&err);
+	g_assert_no_error(err);
+	cq = ccl_queue_new(ctx, NULL, 0, &err);
+	g_assert_no_error(err);
+	a = ccl_buffer_new(ctx, CL_MEM_READ_WRITE | CL_MEM_COPY_HOST_PTR,
+		sizeof(a_h), a_h, &err);
+	g_assert_no_error(err);
+	b = ccl_buffer_new(ctx, CL_MEM_READ_ONLY | CL_MEM_COPY_HOST_PTR,
+		sizeof(b_h), b_h, &err);
+	g_assert_no_error(err);
+	c = ccl_buffer_new(ctx, CL_MEM_WRITE_ONLY, sizeof(c_h), NULL, &err);
+	g_assert_no_error(err);
+
+	/* Declare chain. */
+	CCLFusionOp ops[] = {
+		ccl_fusion_op_scale(0.5f),
+		ccl_fusion_op_add(b),
+		ccl_fusion_op_clamp(0.0f, 20.0f),
+		ccl_fusion_op_convert("int")
+	};
+
+	/* Check generated source, scalar and vectorized. */
+	src = ccl_fusion_get_source("float", ops, 4, 1, &err);
+	g_assert_no_error(err);
+	g_assert(strstr(src, "__kernel void ccl_fused") != NULL);
+	g_assert(strstr(src, "__global int* out") != NULL);
+	g_assert(strstr(src, "convert_int(x3)") != NULL);
+	g_free(src);
+	src = ccl_fusion_get_source("float", ops, 4, 4, &err);
+	g_assert_no_error(err);
+	g_assert(strstr(src, "vload4(0, b1 + i)") != NULL);
+	g_assert(strstr(src, "convert_int4(x3)") != NULL);
+	g_free(src);
+
+	/* Run chain. */
+	fus = ccl_fusion_new(ctx);
+	evt = ccl_fusion_enqueue(fus, cq, a, "float", c, n, ops, 4, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(evt != NULL);
+	g_assert_cmpuint(ccl_fusion_get_num_kernels(fus), ==, 1);
+
+	/* Check results (not available with OpenCL stub). */
+	ccl_buffer_enqueue_read(c, cq, CL_TRUE, 0, sizeof(c_h), c_h, NULL, &err);
+	g_assert_no_error(err);
+#ifndef OPENCL_STUB
+	for (cl_uint i = 0; i < n; ++i) {
+		g_assert_cmpint(c_h[i], ==, (cl_int) MIN(2.5f * i, 20.0f));
+	}
+#endif
+
+	/* Different constants reuse the cached kernel. */
+	ops[0].a = 2.0f;
+	ccl_fusion_enqueue(fus, cq, a, "float", c, n, ops, 4, NULL, &err);
+	g_assert_no_error(err);
+	g_assert_cmpuint(ccl_fusion_get_num_kernels(fus), ==, 1);
+
+	/* A different chain, in place, requires a new kernel. */
+	ccl_fusion_enqueue(fus, cq, a, "float", a, n, ops, 2, NULL, &err);
+	g_assert_no_error(err);
+	g_assert_cmpuint(ccl_fusion_get_num_kernels(fus), ==, 2);
+
+	/* Unsupported types are rejected. */
+	ops[3].type_name = "bogus";
+	evt = ccl_fusion_enqueue(fus, cq, a, "float", c, n, ops, 4, NULL, &err);
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+	g_assert(evt == NULL);
+	g_clear_error(&err);
+
+	ccl_queue_finish(cq, &err);
+	g_assert_no_error(err);
+
+	/* Destroy stuff. */
+	ccl_fusion_destroy(fus);
+	ccl_buffer_destroy(a);
+	ccl_buffer_destroy(b);
+	ccl_buffer_destroy(c);
+	ccl_queue_destroy(cq);
+	ccl_context_destroy(ctx);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
+/**
+ * Tests batched launches.
+ * */
+static void batch_test() {
+
+	/* Test variables. */
+	CCLErr* err = NULL;
+	CCLContext* ctx = NULL;
+	CCLQueue* cq = NULL;
+	CCLBatch* batch = NULL;
+	CCLEvent* evt = NULL;
+	char* src;
+	cl_uint a_h[25], b_h[25], c_h[25];
+	size_t lengths[] = { 5, 0, 17, 3 };
+	size_t off = 0;
+	cl_uint d = 7;
+
+	/* Kernel source, with a helper function and another kernel around
+	 * the kernel to batch. */
+	const char* ksrc =
+		"uint add3(uint x, uint y, uint z) { return x + y + z; }\n"
+		"__kernel void sum(__global const uint *a,\n"
+		"	__global const uint *b, __global uint *c, uint d,\n"
+		"	uint buf_size) {\n"
+		"	uint gid = get_global_id(0);\n"
+		"	if (gid < buf_size) { c[gid] = add3(a[gid], b[gid], d); }\n"
+		"}\n"
+		"__kernel void other(__global uint *c) { c[0] = 1; }\n";
+
+	/* Description of kernel arguments. */
+	CCLBatchArg args[] = {
+		ccl_batch_arg_in(cl_uint), ccl_batch_arg_in(cl_uint),
+		ccl_batch_arg_out(cl_uint), ccl_batch_arg_shared(),
+		ccl_batch_arg_length()
+	};
+
+	/* Initialize host data. */
+	for (cl_uint i = 0; i < 25; ++i) {
+		a_h[i] = i;
+		b_h[i] = 100 * i;
+		c_h[i] = 0;
+	}
+
+	/* Check generated source. */
+	src = ccl_batch_get_source(ksrc, "sum", args, 5, &err);
+	g_assert_no_error(err);
+	g_assert(strstr(src, "__kernel void ccl_batched(") != NULL);
+	g_assert(strstr(src, "void ccl_batch_sum(size_t ccl_batch_i") != NULL);
+	g_assert(strstr(src, "__kernel void sum(") == NULL);
+	g_assert(strstr(src, "__kernel void other(") != NULL);
+	g_assert(strstr(src, "a + ccl_offs[ccl_lo]") != NULL);
+	g_free(src);
+
+	/* Unknown kernels and mismatched arguments are rejected. */
+	src = ccl_batch_get_source(ksrc, "su", args, 5, &err);
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+	g_assert(src == NULL);
+	g_clear_error(&err);
+	src = ccl_batch_get_source(ksrc, "sum", args, 4, &err);
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+	g_assert(src == NULL);
+	g_clear_error(&err);
+
+	/* Set up context, queue and batcher. */
+	ctx = ccl_test_context_new(&err);
+	g_assert_no_error(err);
+	cq = ccl_queue_new(ctx, NULL, 0, &err);
+	g_assert_no_error(err);
+	batch = ccl_batch_new(ctx, ksrc, "sum", args, 5, &err);
+	g_assert_no_error(err);
+
+	/* Launching without instances is an error. */
+	evt = ccl_batch_enqueue(batch, cq, NULL, &err);
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+	g_assert(evt == NULL);
+	g_clear_error(&err);
+
+	/* Add instances, one of them empty, and launch them. */
+	for (cl_uint p = 0; p < G_N_ELEMENTS(lengths); ++p) {
+		void* data[] = { a_h + off, b_h + off, c_h + off, NULL, NULL };
+		ccl_batch_add(batch, lengths[p], data);
+		off += lengths[p];
+	}
+	g_assert_cmpuint(ccl_batch_get_num_problems(batch), ==, 4);
+	void* shared[] = { NULL, NULL, NULL, ccl_arg_priv(d, cl_uint), NULL };
+	evt = ccl_batch_enqueue(batch, cq, shared, &err);
+	g_assert_no_error(err);
+	g_assert(evt != NULL);
+	g_assert_cmpuint(ccl_batch_get_num_problems(batch), ==, 0);
+
+	/* Check results (not available with OpenCL stub). */
+#ifndef OPENCL_STUB
+	for (cl_uint i = 0; i < off; ++i) {
+		g_assert_cmpuint(c_h[i], ==, 101 * i + d);
+	}
+#endif
+
+	/* Destroy stuff. */
+	ccl_batch_destroy(batch);
+	ccl_queue_destroy(cq);
+	ccl_context_destroy(ctx);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
 /**
  * Main function.
  * @param[in] argc Number of command line arguments.
@@ -1206,6 +1730,22 @@ int main(int argc, char** argv) {
 		"/wrappers/kernel/native",
 		native_test);
 
+	g_test_add_func(
+		"/wrappers/kernel/iter",
+		iter_test);
+
+	g_test_add_func(
+		"/wrappers/kernel/chunked",
+		chunked_test);
+
+	g_test_add_func(
+		"/wrappers/kernel/fusion",
+		fusion_test);
+
+	g_test_add_func(
+		"/wrappers/kernel/batch",
+		batch_test);
+
 	return g_test_run();
 }
 
@@ -25,6 +25,7 @@
  * */
 
 #include <cf4ocl2.h>
+#include <glib/gstdio.h>
 #include "test.h"
 
 /**
@@ -134,6 +135,623 @@ static void create_add_destroy_test() {
 
 }
 
+/**
+ * Tests the history-based kernel cost model.
+ * */
+static void cost_model_test() {
+
+	/* Test variables. */
+	CCLErr* err = NULL;
+	CCLCostModel* cm = NULL;
+	CCLCostModel* cm_loaded = NULL;
+	CCLContext* ctx = NULL;
+	CCLDevice* d = NULL;
+	CCLDevice* devs[2];
+	CCLQueue* cq = NULL;
+	CCLProgram* prg = NULL;
+	CCLKernel* krnl = NULL;
+	CCLBuffer* buf = NULL;
+	CCLEvent* evt = NULL;
+	CCLEventWaitList ewl = NULL;
+	const char* dev_name;
+	size_t gws = 16;
+	size_t bytes[2] = { 1 << 30, 0 };
+	double predicted;
+	cl_int chosen;
+	gchar* tmp_dir_name;
+	gchar* filename;
+
+	/* Set up context, queue, kernel and buffer. */
+	ctx = ccl_test_context_new(&err);
+	g_assert_no_error(err);
+	d = ccl_context_get_device(ctx, 0, &err);
+	g_assert_no_error(err);
+	cq = ccl_queue_new(ctx, d, CL_QUEUE_PROFILING_ENABLE, &err);
+	g_assert_no_error(err);
+	prg = ccl_program_new_from_source(ctx,
+		"__kernel void cm_krnl(__global uint *buf)\n"
+		"{ buf[get_global_id(0)] += 1; }\n", &err);
+	g_assert_no_error(err);
+	ccl_program_build(prg, NULL, &err);
+	g_assert_no_error(err);
+	krnl = ccl_program_get_kernel(prg, "cm_krnl", &err);
+	g_assert_no_error(err);
+	buf = ccl_buffer_new(
+		ctx, CL_MEM_READ_WRITE, gws * sizeof(cl_uint), NULL, &err);
+	g_assert_no_error(err);
+	dev_name = ccl_device_get_info_array(d, CL_DEVICE_NAME, char*, &err);
+	g_assert_no_error(err);
+
+	/* Create cost model without exploration. */
+	cm = ccl_cost_model_new();
+	ccl_cost_model_set_exploration(cm, 0.0, 0);
+	devs[0] = d;
+	devs[1] = d;
+
+	/* Without history, the first device is explored. */
+	chosen = ccl_cost_model_place(
+		cm, krnl, devs, 2, gws, NULL, &predicted, &err);
+	g_assert_no_error(err);
+	g_assert_cmpint(chosen, ==, 0);
+	g_assert_cmpfloat(predicted, <, 0.0);
+	g_assert_cmpfloat(
+		ccl_cost_model_predict(cm, "cm_krnl", dev_name, gws), <, 0.0);
+
+	/* Launch kernel and record its execution time. */
+	evt = ccl_kernel_set_args_and_enqueue_ndrange(krnl, cq, 1, NULL,
+		&gws, NULL, NULL, &err, buf, NULL);
+	g_assert_no_error(err);
+	ccl_event_wait(ccl_ewl(&ewl, evt, NULL), &err);
+	g_assert_no_error(err);
+	ccl_cost_model_record_event(cm, krnl, d, evt, gws, &err);
+	g_assert_no_error(err);
+	g_assert_cmpfloat(
+		ccl_cost_model_predict(cm, "cm_krnl", dev_name, gws), >=, 0.0);
+
+	/* Check averaging and linear scaling between size buckets. */
+	ccl_cost_model_record(cm, "k", "dev", 1000, 1.0);
+	ccl_cost_model_record(cm, "k", "dev", 1000, 3.0);
+	g_assert_cmpfloat(
+		ccl_cost_model_predict(cm, "k", "dev", 1000), ==, 2.0);
+	g_assert_cmpfloat(
+		ccl_cost_model_predict(cm, "k", "dev", 4000), ==, 8.0);
+	g_assert_cmpfloat(
+		ccl_cost_model_predict(cm, "k", "dev", 250), ==, 0.5);
+	g_assert_cmpfloat(
+		ccl_cost_model_predict(cm, "k", "other", 1000), <, 0.0);
+
+	/* With history, the device to which data must not be moved wins. */
+	ccl_cost_model_record_transfer(cm, dev_name, 1 << 20, 1e-3);
+	chosen = ccl_cost_model_place(
+		cm, krnl, devs, 2, gws, bytes, &predicted, &err);
+	g_assert_no_error(err);
+	g_assert_cmpint(chosen, ==, 1);
+	g_assert_cmpfloat(predicted, >=, 0.0);
+	g_assert_cmpfloat(predicted, <, 1.0);
+
+	/* With full exploration, the other device is always chosen. */
+	ccl_cost_model_set_exploration(cm, 1.0, 1);
+	chosen = ccl_cost_model_place(
+		cm, krnl, devs, 2, gws, bytes, NULL, &err);
+	g_assert_no_error(err);
+	g_assert_cmpint(chosen, ==, 0);
+
+	/* Save history and load it into another cost model. */
+	tmp_dir_name = g_dir_make_tmp("test_cost_model_XXXXXX", &err);
+	g_assert_no_error(err);
+	filename = g_build_filename(tmp_dir_name, "costs.txt", NULL);
+	ccl_cost_model_save(cm, filename, &err);
+	g_assert_no_error(err);
+	cm_loaded = ccl_cost_model_new();
+	ccl_cost_model_load(cm_loaded, filename, &err);
+	g_assert_no_error(err);
+	g_assert_cmpfloat(
+		ccl_cost_model_predict(cm_loaded, "k", "dev", 1000), ==, 2.0);
+	g_assert_cmpfloat(
+		ccl_cost_model_predict(cm_loaded, "cm_krnl", dev_name, gws), ==,
+		ccl_cost_model_predict(cm, "cm_krnl", dev_name, gws));
+
+	/* Loading something which is not a cost model file fails. */
+	g_file_set_contents(filename, "garbage\n", -1, &err);
+	g_assert_no_error(err);
+	ccl_cost_model_load(cm_loaded, filename, &err);
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_INVALID_DATA);
+	g_clear_error(&err);
+	g_unlink(filename);
+	g_rmdir(tmp_dir_name);
+	g_free(filename);
+	g_free(tmp_dir_name);
+
+	/* Destroy stuff. */
+	ccl_cost_model_destroy(cm_loaded);
+	ccl_cost_model_destroy(cm);
+	ccl_buffer_destroy(buf);
+	ccl_program_destroy(prg);
+	ccl_queue_destroy(cq);
+	ccl_context_destroy(ctx);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
+/**
+ * Tests roofline information of events annotated with the work they
+ * perform.
+ * */
+static void roofline_test() {
+
+	/* Test variables. */
+	CCLErr* err = NULL;
+	CCLProf* prof = NULL;
+	CCLContext* ctx = NULL;
+	CCLDevice* d = NULL;
+	CCLQueue* cq = NULL;
+	CCLProgram* prg = NULL;
+	CCLKernel* krnl = NULL;
+	CCLBuffer* buf = NULL;
+	CCLEvent* evt = NULL;
+	CCLEventWaitList ewl = NULL;
+	const CCLProfAgg* agg;
+	size_t gws = 1024;
+	cl_ulong br, bw, fl;
+	double peak_bw, peak_flops;
+	const char* summary;
+	gchar* tmp_dir_name;
+	gchar* filename;
+	gchar* contents;
+
+	/* Set up context, queue, kernel and buffer. */
+	ctx = ccl_test_context_new(&err);
+	g_assert_no_error(err);
+	d = ccl_context_get_device(ctx, 0, &err);
+	g_assert_no_error(err);
+	cq = ccl_queue_new(ctx, d, CL_QUEUE_PROFILING_ENABLE, &err);
+	g_assert_no_error(err);
+	prg = ccl_program_new_from_source(ctx,
+		"__kernel void rl_krnl(__global float *buf)\n"
+		"{ buf[get_global_id(0)] *= 2.0f; }\n", &err);
+	g_assert_no_error(err);
+	ccl_program_build(prg, NULL, &err);
+	g_assert_no_error(err);
+	krnl = ccl_program_get_kernel(prg, "rl_krnl", &err);
+	g_assert_no_error(err);
+	buf = ccl_buffer_new(
+		ctx, CL_MEM_READ_WRITE, gws * sizeof(cl_float), NULL, &err);
+	g_assert_no_error(err);
+
+	/* Device peaks are unknown until measured or set. */
+	g_assert(!ccl_prof_get_device_peaks(d, &peak_bw, &peak_flops));
+
+	/* Without peaks, annotated events have no roofline information. */
+	evt = ccl_kernel_set_args_and_enqueue_ndrange(krnl, cq, 1, NULL,
+		&gws, NULL, NULL, &err, buf, NULL);
+	g_assert_no_error(err);
+	ccl_event_set_name(evt, "no_peaks");
+	ccl_event_set_work(evt, gws * sizeof(cl_float), gws * sizeof(cl_float),
+		gws);
+	ccl_event_wait(ccl_ewl(&ewl, evt, NULL), &err);
+	g_assert_no_error(err);
+	prof = ccl_prof_new();
+	ccl_prof_add_queue(prof, "q", cq);
+	g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "*'no_peaks'*");
+	ccl_prof_calc(prof, &err);
+	g_test_assert_expected_messages();
+	g_assert_no_error(err);
+	agg = ccl_prof_get_agg(prof, "no_peaks");
+	g_assert(agg != NULL);
+	g_assert_cmpuint(agg->bytes, ==, 2 * gws * sizeof(cl_float));
+	g_assert_cmpuint(agg->flops, ==, gws);
+	g_assert_cmpint(agg->bound, ==, CCL_PROF_BOUND_NONE);
+	g_assert_cmpfloat(agg->roofline, ==, 0.0);
+	ccl_prof_destroy(prof);
+
+#ifndef OPENCL_STUB
+	/* Measure device peaks (not possible with the OpenCL stub, whose
+	 * kernels don't use device time). */
+	ccl_prof_measure_device_peaks(d, &err);
+	g_assert_no_error(err);
+	g_assert(ccl_prof_get_device_peaks(d, &peak_bw, &peak_flops));
+	g_assert_cmpfloat(peak_bw, >, 0.0);
+	g_assert_cmpfloat(peak_flops, >, 0.0);
+#endif
+
+	/* Set device peaks, which should replace measured ones. */
+	ccl_prof_set_device_peaks(d, 1e10, 1e11);
+	g_assert(ccl_prof_get_device_peaks(d, &peak_bw, &peak_flops));
+	g_assert_cmpfloat(peak_bw, ==, 1e10);
+	g_assert_cmpfloat(peak_flops, ==, 1e11);
+
+	/* A memory-bound launch. */
+	evt = ccl_kernel_set_args_and_enqueue_ndrange(krnl, cq, 1, NULL,
+		&gws, NULL, NULL, &err, buf, NULL);
+	g_assert_no_error(err);
+	g_assert(!ccl_event_get_work(evt, NULL, NULL, NULL));
+	ccl_event_set_name(evt, "mem_bound");
+	ccl_event_set_work(evt, gws * sizeof(cl_float), gws * sizeof(cl_float),
+		gws);
+	g_assert(ccl_event_get_work(evt, &br, &bw, &fl));
+	g_assert_cmpuint(br, ==, gws * sizeof(cl_float));
+	g_assert_cmpuint(bw, ==, gws * sizeof(cl_float));
+	g_assert_cmpuint(fl, ==, gws);
+
+	/* A compute-bound launch, as far as annotations go. */
+	evt = ccl_kernel_enqueue_ndrange(krnl, cq, 1, NULL, &gws, NULL,
+		NULL, &err);
+	g_assert_no_error(err);
+	ccl_event_set_name(evt, "compute_bound");
+	ccl_event_set_work(evt, 1024, 0, 1 << 30);
+
+	/* A launch which is not annotated. */
+	evt = ccl_kernel_enqueue_ndrange(krnl, cq, 1, NULL, &gws, NULL,
+		NULL, &err);
+	g_assert_no_error(err);
+	ccl_event_set_name(evt, "not_annotated");
+	ccl_event_wait(ccl_ewl(&ewl, evt, NULL), &err);
+	g_assert_no_error(err);
+
+	/* Perform profiling. */
+	prof = ccl_prof_new();
+	ccl_prof_add_queue(prof, "q", cq);
+	ccl_prof_calc(prof, &err);
+	g_assert_no_error(err);
+
+	/* Check roofline information. */
+	agg = ccl_prof_get_agg(prof, "mem_bound");
+	g_assert(agg != NULL);
+	g_assert_cmpuint(agg->bytes, ==, 2 * gws * sizeof(cl_float));
+	g_assert_cmpuint(agg->flops, ==, gws);
+	g_assert_cmpfloat(agg->intensity, ==, 1.0 / (2 * sizeof(cl_float)));
+	g_assert_cmpint(agg->bound, ==, CCL_PROF_BOUND_MEMORY);
+	g_assert_cmpfloat(agg->roofline, >=, 0.0);
+
+	agg = ccl_prof_get_agg(prof, "compute_bound");
+	g_assert(agg != NULL);
+	g_assert_cmpfloat(agg->intensity, ==, (1 << 30) / 1024.0);
+	g_assert_cmpint(agg->bound, ==, CCL_PROF_BOUND_COMPUTE);
+
+	agg = ccl_prof_get_agg(prof, "not_annotated");
+	g_assert(agg != NULL);
+	g_assert_cmpuint(agg->bytes, ==, 0);
+	g_assert_cmpuint(agg->flops, ==, 0);
+	g_assert_cmpint(agg->bound, ==, CCL_PROF_BOUND_NONE);
+
+	/* Roofline information is shown in summary. */
+	summary = ccl_prof_get_summary(prof,
+		CCL_PROF_AGG_SORT_NAME | CCL_PROF_SORT_ASC,
+		CCL_PROF_OVERLAP_SORT_NAME | CCL_PROF_SORT_ASC);
+	g_assert(g_strrstr(summary, "Roofline by event") != NULL);
+	g_assert(g_strrstr(summary, "compute") != NULL);
+
+	/* ...and in exported aggregate information. */
+	tmp_dir_name = g_dir_make_tmp("test_roofline_XXXXXX", &err);
+	g_assert_no_error(err);
+	filename = g_build_filename(tmp_dir_name, "agg.tsv", NULL);
+	ccl_prof_export_agg_file(prof, filename, &err);
+	g_assert_no_error(err);
+	g_file_get_contents(filename, &contents, NULL, &err);
+	g_assert_no_error(err);
+	g_assert(g_str_has_prefix(contents, "compute_bound\t"));
+	g_assert(g_strrstr(contents, "\tmemory\n") != NULL);
+	g_assert(g_strrstr(contents, "\tnone\n") != NULL);
+	g_free(contents);
+	g_unlink(filename);
+	g_rmdir(tmp_dir_name);
+	g_free(filename);
+	g_free(tmp_dir_name);
+
+	/* Destroy stuff. */
+	ccl_prof_destroy(prof);
+	ccl_buffer_destroy(buf);
+	ccl_program_destroy(prg);
+	ccl_queue_destroy(cq);
+	ccl_context_destroy(ctx);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
+/**
+ * Tests recording of launch geometry and fitting of launch scaling.
+ * */
+static void launch_fit_test() {
+
+	/* Test variables. */
+	CCLErr* err = NULL;
+	CCLProf* prof = NULL;
+	CCLContext* ctx = NULL;
+	CCLDevice* d = NULL;
+	CCLQueue* cq = NULL;
+	CCLProgram* prg = NULL;
+	CCLKernel* krnl = NULL;
+	CCLBuffer* buf = NULL;
+	CCLEvent* evt = NULL;
+	CCLEventWaitList ewl = NULL;
+	const CCLProfInfo* info;
+	const size_t max_gws = 4096;
+	size_t gws, lws = 32;
+	size_t ev_gws[3], ev_lws[3];
+	cl_uint num_kernel_infos = 0;
+	cl_uint hbuf[4096] = { 0 };
+
+	/* Set up context, queue, kernel and buffer. */
+	ctx = ccl_test_context_new(&err);
+	g_assert_no_error(err);
+	d = ccl_context_get_device(ctx, 0, &err);
+	g_assert_no_error(err);
+	cq = ccl_queue_new(ctx, d, CL_QUEUE_PROFILING_ENABLE, &err);
+	g_assert_no_error(err);
+	prg = ccl_program_new_from_source(ctx,
+		"__kernel void fit_krnl(__global uint *buf)\n"
+		"{ buf[get_global_id(0)] += 1; }\n", &err);
+	g_assert_no_error(err);
+	ccl_program_build(prg, NULL, &err);
+	g_assert_no_error(err);
+	krnl = ccl_program_get_kernel(prg, "fit_krnl", &err);
+	g_assert_no_error(err);
+	buf = ccl_buffer_new(
+		ctx, CL_MEM_READ_WRITE, max_gws * sizeof(cl_uint), NULL, &err);
+	g_assert_no_error(err);
+	ccl_kernel_set_arg(krnl, 0, buf);
+
+	/* A transfer, which has no launch geometry. */
+	evt = ccl_buffer_enqueue_write(buf, cq, CL_TRUE, 0,
+		max_gws * sizeof(cl_uint), hbuf, NULL, &err);
+	g_assert_no_error(err);
+	g_assert_cmpuint(ccl_event_get_ndrange(evt, NULL, NULL), ==, 0);
+
+	/* Launch kernel with increasing global work sizes. */
+	for (gws = 64; gws <= max_gws; gws *= 2) {
+		evt = ccl_kernel_enqueue_ndrange(krnl, cq, 1, NULL, &gws, &lws,
+			NULL, &err);
+		g_assert_no_error(err);
+		ccl_event_set_name(evt, "fit_krnl");
+		g_assert_cmpuint(
+			ccl_event_get_ndrange(evt, ev_gws, ev_lws), ==, 1);
+		g_assert_cmpuint(ev_gws[0], ==, gws);
+		g_assert_cmpuint(ev_gws[1], ==, 1);
+		g_assert_cmpuint(ev_gws[2], ==, 1);
+		g_assert_cmpuint(ev_lws[0], ==, lws);
+	}
+	ccl_event_wait(ccl_ewl(&ewl, evt, NULL), &err);
+	g_assert_no_error(err);
+
+	/* Perform profiling. */
+	prof = ccl_prof_new();
+	ccl_prof_add_queue(prof, "q", cq);
+	ccl_prof_calc(prof, &err);
+	g_assert_no_error(err);
+
+	/* Check that launch geometry was recorded in event information. */
+	ccl_prof_iter_info_init(prof,
+		CCL_PROF_INFO_SORT_T_QUEUED | CCL_PROF_SORT_ASC);
+	while ((info = ccl_prof_iter_info_next(prof)) != NULL) {
+		if (info->command_type == CL_COMMAND_NDRANGE_KERNEL) {
+			g_assert_cmpuint(info->work_dim, ==, 1);
+			g_assert_cmpuint(info->global_work_size[0], >=, 64);
+			g_assert_cmpuint(info->local_work_size[0], ==, lws);
+			num_kernel_infos++;
+		} else {
+			g_assert_cmpuint(info->work_dim, ==, 0);
+		}
+	}
+	g_assert_cmpuint(num_kernel_infos, ==, 7);
+
+	/* Transfers are never fitted. */
+	g_assert(ccl_prof_get_fit(prof, "WRITE_BUFFER") == NULL);
+
+#ifndef OPENCL_STUB
+	/* Check launch scaling fit (not possible with the OpenCL stub,
+	 * whose kernels don't use device time; fits of launches with known
+	 * durations are checked by the profiler operation tests). */
+	{
+		const CCLProfFit* fit = ccl_prof_get_fit(prof, "fit_krnl");
+		g_assert(fit != NULL);
+		g_assert_cmpuint(fit->num_launches, ==, 7);
+		g_assert_cmpuint(fit->min_work_items, ==, 64);
+		g_assert_cmpuint(fit->max_work_items, ==, max_gws);
+		g_assert_cmpfloat(fit->overhead, >=, 0.0);
+		g_assert_cmpfloat(fit->per_item, >=, 0.0);
+		ccl_prof_iter_fit_init(prof,
+			CCL_PROF_FIT_SORT_NAME | CCL_PROF_SORT_ASC);
+		g_assert(ccl_prof_iter_fit_next(prof) == fit);
+		g_assert(ccl_prof_iter_fit_next(prof) == NULL);
+	}
+#endif
+
+	/* Destroy stuff. */
+	ccl_prof_destroy(prof);
+	ccl_buffer_destroy(buf);
+	ccl_program_destroy(prg);
+	ccl_queue_destroy(cq);
+	ccl_context_destroy(ctx);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
+/**
+ * Tests detection of redundant transfers.
+ * */
+static void redundant_transfers_test() {
+
+	/* Test variables. */
+	CCLErr* err = NULL;
+	CCLProf* prof = NULL;
+	CCLContext* ctx = NULL;
+	CCLDevice* d = NULL;
+	CCLQueue* cq = NULL;
+	CCLProgram* prg = NULL;
+	CCLKernel* krnl = NULL;
+	CCLKernel* krnl_copy = NULL;
+	CCLBuffer* bufs[5] = { NULL, NULL, NULL, NULL, NULL };
+	CCLEvent* evt = NULL;
+	const CCLProfTransfer* transfer;
+	const size_t n = 1024;
+	const size_t size = n * sizeof(cl_uint);
+	cl_uint hbuf1[1024] = { 0 };
+	cl_uint hbuf2[1024] = { 0 };
+	const char* summary;
+
+	/* Set up context, queue, kernel and buffers. */
+	ctx = ccl_test_context_new(&err);
+	g_assert_no_error(err);
+	d = ccl_context_get_device(ctx, 0, &err);
+	g_assert_no_error(err);
+	cq = ccl_queue_new(ctx, d, CL_QUEUE_PROFILING_ENABLE, &err);
+	g_assert_no_error(err);
+	prg = ccl_program_new_from_source(ctx,
+		"__kernel void rt_krnl(__global uint *buf)\n"
+		"{ buf[get_global_id(0)] += 1; }\n"
+		"__kernel void rt_copy(__global uint *src, __global uint *dst)\n"
+		"{ dst[get_global_id(0)] = src[get_global_id(0)]; }\n", &err);
+	g_assert_no_error(err);
+	ccl_program_build(prg, NULL, &err);
+	g_assert_no_error(err);
+	krnl = ccl_program_get_kernel(prg, "rt_krnl", &err);
+	g_assert_no_error(err);
+	krnl_copy = ccl_program_get_kernel(prg, "rt_copy", &err);
+	g_assert_no_error(err);
+	for (cl_uint i = 0; i < 5; ++i) {
+		bufs[i] = ccl_buffer_new(ctx,
+			i == 3 ? CL_MEM_READ_ONLY : CL_MEM_READ_WRITE, size, NULL, &err);
+		g_assert_no_error(err);
+	}
+
+	/* Enable transfer analysis. */
+	g_assert_cmpint(ccl_prof_get_transfer_mode(), ==, CCL_PROF_TRANSFER_OFF);
+	ccl_prof_set_transfer_mode(CCL_PROF_TRANSFER_FULL);
+	g_assert_cmpint(ccl_prof_get_transfer_mode(), ==, CCL_PROF_TRANSFER_FULL);
+
+	/* Write the same data twice to the first buffer, the second write
+	 * being redundant. */
+	evt = ccl_buffer_enqueue_write(
+		bufs[0], cq, CL_TRUE, 0, size, hbuf1, NULL, &err);
+	g_assert_no_error(err);
+	ccl_event_set_name(evt, "write_a");
+	evt = ccl_buffer_enqueue_write(
+		bufs[0], cq, CL_TRUE, 0, size, hbuf1, NULL, &err);
+	g_assert_no_error(err);
+	ccl_event_set_name(evt, "write_a_again");
+
+	/* Read the second buffer before and after a kernel modifies it, and
+	 * then once more, the last read being of unmodified data. */
+	evt = ccl_buffer_enqueue_read(
+		bufs[1], cq, CL_TRUE, 0, size, hbuf2, NULL, &err);
+	g_assert_no_error(err);
+	ccl_event_set_name(evt, "read_b");
+	evt = ccl_kernel_set_args_and_enqueue_ndrange(krnl, cq, 1, NULL,
+		&n, NULL, NULL, &err, bufs[1], NULL);
+	g_assert_no_error(err);
+	ccl_event_set_name(evt, "rt_krnl");
+	evt = ccl_buffer_enqueue_read(
+		bufs[1], cq, CL_TRUE, 0, size, hbuf2, NULL, &err);
+	g_assert_no_error(err);
+	ccl_event_set_name(evt, "read_b");
+	evt = ccl_buffer_enqueue_read(
+		bufs[1], cq, CL_TRUE, 0, size, hbuf2, NULL, &err);
+	g_assert_no_error(err);
+	ccl_event_set_name(evt, "read_b_again");
+
+	/* Write different data twice to the third buffer, the first write
+	 * being overwritten without being read. */
+	hbuf2[0] = 1; /* Make sure the data differs from the first write. */
+	evt = ccl_buffer_enqueue_write(
+		bufs[2], cq, CL_TRUE, 0, size, hbuf1, NULL, &err);
+	g_assert_no_error(err);
+	ccl_event_set_name(evt, "write_c");
+	evt = ccl_buffer_enqueue_write(
+		bufs[2], cq, CL_TRUE, 0, size, hbuf2, NULL, &err);
+	g_assert_no_error(err);
+	ccl_event_set_name(evt, "write_c_other");
+
+	/* Upload an input buffer, run a kernel which only reads it (the
+	 * buffer is read-only), and upload the same data again, the second
+	 * upload being redundant. */
+	evt = ccl_buffer_enqueue_write(
+		bufs[3], cq, CL_TRUE, 0, size, hbuf1, NULL, &err);
+	g_assert_no_error(err);
+	ccl_event_set_name(evt, "write_d");
+	evt = ccl_kernel_set_args_and_enqueue_ndrange(krnl_copy, cq, 1, NULL,
+		&n, NULL, NULL, &err, bufs[3], bufs[4], NULL);
+	g_assert_no_error(err);
+	ccl_event_set_name(evt, "rt_copy");
+	evt = ccl_buffer_enqueue_write(
+		bufs[3], cq, CL_TRUE, 0, size, hbuf1, NULL, &err);
+	g_assert_no_error(err);
+	ccl_event_set_name(evt, "write_d_again");
+	ccl_queue_finish(cq, &err);
+	g_assert_no_error(err);
+
+	/* Disable transfer analysis. */
+	ccl_prof_set_transfer_mode(CCL_PROF_TRANSFER_OFF);
+
+	/* Perform profiling. */
+	prof = ccl_prof_new();
+	ccl_prof_add_queue(prof, "q", cq);
+	ccl_prof_calc(prof, &err);
+	g_assert_no_error(err);
+
+	/* Check wasted transfers, sorted by kind and event name. */
+	ccl_prof_iter_transfer_init(prof,
+		CCL_PROF_TRANSFER_SORT_KIND | CCL_PROF_SORT_ASC);
+
+	transfer = ccl_prof_iter_transfer_next(prof);
+	g_assert(transfer != NULL);
+	g_assert_cmpint(transfer->kind, ==, CCL_PROF_TRANSFER_REDUNDANT);
+	g_assert_cmpstr(transfer->event_name, ==, "write_a_again");
+	g_assert_cmpuint(transfer->count, ==, 1);
+	g_assert_cmpuint(transfer->bytes, ==, size);
+
+	transfer = ccl_prof_iter_transfer_next(prof);
+	g_assert(transfer != NULL);
+	g_assert_cmpint(transfer->kind, ==, CCL_PROF_TRANSFER_REDUNDANT);
+	g_assert_cmpstr(transfer->event_name, ==, "write_d_again");
+	g_assert_cmpuint(transfer->count, ==, 1);
+	g_assert_cmpuint(transfer->bytes, ==, size);
+
+	transfer = ccl_prof_iter_transfer_next(prof);
+	g_assert(transfer != NULL);
+	g_assert_cmpint(transfer->kind, ==, CCL_PROF_TRANSFER_UNMODIFIED);
+	g_assert_cmpstr(transfer->event_name, ==, "read_b_again");
+	g_assert_cmpuint(transfer->count, ==, 1);
+	g_assert_cmpuint(transfer->bytes, ==, size);
+
+	transfer = ccl_prof_iter_transfer_next(prof);
+	g_assert(transfer != NULL);
+	g_assert_cmpint(transfer->kind, ==, CCL_PROF_TRANSFER_OVERWRITTEN);
+	g_assert_cmpstr(transfer->event_name, ==, "write_c");
+	g_assert_cmpuint(transfer->count, ==, 1);
+	g_assert_cmpuint(transfer->bytes, ==, size);
+
+	g_assert(ccl_prof_iter_transfer_next(prof) == NULL);
+
+	/* Wasted transfers are shown in summary. */
+	summary = ccl_prof_get_summary(prof,
+		CCL_PROF_AGG_SORT_NAME | CCL_PROF_SORT_ASC,
+		CCL_PROF_OVERLAP_SORT_NAME | CCL_PROF_SORT_ASC);
+	g_assert(g_strrstr(summary, "Redundant transfers") != NULL);
+	g_assert(g_strrstr(summary, "overwritten") != NULL);
+
+	/* Destroy stuff. */
+	ccl_prof_destroy(prof);
+	for (cl_uint i = 0; i < 5; ++i)
+		ccl_buffer_destroy(bufs[i]);
+	ccl_program_destroy(prg);
+	ccl_queue_destroy(cq);
+	ccl_context_destroy(ctx);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
 /**
  * Main function.
  * @param[in] argc Number of command line arguments.
@@ -147,6 +765,18 @@ int main(int argc, char** argv) {
 	g_test_add_func(
 		"/profiler/create-add-destroy", create_add_destroy_test);
 
+	g_test_add_func(
+		"/profiler/cost-model", cost_model_test);
+
+	g_test_add_func(
+		"/profiler/roofline", roofline_test);
+
+	g_test_add_func(
+		"/profiler/launch-fit", launch_fit_test);
+
+	g_test_add_func(
+		"/profiler/redundant-transfers", redundant_transfers_test);
+
 	return g_test_run();
 
 }
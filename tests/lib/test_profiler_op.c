@@ -351,6 +351,126 @@ static void operation_test() {
 
 }
 
+/**
+ * Launch a kernel on a single dimension and set the device times of its
+ * event.
+ * */
+static void fit_test_launch(CCLKernel* krnl, CCLQueue* q,
+	const char* name, size_t gws, cl_ulong t_start, cl_ulong duration) {
+
+	CCLEvent* ev;
+	cl_event ev_unwrapped;
+	CCLErr* err = NULL;
+
+	ev = ccl_kernel_enqueue_ndrange(krnl, q, 1, NULL, &gws, NULL, NULL,
+		&err);
+	g_assert_no_error(err);
+	ccl_event_set_name(ev, name);
+	ev_unwrapped = ccl_event_unwrap(ev);
+	ev_unwrapped->t_start = t_start;
+	ev_unwrapped->t_end = t_start + duration;
+
+}
+
+/**
+ * Tests the launch scaling fits of the profiling module, with known
+ * launch durations.
+ * */
+static void fit_test() {
+
+	/* Aux vars. */
+	CCLContext* ctx;
+	CCLDevice* dev;
+	CCLQueue* q;
+	CCLBuffer* buf;
+	CCLProgram* prg;
+	CCLKernel* krnl;
+	CCLProf* prof;
+	const CCLProfFit* fit;
+	CCLErr* err = NULL;
+	const char* src = "__kernel void k1(_global int* a){}";
+	cl_uint devidx = 0;
+
+	/* Create OpenCL wrappers for testing. */
+	ctx = ccl_context_new_from_device_index(&devidx, &err);
+	g_assert_no_error(err);
+	dev = ccl_context_get_device(ctx, 0, &err);
+	g_assert_no_error(err);
+	q = ccl_queue_new(ctx, dev, CL_QUEUE_PROFILING_ENABLE, &err);
+	g_assert_no_error(err);
+	buf = ccl_buffer_new(ctx, CL_MEM_READ_WRITE,
+		sizeof(cl_int) * CCL_TEST_MAXBUF, NULL, &err);
+	g_assert_no_error(err);
+	prg = ccl_program_new_from_source(ctx, src, &err);
+	g_assert_no_error(err);
+	krnl = ccl_program_get_kernel(prg, "k1", &err);
+	g_assert_no_error(err);
+	ccl_kernel_set_arg(krnl, 0, buf);
+
+	/* Launches which take 1000 ns plus 2 ns per work-item. */
+	fit_test_launch(krnl, q, "Linear", 100, 0, 1200);
+	fit_test_launch(krnl, q, "Linear", 200, 2000, 1400);
+	fit_test_launch(krnl, q, "Linear", 400, 4000, 1800);
+
+	/* Launches whose least-squares overhead would be negative. */
+	fit_test_launch(krnl, q, "NoOverhead", 100, 6000, 100);
+	fit_test_launch(krnl, q, "NoOverhead", 200, 7000, 300);
+
+	/* Launches whose least-squares per-item cost would be negative. */
+	fit_test_launch(krnl, q, "NoPerItem", 100, 8000, 500);
+	fit_test_launch(krnl, q, "NoPerItem", 200, 9000, 300);
+
+	/* Launches which always use the same number of work-items. */
+	fit_test_launch(krnl, q, "SameSize", 100, 10000, 500);
+	fit_test_launch(krnl, q, "SameSize", 100, 11000, 600);
+
+	/* Perform profiling calculations. */
+	prof = ccl_prof_new();
+	ccl_prof_add_queue(prof, "Q", q);
+	ccl_prof_calc(prof, &err);
+	g_assert_no_error(err);
+
+	/* Exact fit. */
+	fit = ccl_prof_get_fit(prof, "Linear");
+	g_assert(fit != NULL);
+	g_assert_cmpuint(fit->num_launches, ==, 3);
+	g_assert_cmpuint(fit->min_work_items, ==, 100);
+	g_assert_cmpuint(fit->max_work_items, ==, 400);
+	g_assert_cmpfloat(ABS(fit->overhead - 1000.0), <, 1e-6);
+	g_assert_cmpfloat(ABS(fit->per_item - 2.0), <, 1e-6);
+	g_assert_cmpfloat(ABS(fit->break_even - 500.0), <, 1e-6);
+
+	/* Overhead clamped to zero, per-item cost refitted through the
+	 * origin, (100 * 100 + 200 * 300) / (100 * 100 + 200 * 200). */
+	fit = ccl_prof_get_fit(prof, "NoOverhead");
+	g_assert(fit != NULL);
+	g_assert_cmpfloat(fit->overhead, ==, 0.0);
+	g_assert_cmpfloat(ABS(fit->per_item - 1.4), <, 1e-6);
+	g_assert_cmpfloat(fit->break_even, ==, 0.0);
+
+	/* Per-item cost clamped to zero, overhead is the mean duration. */
+	fit = ccl_prof_get_fit(prof, "NoPerItem");
+	g_assert(fit != NULL);
+	g_assert_cmpfloat(fit->per_item, ==, 0.0);
+	g_assert_cmpfloat(ABS(fit->overhead - 400.0), <, 1e-6);
+	g_assert_cmpfloat(fit->break_even, ==, 0.0);
+
+	/* Overhead and per-item cost can't be separated. */
+	g_assert(ccl_prof_get_fit(prof, "SameSize") == NULL);
+
+	/* Free stuff. */
+	ccl_prof_destroy(prof);
+	ccl_program_destroy(prg);
+	ccl_buffer_destroy(buf);
+	ccl_queue_destroy(q);
+	ccl_context_destroy(ctx);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
 /**
  * Main function.
  * @param[in] argc Number of command line arguments.
@@ -363,6 +483,8 @@ int main(int argc, char** argv) {
 
 	g_test_add_func("/profiler/operation", operation_test);
 
+	g_test_add_func("/profiler/fit", fit_test);
+
 	return g_test_run();
 
 }
@@ -27,6 +27,7 @@
 #include <cf4ocl2.h>
 #include <glib/gstdio.h>
 #include "test.h"
+#include "_ccl_program_wrapper.h"
 
 #define CCL_TEST_PROGRAM_SUM "test_sum_full"
 
@@ -647,6 +648,132 @@ static void ref_unref_test() {
 
 }
 
+/**
+ * Warm-up costs reported during the kernel pre-warming test.
+ * */
+typedef struct prewarm_test_data {
+	cl_uint count;
+	double cost;
+} PrewarmTestData;
+
+/**
+ * Callback for the kernel pre-warming test.
+ * */
+static void prewarm_test_cb(
+	const char* kernel_name, double cost, void* user_data) {
+
+	PrewarmTestData* data = (PrewarmTestData*) user_data;
+
+	g_assert_cmpstr(kernel_name, ==, CCL_TEST_PROGRAM_SUM);
+	data->count++;
+	data->cost = cost;
+
+}
+
+/**
+ * Test the mapping of kernel argument type names to argument sizes
+ * used for kernel pre-warming.
+ * */
+static void prewarm_arg_size_test() {
+
+	/* Scalar types, including spelled out unsigned types. */
+	g_assert_cmpuint(ccl_program_prewarm_arg_size("char"), ==, 1);
+	g_assert_cmpuint(ccl_program_prewarm_arg_size("uint"), ==, 4);
+	g_assert_cmpuint(ccl_program_prewarm_arg_size("unsigned int"), ==, 4);
+	g_assert_cmpuint(ccl_program_prewarm_arg_size("unsigned char"), ==, 1);
+	g_assert_cmpuint(ccl_program_prewarm_arg_size("double"), ==, 8);
+
+	/* Vector types, three-component vectors are sized as four-component
+	 * ones. */
+	g_assert_cmpuint(ccl_program_prewarm_arg_size("uint4"), ==, 16);
+	g_assert_cmpuint(ccl_program_prewarm_arg_size("float3"), ==, 16);
+	g_assert_cmpuint(ccl_program_prewarm_arg_size("short2"), ==, 4);
+	g_assert_cmpuint(ccl_program_prewarm_arg_size("double16"), ==, 128);
+
+	/* Types which can't be derived. */
+	g_assert_cmpuint(ccl_program_prewarm_arg_size("mystruct"), ==, 0);
+	g_assert_cmpuint(
+		ccl_program_prewarm_arg_size("struct my_struct"), ==, 0);
+	g_assert_cmpuint(ccl_program_prewarm_arg_size("uint5"), ==, 0);
+	g_assert_cmpuint(ccl_program_prewarm_arg_size("float4x"), ==, 0);
+	g_assert_cmpuint(ccl_program_prewarm_arg_size("uint*"), ==, 0);
+	g_assert_cmpuint(ccl_program_prewarm_arg_size("intptr_t"), ==, 0);
+
+}
+
+/**
+ * Test kernel pre-warming.
+ * */
+static void prewarm_test() {
+
+	CCLContext* ctx = NULL;
+	CCLDevice* dev = NULL;
+	CCLProgram* prg = NULL;
+	CCLErr* err = NULL;
+	const char* names[] = { CCL_TEST_PROGRAM_SUM, NULL };
+	PrewarmTestData data = { 0, 0.0 };
+	cl_uint ocl_ver;
+
+	const char* src = CCL_TEST_PROGRAM_SUM_CONTENT;
+
+	/* Get some context and its first device. */
+	ctx = ccl_test_context_new(&err);
+	g_assert_no_error(err);
+	dev = ccl_context_get_device(ctx, 0, &err);
+	g_assert_no_error(err);
+	ocl_ver = ccl_context_get_opencl_version(ctx, &err);
+	g_assert_no_error(err);
+
+	/* Create and build program, keeping argument information where
+	 * supported. */
+	prg = ccl_program_new_from_source(ctx, src, &err);
+	g_assert_no_error(err);
+	ccl_program_build(
+		prg, ocl_ver >= 120 ? "-cl-kernel-arg-info" : NULL, &err);
+	g_assert_no_error(err);
+
+	/* Pre-warm listed kernel. */
+	ccl_program_prewarm(prg, dev, names, prewarm_test_cb, &data, &err);
+	g_assert_no_error(err);
+	g_assert_cmpuint(data.count, ==, 1);
+
+#ifndef OPENCL_STUB
+	/* Kernel arguments can be derived with OpenCL >= 1.2. */
+	if (ocl_ver >= 120)
+		g_assert_cmpfloat(data.cost, >=, 0.0);
+#else
+	/* The stub provides no kernel argument information, so the kernel
+	 * is skipped. Argument size derivation is checked separately in
+	 * prewarm_arg_size_test(). */
+	g_assert_cmpfloat(data.cost, <, 0.0);
+#endif
+
+	/* Pre-warm all kernels, which requires OpenCL >= 1.2. */
+	data.count = 0;
+	if (ocl_ver >= 120) {
+#ifndef OPENCL_STUB
+		ccl_program_prewarm(prg, NULL, NULL, prewarm_test_cb, &data, &err);
+		g_assert_no_error(err);
+		g_assert_cmpuint(data.count, ==, 1);
+		g_assert_cmpfloat(data.cost, >=, 0.0);
+#endif
+	} else {
+		ccl_program_prewarm(prg, NULL, NULL, prewarm_test_cb, &data, &err);
+		g_assert_error(err, CCL_ERROR, CCL_ERROR_UNSUPPORTED_OCL);
+		g_clear_error(&err);
+		g_assert_cmpuint(data.count, ==, 0);
+	}
+
+	/* Destroy stuff. */
+	ccl_program_destroy(prg);
+	ccl_context_destroy(ctx);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
 #ifdef CL_VERSION_1_2
 
 static const char* src_head[] = {
@@ -785,6 +912,14 @@ int main(int argc, char** argv) {
 		"/wrappers/program/ref-unref",
 		ref_unref_test);
 
+	g_test_add_func(
+		"/wrappers/program/prewarm",
+		prewarm_test);
+
+	g_test_add_func(
+		"/wrappers/program/prewarm-arg-size",
+		prewarm_arg_size_test);
+
 #ifdef CL_VERSION_1_2
 	g_test_add_func(
 		"/wrappers/program/compile-link",
@@ -313,6 +313,457 @@ static void barrier_marker_test() {
 
 }
 
+#ifdef CL_VERSION_2_0
+
+/* Kernel which enqueues a child kernel in the on-device queue passed as
+ * argument. */
+#define ON_DEVICE_TEST_SRC \
+	"__kernel void on_device(queue_t q, __global uint* out) {\n" \
+	"	enqueue_kernel(q, CLK_ENQUEUE_FLAGS_NO_WAIT, ndrange_1D(1),\n" \
+	"		^{ out[0] = 1; });\n" \
+	"}\n"
+
+/**
+ * Device filter which only accepts OpenCL 2.0 or newer devices.
+ * */
+static cl_bool on_device_test_filter(
+	CCLDevice* dev, void* data, CCLErr** err) {
+
+	CCL_UNUSED(data);
+	return ccl_device_get_opencl_version(dev, err) >= 200;
+
+}
+
+#endif
+
+/**
+ * Tests creation of on-device command queues.
+ * */
+static void on_device_test() {
+
+	/* Test variables. */
+	CCLContext* ctx = NULL;
+	CCLDevice* dev = NULL;
+	CCLQueue* cq = NULL;
+	CCLErr* err = NULL;
+	cl_uint ocl_ver;
+
+#ifdef CL_VERSION_2_0
+
+	CCLDevSelFilters filters = NULL;
+
+	/* Prefer a context with an OpenCL 2.0 device, such as the one
+	 * provided by the OpenCL stub. */
+	ccl_devsel_add_indep_filter(&filters, on_device_test_filter, NULL);
+	ccl_devsel_add_dep_filter(&filters, ccl_devsel_dep_platform, NULL);
+	ctx = ccl_context_new_from_filters(&filters, &err);
+	g_clear_error(&err);
+
+#endif
+
+	/* Otherwise get the test context with the pre-defined device. */
+	if (ctx == NULL) {
+		ctx = ccl_test_context_new(&err);
+		g_assert_no_error(err);
+	}
+
+	/* Get first device in context. */
+	dev = ccl_context_get_device(ctx, 0, &err);
+	g_assert_no_error(err);
+
+	/* Get OpenCL versions of platform and device, the lowest one
+	 * determines if on-device queues are supported. */
+	ocl_ver = ccl_context_get_opencl_version(ctx, &err);
+	g_assert_no_error(err);
+	ocl_ver = MIN(ocl_ver, ccl_device_get_opencl_version(dev, &err));
+	g_assert_no_error(err);
+
+	/* Create default on-device queue with the preferred size. */
+	cq = ccl_queue_new_on_device(ctx, dev, 0, 0, CL_TRUE, &err);
+
+#ifdef CL_VERSION_2_0
+	if (ocl_ver >= 200) {
+
+		cl_command_queue_properties prop;
+		cl_uint size, max_size;
+		CCLQueue* cq_host;
+		CCLProgram* prg;
+		CCLKernel* krnl;
+		CCLBuffer* buf;
+		cl_uint out = 0;
+		size_t gws = 1;
+
+		g_assert_no_error(err);
+
+		/* Check that queue is on-device, default and out-of-order. */
+		prop = ccl_queue_get_info_scalar(
+			cq, CL_QUEUE_PROPERTIES, cl_command_queue_properties, &err);
+		g_assert_no_error(err);
+		g_assert(prop & CL_QUEUE_ON_DEVICE);
+		g_assert(prop & CL_QUEUE_ON_DEVICE_DEFAULT);
+		g_assert(prop & CL_QUEUE_OUT_OF_ORDER_EXEC_MODE_ENABLE);
+
+		/* Check that queue size is the preferred size. */
+		size = ccl_queue_get_info_scalar(cq, CL_QUEUE_SIZE, cl_uint, &err);
+		g_assert_no_error(err);
+		g_assert_cmpuint(size, ==, ccl_device_get_info_scalar(dev,
+			CL_DEVICE_QUEUE_ON_DEVICE_PREFERRED_SIZE, cl_uint, NULL));
+
+		/* Bind the on-device queue to a queue_t kernel argument and
+		 * launch the kernel from a host queue. */
+		cq_host = ccl_queue_new(ctx, dev, 0, &err);
+		g_assert_no_error(err);
+		buf = ccl_buffer_new(ctx, CL_MEM_READ_WRITE, sizeof(cl_uint),
+			NULL, &err);
+		g_assert_no_error(err);
+		prg = ccl_program_new_from_source(ctx, ON_DEVICE_TEST_SRC, &err);
+		g_assert_no_error(err);
+		ccl_program_build(prg, "-cl-std=CL2.0", &err);
+		g_assert_no_error(err);
+		krnl = ccl_program_get_kernel(prg, "on_device", &err);
+		g_assert_no_error(err);
+		ccl_buffer_enqueue_write(buf, cq_host, CL_TRUE, 0, sizeof(cl_uint),
+			&out, NULL, &err);
+		g_assert_no_error(err);
+		ccl_kernel_set_args_and_enqueue_ndrange(krnl, cq_host, 1, NULL,
+			&gws, NULL, NULL, &err, cq, buf, NULL);
+		g_assert_no_error(err);
+		ccl_buffer_enqueue_read(buf, cq_host, CL_TRUE, 0, sizeof(cl_uint),
+			&out, NULL, &err);
+		g_assert_no_error(err);
+
+#ifndef OPENCL_STUB
+		/* The child kernel should have run. */
+		g_assert_cmpuint(out, ==, 1);
+#endif
+
+		ccl_program_destroy(prg);
+		ccl_buffer_destroy(buf);
+		ccl_queue_destroy(cq_host);
+		ccl_queue_destroy(cq);
+
+		/* A queue larger than the maximum size should not be created. */
+		max_size = ccl_device_get_info_scalar(dev,
+			CL_DEVICE_QUEUE_ON_DEVICE_MAX_SIZE, cl_uint, &err);
+		g_assert_no_error(err);
+		cq = ccl_queue_new_on_device(ctx, dev, 0, max_size + 1, CL_FALSE,
+			&err);
+		g_assert_error(err, CCL_ERROR, CCL_ERROR_ARGS);
+		g_assert(cq == NULL);
+		g_clear_error(&err);
+
+	} else {
+#endif
+
+		/* On-device queues are not supported. */
+		CCL_UNUSED(ocl_ver);
+		g_assert_error(err, CCL_ERROR, CCL_ERROR_UNSUPPORTED_OCL);
+		g_assert(cq == NULL);
+		g_clear_error(&err);
+
+#ifdef CL_VERSION_2_0
+	}
+#endif
+
+	/* Release wrappers. */
+	ccl_context_destroy(ctx);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
+/**
+ * @internal
+ * Thread function which launches a kernel on a low priority queue and
+ * flags when the launch returns.
+ * */
+static gpointer qos_low_thread(gpointer data) {
+
+	CCLErr* err = NULL;
+	CCLKernel* krnl = ((gpointer*) data)[0];
+	CCLQueue* cq_low = ((gpointer*) data)[1];
+	CCLBuffer* buf_low = ((gpointer*) data)[2];
+	size_t* gws = ((gpointer*) data)[3];
+	gint* launched = ((gpointer*) data)[4];
+	CCLEvent* evt_low = ccl_kernel_set_args_and_enqueue_ndrange(krnl,
+		cq_low, 1, NULL, gws, NULL, NULL, &err, buf_low, NULL);
+	g_assert_no_error(err);
+	g_atomic_int_set(launched, 1);
+	return evt_low;
+
+}
+
+/**
+ * Tests quality-of-service queue classes.
+ * */
+static void qos_test() {
+
+	/* Test variables. */
+	CCLErr* err = NULL;
+	CCLContext* ctx = NULL;
+	CCLDevice* dev = NULL;
+	CCLQueue* cq_high = NULL;
+	CCLQueue* cq_low = NULL;
+	CCLQueue* cq = NULL;
+	CCLProgram* prg = NULL;
+	CCLKernel* krnl = NULL;
+	CCLBuffer* buf_high = NULL;
+	CCLBuffer* buf_low = NULL;
+	CCLEvent* uevt = NULL;
+	CCLEvent* evt_high = NULL;
+	CCLEvent* evt_low = NULL;
+	CCLEventWaitList ewl = NULL;
+	CCLProf* prof = NULL;
+	GThread* thread = NULL;
+	gpointer thread_data[5];
+	gint launched = 0;
+	size_t gws = 16;
+	cl_int exec_status;
+	cl_ulong latency, max_latency;
+
+	/* Set up context, program, kernel and buffers. */
+	ctx = ccl_test_context_new(&err);
+	g_assert_no_error(err);
+	dev = ccl_context_get_device(ctx, 0, &err);
+	g_assert_no_error(err);
+	prg = ccl_program_new_from_source(ctx,
+		"__kernel void qos_krnl(__global uint *buf)\n"
+		"{ buf[get_global_id(0)] += 1; }\n", &err);
+	g_assert_no_error(err);
+	ccl_program_build(prg, NULL, &err);
+	g_assert_no_error(err);
+	krnl = ccl_program_get_kernel(prg, "qos_krnl", &err);
+	g_assert_no_error(err);
+	buf_high = ccl_buffer_new(
+		ctx, CL_MEM_READ_WRITE, gws * sizeof(cl_uint), NULL, &err);
+	g_assert_no_error(err);
+	buf_low = ccl_buffer_new(
+		ctx, CL_MEM_READ_WRITE, gws * sizeof(cl_uint), NULL, &err);
+	g_assert_no_error(err);
+
+	/* Create queues of each class. */
+	cq_high = ccl_queue_new_qos(ctx, dev, CL_QUEUE_PROFILING_ENABLE,
+		CCL_QUEUE_QOS_HIGH, &err);
+	g_assert_no_error(err);
+	cq_low = ccl_queue_new_qos(ctx, dev, CL_QUEUE_PROFILING_ENABLE,
+		CCL_QUEUE_QOS_LOW, &err);
+	g_assert_no_error(err);
+	cq = ccl_queue_new_qos(ctx, NULL, 0, CCL_QUEUE_QOS_NORMAL, &err);
+	g_assert_no_error(err);
+
+	/* Check classes. */
+	g_assert_cmpint(ccl_queue_get_qos(cq_high), ==, CCL_QUEUE_QOS_HIGH);
+	g_assert_cmpint(ccl_queue_get_qos(cq_low), ==, CCL_QUEUE_QOS_LOW);
+	g_assert_cmpint(ccl_queue_get_qos(cq), ==, CCL_QUEUE_QOS_NORMAL);
+	g_assert(!ccl_queue_get_qos_hints(cq));
+	g_assert_cmpuint(ccl_queue_get_qos_hints(cq_high), ==,
+		ccl_queue_get_qos_hints(cq_low));
+
+	/* Launch high priority kernel, held in flight by a user event. */
+	uevt = ccl_user_event_new(ctx, &err);
+	g_assert_no_error(err);
+	evt_high = ccl_kernel_set_args_and_enqueue_ndrange(krnl, cq_high, 1,
+		NULL, &gws, NULL, ccl_ewl(&ewl, uevt, NULL), &err, buf_high, NULL);
+	g_assert_no_error(err);
+
+	/* Launch low priority kernel in another thread. */
+	thread_data[0] = krnl;
+	thread_data[1] = cq_low;
+	thread_data[2] = buf_low;
+	thread_data[3] = &gws;
+	thread_data[4] = &launched;
+	thread = g_thread_new("qos_low", qos_low_thread, thread_data);
+
+	/* With the host-side scheduler, the low priority launch is deferred
+	 * while the high priority kernel is in flight. */
+	g_usleep(100000);
+	if (!ccl_queue_get_qos_hints(cq_low))
+		g_assert_cmpint(g_atomic_int_get(&launched), ==, 0);
+
+	/* Release the high priority kernel, after which the low priority
+	 * launch goes through. */
+	ccl_user_event_set_status(uevt, CL_COMPLETE, &err);
+	g_assert_no_error(err);
+	evt_low = g_thread_join(thread);
+	g_assert(evt_low != NULL);
+	g_assert_cmpint(g_atomic_int_get(&launched), ==, 1);
+
+	/* With the host-side scheduler, the low priority kernel is only
+	 * launched after the high priority kernel completes. */
+	if (!ccl_queue_get_qos_hints(cq_low)) {
+		exec_status = ccl_event_get_info_scalar(evt_high,
+			CL_EVENT_COMMAND_EXECUTION_STATUS, cl_int, &err);
+		g_assert_no_error(err);
+		g_assert_cmpint(exec_status, ==, CL_COMPLETE);
+	}
+
+	/* Wait for low priority kernel. */
+	ccl_event_wait(ccl_ewl(&ewl, evt_low, NULL), &err);
+	g_assert_no_error(err);
+
+	/* Get latency per class. */
+	prof = ccl_prof_new();
+	ccl_prof_add_queue(prof, "high", cq_high);
+	ccl_prof_add_queue(prof, "low", cq_low);
+	ccl_prof_calc(prof, &err);
+	g_assert_no_error(err);
+	latency = ccl_prof_get_queue_latency(prof, "high", &max_latency);
+	g_assert_cmpuint(latency, <=, max_latency);
+	g_assert_cmpuint(max_latency, >, 0);
+	latency = ccl_prof_get_queue_latency(prof, "low", &max_latency);
+	g_assert_cmpuint(latency, <=, max_latency);
+	g_assert_cmpuint(
+		ccl_prof_get_queue_latency(prof, "none", NULL), ==, 0);
+
+	/* Release wrappers. */
+	ccl_prof_destroy(prof);
+	ccl_event_destroy(uevt);
+	ccl_queue_destroy(cq);
+	ccl_queue_destroy(cq_low);
+	ccl_queue_destroy(cq_high);
+	ccl_buffer_destroy(buf_low);
+	ccl_buffer_destroy(buf_high);
+	ccl_program_destroy(prg);
+	ccl_context_destroy(ctx);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
+/**
+ * @internal
+ * Thread function which completes a user event after a while.
+ * */
+static gpointer inflight_release_thread(gpointer data) {
+
+	CCLErr* err = NULL;
+	CCLEvent* uevt = (CCLEvent*) data;
+
+	g_usleep(50000);
+	ccl_user_event_set_status(uevt, CL_COMPLETE, &err);
+	g_assert_no_error(err);
+	return NULL;
+
+}
+
+/**
+ * Tests the in-flight command limit of command queues.
+ * */
+static void inflight_test() {
+
+	/* Test variables. */
+	CCLErr* err = NULL;
+	CCLContext* ctx = NULL;
+	CCLQueue* cq = NULL;
+	CCLBuffer* buf = NULL;
+	CCLEvent* uevt = NULL;
+	CCLEvent* evt = NULL;
+	CCLEventWaitList ewl = NULL;
+	GThread* thread = NULL;
+	cl_uint hbuf[8] = { 0 };
+	size_t bytes;
+	cl_ulong num_throttled, num_would_block;
+	double time_throttled;
+
+	/* Set up context, queue and buffer. */
+	ctx = ccl_test_context_new(&err);
+	g_assert_no_error(err);
+	cq = ccl_queue_new(ctx, NULL, 0, &err);
+	g_assert_no_error(err);
+	buf = ccl_buffer_new(ctx, CL_MEM_READ_WRITE, sizeof(hbuf), NULL, &err);
+	g_assert_no_error(err);
+
+	/* Allow two commands in flight, without blocking. */
+	ccl_queue_set_inflight_limit(cq, 2, 0, CL_FALSE);
+
+	/* Enqueue two writes which wait on a user event. */
+	uevt = ccl_user_event_new(ctx, &err);
+	g_assert_no_error(err);
+	ccl_buffer_enqueue_write(buf, cq, CL_FALSE, 0, sizeof(hbuf), hbuf,
+		ccl_ewl(&ewl, uevt, NULL), &err);
+	g_assert_no_error(err);
+	ccl_buffer_enqueue_write(buf, cq, CL_FALSE, 0, sizeof(hbuf), hbuf,
+		ccl_ewl(&ewl, uevt, NULL), &err);
+	g_assert_no_error(err);
+	evt = ccl_buffer_enqueue_write(buf, cq, CL_FALSE, 0, sizeof(hbuf), hbuf,
+		NULL, &err);
+
+	/* Both commands are pending, so a third command does not fit. */
+	g_assert_error(err, CCL_ERROR, CCL_ERROR_WOULD_BLOCK);
+	g_assert(evt == NULL);
+	g_clear_error(&err);
+	g_assert_cmpuint(ccl_queue_get_inflight(cq, &bytes), ==, 2);
+	g_assert_cmpuint(bytes, ==, 2 * sizeof(hbuf));
+
+	/* Let commands run and wait for them. */
+	ccl_user_event_set_status(uevt, CL_COMPLETE, &err);
+	g_assert_no_error(err);
+	ccl_queue_finish(cq, &err);
+	g_assert_no_error(err);
+	g_assert_cmpuint(ccl_queue_get_inflight(cq, &bytes), ==, 0);
+	g_assert_cmpuint(bytes, ==, 0);
+
+	/* The bytes of a command which fails to be enqueued are not
+	 * accounted to the next command, here a marker held back by a user
+	 * event. */
+	ccl_buffer_enqueue_read(buf, cq, CL_FALSE, 0, 2 * sizeof(hbuf), hbuf,
+		NULL, &err);
+	g_assert_error(err, CCL_OCL_ERROR, CL_INVALID_VALUE);
+	g_clear_error(&err);
+	ccl_event_destroy(uevt);
+	uevt = ccl_user_event_new(ctx, &err);
+	g_assert_no_error(err);
+	ccl_enqueue_marker(cq, ccl_ewl(&ewl, uevt, NULL), &err);
+	g_assert_no_error(err);
+	g_assert_cmpuint(ccl_queue_get_inflight(cq, &bytes), ==, 1);
+	g_assert_cmpuint(bytes, ==, 0);
+	ccl_user_event_set_status(uevt, CL_COMPLETE, &err);
+	g_assert_no_error(err);
+	ccl_queue_finish(cq, &err);
+	g_assert_no_error(err);
+
+	/* Allow one command in flight, blocking. A write held back by a user
+	 * event, which another thread completes after a while, blocks the
+	 * read which follows it until the write completes. */
+	ccl_queue_set_inflight_limit(cq, 1, 0, CL_TRUE);
+	ccl_event_destroy(uevt);
+	uevt = ccl_user_event_new(ctx, &err);
+	g_assert_no_error(err);
+	ccl_buffer_enqueue_write(buf, cq, CL_FALSE, 0, sizeof(hbuf), hbuf,
+		ccl_ewl(&ewl, uevt, NULL), &err);
+	g_assert_no_error(err);
+	thread = g_thread_new("inflight", inflight_release_thread, uevt);
+	ccl_buffer_enqueue_read(buf, cq, CL_FALSE, 0, sizeof(hbuf), hbuf,
+		NULL, &err);
+	g_assert_no_error(err);
+	g_thread_join(thread);
+	g_assert_cmpuint(ccl_queue_get_inflight(cq, NULL), <=, 1);
+	ccl_queue_finish(cq, &err);
+	g_assert_no_error(err);
+
+	/* Check statistics. */
+	ccl_queue_get_throttle_stats(
+		cq, &num_throttled, &num_would_block, &time_throttled);
+	g_assert_cmpuint(num_throttled, ==, 1);
+	g_assert_cmpuint(num_would_block, ==, 1);
+	g_assert_cmpfloat(time_throttled, >, 0.0);
+
+	/* Release wrappers. */
+	ccl_event_destroy(uevt);
+	ccl_buffer_destroy(buf);
+	ccl_queue_destroy(cq);
+	ccl_context_destroy(ctx);
+
+	/* Confirm that memory allocated by wrappers has been properly
+	 * freed. */
+	g_assert(ccl_wrapper_memcheck());
+
+}
+
 /**
  * Main function.
  * @param[in] argc Number of command line arguments.
@@ -335,6 +786,18 @@ int main(int argc, char** argv) {
 		"/wrappers/queue/barrier-marker",
 		barrier_marker_test);
 
+	g_test_add_func(
+		"/wrappers/queue/on-device",
+		on_device_test);
+
+	g_test_add_func(
+		"/wrappers/queue/qos",
+		qos_test);
+
+	g_test_add_func(
+		"/wrappers/queue/inflight",
+		inflight_test);
+
 	return g_test_run();
 }
 